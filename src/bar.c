@@ -22,6 +22,7 @@
 #include "main.h"
 #include "bar.h"
 
+#include "exif.h"
 #include "filedata.h"
 #include "history_list.h"
 #include "metadata.h"
@@ -215,6 +216,11 @@ static const KnownPanes known_panes[] = {
 	{PANE_UNDEF,		NULL,		NULL,			NULL}
 };
 
+/* delay before the panes follow a new image, keeps them quiet while the selection moves fast */
+#define BAR_UPDATE_DELAY 100
+
+typedef struct _BarUpdate BarUpdate;
+
 typedef struct _BarData BarData;
 struct _BarData
 {
@@ -226,8 +232,24 @@ struct _BarData
 
 	LayoutWindow *lw;
 	gint width;
+
+	guint update_id;	/**< event source id of the delayed pane update */
+	BarUpdate *update;	/**< metadata read in progress for the pane update */
+};
+
+/* metadata read for the panes, handed from the worker back to the main loop once */
+struct _BarUpdate
+{
+	gint cancelled;
+	BarData *bd;
+	FileData *fd;
+	gchar *path;
+	gchar *sidecar_path;
+	ExifData *exif;
 };
 
+static GThreadPool *bar_update_pool = NULL;
+
 static void bar_expander_move(GtkWidget *widget, gpointer data, gboolean up, gboolean single_step)
 {
 	GtkWidget *expander = data;
@@ -414,19 +436,125 @@ static void bar_pane_set_fd_cb(GtkWidget *expander, gpointer data)
 	if (pd->pane_set_fd) pd->pane_set_fd(widget, data);
 }
 
+static void bar_update_panes(BarData *bd)
+{
+	gtk_container_foreach(GTK_CONTAINER(bd->vbox), bar_pane_set_fd_cb, bd->fd);
+}
+
+static void bar_update_free(BarUpdate *bu)
+{
+	exif_free(bu->exif);
+	file_data_unref(bu->fd);
+	g_free(bu->path);
+	g_free(bu->sidecar_path);
+	g_free(bu);
+}
+
+static void bar_update_cancel(BarData *bd)
+{
+	if (bd->update_id)
+		{
+		g_source_remove(bd->update_id);
+		bd->update_id = 0;
+		}
+
+	if (bd->update)
+		{
+		/* freed by bar_update_done_cb */
+		g_atomic_int_set(&bd->update->cancelled, TRUE);
+		bd->update = NULL;
+		}
+}
+
+static gboolean bar_update_done_cb(gpointer data)
+{
+	BarUpdate *bu = data;
+
+	if (!g_atomic_int_get(&bu->cancelled))
+		{
+		BarData *bd = bu->bd;
+
+		bd->update = NULL;
+
+		exif_set_fd(bu->fd, bu->exif);
+		bu->exif = NULL;
+
+		bar_update_panes(bd);
+		}
+
+	bar_update_free(bu);
+	return FALSE;
+}
+
+static void bar_update_thread(gpointer data, gpointer user_data)
+{
+	BarUpdate *bu = data;
+
+	if (!g_atomic_int_get(&bu->cancelled))
+		{
+		bu->exif = exif_read(bu->path, bu->sidecar_path, NULL);
+		}
+
+	g_idle_add(bar_update_done_cb, bu);
+}
+
+static gboolean bar_update_cb(gpointer data)
+{
+	BarData *bd = data;
+	BarUpdate *bu;
+
+	bd->update_id = 0;
+
+	/* nothing to read ahead, or the panes will edit unsaved changes */
+	if (!bd->fd || bd->fd->exif || bd->fd->modified_xmp)
+		{
+		bar_update_panes(bd);
+		return FALSE;
+		}
+
+	bu = g_new0(BarUpdate, 1);
+	bu->bd = bd;
+	bu->fd = file_data_ref(bd->fd);
+	bu->path = g_strdup(bd->fd->path);
+	bu->sidecar_path = exif_get_sidecar_path_fd(bd->fd);
+	bd->update = bu;
+
+	if (!bar_update_pool)
+		{
+		bar_update_pool = g_thread_pool_new(bar_update_thread, NULL, 1, FALSE, NULL);
+		}
+	g_thread_pool_push(bar_update_pool, bu, NULL);
+
+	return FALSE;
+}
+
+/**
+ * @brief Shows \a fd in the sidebar
+ *
+ * The file name follows at once. The panes follow after a short delay,
+ * when the exif data was read in a worker thread, so that stepping quickly
+ * through a folder updates them only for the image it stops at.
+ */
 void bar_set_fd(GtkWidget *bar, FileData *fd)
 {
 	BarData *bd;
 	bd = g_object_get_data(G_OBJECT(bar), "bar_data");
 	if (!bd) return;
 
+	bar_update_cancel(bd);
+
 	file_data_unref(bd->fd);
 	bd->fd = file_data_ref(fd);
 
-	gtk_container_foreach(GTK_CONTAINER(bd->vbox), bar_pane_set_fd_cb, fd);
-
 	gtk_label_set_text(GTK_LABEL(bd->label_file_name), (bd->fd) ? bd->fd->name : "");
 
+	if (!bd->fd)
+		{
+		bar_update_panes(bd);
+		return;
+		}
+
+	bd->update_id = g_timeout_add(BAR_UPDATE_DELAY, bar_update_cb, bd);
 }
 
 static void bar_pane_notify_selection_cb(GtkWidget *expander, gpointer data)
@@ -655,6 +783,7 @@ static void bar_destroy(GtkWidget *widget, gpointer data)
 {
 	BarData *bd = data;
 
+	bar_update_cancel(bd);
 	file_data_unref(bd->fd);
 	g_free(bd);
 }
@@ -0,0 +1,872 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * geeqie-bench: times the decode, thumbnail, similarity, histogram, file
+ * list and .sim cache paths without a display and prints the results as
+ * JSON, so that runs of different builds can be compared.
+ *
+ * Built with "make geeqie-bench". Without folder arguments a synthetic
+ * corpus of JPEG files is generated in a temporary folder.
+ *
+ * The pixel kernels are also checked against the plain C versions, the
+ * exit status is 1 if they differ.
+ */
+
+#include "main.h"
+
+#include <glib/gstdio.h>
+
+#include "cache.h"
+#include "exif.h"
+#include "filedata.h"
+#include "filefilter.h"
+#include "histogram.h"
+#include "image-load.h"
+#include "pixbuf_kernels.h"
+#include "pixbuf_util.h"
+#include "similar.h"
+#include "ui_fileops.h"
+
+#define BENCH_DEFAULT_COUNT 20
+#define BENCH_DEFAULT_WIDTH 2000
+#define BENCH_DEFAULT_HEIGHT 1500
+#define BENCH_THUMB_SIZE 256
+#define BENCH_SHARED_LOADERS 4
+#define BENCH_BATCH_LOADERS 32
+#define BENCH_SIM_COMPARE_MAX 200000
+#define BENCH_SIM_COMPARE_BATCH 1000
+
+typedef struct _BenchStage BenchStage;
+struct _BenchStage {
+	const gchar *name;
+	GArray *samples;	/**< gdouble, milliseconds per call */
+	guint calls;
+	gdouble total;		/**< milliseconds */
+	gint64 bytes;
+};
+
+typedef struct _BenchLoad BenchLoad;
+struct _BenchLoad {
+	gboolean finished;
+	gboolean error;
+};
+
+static gint bench_iterations = 1;
+static gboolean bench_kernels_exact = TRUE;
+
+
+static BenchStage *bench_stage_new(const gchar *name)
+{
+	BenchStage *bs = g_new0(BenchStage, 1);
+
+	bs->name = name;
+	bs->samples = g_array_new(FALSE, FALSE, sizeof(gdouble));
+
+	return bs;
+}
+
+static void bench_stage_free(BenchStage *bs)
+{
+	g_array_free(bs->samples, TRUE);
+	g_free(bs);
+}
+
+/* calls that are too short to be timed one by one are timed in batches,
+ * each batch is one sample of the mean time per call */
+static void bench_stage_add_batch(BenchStage *bs, gint64 start, guint calls)
+{
+	gdouble ms = (g_get_monotonic_time() - start) / 1000.0;
+	gdouble per_call = ms / calls;
+
+	g_array_append_val(bs->samples, per_call);
+	bs->calls += calls;
+	bs->total += ms;
+}
+
+static void bench_stage_add(BenchStage *bs, gint64 start)
+{
+	bench_stage_add_batch(bs, start, 1);
+}
+
+static BenchStage *bench_stage_find(GList *stages, const gchar *name)
+{
+	GList *work;
+
+	for (work = stages; work; work = work->next)
+		{
+		BenchStage *bs = work->data;
+
+		if (strcmp(bs->name, name) == 0) return bs;
+		}
+
+	g_error("bench: no stage %s", name);
+	return NULL;
+}
+
+static gint bench_sample_cmp(gconstpointer a, gconstpointer b)
+{
+	gdouble da = *(const gdouble *)a;
+	gdouble db = *(const gdouble *)b;
+
+	return (da > db) - (da < db);
+}
+
+/* nearest rank */
+static gdouble bench_percentile(GArray *sorted, gdouble p)
+{
+	guint rank;
+
+	if (sorted->len == 0) return 0.0;
+
+	rank = (guint)(p / 100.0 * sorted->len + 0.5);
+	if (rank < 1) rank = 1;
+	if (rank > sorted->len) rank = sorted->len;
+
+	return g_array_index(sorted, gdouble, rank - 1);
+}
+
+static void bench_stage_print(BenchStage *bs, gboolean last)
+{
+	gdouble total = bs->total;
+
+	g_array_sort(bs->samples, bench_sample_cmp);
+
+	printf("    {\"stage\": \"%s\", \"count\": %u, \"total_ms\": %.3f, \"per_second\": %.3f",
+	       bs->name, bs->calls, total,
+	       total > 0.0 ? bs->calls * 1000.0 / total : 0.0);
+	if (bs->bytes > 0)
+		{
+		printf(", \"mb_per_second\": %.3f", total > 0.0 ? bs->bytes / 1048576.0 * 1000.0 / total : 0.0);
+		}
+	printf(", \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}%s\n",
+	       bench_percentile(bs->samples, 50.0),
+	       bench_percentile(bs->samples, 90.0),
+	       bench_percentile(bs->samples, 99.0),
+	       bench_percentile(bs->samples, 100.0),
+	       last ? "" : ",");
+}
+
+/*
+ *-------------------------------------------------------------------
+ * corpus
+ *-------------------------------------------------------------------
+ */
+
+static gchar *bench_corpus_create(gint count, gint width, gint height)
+{
+	gchar *dir;
+	GRand *rand;
+	gint n;
+
+	dir = g_dir_make_tmp("geeqie-bench-XXXXXX", NULL);
+	if (!dir) return NULL;
+
+	/* fixed seed, runs of different builds see the same files */
+	rand = g_rand_new_with_seed(1);
+
+	for (n = 0; n < count; n++)
+		{
+		GdkPixbuf *pixbuf;
+		guchar *pixels;
+		gint rowstride;
+		gint x, y;
+		gchar *name;
+		gchar *path;
+
+		pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+		pixels = gdk_pixbuf_get_pixels(pixbuf);
+		rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+
+		for (y = 0; y < height; y++)
+			{
+			guchar *p = pixels + y * rowstride;
+			for (x = 0; x < width; x++)
+				{
+				/* gradients plus noise, so the encoder has some work */
+				guint noise = g_rand_int_range(rand, 0, 32);
+				*p++ = (x * 255 / width + n * 8 + noise) & 0xff;
+				*p++ = (y * 255 / height + noise) & 0xff;
+				*p++ = ((x + y) * 255 / (width + height) + n * 16) & 0xff;
+				}
+			}
+
+		name = g_strdup_printf("bench_%04d.jpg", n);
+		path = g_build_filename(dir, name, NULL);
+		gdk_pixbuf_save(pixbuf, path, "jpeg", NULL, "quality", "90", NULL);
+
+		g_free(path);
+		g_free(name);
+		g_object_unref(pixbuf);
+		}
+
+	g_rand_free(rand);
+
+	return dir;
+}
+
+static void bench_corpus_remove(const gchar *dir)
+{
+	GDir *d;
+	const gchar *name;
+
+	d = g_dir_open(dir, 0, NULL);
+	if (d)
+		{
+		while ((name = g_dir_read_name(d)))
+			{
+			gchar *path = g_build_filename(dir, name, NULL);
+			g_unlink(path);
+			g_free(path);
+			}
+		g_dir_close(d);
+		}
+	g_rmdir(dir);
+}
+
+/*
+ *-------------------------------------------------------------------
+ * pixel kernels
+ *-------------------------------------------------------------------
+ */
+
+enum {
+	BENCH_KERNEL_ROTATE_CW = 0,
+	BENCH_KERNEL_ROTATE_CCW,
+	BENCH_KERNEL_MIRROR,
+	BENCH_KERNEL_MIRROR_FLIP,
+	BENCH_KERNEL_DESATURATE,
+	BENCH_KERNEL_HIGHLIGHT,
+	BENCH_KERNEL_IGNORE_ALPHA,
+	BENCH_KERNEL_COUNT
+};
+
+static GdkPixbuf *bench_kernel_apply(GdkPixbuf *src, gint op)
+{
+	GdkPixbuf *dest;
+	gint w = gdk_pixbuf_get_width(src);
+	gint h = gdk_pixbuf_get_height(src);
+
+	switch (op)
+		{
+		case BENCH_KERNEL_ROTATE_CW:
+			return pixbuf_copy_rotate_90(src, FALSE);
+		case BENCH_KERNEL_ROTATE_CCW:
+			return pixbuf_copy_rotate_90(src, TRUE);
+		case BENCH_KERNEL_MIRROR:
+			return pixbuf_copy_mirror(src, TRUE, FALSE);
+		case BENCH_KERNEL_MIRROR_FLIP:
+			return pixbuf_copy_mirror(src, TRUE, TRUE);
+		default:
+			break;
+		}
+
+	/* the rectangle starts at an odd offset to cover the unaligned ends */
+	dest = gdk_pixbuf_copy(src);
+	switch (op)
+		{
+		case BENCH_KERNEL_DESATURATE:
+			pixbuf_desaturate_rect(dest, 1, 1, w - 1, h - 1);
+			break;
+		case BENCH_KERNEL_HIGHLIGHT:
+			pixbuf_highlight_overunderexposed(dest, 1, 1, w - 1, h - 1);
+			break;
+		case BENCH_KERNEL_IGNORE_ALPHA:
+			pixbuf_ignore_alpha_rect(dest, 1, 1, w - 1, h - 1);
+			break;
+		}
+
+	return dest;
+}
+
+/* compares the pixels only, the padding at the end of the rows is undefined */
+static gboolean bench_pixbuf_equal(GdkPixbuf *a, GdkPixbuf *b)
+{
+	gint w = gdk_pixbuf_get_width(a);
+	gint h = gdk_pixbuf_get_height(a);
+	gint n = gdk_pixbuf_get_n_channels(a);
+	gint i;
+
+	if (w != gdk_pixbuf_get_width(b) || h != gdk_pixbuf_get_height(b) ||
+	    n != gdk_pixbuf_get_n_channels(b)) return FALSE;
+
+	for (i = 0; i < h; i++)
+		{
+		if (memcmp(gdk_pixbuf_get_pixels(a) + i * gdk_pixbuf_get_rowstride(a),
+			   gdk_pixbuf_get_pixels(b) + i * gdk_pixbuf_get_rowstride(b), w * n) != 0) return FALSE;
+		}
+
+	return TRUE;
+}
+
+/* the selected kernels must give the same bytes as the plain C ones,
+ * for RGB and RGBA and for a size that is not a multiple of the vector width */
+static void bench_kernels_check(GdkPixbuf *pixbuf)
+{
+	gchar *name;
+	GdkPixbuf *sources[3];
+	gint i, op;
+
+	if (strcmp(pixbuf_kernels_get_name(), "generic") == 0) return;
+
+	name = g_strdup(pixbuf_kernels_get_name());
+	sources[0] = g_object_ref(pixbuf);
+	sources[1] = gdk_pixbuf_add_alpha(pixbuf, FALSE, 0, 0, 0);
+	sources[2] = gdk_pixbuf_new_subpixbuf(sources[1], 1, 1,
+					      MAX(1, gdk_pixbuf_get_width(pixbuf) - 3),
+					      MAX(1, gdk_pixbuf_get_height(pixbuf) - 2));
+
+	for (i = 0; i < 3; i++)
+		{
+		for (op = 0; op < BENCH_KERNEL_COUNT; op++)
+			{
+			GdkPixbuf *expected;
+			GdkPixbuf *result;
+
+			pixbuf_kernels_select("generic");
+			expected = bench_kernel_apply(sources[i], op);
+			pixbuf_kernels_select(name);
+			result = bench_kernel_apply(sources[i], op);
+
+			if (!bench_pixbuf_equal(expected, result))
+				{
+				log_printf("geeqie-bench: %s kernels differ from generic, operation %d, %dx%d, %d channels\n",
+					   name, op, gdk_pixbuf_get_width(sources[i]), gdk_pixbuf_get_height(sources[i]),
+					   gdk_pixbuf_get_n_channels(sources[i]));
+				bench_kernels_exact = FALSE;
+				}
+
+			g_object_unref(expected);
+			g_object_unref(result);
+			}
+		g_object_unref(sources[i]);
+		}
+
+	g_free(name);
+}
+
+/*
+ *-------------------------------------------------------------------
+ * stages
+ *-------------------------------------------------------------------
+ */
+
+static void bench_load_done_cb(ImageLoader *il, gpointer data)
+{
+	BenchLoad *bl = data;
+
+	bl->finished = TRUE;
+}
+
+static void bench_load_error_cb(ImageLoader *il, gpointer data)
+{
+	BenchLoad *bl = data;
+
+	bl->finished = TRUE;
+	bl->error = TRUE;
+}
+
+/* the loader reports back through the main loop, as in the viewer */
+static GdkPixbuf *bench_decode(FileData *fd, gint width, gint height)
+{
+	ImageLoader *il;
+	BenchLoad bl = { FALSE, FALSE };
+	GdkPixbuf *pixbuf = NULL;
+
+	image_loader_cache_clear();
+
+	il = image_loader_new(fd);
+	if (width > 0) image_loader_set_requested_size(il, width, height);
+	g_signal_connect(G_OBJECT(il), "done", (GCallback)bench_load_done_cb, &bl);
+	g_signal_connect(G_OBJECT(il), "error", (GCallback)bench_load_error_cb, &bl);
+
+	if (image_loader_start(il))
+		{
+		while (!bl.finished) g_main_context_iteration(NULL, TRUE);
+		}
+	else
+		{
+		bl.error = TRUE;
+		}
+
+	if (!bl.error && image_loader_get_pixbuf(il))
+		{
+		pixbuf = g_object_ref(image_loader_get_pixbuf(il));
+		}
+	image_loader_free(il);
+
+	return pixbuf;
+}
+
+/* several views asking for the same thumbnail at once, as the loaders share
+ * one decode this should cost about as much as a single decode */
+static void bench_decode_shared(FileData *fd)
+{
+	ImageLoader *il[BENCH_SHARED_LOADERS];
+	BenchLoad bl[BENCH_SHARED_LOADERS];
+	gint i;
+
+	image_loader_cache_clear();
+
+	for (i = 0; i < BENCH_SHARED_LOADERS; i++)
+		{
+		bl[i].finished = FALSE;
+		bl[i].error = FALSE;
+		il[i] = image_loader_new(fd);
+		image_loader_set_requested_size(il[i], BENCH_THUMB_SIZE - i, BENCH_THUMB_SIZE - i);
+		g_signal_connect(G_OBJECT(il[i]), "done", (GCallback)bench_load_done_cb, &bl[i]);
+		g_signal_connect(G_OBJECT(il[i]), "error", (GCallback)bench_load_error_cb, &bl[i]);
+		if (!image_loader_start(il[i])) bl[i].finished = TRUE;
+		}
+
+	for (i = 0; i < BENCH_SHARED_LOADERS; i++)
+		{
+		while (!bl[i].finished) g_main_context_iteration(NULL, TRUE);
+		}
+
+	for (i = 0; i < BENCH_SHARED_LOADERS; i++) image_loader_free(il[i]);
+}
+
+/* decoding the image for the view while a batch job keeps the loader threads busy */
+static void bench_decode_under_load(GList *files, BenchStage *stage)
+{
+	ImageLoader *il;
+	BenchLoad bl = { FALSE, FALSE };
+	FileData *view_fd = NULL;
+	GList *batch = NULL;
+	GList *work;
+	gint n = 0;
+	gint64 start;
+
+	image_loader_cache_clear();
+
+	for (work = files; work && n < BENCH_BATCH_LOADERS; work = work->next)
+		{
+		FileData *fd = work->data;
+
+		if (fd->format_class != FORMAT_CLASS_IMAGE) continue;
+
+		if (!view_fd)
+			{
+			view_fd = fd;
+			continue;
+			}
+
+		il = image_loader_new(fd);
+		image_loader_set_priority_class(il, IMAGE_LOADER_PRIORITY_BATCH);
+		if (image_loader_start(il))
+			{
+			batch = g_list_prepend(batch, il);
+			n++;
+			}
+		else
+			{
+			image_loader_free(il);
+			}
+		}
+
+	if (view_fd)
+		{
+		start = g_get_monotonic_time();
+
+		il = image_loader_new(view_fd);
+		g_signal_connect(G_OBJECT(il), "done", (GCallback)bench_load_done_cb, &bl);
+		g_signal_connect(G_OBJECT(il), "error", (GCallback)bench_load_error_cb, &bl);
+		if (image_loader_start(il))
+			{
+			while (!bl.finished) g_main_context_iteration(NULL, TRUE);
+			bench_stage_add(stage, start);
+			}
+		image_loader_free(il);
+		}
+
+	/* the loaders still queued are cancelled */
+	g_list_free_full(batch, (GDestroyNotify)image_loader_free);
+}
+
+static void bench_run(GList *dirs, GList *stages)
+{
+	BenchStage *filelist_stage = bench_stage_find(stages, "filelist_read");
+	BenchStage *decode_stage = bench_stage_find(stages, "decode");
+	BenchStage *decode_thumb_stage = bench_stage_find(stages, "decode_thumbnail_size");
+	BenchStage *scale_stage = bench_stage_find(stages, "thumbnail_scale");
+	BenchStage *histmap_stage = bench_stage_find(stages, "histmap_read");
+	BenchStage *sim_fill_stage = bench_stage_find(stages, "image_sim_fill_data");
+	BenchStage *sim_compare_stage = bench_stage_find(stages, "image_sim_compare_fast");
+	BenchStage *sim_save_stage = bench_stage_find(stages, "cache_sim_data_save");
+	BenchStage *sim_load_stage = bench_stage_find(stages, "cache_sim_data_load");
+	BenchStage *rotate_stage = bench_stage_find(stages, "pixbuf_rotate_90");
+	BenchStage *mirror_stage = bench_stage_find(stages, "pixbuf_mirror");
+	BenchStage *desaturate_stage = bench_stage_find(stages, "pixbuf_desaturate");
+	BenchStage *highlight_stage = bench_stage_find(stages, "pixbuf_highlight");
+	BenchStage *dimensions_stage = bench_stage_find(stages, "image_load_dimensions");
+	BenchStage *decode_shared_stage = bench_stage_find(stages, "decode_shared_thumbnail_size");
+	BenchStage *decode_under_load_stage = bench_stage_find(stages, "decode_under_batch_load");
+	GList *files = NULL;
+	GList *sims = NULL;
+	GList *work;
+	gchar *sim_dir;
+	gint i;
+
+	for (work = dirs; work; work = work->next)
+		{
+		FileData *dir_fd = file_data_new_dir(work->data);
+		GList *list = NULL;
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+
+			filelist_free(list);
+			list = NULL;
+			filelist_read(dir_fd, &list, NULL);
+			bench_stage_add(filelist_stage, start);
+			}
+
+		files = g_list_concat(files, list);
+		file_data_unref(dir_fd);
+		}
+
+	sim_dir = g_dir_make_tmp("geeqie-bench-sim-XXXXXX", NULL);
+
+	for (work = files; work; work = work->next)
+		{
+		FileData *fd = work->data;
+		GdkPixbuf *pixbuf = NULL;
+		ImageSimilarityData *sd = NULL;
+
+		if (fd->format_class != FORMAT_CLASS_IMAGE && fd->format_class != FORMAT_CLASS_RAWIMAGE) continue;
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+			gint w, h;
+
+			image_load_dimensions(fd, &w, &h);
+			bench_stage_add(dimensions_stage, start);
+			}
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+			GdkPixbuf *thumb;
+
+			if (pixbuf) g_object_unref(pixbuf);
+			pixbuf = bench_decode(fd, 0, 0);
+			if (!pixbuf) break;
+			bench_stage_add(decode_stage, start);
+			decode_stage->bytes += fd->size;
+
+			start = g_get_monotonic_time();
+			thumb = bench_decode(fd, BENCH_THUMB_SIZE, BENCH_THUMB_SIZE);
+			bench_stage_add(decode_thumb_stage, start);
+			if (thumb) g_object_unref(thumb);
+
+			start = g_get_monotonic_time();
+			bench_decode_shared(fd);
+			bench_stage_add(decode_shared_stage, start);
+			}
+		if (!pixbuf)
+			{
+			DEBUG_1("bench: can not decode %s", fd->path);
+			continue;
+			}
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+			gint tw, th;
+			GdkPixbuf *thumb;
+
+			pixbuf_scale_aspect(BENCH_THUMB_SIZE, BENCH_THUMB_SIZE,
+					    gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf), &tw, &th);
+			thumb = gdk_pixbuf_scale_simple(pixbuf, tw, th, (GdkInterpType)options->thumbnails.quality);
+			bench_stage_add(scale_stage, start);
+			g_object_unref(thumb);
+			}
+
+		if (bench_kernels_exact) bench_kernels_check(pixbuf);
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+			GdkPixbuf *copy;
+
+			copy = pixbuf_copy_rotate_90(pixbuf, i & 1);
+			bench_stage_add(rotate_stage, start);
+			g_object_unref(copy);
+
+			start = g_get_monotonic_time();
+			copy = pixbuf_copy_mirror(pixbuf, TRUE, TRUE);
+			bench_stage_add(mirror_stage, start);
+
+			/* in place, on the copy */
+			start = g_get_monotonic_time();
+			pixbuf_desaturate_rect(copy, 0, 0, gdk_pixbuf_get_width(copy), gdk_pixbuf_get_height(copy));
+			bench_stage_add(desaturate_stage, start);
+
+			start = g_get_monotonic_time();
+			pixbuf_highlight_overunderexposed(copy, 0, 0, gdk_pixbuf_get_width(copy), gdk_pixbuf_get_height(copy));
+			bench_stage_add(highlight_stage, start);
+			g_object_unref(copy);
+			}
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+
+			histmap_free(fd->histmap);
+			fd->histmap = NULL;
+			fd->pixbuf = pixbuf;
+			histmap_start_idle(fd);
+			fd->pixbuf = NULL;
+			while (!histmap_get(fd)) g_main_context_iteration(NULL, TRUE);
+			bench_stage_add(histmap_stage, start);
+			}
+
+		for (i = 0; i < bench_iterations; i++)
+			{
+			gint64 start = g_get_monotonic_time();
+
+			image_sim_free(sd);
+			sd = image_sim_new();
+			image_sim_fill_data(sd, pixbuf);
+			bench_stage_add(sim_fill_stage, start);
+			}
+
+		if (sim_dir)
+			{
+			gchar *name = g_strconcat(fd->name, GQ_CACHE_EXT_SIM, NULL);
+			gchar *path = g_build_filename(sim_dir, name, NULL);
+
+			for (i = 0; i < bench_iterations; i++)
+				{
+				gint64 start = g_get_monotonic_time();
+				CacheData *cd;
+
+				cd = cache_sim_data_new();
+				cd->path = g_strdup(path);
+				cache_sim_data_set_dimensions(cd, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+				cache_sim_data_set_date(cd, fd->date);
+				cache_sim_data_set_similarity(cd, sd);
+				cache_sim_data_save(cd);
+				cache_sim_data_free(cd);
+				bench_stage_add(sim_save_stage, start);
+
+				start = g_get_monotonic_time();
+				cd = cache_sim_data_load(path);
+				bench_stage_add(sim_load_stage, start);
+				cache_sim_data_free(cd);
+				}
+
+			g_free(path);
+			g_free(name);
+			}
+
+		sims = g_list_prepend(sims, sd);
+		g_object_unref(pixbuf);
+		}
+
+	for (i = 0; i < bench_iterations; i++)
+		{
+		bench_decode_under_load(files, decode_under_load_stage);
+		}
+
+	/* pairwise, as in the duplicates window */
+	if (sims)
+		{
+		GList *a, *b;
+		gint compared = 0;
+
+		for (a = sims; a && compared < BENCH_SIM_COMPARE_MAX; a = a->next)
+			{
+			gint64 start = g_get_monotonic_time();
+			guint batch = 0;
+
+			for (b = a->next; b && compared < BENCH_SIM_COMPARE_MAX; b = b->next)
+				{
+				image_sim_compare_fast(a->data, b->data, 0.95);
+				compared++;
+				batch++;
+
+				if (batch == BENCH_SIM_COMPARE_BATCH)
+					{
+					bench_stage_add_batch(sim_compare_stage, start, batch);
+					start = g_get_monotonic_time();
+					batch = 0;
+					}
+				}
+			if (batch > 0) bench_stage_add_batch(sim_compare_stage, start, batch);
+			}
+		}
+
+	if (sim_dir)
+		{
+		bench_corpus_remove(sim_dir);
+		g_free(sim_dir);
+		}
+
+	g_list_free_full(sims, (GDestroyNotify)image_sim_free);
+	filelist_free(files);
+}
+
+static void bench_usage(void)
+{
+	printf("Usage: geeqie-bench [options] [folder...]\n\n");
+	printf("  --iterations=N   repeat every measurement N times (default 1)\n");
+	printf("  --count=N        number of synthetic images (default %d)\n", BENCH_DEFAULT_COUNT);
+	printf("  --size=WxH       size of synthetic images (default %dx%d)\n", BENCH_DEFAULT_WIDTH, BENCH_DEFAULT_HEIGHT);
+	printf("  --kernels=NAME   pixel kernels to use: sse2 or generic (default: best supported)\n");
+	printf("  --debug[=level]  turn on debug output\n");
+	printf("\nWithout folders a synthetic corpus is generated and removed afterwards.\n");
+	printf("Results are printed to stdout as JSON.\n");
+}
+
+gint main(gint argc, gchar *argv[])
+{
+	GList *dirs = NULL;
+	GList *stages = NULL;
+	GList *work;
+	gchar *corpus = NULL;
+	ImageLoaderQueueStats queue_stats;
+	gint count = BENCH_DEFAULT_COUNT;
+	gint width = BENCH_DEFAULT_WIDTH;
+	gint height = BENCH_DEFAULT_HEIGHT;
+	gint64 start;
+	gint i;
+
+	init_exec_time();
+	setlocale(LC_ALL, "");
+
+	for (i = 1; i < argc; i++)
+		{
+		const gchar *arg = argv[i];
+
+		if (g_str_has_prefix(arg, "--iterations="))
+			{
+			bench_iterations = MAX(1, atoi(arg + 13));
+			}
+		else if (g_str_has_prefix(arg, "--count="))
+			{
+			count = MAX(1, atoi(arg + 8));
+			}
+		else if (g_str_has_prefix(arg, "--size="))
+			{
+			if (sscanf(arg + 7, "%dx%d", &width, &height) != 2 || width < 1 || height < 1)
+				{
+				bench_usage();
+				return 1;
+				}
+			}
+		else if (g_str_has_prefix(arg, "--kernels="))
+			{
+			if (!pixbuf_kernels_select(arg + 10))
+				{
+				log_printf("geeqie-bench: kernels %s are not available\n", arg + 10);
+				return 1;
+				}
+			}
+		else if (strcmp(arg, "--debug") == 0)
+			{
+			debug_level_add(1);
+			}
+		else if (g_str_has_prefix(arg, "--debug="))
+			{
+			debug_level_add(atoi(arg + 8));
+			}
+		else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+			{
+			bench_usage();
+			return 0;
+			}
+		else if (arg[0] == '-')
+			{
+			bench_usage();
+			return 1;
+			}
+		else
+			{
+			dirs = g_list_append(dirs, path_to_utf8(arg));
+			}
+		}
+
+	exif_init();
+
+	/* defaults only, results must not depend on the user's configuration */
+	options = init_options(NULL);
+	setup_default_options(options);
+	filter_add_defaults();
+	filter_rebuild();
+
+	if (!dirs)
+		{
+		start = g_get_monotonic_time();
+		corpus = bench_corpus_create(count, width, height);
+		if (!corpus)
+			{
+			log_printf("geeqie-bench: can not create the synthetic corpus\n");
+			return 1;
+			}
+		DEBUG_1("bench: corpus created in %.3f s", (g_get_monotonic_time() - start) / 1000000.0);
+		dirs = g_list_append(dirs, g_strdup(corpus));
+		}
+
+	stages = g_list_append(stages, bench_stage_new("filelist_read"));
+	stages = g_list_append(stages, bench_stage_new("decode"));
+	stages = g_list_append(stages, bench_stage_new("decode_thumbnail_size"));
+	stages = g_list_append(stages, bench_stage_new("thumbnail_scale"));
+	stages = g_list_append(stages, bench_stage_new("histmap_read"));
+	stages = g_list_append(stages, bench_stage_new("image_sim_fill_data"));
+	stages = g_list_append(stages, bench_stage_new("image_sim_compare_fast"));
+	stages = g_list_append(stages, bench_stage_new("cache_sim_data_save"));
+	stages = g_list_append(stages, bench_stage_new("cache_sim_data_load"));
+	stages = g_list_append(stages, bench_stage_new("pixbuf_rotate_90"));
+	stages = g_list_append(stages, bench_stage_new("pixbuf_mirror"));
+	stages = g_list_append(stages, bench_stage_new("pixbuf_desaturate"));
+	stages = g_list_append(stages, bench_stage_new("pixbuf_highlight"));
+	stages = g_list_append(stages, bench_stage_new("image_load_dimensions"));
+	stages = g_list_append(stages, bench_stage_new("decode_shared_thumbnail_size"));
+	stages = g_list_append(stages, bench_stage_new("decode_under_batch_load"));
+
+	bench_run(dirs, stages);
+
+	printf("{\n  \"version\": \"%s\",\n  \"iterations\": %d,\n  \"synthetic\": %s,\n",
+	       VERSION, bench_iterations, corpus ? "true" : "false");
+	printf("  \"kernels\": \"%s\",\n  \"kernels_exact\": %s,\n",
+	       pixbuf_kernels_get_name(), bench_kernels_exact ? "true" : "false");
+	image_loader_get_queue_stats(&queue_stats);
+	printf("  \"loader_threads\": %d,\n  \"loaders_finished\": %u,\n  \"loaders_cancelled\": %u,\n  \"stages\": [\n",
+	       queue_stats.threads, queue_stats.finished, queue_stats.cancelled);
+	for (work = stages; work; work = work->next)
+		{
+		bench_stage_print(work->data, work->next == NULL);
+		}
+	printf("  ]\n}\n");
+
+	if (corpus)
+		{
+		bench_corpus_remove(corpus);
+		g_free(corpus);
+		}
+
+	g_list_free_full(stages, (GDestroyNotify)bench_stage_free);
+	g_list_free_full(dirs, g_free);
+
+	return bench_kernels_exact ? 0 : 1;
+}
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
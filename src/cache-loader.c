@@ -55,6 +55,7 @@ static gboolean cache_loader_phase1_process(CacheLoader *cl)
 		if (!cl->il && !cl->error)
 			{
 			cl->il = image_loader_new(cl->fd);
+			image_loader_set_priority_class(cl->il, IMAGE_LOADER_PRIORITY_BATCH);
 			g_signal_connect(G_OBJECT(cl->il), "error", (GCallback)cache_loader_phase1_error_cb, cl);
 			g_signal_connect(G_OBJECT(cl->il), "done", (GCallback)cache_loader_phase1_done_cb, cl);
 			if (image_loader_start(cl->il))
@@ -145,7 +145,7 @@ static gboolean cache_sim_write_similarity(SecureSaveInfo *ssi, CacheData *cd)
 	return TRUE;
 }
 
-gboolean cache_sim_data_save(CacheData *cd)
+static gboolean cache_sim_data_save_real(CacheData *cd)
 {
 	SecureSaveInfo *ssi;
 	gchar *pathl;
@@ -178,6 +178,17 @@ gboolean cache_sim_data_save(CacheData *cd)
 	return TRUE;
 }
 
+gboolean cache_sim_data_save(CacheData *cd)
+{
+	gboolean success;
+	TRACE_BEGIN(trace_start);
+
+	success = cache_sim_data_save_real(cd);
+
+	TRACE_END(trace_start, "cache_sim_data_save", cd ? cd->path : NULL);
+	return success;
+}
+
 /*
  *-------------------------------------------------------------------
  * sim cache read
@@ -396,7 +407,7 @@ static gboolean cache_sim_read_similarity(FILE *f, gchar *buf, gint s, CacheData
 
 #define CACHE_LOAD_LINE_NOISE 8
 
-CacheData *cache_sim_data_load(const gchar *path)
+static CacheData *cache_sim_data_load_real(const gchar *path)
 {
 	FILE *f;
 	CacheData *cd = NULL;
@@ -469,6 +480,17 @@ CacheData *cache_sim_data_load(const gchar *path)
 	return cd;
 }
 
+CacheData *cache_sim_data_load(const gchar *path)
+{
+	CacheData *cd;
+	TRACE_BEGIN(trace_start);
+
+	cd = cache_sim_data_load_real(path);
+
+	TRACE_END(trace_start, "cache_sim_data_load", path);
+	return cd;
+}
+
 /*
  *-------------------------------------------------------------------
  * sim cache setting
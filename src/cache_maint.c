@@ -26,6 +26,7 @@
 #include "cache-loader.h"
 #include "filedata.h"
 #include "layout.h"
+#include "secure_save.h"
 #include "thumb.h"
 #include "thumb_standard.h"
 #include "ui_fileops.h"
@@ -36,12 +37,13 @@
 #include "window.h"
 
 
+typedef struct _CacheClean CacheClean;
+
 typedef struct _CMData CMData;
 struct _CMData
 {
-	GList *list;
-	GList *done_list;
-	guint idle_id; /* event source id */
+	CacheClean *cc;
+	guint update_id; /* event source id */
 	GenericDialog *gd;
 	GtkWidget *entry;
 	GtkWidget *spinner;
@@ -57,10 +59,67 @@ struct _CMData
 
 /*
  *-------------------------------------------------------------------
- * cache maintenance
+ * threaded cache cleanup
  *-------------------------------------------------------------------
  */
 
+#define CACHE_CLEAN_THREADS_MAX 8
+#define CACHE_CLEAN_BATCH_SIZE 256
+#define CACHE_CLEAN_UPDATE_INTERVAL 250
+#define CACHE_CLEAN_MANIFEST "thumbnails_standard.manifest"
+#define CACHE_CLEAN_MANIFEST_HEADER "#Geeqie thumbnail manifest 1"
+
+typedef enum {
+	CACHE_CLEAN_HOME,	/* geeqie thumbnail or metadata cache, checked against the source path */
+	CACHE_CLEAN_STANDARD	/* shared thumbnail cache, checked against the markers in each file */
+} CacheCleanType;
+
+typedef void (* CacheCleanDoneFunc)(CacheClean *cc, gpointer data);
+
+struct _CacheClean
+{
+	CacheCleanType type;
+	gboolean clear;
+	gboolean metadata;
+	gint days;
+
+	gchar *base;		/* cache root, locale encoding */
+	gsize base_length;
+	GList *roots;		/* folders to scan, locale encoding */
+
+	GThreadPool *pool;
+	gint pending;		/* queued and running tasks, atomic */
+	gint cancelled;		/* atomic */
+	gint count_done;	/* atomic */
+	gint count_total;	/* atomic */
+
+	GMutex lock;		/* protects dirs and manifest_new */
+	GList *dirs;		/* visited folders, removed at the end if empty */
+
+	gchar *manifest_path;	/* NULL when no manifest is kept */
+	GHashTable *manifest;	/* entries of the last run, read only once scanning starts */
+	GHashTable *manifest_new;
+
+	CacheCleanDoneFunc done_func;
+	gpointer done_data;
+};
+
+typedef struct _CacheCleanTask CacheCleanTask;
+struct _CacheCleanTask
+{
+	gchar *dir;		/* NULL for the setup task */
+	GPtrArray *names;	/* files of dir to check, NULL to scan dir */
+};
+
+typedef struct _CacheCleanEntry CacheCleanEntry;
+struct _CacheCleanEntry
+{
+	gint64 thumb_mtime;
+	gint64 thumb_size;
+	gint64 source_mtime;
+	gchar *uri;
+};
+
 static gchar *extension_find_dot(gchar *path)
 {
 	gchar *dot = NULL;
@@ -76,185 +135,534 @@ static gchar *extension_find_dot(gchar *path)
 	return dot;
 }
 
-static gboolean isempty(const gchar *path)
+static void cache_clean_entry_free(gpointer data)
 {
-	DIR *dp;
-	struct dirent *dir;
-	gchar *pathl;
+	CacheCleanEntry *entry = data;
+
+	g_free(entry->uri);
+	g_free(entry);
+}
+
+static GHashTable *cache_clean_manifest_new(void)
+{
+	return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, cache_clean_entry_free);
+}
 
-	pathl = path_from_utf8(path);
-	dp = opendir(pathl);
-	g_free(pathl);
-	if (!dp) return FALSE;
+static GHashTable *cache_clean_manifest_load(const gchar *path)
+{
+	GHashTable *manifest;
+	gchar *contents;
+	gchar **lines;
+	gint i;
+
+	if (!g_file_get_contents(path, &contents, NULL, NULL)) return NULL;
+
+	if (!g_str_has_prefix(contents, CACHE_CLEAN_MANIFEST_HEADER "\n"))
+		{
+		g_free(contents);
+		return NULL;
+		}
 
-	while ((dir = readdir(dp)) != NULL)
+	manifest = cache_clean_manifest_new();
+	lines = g_strsplit(contents + strlen(CACHE_CLEAN_MANIFEST_HEADER "\n"), "\n", -1);
+	g_free(contents);
+
+	for (i = 0; lines[i]; i++)
 		{
-		gchar *name = dir->d_name;
+		gchar **fields = g_strsplit(lines[i], " ", 5);
 
-		if (!(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) )
+		if (g_strv_length(fields) == 5)
 			{
-			closedir(dp);
-			return FALSE;
+			CacheCleanEntry *entry = g_new(CacheCleanEntry, 1);
+
+			entry->thumb_mtime = g_ascii_strtoll(fields[1], NULL, 10);
+			entry->thumb_size = g_ascii_strtoll(fields[2], NULL, 10);
+			entry->source_mtime = g_ascii_strtoll(fields[3], NULL, 10);
+			entry->uri = g_strdup(fields[4]);
+			g_hash_table_insert(manifest, g_strdup(fields[0]), entry);
 			}
+		g_strfreev(fields);
 		}
+	g_strfreev(lines);
 
-	closedir(dp);
-	return TRUE;
+	return manifest;
 }
 
-static void cache_maintain_home_close(CMData *cm)
+static void cache_clean_manifest_save(CacheClean *cc)
 {
-	if (cm->idle_id) g_source_remove(cm->idle_id);
-	if (cm->gd) generic_dialog_close(cm->gd);
-	filelist_free(cm->list);
-	g_list_free(cm->done_list);
-	g_free(cm);
+	SecureSaveInfo *ssi;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	ssi = secure_open(cc->manifest_path);
+	if (!ssi)
+		{
+		log_printf("Error: Unable to write thumbnail manifest %s\n", cc->manifest_path);
+		return;
+		}
+
+	secure_fprintf(ssi, "%s\n", CACHE_CLEAN_MANIFEST_HEADER);
+
+	g_hash_table_iter_init(&iter, cc->manifest_new);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		{
+		CacheCleanEntry *entry = value;
+
+		secure_fprintf(ssi, "%s %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %s\n",
+			       (gchar *)key, entry->thumb_mtime, entry->thumb_size, entry->source_mtime, entry->uri);
+		}
+
+	if (secure_close(ssi))
+		{
+		log_printf("Error: Unable to write thumbnail manifest %s: %s\n", cc->manifest_path,
+			   secsave_strerror(secsave_errno));
+		}
 }
 
-static void cache_maintain_home_stop(CMData *cm)
+static void cache_clean_task_free(CacheCleanTask *task)
+{
+	if (task->names) g_ptr_array_free(task->names, TRUE);
+	g_free(task->dir);
+	g_free(task);
+}
+
+static void cache_clean_push(CacheClean *cc, gchar *dir, GPtrArray *names)
+{
+	CacheCleanTask *task;
+
+	task = g_new0(CacheCleanTask, 1);
+	task->dir = dir;
+	task->names = names;
+
+	if (names) g_atomic_int_add(&cc->count_total, names->len);
+
+	g_atomic_int_inc(&cc->pending);
+	g_thread_pool_push(cc->pool, task, NULL);
+}
+
+static void cache_clean_check_home(CacheClean *cc, const gchar *path)
 {
-	if (cm->idle_id)
+	struct stat st;
+	gchar *source;
+	gchar *dot;
+	gboolean stale = FALSE;
+
+	if (!cc->metadata && cc->clear)
 		{
-		g_source_remove(cm->idle_id);
-		cm->idle_id = 0;
+		stale = TRUE;
 		}
-
-	if (!cm->remote)
+	else if (strlen(path) > cc->base_length)
 		{
-		gtk_entry_set_text(GTK_ENTRY(cm->entry), _("done"));
-		spinner_set_interval(cm->spinner, -1);
+		source = g_strdup(path + cc->base_length);
+		dot = extension_find_dot(source);
+		if (dot) *dot = '\0';
 
-		gtk_widget_set_sensitive(cm->button_stop, FALSE);
-		gtk_widget_set_sensitive(cm->button_close, TRUE);
+		stale = (stat(source, &st) != 0 || !S_ISREG(st.st_mode));
+		g_free(source);
 		}
+
+	if (stale && unlink(path) != 0) log_printf("failed to delete:%s\n", path);
 }
 
-static gboolean cache_maintain_home_cb(gpointer data)
+static void cache_clean_check_standard(CacheClean *cc, const gchar *path)
 {
-	CMData *cm = data;
-	GList *dlist = NULL;
-	GList *list = NULL;
-	FileData *fd;
-	gboolean just_done = FALSE;
-	gboolean still_have_a_file = TRUE;
-	gsize base_length;
-	const gchar *cache_folder;
-	gboolean filter_disable;
+	struct stat st;
+	struct stat st_source;
+	CacheCleanEntry *entry;
+	const gchar *key;
+	gchar *uri = NULL;
+	gchar *mtime_str = NULL;
+	gint64 source_mtime = 0;
+	gboolean valid = FALSE;
+
+	if (cc->clear)
+		{
+		DEBUG_1("thumb removed: %s", path);
+		unlink(path);
+		return;
+		}
+
+	if (lstat(path, &st) != 0) return;
 
-	if (cm->metadata)
+	key = path + cc->base_length;
+	if (*key == G_DIR_SEPARATOR) key++;
+
+	/* an unchanged thumbnail keeps the markers recorded by the last run */
+	entry = cc->manifest ? g_hash_table_lookup(cc->manifest, key) : NULL;
+	if (entry && entry->thumb_mtime == (gint64)st.st_mtime && entry->thumb_size == (gint64)st.st_size)
 		{
-		cache_folder = get_metadata_cache_dir();
+		uri = g_strdup(entry->uri);
+		source_mtime = entry->source_mtime;
+		}
+	else if (thumb_std_read_markers(path, &uri, &mtime_str) && uri && mtime_str)
+		{
+		source_mtime = g_ascii_strtoll(mtime_str, NULL, 10);
 		}
 	else
 		{
-		cache_folder = get_thumbnails_cache_dir();
+		DEBUG_1("invalid image found in std cache: %s", path);
+		g_free(uri);
+		uri = NULL;
 		}
+	g_free(mtime_str);
 
-	base_length = strlen(cache_folder);
+	if (uri && strncmp(uri, "file:", strlen("file:")) == 0)
+		{
+		gchar *target;
 
-	if (!cm->list)
+		target = g_filename_from_uri(uri, NULL, NULL);
+		if (target && stat(target, &st_source) == 0 && (gint64)st_source.st_mtime == source_mtime)
+			{
+			valid = TRUE;
+			}
+		g_free(target);
+		}
+	else if (uri)
 		{
-		DEBUG_1("purge chk done.");
-		cm->idle_id = 0;
-		cache_maintain_home_stop(cm);
-		return FALSE;
+		DEBUG_1("thumb uri foreign, doing day check: %s", uri);
+
+		if (st.st_atime >= time(NULL) - (time_t)cc->days * 24 * 60 * 60)
+			{
+			valid = TRUE;
+			}
+		}
+
+	if (!valid)
+		{
+		DEBUG_1("thumb cleaned: %s", path);
+		unlink(path);
 		}
+	else if (cc->manifest_new && !strchr(uri, ' ') && !strchr(uri, '\n'))
+		{
+		entry = g_new(CacheCleanEntry, 1);
+		entry->thumb_mtime = st.st_mtime;
+		entry->thumb_size = st.st_size;
+		entry->source_mtime = source_mtime;
+		entry->uri = uri;
+		uri = NULL;
+
+		g_mutex_lock(&cc->lock);
+		g_hash_table_insert(cc->manifest_new, g_strdup(key), entry);
+		g_mutex_unlock(&cc->lock);
+		}
+
+	g_free(uri);
+}
 
-	fd = cm->list->data;
+static void cache_clean_scan(CacheClean *cc, const gchar *dir)
+{
+	DIR *dp;
+	struct dirent *entry;
+	GPtrArray *names = NULL;
 
-	DEBUG_1("purge chk (%d) \"%s\"", (cm->clear && !cm->metadata), fd->path);
+	dp = opendir(dir);
+	if (!dp) return;
 
-/**
- * It is necessary to disable the file filter when clearing the cache,
- * otherwise the .sim (file similarity) files are not deleted.
- */
-	filter_disable = options->file_filter.disable;
-	options->file_filter.disable = TRUE;
+	if (cc->type == CACHE_CLEAN_HOME)
+		{
+		g_mutex_lock(&cc->lock);
+		cc->dirs = g_list_prepend(cc->dirs, g_strdup(dir));
+		g_mutex_unlock(&cc->lock);
+		}
 
-	if (g_list_find(cm->done_list, fd) == NULL)
+	while ((entry = readdir(dp)) != NULL && !g_atomic_int_get(&cc->cancelled))
 		{
-		cm->done_list = g_list_prepend(cm->done_list, fd);
+		const gchar *name = entry->d_name;
+		gchar *path;
+		struct stat st;
 
-		if (filelist_read(fd, &list, &dlist))
-			{
-			GList *work;
+		if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
 
-			just_done = TRUE;
-			still_have_a_file = FALSE;
+		path = g_build_filename(dir, name, NULL);
+		if (lstat(path, &st) != 0)
+			{
+			g_free(path);
+			continue;
+			}
 
-			work = list;
-			while (work)
+		if (S_ISDIR(st.st_mode))
+			{
+			/* the standard cache folders are flat */
+			if (cc->type == CACHE_CLEAN_HOME)
 				{
-				FileData *fd_list = work->data;
-				gchar *path_buf = g_strdup(fd_list->path);
-				gchar *dot;
-
-				dot = extension_find_dot(path_buf);
-
-				if (dot) *dot = '\0';
-				if ((!cm->metadata && cm->clear) ||
-				    (strlen(path_buf) > base_length && !isfile(path_buf + base_length)) )
-					{
-					if (dot) *dot = '.';
-					if (!unlink_file(path_buf)) log_printf("failed to delete:%s\n", path_buf);
-					}
-				else
-					{
-					still_have_a_file = TRUE;
-					}
-				g_free(path_buf);
-				work = work->next;
+				cache_clean_push(cc, path, NULL);
 				}
+			else
+				{
+				g_free(path);
+				}
+			continue;
+			}
+		g_free(path);
+
+		if (!names) names = g_ptr_array_new_with_free_func(g_free);
+		g_ptr_array_add(names, g_strdup(name));
+
+		if (names->len >= CACHE_CLEAN_BATCH_SIZE)
+			{
+			cache_clean_push(cc, g_strdup(dir), names);
+			names = NULL;
+			}
+		}
+	closedir(dp);
+
+	if (names) cache_clean_push(cc, g_strdup(dir), names);
+}
+
+static gint cache_clean_sort_depth_cb(gconstpointer a, gconstpointer b)
+{
+	return (gint)strlen((const gchar *)b) - (gint)strlen((const gchar *)a);
+}
+
+static gboolean cache_clean_done_idle_cb(gpointer data)
+{
+	CacheClean *cc = data;
+
+	/* the last task may still be returning */
+	g_thread_pool_free(cc->pool, FALSE, TRUE);
+
+	if (cc->manifest_path && !g_atomic_int_get(&cc->cancelled))
+		{
+		if (cc->clear)
+			{
+			unlink(cc->manifest_path);
+			}
+		else if (cc->manifest_new)
+			{
+			cache_clean_manifest_save(cc);
+			}
+		}
+
+	if (cc->done_func) cc->done_func(cc, cc->done_data);
+
+	if (cc->manifest) g_hash_table_destroy(cc->manifest);
+	if (cc->manifest_new) g_hash_table_destroy(cc->manifest_new);
+	g_free(cc->manifest_path);
+	string_list_free(cc->dirs);
+	string_list_free(cc->roots);
+	g_mutex_clear(&cc->lock);
+	g_free(cc->base);
+	g_free(cc);
+
+	return FALSE;
+}
+
+static void cache_clean_finish(CacheClean *cc)
+{
+	GList *work;
+
+	if (!g_atomic_int_get(&cc->cancelled))
+		{
+		/* deepest first, so that folders emptied by the removal go too */
+		cc->dirs = g_list_sort(cc->dirs, cache_clean_sort_depth_cb);
+		for (work = cc->dirs; work; work = work->next)
+			{
+			const gchar *dir = work->data;
+
+			if (strcmp(dir, cc->base) == 0) continue;
+			if (rmdir(dir) == 0) DEBUG_1("removed empty dir: %s", dir);
 			}
 		}
-	options->file_filter.disable = filter_disable;
 
-	filelist_free(list);
+	g_idle_add(cache_clean_done_idle_cb, cc);
+}
 
-	cm->list = g_list_concat(dlist, cm->list);
+static void cache_clean_task_run(gpointer data, gpointer user_data)
+{
+	CacheCleanTask *task = data;
+	CacheClean *cc = user_data;
+	GList *work;
+	guint i;
 
-	if (cm->list && g_list_find(cm->done_list, cm->list->data) != NULL)
+	if (g_atomic_int_get(&cc->cancelled))
 		{
-		/* check if the dir is empty */
+		/* nothing */
+		}
+	else if (!task->dir)
+		{
+		if (cc->manifest_path && !cc->clear)
+			{
+			cc->manifest = cache_clean_manifest_load(cc->manifest_path);
+			cc->manifest_new = cache_clean_manifest_new();
+			}
 
-		if (cm->list->data == fd && just_done)
+		for (work = cc->roots; work; work = work->next)
 			{
-			if (!still_have_a_file && !dlist && cm->list->next && !rmdir_utf8(fd->path))
-				{
-				log_printf("Unable to delete dir: %s\n", fd->path);
-				}
+			cache_clean_push(cc, g_strdup(work->data), NULL);
 			}
-		else
+		}
+	else if (!task->names)
+		{
+		cache_clean_scan(cc, task->dir);
+		}
+	else
+		{
+		for (i = 0; i < task->names->len && !g_atomic_int_get(&cc->cancelled); i++)
 			{
-			/* must re-check for an empty dir */
-			if (isempty(fd->path) && cm->list->next && !rmdir_utf8(fd->path))
+			gchar *path = g_build_filename(task->dir, g_ptr_array_index(task->names, i), NULL);
+
+			if (cc->type == CACHE_CLEAN_HOME)
+				{
+				cache_clean_check_home(cc, path);
+				}
+			else
 				{
-				log_printf("Unable to delete dir: %s\n", fd->path);
+				cache_clean_check_standard(cc, path);
 				}
+			g_free(path);
 			}
-
-		fd = cm->list->data;
-		cm->done_list = g_list_remove(cm->done_list, fd);
-		cm->list = g_list_remove(cm->list, fd);
-		file_data_unref(fd);
+		g_atomic_int_add(&cc->count_done, task->names->len);
 		}
 
-	if (cm->list && !cm->remote)
-		{
-		const gchar *buf;
+	cache_clean_task_free(task);
 
-		fd = cm->list->data;
-		if (strlen(fd->path) > base_length)
+	if (g_atomic_int_dec_and_test(&cc->pending)) cache_clean_finish(cc);
+}
+
+/**
+ * @brief Starts cleaning a cache on a pool of worker threads
+ * @param type which cache
+ * @param metadata for CACHE_CLEAN_HOME, the metadata cache instead of thumbnails
+ * @param clear remove every thumbnail instead of only stale ones
+ * @param done_func called in the main thread when finished or cancelled
+ *
+ * Entries are validated by stat() of their source, the standard cache
+ * reads only the png text chunks. With options->thumbnails.cache_manifest
+ * set, markers of standard thumbnails unchanged since the last run are
+ * taken from a manifest instead of the files.
+ */
+static CacheClean *cache_clean_start(CacheCleanType type, gboolean metadata, gboolean clear,
+				     CacheCleanDoneFunc done_func, gpointer done_data)
+{
+	CacheClean *cc;
+	gchar *base;
+	gchar *path;
+	gchar *dir;
+
+	cc = g_new0(CacheClean, 1);
+	cc->type = type;
+	cc->metadata = metadata;
+	cc->clear = clear;
+	cc->days = 30;
+	cc->done_func = done_func;
+	cc->done_data = done_data;
+	g_mutex_init(&cc->lock);
+
+	if (type == CACHE_CLEAN_HOME)
+		{
+		cc->base = path_from_utf8(metadata ? get_metadata_cache_dir() : get_thumbnails_cache_dir());
+		cc->roots = g_list_prepend(NULL, g_strdup(cc->base));
+		}
+	else
+		{
+		cc->base = path_from_utf8(get_thumbnails_standard_cache_dir());
+
+		base = g_build_filename(get_thumbnails_standard_cache_dir(), THUMB_FOLDER_NORMAL, NULL);
+		cc->roots = g_list_append(cc->roots, path_from_utf8(base));
+		g_free(base);
+		base = g_build_filename(get_thumbnails_standard_cache_dir(), THUMB_FOLDER_LARGE, NULL);
+		cc->roots = g_list_append(cc->roots, path_from_utf8(base));
+		g_free(base);
+		base = g_build_filename(get_thumbnails_standard_cache_dir(), THUMB_FOLDER_FAIL, NULL);
+		cc->roots = g_list_append(cc->roots, path_from_utf8(base));
+		g_free(base);
+
+		if (options->thumbnails.cache_manifest)
 			{
-			buf = fd->path + base_length;
+			dir = g_path_get_dirname(get_thumbnails_cache_dir());
+			path = g_build_filename(dir, CACHE_CLEAN_MANIFEST, NULL);
+			cc->manifest_path = path_from_utf8(path);
+			g_free(path);
+			g_free(dir);
 			}
-		else
+		}
+	cc->base_length = strlen(cc->base);
+
+	cc->pool = g_thread_pool_new(cache_clean_task_run, cc,
+				     CLAMP(g_get_num_processors(), 1, CACHE_CLEAN_THREADS_MAX), FALSE, NULL);
+
+	/* the setup task loads the manifest off the main thread */
+	cache_clean_push(cc, NULL, NULL);
+
+	return cc;
+}
+
+static void cache_clean_cancel(CacheClean *cc)
+{
+	if (cc) g_atomic_int_set(&cc->cancelled, TRUE);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ * cache maintenance
+ *-------------------------------------------------------------------
+ */
+
+static void cache_maintain_home_close(CMData *cm)
+{
+	if (cm->update_id) g_source_remove(cm->update_id);
+	if (cm->gd) generic_dialog_close(cm->gd);
+	g_free(cm);
+}
+
+static void cache_maintain_home_stop(CMData *cm)
+{
+	if (cm->cc)
+		{
+		cache_clean_cancel(cm->cc);
+		if (!cm->remote)
 			{
-			buf = "...";
+			gtk_widget_set_sensitive(cm->button_stop, FALSE);
 			}
-		gtk_entry_set_text(GTK_ENTRY(cm->entry), buf);
+		return;
+		}
+
+	if (cm->update_id)
+		{
+		g_source_remove(cm->update_id);
+		cm->update_id = 0;
+		}
+
+	if (!cm->remote)
+		{
+		gtk_entry_set_text(GTK_ENTRY(cm->entry), _("done"));
+		spinner_set_interval(cm->spinner, -1);
+
+		gtk_widget_set_sensitive(cm->button_stop, FALSE);
+		gtk_widget_set_sensitive(cm->button_close, TRUE);
+		}
+}
+
+static void cache_maintain_home_done_cb(CacheClean *cc, gpointer data)
+{
+	CMData *cm = data;
+
+	DEBUG_1("purge chk done.");
+
+	cm->cc = NULL;
+	if (cm->remote)
+		{
+		g_free(cm);
+		return;
 		}
 
+	cache_maintain_home_stop(cm);
+}
+
+static gboolean cache_maintain_home_update_cb(gpointer data)
+{
+	CMData *cm = data;
+	gchar *buf;
+
+	if (!cm->cc) return TRUE;
+
+	buf = g_strdup_printf(_("%d of %d files checked"),
+			      g_atomic_int_get(&cm->cc->count_done), g_atomic_int_get(&cm->cc->count_total));
+	gtk_entry_set_text(GTK_ENTRY(cm->entry), buf);
+	g_free(buf);
+
 	return TRUE;
 }
 
@@ -274,37 +682,13 @@ static void cache_maintain_home_stop_cb(GenericDialog *gd, gpointer data)
 	cache_maintain_home_stop(cm);
 }
 
-/* sorry for complexity (cm->done_list), but need it to remove empty dirs */
 void cache_maintain_home(gboolean metadata, gboolean clear, GtkWidget *parent)
 {
 	CMData *cm;
-	GList *dlist;
-	FileData *dir_fd;
 	const gchar *msg;
-	const gchar *cache_folder;
 	GtkWidget *hbox;
 
-	if (metadata)
-		{
-		cache_folder = get_metadata_cache_dir();
-		}
-	else
-		{
-		cache_folder = get_thumbnails_cache_dir();
-		}
-
-	dir_fd = file_data_new_dir(cache_folder);
-	if (!filelist_read(dir_fd, NULL, &dlist))
-		{
-		file_data_unref(dir_fd);
-		return;
-		}
-
-	dlist = g_list_append(dlist, dir_fd);
-
 	cm = g_new0(CMData, 1);
-	cm->list = dlist;
-	cm->done_list = NULL;
 	cm->clear = clear;
 	cm->metadata = metadata;
 	cm->remote = FALSE;
@@ -352,42 +736,20 @@ void cache_maintain_home(gboolean metadata, gboolean clear, GtkWidget *parent)
 
 	gtk_widget_show(cm->gd->dialog);
 
-	cm->idle_id = g_idle_add(cache_maintain_home_cb, cm);
+	cm->cc = cache_clean_start(CACHE_CLEAN_HOME, metadata, clear, cache_maintain_home_done_cb, cm);
+	cm->update_id = g_timeout_add(CACHE_CLEAN_UPDATE_INTERVAL, cache_maintain_home_update_cb, cm);
 }
 
 void cache_maintain_home_remote(gboolean metadata, gboolean clear)
 {
 	CMData *cm;
-	GList *dlist;
-	FileData *dir_fd;
-	const gchar *cache_folder;
-
-	if (metadata)
-		{
-		cache_folder = get_metadata_cache_dir();
-		}
-	else
-		{
-		cache_folder = get_thumbnails_cache_dir();
-		}
-
-	dir_fd = file_data_new_dir(cache_folder);
-	if (!filelist_read(dir_fd, NULL, &dlist))
-		{
-		file_data_unref(dir_fd);
-		return;
-		}
-
-	dlist = g_list_append(dlist, dir_fd);
 
 	cm = g_new0(CMData, 1);
-	cm->list = dlist;
-	cm->done_list = NULL;
 	cm->clear = clear;
 	cm->metadata = metadata;
 	cm->remote = TRUE;
 
-	cm->idle_id = g_idle_add(cache_maintain_home_cb, cm);
+	cm->cc = cache_clean_start(CACHE_CLEAN_HOME, metadata, clear, cache_maintain_home_done_cb, cm);
 }
 
 static void cache_file_move(const gchar *src, const gchar *dest)
@@ -556,6 +918,7 @@ struct _CacheOpsData
 	GenericDialog *gd;
 	ThumbLoaderStd *tl;
 	CacheLoader *cl;
+	CacheClean *clean;
 
 	GList *list;
 	GList *list_dir;
@@ -679,6 +1042,7 @@ static gboolean cache_manager_render_file(CacheOpsData *cd)
 					   cache_manager_render_thumb_done_cb,
 					   NULL, cd);
 		thumb_loader_set_cache((ThumbLoader *)cd->tl, TRUE, cd->local, TRUE);
+		thumb_loader_set_priority_class((ThumbLoader *)cd->tl, IMAGE_LOADER_PRIORITY_BATCH);
 		success = thumb_loader_start((ThumbLoader *)cd->tl, fd);
 		if (success)
 			{
@@ -881,13 +1245,20 @@ static void cache_manager_standard_clean_close_cb(GenericDialog *gd, gpointer da
 
 	generic_dialog_close(cd->gd);
 
-	thumb_loader_std_thumb_file_validate_cancel(cd->tl);
-	filelist_free(cd->list);
+	if (cd->idle_id) g_source_remove(cd->idle_id);
 	g_free(cd);
 }
 
 static void cache_manager_standard_clean_done(CacheOpsData *cd)
 {
+	if (cd->clean)
+		{
+		/* finishes in cache_manager_standard_clean_done_cb */
+		cache_clean_cancel(cd->clean);
+		if (!cd->remote) gtk_widget_set_sensitive(cd->button_stop, FALSE);
+		return;
+		}
+
 	if (!cd->remote)
 		{
 		gtk_widget_set_sensitive(cd->button_stop, FALSE);
@@ -901,12 +1272,6 @@ static void cache_manager_standard_clean_done(CacheOpsData *cd)
 		g_source_remove(cd->idle_id);
 		cd->idle_id = 0;
 		}
-
-	thumb_loader_std_thumb_file_validate_cancel(cd->tl);
-	cd->tl = NULL;
-
-	filelist_free(cd->list);
-	cd->list = NULL;
 }
 
 static void cache_manager_standard_clean_stop_cb(GenericDialog *gd, gpointer data)
@@ -916,132 +1281,56 @@ static void cache_manager_standard_clean_stop_cb(GenericDialog *gd, gpointer dat
 	cache_manager_standard_clean_done(cd);
 }
 
-static gint cache_manager_standard_clean_clear_cb(gpointer data)
+static gboolean cache_manager_standard_clean_update_cb(gpointer data)
 {
 	CacheOpsData *cd = data;
+	gint total;
 
-	if (cd->list)
-		{
-		FileData *next_fd;
-
-		next_fd = cd->list->data;
-		cd->list = g_list_remove(cd->list, next_fd);
-
-		DEBUG_1("thumb removed: %s", next_fd->path);
-
-		unlink_file(next_fd->path);
-		file_data_unref(next_fd);
-
-		cd->count_done++;
-		if (!cd->remote)
-			{
-			if (cd->count_total != 0)
-				{
-				gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(cd->progress),
-							      (gdouble)cd->count_done / cd->count_total);
-				}
-			}
+	if (!cd->clean) return TRUE;
 
-		return TRUE;
+	total = g_atomic_int_get(&cd->clean->count_total);
+	if (total != 0)
+		{
+		gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(cd->progress),
+					      (gdouble)g_atomic_int_get(&cd->clean->count_done) / total);
 		}
 
-	cd->idle_id = 0;
-	cache_manager_standard_clean_done(cd);
-	return FALSE;
+	return TRUE;
 }
 
-static void cache_manager_standard_clean_valid_cb(const gchar *path, gboolean valid, gpointer data)
+static void cache_manager_standard_clean_done_cb(CacheClean *cc, gpointer data)
 {
 	CacheOpsData *cd = data;
 
-	if (path)
+	cd->clean = NULL;
+	if (cd->remote)
 		{
-		if (!valid)
-			{
-			DEBUG_1("thumb cleaned: %s", path);
-			unlink_file(path);
-			}
-
-		cd->count_done++;
-		if (!cd->remote)
-			{
-			if (cd->count_total != 0)
-				{
-				gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(cd->progress),
-							      (gdouble)cd->count_done / cd->count_total);
-				}
-			}
+		g_free(cd);
+		return;
 		}
 
-	cd->tl = NULL;
-	if (cd->list)
-		{
-		FileData *next_fd;
-
-		next_fd = cd->list->data;
-		cd->list = g_list_remove(cd->list, next_fd);
-
-		cd->tl = thumb_loader_std_thumb_file_validate(next_fd->path, cd->days,
-							      cache_manager_standard_clean_valid_cb, cd);
-		file_data_unref(next_fd);
-		}
-	else
-		{
-		cache_manager_standard_clean_done(cd);
-		}
+	cache_manager_standard_clean_done(cd);
 }
 
 static void cache_manager_standard_clean_start(GenericDialog *gd, gpointer data)
 {
 	CacheOpsData *cd = data;
-	GList *list;
-	gchar *path;
-	FileData *dir_fd;
 
 	if (!cd->remote)
 	{
-		if (cd->list || !gtk_widget_get_sensitive(cd->button_start)) return;
+		if (cd->clean || !gtk_widget_get_sensitive(cd->button_start)) return;
 
 		gtk_widget_set_sensitive(cd->button_start, FALSE);
 		gtk_widget_set_sensitive(cd->button_stop, TRUE);
 		gtk_widget_set_sensitive(cd->button_close, FALSE);
 
 		gtk_progress_bar_set_text(GTK_PROGRESS_BAR(cd->progress), _("running..."));
-	}
-
-	path = g_build_filename(get_thumbnails_standard_cache_dir(), THUMB_FOLDER_NORMAL, NULL);
-	dir_fd = file_data_new_dir(path);
-	filelist_read(dir_fd, &list, NULL);
-	cd->list = list;
-	file_data_unref(dir_fd);
-	g_free(path);
 
-	path = g_build_filename(get_thumbnails_standard_cache_dir(), THUMB_FOLDER_LARGE, NULL);
-	dir_fd = file_data_new_dir(path);
-	filelist_read(dir_fd, &list, NULL);
-	cd->list = g_list_concat(cd->list, list);
-	file_data_unref(dir_fd);
-	g_free(path);
-
-	path = g_build_filename(get_thumbnails_standard_cache_dir(), THUMB_FOLDER_FAIL, NULL);
-	dir_fd = file_data_new_dir(path);
-	filelist_read(dir_fd, &list, NULL);
-	cd->list = g_list_concat(cd->list, list);
-	file_data_unref(dir_fd);
-	g_free(path);
-
-	cd->count_total = g_list_length(cd->list);
-	cd->count_done = 0;
+		cd->idle_id = g_timeout_add(CACHE_CLEAN_UPDATE_INTERVAL, cache_manager_standard_clean_update_cb, cd);
+	}
 
-	/* start iterating */
-	if (cd->clear)
-		{
-		cd->idle_id = g_idle_add(cache_manager_standard_clean_clear_cb, cd);
-		}
-	else
-		{
-		cache_manager_standard_clean_valid_cb(NULL, TRUE, cd);
-		}
+	cd->clean = cache_clean_start(CACHE_CLEAN_STANDARD, FALSE, cd->clear,
+				      cache_manager_standard_clean_done_cb, cd);
 }
 
 static void cache_manager_standard_clean_start_cb(GenericDialog *gd, gpointer data)
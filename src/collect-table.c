@@ -60,8 +60,11 @@
 #define COLLECT_TABLE_TIP_DELAY_PATH (COLLECT_TABLE_TIP_DELAY * 1.7)
 
 
+/* the store only holds the row number, the CollectInfo of each cell is
+ * resolved arithmetically from ct->index when it is drawn
+ */
 enum {
-	CTABLE_COLUMN_POINTER = 0,
+	CTABLE_COLUMN_ROW = 0,
 	CTABLE_COLUMN_COUNT
 };
 
@@ -77,11 +80,66 @@ static void collection_table_populate_at_new_size(CollectTable *ct, gint w, gint
  *-------------------------------------------------------------------
  */
 
+static void collection_table_index_rebuild(CollectTable *ct)
+{
+	GList *work;
+	gint n = 0;
+
+	if (!ct->index)
+		{
+		ct->index = g_ptr_array_new();
+		ct->positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+		}
+
+	g_ptr_array_set_size(ct->index, 0);
+	g_hash_table_remove_all(ct->positions);
+
+	for (work = ct->cd->list; work; work = work->next)
+		{
+		g_ptr_array_add(ct->index, work->data);
+		g_hash_table_insert(ct->positions, work->data, GINT_TO_POINTER(++n));
+		}
+}
+
+static CollectInfo *collection_table_index_nth(CollectTable *ct, gint n)
+{
+	if (!ct->index || n < 0 || (guint)n >= ct->index->len) return NULL;
+
+	return g_ptr_array_index(ct->index, n);
+}
+
+static gint collection_table_index_by_info(CollectTable *ct, CollectInfo *info)
+{
+	if (!info || !ct->positions) return -1;
+
+	return GPOINTER_TO_INT(g_hash_table_lookup(ct->positions, info)) - 1;
+}
+
+static gint collection_table_row_from_iter(CollectTable *ct, GtkTreeModel *store, GtkTreeIter *iter)
+{
+	gint row;
+
+	gtk_tree_model_get(store, iter, CTABLE_COLUMN_ROW, &row, -1);
+
+	return row;
+}
+
+static void collection_table_row_changed(CollectTable *ct, GtkTreeIter *iter)
+{
+	GtkTreeModel *store;
+	GtkTreePath *tpath;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
+	tpath = gtk_tree_model_get_path(store, iter);
+	gtk_tree_model_row_changed(store, tpath, iter);
+	gtk_tree_path_free(tpath);
+}
+
 static gboolean collection_table_find_position(CollectTable *ct, CollectInfo *info, gint *row, gint *col)
 {
 	gint n;
 
-	n = g_list_index(ct->cd->list, info);
+	n = collection_table_index_by_info(ct, info);
 
 	if (n < 0) return FALSE;
 
@@ -109,22 +167,16 @@ static CollectInfo *collection_table_find_data(CollectTable *ct, gint row, gint
 	GtkTreeModel *store;
 	GtkTreeIter p;
 
-	if (row < 0 || col < 0) return NULL;
+	if (row < 0 || col < 0 || col >= ct->columns) return NULL;
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
-	if (gtk_tree_model_iter_nth_child(store, &p, NULL, row))
+	if (iter)
 		{
-		GList *list;
-
-		gtk_tree_model_get(store, &p, CTABLE_COLUMN_POINTER, &list, -1);
-		if (!list) return NULL;
-
-		if (iter) *iter = p;
-
-		return g_list_nth_data(list, col);
+		store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
+		if (!gtk_tree_model_iter_nth_child(store, &p, NULL, row)) return NULL;
+		*iter = p;
 		}
 
-	return NULL;
+	return collection_table_index_nth(ct, row * ct->columns + col);
 }
 
 static CollectInfo *collection_table_find_data_by_coord(CollectTable *ct, gint x, gint y, GtkTreeIter *iter)
@@ -133,7 +185,6 @@ static CollectInfo *collection_table_find_data_by_coord(CollectTable *ct, gint x
 	GtkTreeViewColumn *column;
 	GtkTreeModel *store;
 	GtkTreeIter row;
-	GList *list;
 	gint n;
 
 	if (!gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(ct->listview), x, y,
@@ -144,12 +195,11 @@ static CollectInfo *collection_table_find_data_by_coord(CollectTable *ct, gint x
 	gtk_tree_model_get_iter(store, &row, tpath);
 	gtk_tree_path_free(tpath);
 
-	gtk_tree_model_get(store, &row, CTABLE_COLUMN_POINTER, &list, -1);
-	if (!list) return NULL;
-
 	n = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(column), "column_number"));
+	if (n >= ct->columns) return NULL;
+
 	if (iter) *iter = row;
-	return g_list_nth_data(list, n);
+	return collection_table_index_nth(ct, collection_table_row_from_iter(ct, store, &row) * ct->columns + n);
 }
 
 static guint collection_table_list_count(CollectTable *ct, gint64 *bytes)
@@ -286,29 +336,20 @@ static gint collection_table_get_icon_width(CollectTable *ct)
 
 static void collection_table_selection_set(CollectTable *ct, CollectInfo *info, SelectionType value, GtkTreeIter *iter)
 {
-	GtkTreeModel *store;
-	GList *list;
-
 	if (!info) return;
 
 	if (info->flag_mask == value) return;
 	info->flag_mask = value;
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
 	if (iter)
 		{
-		gtk_tree_model_get(store, iter, CTABLE_COLUMN_POINTER, &list, -1);
-		if (list) gtk_list_store_set(GTK_LIST_STORE(store), iter, CTABLE_COLUMN_POINTER, list, -1);
+		collection_table_row_changed(ct, iter);
 		}
 	else
 		{
 		GtkTreeIter row;
 
-		if (collection_table_find_iter(ct, info, &row, NULL))
-			{
-			gtk_tree_model_get(store, &row, CTABLE_COLUMN_POINTER, &list, -1);
-			if (list) gtk_list_store_set(GTK_LIST_STORE(store), &row, CTABLE_COLUMN_POINTER, list, -1);
-			}
+		if (collection_table_find_iter(ct, info, &row, NULL)) collection_table_row_changed(ct, &row);
 		}
 }
 
@@ -340,7 +381,7 @@ static void collection_table_verify_selections(CollectTable *ct)
 		{
 		CollectInfo *info = work->data;
 		work = work->next;
-		if (!g_list_find(ct->cd->list, info))
+		if (collection_table_index_by_info(ct, info) < 0)
 			{
 			ct->selection = g_list_remove(ct->selection, info);
 			}
@@ -466,7 +507,7 @@ static void collection_table_select_region_util(CollectTable *ct, CollectInfo *s
 		GList *work;
 		CollectInfo *info;
 
-		if (g_list_index(ct->cd->list, start) > g_list_index(ct->cd->list, end))
+		if (collection_table_index_by_info(ct, start) > collection_table_index_by_info(ct, end))
 			{
 			info = start;
 			start = end;
@@ -1168,7 +1209,7 @@ static void collection_table_move_focus(CollectTable *ct, gint row, gint col, gb
 
 		/* if we moved beyond the last image, go to the last image */
 
-		l = g_list_length(ct->cd->list);
+		l = ct->index ? ct->index->len : 0;
 		if (ct->rows > 1) l -= (ct->rows - 1) * ct->columns;
 		if (new_col >= l) new_col = l - 1;
 		}
@@ -1406,14 +1447,12 @@ static CollectInfo *collection_table_insert_find(CollectTable *ct, CollectInfo *
 	if (gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(ct->listview), x, y,
 					  &tpath, &column, NULL, NULL))
 		{
-		GList *list;
 		gint n;
 
 		gtk_tree_model_get_iter(store, &iter, tpath);
-		gtk_tree_model_get(store, &iter, CTABLE_COLUMN_POINTER, &list, -1);
 
 		n = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(column), "column_number"));
-		info = g_list_nth_data(list, n);
+		info = collection_table_find_data(ct, collection_table_row_from_iter(ct, store, &iter), n, NULL);
 
 		if (info)
 			{
@@ -1795,49 +1834,17 @@ static gboolean collection_table_leave_cb(GtkWidget *widget, GdkEventCrossing *e
  *-------------------------------------------------------------------
  */
 
-static gboolean collection_table_destroy_node_cb(GtkTreeModel *store, GtkTreePath *tpath, GtkTreeIter *iter, gpointer data)
-{
-	GList *list;
-
-	gtk_tree_model_get(store, iter, CTABLE_COLUMN_POINTER, &list, -1);
-	g_list_free(list);
-
-	return FALSE;
-}
-
-static void collection_table_clear_store(CollectTable *ct)
-{
-	GtkTreeModel *store;
-
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
-	gtk_tree_model_foreach(store, collection_table_destroy_node_cb, NULL);
-
-	gtk_list_store_clear(GTK_LIST_STORE(store));
-}
-
-static GList *collection_table_add_row(CollectTable *ct, GtkTreeIter *iter)
-{
-	GtkListStore *store;
-	GList *list = NULL;
-	gint i;
-
-	for (i = 0; i < ct->columns; i++) list = g_list_prepend(list, NULL);
-
-	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview)));
-	gtk_list_store_append(store, iter);
-	gtk_list_store_set(store, iter, CTABLE_COLUMN_POINTER, list, -1);
-
-	return list;
-}
-
 static void collection_table_populate(CollectTable *ct, gboolean resize)
 {
-	gint row;
-	GList *work;
+	GtkTreeModel *store;
+	GtkTreeIter iter;
+	gint rows;
+	gint r;
 
+	collection_table_index_rebuild(ct);
 	collection_table_verify_selections(ct);
 
-	collection_table_clear_store(ct);
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
 
 	if (resize)
 		{
@@ -1867,28 +1874,33 @@ static void collection_table_populate(CollectTable *ct, gboolean resize)
 							     "show_text", ct->show_text || ct->show_stars, NULL);
 				}
 			}
-		if (gtk_widget_get_realized(ct->listview)) gtk_tree_view_columns_autosize(GTK_TREE_VIEW(ct->listview));
 		}
 
-	row = -1;
-	work = ct->cd->list;
-	while (work)
-		{
-		GList *list;
-		GtkTreeIter iter;
-
-		row++;
+	/* the layout is arithmetic, only the number of rows has to match */
+	rows = (ct->columns > 0) ? (ct->index->len + ct->columns - 1) / ct->columns : 0;
+	r = gtk_tree_model_iter_n_children(store, NULL);
 
-		list = collection_table_add_row(ct, &iter);
-		while (work && list)
+	while (r > rows)
+		{
+		r--;
+		if (gtk_tree_model_iter_nth_child(store, &iter, NULL, r))
 			{
-			list->data = work->data;
-			list = list->next;
-			work = work->next;
+			gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
 			}
 		}
+	while (r < rows)
+		{
+		gtk_list_store_insert_with_values(GTK_LIST_STORE(store), &iter, r, CTABLE_COLUMN_ROW, r, -1);
+		r++;
+		}
 
-	ct->rows = row + 1;
+	ct->rows = rows;
+
+	/* existing rows are not touched, so their heights have to be invalidated,
+	 * the tree view then measures the visible rows first and the rest when idle
+	 */
+	if (gtk_widget_get_realized(ct->listview)) gtk_tree_view_columns_autosize(GTK_TREE_VIEW(ct->listview));
+	gtk_widget_queue_draw(ct->listview);
 
 	collection_table_update_focus(ct);
 	collection_table_update_status(ct);
@@ -1913,71 +1925,6 @@ static void collection_table_populate_at_new_size(CollectTable *ct, gint w, gint
 	DEBUG_1("col tab pop cols=%d rows=%d", ct->columns, ct->rows);
 }
 
-static void collection_table_sync(CollectTable *ct)
-{
-	GtkTreeModel *store;
-	GtkTreeIter iter;
-	GList *work;
-	gint r, c;
-
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
-
-	r = -1;
-	c = 0;
-
-	work = ct->cd->list;
-	while (work)
-		{
-		GList *list;
-		r++;
-		c = 0;
-		if (gtk_tree_model_iter_nth_child(store, &iter, NULL, r))
-			{
-			gtk_tree_model_get(store, &iter, CTABLE_COLUMN_POINTER, &list, -1);
-			gtk_list_store_set(GTK_LIST_STORE(store), &iter, CTABLE_COLUMN_POINTER, list, -1);
-			}
-		else
-			{
-			list = collection_table_add_row(ct, &iter);
-			}
-
-		while (list)
-			{
-			CollectInfo *info;
-			if (work)
-				{
-				info = work->data;
-				work = work->next;
-				c++;
-				}
-			else
-				{
-				info = NULL;
-				}
-			if (list)
-				{
-				list->data = info;
-				list = list->next;
-				}
-			}
-		}
-
-	r++;
-	while (gtk_tree_model_iter_nth_child(store, &iter, NULL, r))
-		{
-		GList *list;
-
-		gtk_tree_model_get(store, &iter, CTABLE_COLUMN_POINTER, &list, -1);
-		gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
-		g_list_free(list);
-		}
-
-	ct->rows = r;
-
-	collection_table_update_focus(ct);
-	collection_table_update_status(ct);
-}
-
 static gboolean collection_table_sync_idle_cb(gpointer data)
 {
 	CollectTable *ct = data;
@@ -1986,7 +1933,7 @@ static gboolean collection_table_sync_idle_cb(gpointer data)
 	g_source_remove(ct->sync_idle_id);
 	ct->sync_idle_id = 0;
 
-	collection_table_sync(ct);
+	collection_table_populate(ct, FALSE);
 	return FALSE;
 }
 
@@ -2121,15 +2068,7 @@ void collection_table_file_update(CollectTable *ct, CollectInfo *info)
 
 	collection_table_update_extras(ct, TRUE, value);
 
-	if (collection_table_find_iter(ct, info, &iter, NULL))
-		{
-		GtkTreeModel *store;
-		GList *list;
-
-		store = gtk_tree_view_get_model(GTK_TREE_VIEW(ct->listview));
-		gtk_tree_model_get(store, &iter, CTABLE_COLUMN_POINTER, &list, -1);
-		gtk_list_store_set(GTK_LIST_STORE(store), &iter, CTABLE_COLUMN_POINTER, list, -1);
-		}
+	if (collection_table_find_iter(ct, info, &iter, NULL)) collection_table_row_changed(ct, &iter);
 }
 
 void collection_table_file_add(CollectTable *ct, CollectInfo *info)
@@ -2490,7 +2429,6 @@ static void collection_table_cell_data_cb(GtkTreeViewColumn *tree_column, GtkCel
 	ColumnData *cd = data;
 	CollectTable *ct;
 	GtkStyle *style;
-	GList *list;
 	CollectInfo *info;
 	GdkColor color_fg;
 	GdkColor color_bg;
@@ -2499,8 +2437,6 @@ static void collection_table_cell_data_cb(GtkTreeViewColumn *tree_column, GtkCel
 
 	ct = cd->ct;
 
-	gtk_tree_model_get(tree_model, iter, CTABLE_COLUMN_POINTER, &list, -1);
-
 #if GTK_CHECK_VERSION(3,0,0)
 	/* FIXME this is a primitive hack to stop a crash.
 	 * When compiled with GTK3, if a Collection window containing
@@ -2509,7 +2445,7 @@ static void collection_table_cell_data_cb(GtkTreeViewColumn *tree_column, GtkCel
 	 */
 	if (cd->number == COLLECT_TABLE_MAX_COLUMNS) return;
 #endif
-	info = g_list_nth_data(list, cd->number);
+	info = collection_table_find_data(ct, collection_table_row_from_iter(ct, tree_model, iter), cd->number, NULL);
 
 	style = gtk_widget_get_style(ct->listview);
 	if (info && (info->flag_mask & SELECTION_SELECTED) )
@@ -2647,6 +2583,9 @@ static void collection_table_destroy(GtkWidget *widget, gpointer data)
 	tip_unschedule(ct);
 	collection_table_scroll(ct, FALSE);
 
+	if (ct->index) g_ptr_array_free(ct->index, TRUE);
+	if (ct->positions) g_hash_table_destroy(ct->positions);
+
 	g_free(ct);
 }
 
@@ -2675,7 +2614,7 @@ CollectTable *collection_table_new(CollectionData *cd)
 	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(ct->scrolled),
 				       GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
 
-	store = gtk_list_store_new(1, G_TYPE_POINTER);
+	store = gtk_list_store_new(CTABLE_COLUMN_COUNT, G_TYPE_INT);
 	ct->listview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
 	g_object_unref(store);
 
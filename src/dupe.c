@@ -59,6 +59,7 @@
 #define DUPE_DEF_WIDTH 800
 #define DUPE_DEF_HEIGHT 400
 #define DUPE_PROGRESS_PULSE_STEP 0.0001
+#define DUPE_DIMENSIONS_CHUNK 64 /**< items per call when reading dimensions */
 
 /** column assignment order (simply change them here)
  */
@@ -439,6 +440,8 @@ static void dupe_item_free(DupeItem *di)
 	file_data_unref(di->fd);
 	image_sim_free(di->simd);
 	g_free(di->md5sum);
+	g_free(di->sort_name_key);
+	g_free(di->sort_path_key);
 	if (di->pixbuf) g_object_unref(di->pixbuf);
 
 	g_free(di);
@@ -611,29 +614,23 @@ static gint dupe_listview_find_item(GtkListStore *store, DupeItem *item, GtkTree
 	return -1;
 }
 
-static void dupe_listview_add(DupeWindow *dw, DupeItem *parent, DupeItem *child)
+/**
+ * @brief Appends the row of \a parent, or of its \a child when set, to \a store
+ *
+ * All display strings and the rank sort key are worked out here, once per row.
+ */
+static void dupe_listview_add(DupeWindow *dw, GtkListStore *store, DupeItem *parent, DupeItem *child, gboolean color_set, gint set)
 {
 	DupeItem *di;
-	gint row;
 	gchar *text[DUPE_COLUMN_COUNT];
-	GtkListStore *store;
-	GtkTreeIter iter;
-	gboolean color_set = FALSE;
 	gint rank;
 
 	if (!parent) return;
 
-	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)));
-
 	if (child)
 		{
 		DupeMatch *dm;
 
-		row = dupe_listview_find_item(store, parent, &iter);
-		gtk_tree_model_get(GTK_TREE_MODEL(store), &iter, DUPE_COLUMN_COLOR, &color_set, -1);
-
-		row++;
-
 		if (child->group)
 			{
 			dm = child->group->data;
@@ -647,17 +644,6 @@ static void dupe_listview_add(DupeWindow *dw, DupeItem *parent, DupeItem *child)
 		}
 	else
 		{
-		if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(store), &iter))
-			{
-			gtk_tree_model_get(GTK_TREE_MODEL(store), &iter, DUPE_COLUMN_COLOR, &color_set, -1);
-			color_set = !color_set;
-			dw->set_count++;
-			}
-		else
-			{
-			color_set = FALSE;
-			}
-		row = 0;
 		rank = 0;
 		}
 
@@ -676,8 +662,9 @@ static void dupe_listview_add(DupeWindow *dw, DupeItem *parent, DupeItem *child)
 		text[DUPE_COLUMN_RANK] = g_strdup_printf("%d%s", rank, (di->second) ? " (2)" : "");
 		}
 
-	text[DUPE_COLUMN_THUMB] = "";
-	text[DUPE_COLUMN_NAME] = (gchar *)di->fd->name;
+	/* rows without a numeric rank sort after all others */
+	di->sort_rank = (rank == 0) ? 101 : rank;
+
 	text[DUPE_COLUMN_SIZE] = text_from_size(di->fd->size);
 	text[DUPE_COLUMN_DATE] = (gchar *)text_from_time(di->fd->date);
 	if (di->width > 0 && di->height > 0)
@@ -688,21 +675,18 @@ static void dupe_listview_add(DupeWindow *dw, DupeItem *parent, DupeItem *child)
 		{
 		text[DUPE_COLUMN_DIMENSIONS] = g_strdup("");
 		}
-	text[DUPE_COLUMN_PATH] = di->fd->path;
-	text[DUPE_COLUMN_COLOR] = NULL;
 
-	gtk_list_store_insert(store, &iter, row);
-	gtk_list_store_set(store, &iter,
+	gtk_list_store_insert_with_values(store, NULL, -1,
 				DUPE_COLUMN_POINTER, di,
 				DUPE_COLUMN_RANK, text[DUPE_COLUMN_RANK],
-				DUPE_COLUMN_THUMB, NULL,
-				DUPE_COLUMN_NAME, text[DUPE_COLUMN_NAME],
+				DUPE_COLUMN_THUMB, (dw->show_thumbs) ? di->pixbuf : NULL,
+				DUPE_COLUMN_NAME, di->fd->name,
 				DUPE_COLUMN_SIZE, text[DUPE_COLUMN_SIZE],
 				DUPE_COLUMN_DATE, text[DUPE_COLUMN_DATE],
 				DUPE_COLUMN_DIMENSIONS, text[DUPE_COLUMN_DIMENSIONS],
-				DUPE_COLUMN_PATH, text[DUPE_COLUMN_PATH],
+				DUPE_COLUMN_PATH, di->fd->path,
 				DUPE_COLUMN_COLOR, color_set,
-				DUPE_COLUMN_SET, dw->set_count,
+				DUPE_COLUMN_SET, set,
 				-1);
 
 	g_free(text[DUPE_COLUMN_RANK]);
@@ -712,38 +696,61 @@ static void dupe_listview_add(DupeWindow *dw, DupeItem *parent, DupeItem *child)
 
 static void dupe_listview_select_dupes(DupeWindow *dw, DupeSelectType parents);
 
-static void dupe_listview_populate(DupeWindow *dw)
+/*
+ * The result list is filled in chunks from an idle callback, so the first
+ * groups are shown at once and the window stays responsive with many
+ * thousands of groups. Rows are appended in display order with sorting
+ * switched off; a user selected sort column is restored at the end.
+ */
+
+#define DUPE_POPULATE_CHUNK 250 /**< groups appended per idle call */
+
+static void dupe_listview_populate_restore_sort(DupeWindow *dw)
+{
+	if (!dw->populate_sorted) return;
+
+	dw->populate_sorted = FALSE;
+	gtk_tree_sortable_set_sort_column_id(dw->sortable, dw->populate_sort_column, dw->populate_sort_order);
+}
+
+/**
+ * @brief Appends up to \a count groups to the list
+ * @returns TRUE if groups remain
+ */
+static gboolean dupe_listview_populate_chunk(DupeWindow *dw, gint count)
 {
 	GtkListStore *store;
-	GList *work;
 
 	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)));
-	gtk_list_store_clear(store);
 
-	work = g_list_last(dw->dupes);
-	while (work)
+	while (dw->populate_point && count > 0)
 		{
-		DupeItem *parent = work->data;
-		GList *temp;
+		DupeItem *parent = dw->populate_point->data;
+		GList *work;
 
-		dupe_listview_add(dw, parent, NULL);
+		dupe_listview_add(dw, store, parent, NULL, dw->populate_color, dw->populate_set);
 
-		temp = g_list_last(parent->group);
-		while (temp)
+		work = parent->group;
+		while (work)
 			{
-			DupeMatch *dm = temp->data;
-			DupeItem *child;
-
-			child = dm->di;
+			DupeMatch *dm = work->data;
 
-			dupe_listview_add(dw, parent, child);
+			dupe_listview_add(dw, store, parent, dm->di, dw->populate_color, dw->populate_set);
 
-			temp = temp->prev;
+			work = work->next;
 			}
 
-		work = work->prev;
+		dw->populate_color = !dw->populate_color;
+		dw->populate_set--;
+
+		dw->populate_point = dw->populate_point->next;
+		count--;
 		}
 
+	if (dw->populate_point) return TRUE;
+
+	dupe_listview_populate_restore_sort(dw);
+
 	gtk_tree_view_columns_autosize(GTK_TREE_VIEW(dw->listview));
 
 	if (options->duplicates_select_type == DUPE_SELECT_GROUP1)
@@ -755,6 +762,75 @@ static void dupe_listview_populate(DupeWindow *dw)
 		dupe_listview_select_dupes(dw, DUPE_SELECT_GROUP2);
 		}
 
+	return FALSE;
+}
+
+static gboolean dupe_listview_populate_cb(gpointer data)
+{
+	DupeWindow *dw = data;
+
+	if (dupe_listview_populate_chunk(dw, DUPE_POPULATE_CHUNK)) return TRUE;
+
+	dw->populate_id = 0;
+	return FALSE;
+}
+
+/**
+ * @brief Completes a pending list fill immediately
+ *
+ * Called before anything changes \a dw->dupes or the groups in it.
+ */
+static void dupe_listview_populate_finish(DupeWindow *dw)
+{
+	if (!dw->populate_id) return;
+
+	g_source_remove(dw->populate_id);
+	dw->populate_id = 0;
+
+	dupe_listview_populate_chunk(dw, G_MAXINT);
+}
+
+/**
+ * @brief Drops a pending list fill, used when the list is about to be cleared
+ */
+static void dupe_listview_populate_cancel(DupeWindow *dw)
+{
+	if (!dw->populate_id) return;
+
+	g_source_remove(dw->populate_id);
+	dw->populate_id = 0;
+	dw->populate_point = NULL;
+
+	dupe_listview_populate_restore_sort(dw);
+}
+
+static void dupe_listview_populate(DupeWindow *dw)
+{
+	GtkListStore *store;
+	gint count;
+
+	dupe_listview_populate_cancel(dw);
+
+	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)));
+	gtk_list_store_clear(store);
+
+	/* the top group gets the highest set number, the bottom one the lowest */
+	count = g_list_length(dw->dupes);
+	if (count > 0) dw->set_count += count - 1;
+	dw->populate_set = dw->set_count;
+	dw->populate_color = (count > 0 && (count - 1) % 2 != 0);
+	dw->populate_point = dw->dupes;
+
+	dw->populate_sorted = gtk_tree_sortable_get_sort_column_id(dw->sortable, &dw->populate_sort_column, &dw->populate_sort_order);
+	if (dw->populate_sorted)
+		{
+		gtk_tree_sortable_set_sort_column_id(dw->sortable, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+		}
+
+	if (dupe_listview_populate_chunk(dw, DUPE_POPULATE_CHUNK))
+		{
+		dw->populate_id = g_idle_add(dupe_listview_populate_cb, dw);
+		}
 }
 
 static void dupe_listview_remove(DupeWindow *dw, DupeItem *di)
@@ -1102,6 +1178,8 @@ static void dupe_match_rank_update(DupeItem *parent)
 		{
 		parent->group_rank = 0.0;
 		}
+
+	parent->group_count = c;
 }
 
 static DupeItem *dupe_match_find_parent(DupeWindow *dw, DupeItem *child)
@@ -1341,8 +1419,8 @@ static gint dupe_match_totals_sort_cb(gconstpointer a, gconstpointer b)
 	DupeItem *da = (DupeItem *)a;
 	DupeItem *db = (DupeItem *)b;
 
-	if (g_list_length(da->group) > g_list_length(db->group)) return -1;
-	if (g_list_length(da->group) < g_list_length(db->group)) return 1;
+	if (da->group_count > db->group_count) return -1;
+	if (da->group_count < db->group_count) return 1;
 
 	if (da->group_rank < db->group_rank) return -1;
 	if (da->group_rank > db->group_rank) return 1;
@@ -2049,6 +2127,8 @@ static void dupe_listview_set_thumb(DupeWindow *dw, DupeItem *di, GtkTreeIter *i
 static void dupe_thumb_do(DupeWindow *dw)
 {
 	DupeItem *di;
+	GtkTreeIter iter;
+	GtkTreePath *tpath;
 
 	if (!dw->thumb_loader || !dw->thumb_item) return;
 	di = dw->thumb_item;
@@ -2056,7 +2136,16 @@ static void dupe_thumb_do(DupeWindow *dw)
 	if (di->pixbuf) g_object_unref(di->pixbuf);
 	di->pixbuf = thumb_loader_get_pixbuf(dw->thumb_loader);
 
-	dupe_listview_set_thumb(dw, di, NULL);
+	tpath = (dw->thumb_row) ? gtk_tree_row_reference_get_path(dw->thumb_row) : NULL;
+	if (tpath && gtk_tree_model_get_iter(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)), &iter, tpath))
+		{
+		dupe_listview_set_thumb(dw, di, &iter);
+		}
+	else
+		{
+		dupe_listview_set_thumb(dw, di, NULL);
+		}
+	gtk_tree_path_free(tpath);
 }
 
 static void dupe_thumb_error_cb(ThumbLoader *tl, gpointer data)
@@ -2075,35 +2164,62 @@ static void dupe_thumb_done_cb(ThumbLoader *tl, gpointer data)
 	dupe_thumb_step(dw);
 }
 
+/**
+ * @brief Loads the next missing thumbnail
+ *
+ * Only the rows currently scrolled into view are considered, the rest
+ * are picked up by dupe_thumb_scroll_cb() when the list is scrolled.
+ */
 static void dupe_thumb_step(DupeWindow *dw)
 {
 	GtkTreeModel *store;
 	GtkTreeIter iter;
+	GtkTreePath *start_path;
+	GtkTreePath *end_path;
 	DupeItem *di = NULL;
-	gboolean valid;
 	gint row = 0;
 	gint length = 0;
 
 	store = gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview));
-	valid = gtk_tree_model_get_iter_first(store, &iter);
 
-	while (!di && valid)
+	gtk_tree_row_reference_free(dw->thumb_row);
+	dw->thumb_row = NULL;
+
+	if (gtk_tree_view_get_visible_range(GTK_TREE_VIEW(dw->listview), &start_path, &end_path))
 		{
-		GdkPixbuf *pixbuf;
+		gboolean valid;
+		gint i;
+
+		length = gtk_tree_path_get_indices(end_path)[0] - gtk_tree_path_get_indices(start_path)[0] + 1;
+		valid = gtk_tree_model_get_iter(store, &iter, start_path);
 
-		length++;
-		gtk_tree_model_get(store, &iter, DUPE_COLUMN_POINTER, &di, DUPE_COLUMN_THUMB, &pixbuf, -1);
-		if (pixbuf || di->pixbuf)
+		gtk_tree_path_free(start_path);
+		gtk_tree_path_free(end_path);
+
+		for (i = 0; valid && i < length; i++)
 			{
-			if (!pixbuf) gtk_list_store_set(GTK_LIST_STORE(store), &iter, DUPE_COLUMN_THUMB, di->pixbuf, -1);
-			row++;
-			di = NULL;
+			DupeItem *di_n;
+			GdkPixbuf *pixbuf;
+
+			gtk_tree_model_get(store, &iter, DUPE_COLUMN_POINTER, &di_n, DUPE_COLUMN_THUMB, &pixbuf, -1);
+			if (pixbuf || di_n->pixbuf)
+				{
+				if (!pixbuf) gtk_list_store_set(GTK_LIST_STORE(store), &iter, DUPE_COLUMN_THUMB, di_n->pixbuf, -1);
+				row++;
+				}
+			else if (!di)
+				{
+				GtkTreePath *tpath;
+
+				di = di_n;
+				tpath = gtk_tree_model_get_path(store, &iter);
+				dw->thumb_row = gtk_tree_row_reference_new(store, tpath);
+				gtk_tree_path_free(tpath);
+				}
+			if (pixbuf) g_object_unref(pixbuf);
+
+			valid = gtk_tree_model_iter_next(store, &iter);
 			}
-		valid = gtk_tree_model_iter_next(store, &iter);
-		}
-	if (valid)
-		{
-		while (gtk_tree_model_iter_next(store, &iter)) length++;
 		}
 
 	if (!di)
@@ -2139,6 +2255,32 @@ static void dupe_thumb_step(DupeWindow *dw)
 		}
 }
 
+static gboolean dupe_thumb_scroll_idle_cb(gpointer data)
+{
+	DupeWindow *dw = data;
+
+	dw->thumb_scroll_id = 0;
+
+	if (dw->show_thumbs && !dw->working && !dw->thumb_loader) dupe_thumb_step(dw);
+
+	return FALSE;
+}
+
+/**
+ * @brief Called when the list is scrolled, resized or rows are added
+ *
+ * A running thumb loader picks up the new visible range by itself
+ * when it completes, otherwise a new step is started from idle.
+ */
+static void dupe_thumb_scroll_cb(GtkAdjustment *adjustment, gpointer data)
+{
+	DupeWindow *dw = data;
+
+	if (!dw->show_thumbs || dw->thumb_scroll_id) return;
+
+	dw->thumb_scroll_id = g_idle_add(dupe_thumb_scroll_idle_cb, dw);
+}
+
 /*
  * ------------------------------------------------------------------
  * Dupe checking loop
@@ -2147,6 +2289,8 @@ static void dupe_thumb_step(DupeWindow *dw)
 
 static void dupe_check_stop(DupeWindow *dw)
 {
+	dupe_listview_populate_finish(dw);
+
 	if (dw->idle_id > 0)
 		{
 		g_source_remove(dw->idle_id);
@@ -2192,9 +2336,16 @@ static void dupe_check_stop(DupeWindow *dw)
 
 	thumb_loader_free(dw->thumb_loader);
 	dw->thumb_loader = NULL;
+	gtk_tree_row_reference_free(dw->thumb_row);
+	dw->thumb_row = NULL;
 
 	image_loader_free(dw->img_loader);
 	dw->img_loader = NULL;
+
+	image_load_dimensions_probe_list_free(dw->probe_list);
+	dw->probe_list = NULL;
+	g_list_free(dw->probe_items);
+	dw->probe_items = NULL;
 }
 
 static void dupe_check_stop_cb(GtkWidget *widget, gpointer data)
@@ -2243,6 +2394,38 @@ static void dupe_loader_done_cb(ImageLoader *il, gpointer data)
 	dw->idle_id = g_idle_add(dupe_check_cb, dw);
 }
 
+static void dupe_probe_done_cb(ImageLoadProbeList *pl, gpointer data)
+{
+	DupeWindow *dw = data;
+	GList *work;
+	guint i;
+
+	for (work = dw->probe_items, i = 0; work; work = work->next, i++)
+		{
+		DupeItem *di = work->data;
+
+		/* removed while the headers were read */
+		if (!di) continue;
+
+		if (!image_load_dimensions_probe_list_get(pl, i, &di->width, &di->height))
+			{
+			image_load_dimensions(di->fd, &di->width, &di->height);
+			}
+		di->dimensions = (di->width << 16) + di->height;
+		if (options->thumbnails.enable_caching)
+			{
+			dupe_item_write_cache(di);
+			}
+		}
+
+	image_load_dimensions_probe_list_free(dw->probe_list);
+	dw->probe_list = NULL;
+	g_list_free(dw->probe_items);
+	dw->probe_items = NULL;
+
+	dw->idle_id = g_idle_add(dupe_check_cb, dw);
+}
+
 static void dupe_setup_reset(DupeWindow *dw)
 {
 	dw->setup_point = NULL;
@@ -2314,9 +2497,14 @@ static gboolean create_checksums_dimensions(DupeWindow *dw, GList *list)
 		if ((dw->match_mask & DUPE_MATCH_DIM)  )
 			{
 			/* Dimensions only */
+			GList *chunk = NULL;
+			gint n = 0;
+
 			if (!dw->setup_point) dw->setup_point = list;
 
-			while (dw->setup_point)
+			/* up to DUPE_DIMENSIONS_CHUNK items per call, the ones not in the
+			 * cache are probed together from their file headers */
+			while (dw->setup_point && n < DUPE_DIMENSIONS_CHUNK)
 				{
 				DupeItem *di = dw->setup_point->data;
 
@@ -2324,27 +2512,41 @@ static gboolean create_checksums_dimensions(DupeWindow *dw, GList *list)
 				dw->setup_n++;
 				if (di->width == 0 && di->height == 0)
 					{
-					dupe_window_update_progress(dw, _("Reading dimensions..."),
-						dw->setup_count == 0 ? 0.0 : (gdouble)(dw->setup_n - 1) / dw->setup_count, FALSE);
+					n++;
 
 					if (options->thumbnails.enable_caching)
 						{
 						dupe_item_read_cache(di);
-						if (di->width != 0 || di->height != 0)
-							{
-							return TRUE;
-							}
+						if (di->width != 0 || di->height != 0) continue;
 						}
 
-					image_load_dimensions(di->fd, &di->width, &di->height);
-					di->dimensions = (di->width << 16) + di->height;
-					if (options->thumbnails.enable_caching)
-						{
-						dupe_item_write_cache(di);
-						}
-					return TRUE;
+					chunk = g_list_prepend(chunk, di);
 					}
 				}
+
+			if (n > 0)
+				{
+				GList *fd_list = NULL;
+				GList *work;
+
+				dupe_window_update_progress(dw, _("Reading dimensions..."),
+					dw->setup_count == 0 ? 0.0 : (gdouble)(dw->setup_n - 1) / dw->setup_count, FALSE);
+
+				dw->probe_items = g_list_reverse(chunk);
+				for (work = dw->probe_items; work; work = work->next)
+					{
+					DupeItem *di = work->data;
+
+					fd_list = g_list_prepend(fd_list, di->fd);
+					}
+				fd_list = g_list_reverse(fd_list);
+
+				/* the check continues from dupe_probe_done_cb */
+				dw->probe_list = image_load_dimensions_probe_list(fd_list, dupe_probe_done_cb, dw);
+				g_list_free(fd_list);
+				dw->idle_id = 0;
+				return TRUE;
+				}
 			dupe_setup_reset(dw);
 			}
 
@@ -2391,14 +2593,15 @@ static gboolean dupe_check_cb(gpointer data)
 			{
 			if (create_checksums_dimensions(dw, dw->list))
 				{
-				return TRUE;
+				/* the idle is dropped while dimensions are probed */
+				return (dw->idle_id != 0);
 				}
 			}
 		if (dw->second_list)
 			{
 			if (create_checksums_dimensions(dw, dw->second_list))
 				{
-				return TRUE;
+				return (dw->idle_id != 0);
 				}
 			}
 		if ((dw->match_mask & DUPE_MATCH_SIM_HIGH ||
@@ -2431,6 +2634,7 @@ static gboolean dupe_check_cb(gpointer data)
 
 					dw->img_loader = image_loader_new(di->fd);
 					image_loader_set_buffer_size(dw->img_loader, 8);
+					image_loader_set_priority_class(dw->img_loader, IMAGE_LOADER_PRIORITY_BATCH);
 					g_signal_connect(G_OBJECT(dw->img_loader), "error", (GCallback)dupe_loader_done_cb, dw);
 					g_signal_connect(G_OBJECT(dw->img_loader), "done", (GCallback)dupe_loader_done_cb, dw);
 
@@ -2565,6 +2769,8 @@ static gboolean dupe_check_cb(gpointer data)
 
 static void dupe_check_start(DupeWindow *dw)
 {
+	dupe_listview_populate_finish(dw);
+
 	dw->setup_done = FALSE;
 
 	dw->setup_count = g_list_length(dw->list);
@@ -2582,7 +2788,8 @@ static void dupe_check_start(DupeWindow *dw)
 	dw->search_matches_sorted = NULL;
 	dw->abort = FALSE;
 
-	if (dw->idle_id) return;
+	/* a running header probe restarts the check when it is done */
+	if (dw->idle_id || dw->probe_list) return;
 
 	dw->idle_id = g_idle_add(dupe_check_cb, dw);
 }
@@ -2607,6 +2814,7 @@ static void dupe_item_remove(DupeWindow *dw, DupeItem *di)
 	if (!di) return;
 
 	/* handle things that may be in progress... */
+	dupe_listview_populate_finish(dw);
 	if (dw->working && dw->working->data == di)
 		{
 		dw->working = dw->working->prev;
@@ -2615,6 +2823,13 @@ static void dupe_item_remove(DupeWindow *dw, DupeItem *di)
 		{
 		dupe_thumb_step(dw);
 		}
+	if (dw->probe_items)
+		{
+		GList *work = g_list_find(dw->probe_items, di);
+
+		/* keeps the places of the other items in the probe results */
+		if (work) work->data = NULL;
+		}
 	if (dw->setup_point && dw->setup_point->data == di)
 		{
 		dw->setup_point = dupe_setup_point_step(dw, dw->setup_point);
@@ -3008,6 +3223,11 @@ static void dupe_item_update(DupeWindow *dw, DupeItem *di)
 		gint row;
 		/* update the listview(s) */
 
+		g_free(di->sort_name_key);
+		di->sort_name_key = NULL;
+		g_free(di->sort_path_key);
+		di->sort_path_key = NULL;
+
 		store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)));
 		row = dupe_listview_find_item(store, di, &iter);
 		if (row >= 0)
@@ -3140,6 +3360,7 @@ static void dupe_window_recompare(DupeWindow *dw)
 {
 	GtkListStore *store;
 
+	dupe_listview_populate_cancel(dw);
 	dupe_check_stop(dw);
 
 	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)));
@@ -4078,6 +4299,8 @@ static void dupe_window_show_thumb_cb(GtkWidget *widget, gpointer data)
 
 		thumb_loader_free(dw->thumb_loader);
 		dw->thumb_loader = NULL;
+		gtk_tree_row_reference_free(dw->thumb_row);
+		dw->thumb_row = NULL;
 
 		store = gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview));
 		valid = gtk_tree_model_get_iter_first(store, &iter);
@@ -4346,6 +4569,7 @@ void dupe_window_clear(DupeWindow *dw)
 {
 	GtkListStore *store;
 
+	dupe_listview_populate_cancel(dw);
 	dupe_check_stop(dw);
 
 	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(dw->listview)));
@@ -4382,8 +4606,12 @@ static void dupe_window_get_geometry(DupeWindow *dw)
 
 void dupe_window_close(DupeWindow *dw)
 {
+	dupe_listview_populate_cancel(dw);
 	dupe_check_stop(dw);
 
+	g_signal_handlers_disconnect_by_func(gtk_tree_view_get_vadjustment(GTK_TREE_VIEW(dw->listview)), dupe_thumb_scroll_cb, dw);
+	if (dw->thumb_scroll_id) g_source_remove(dw->thumb_scroll_id);
+
 	dupe_window_get_geometry(dw);
 
 	dupe_window_list = g_list_remove(dupe_window_list, dw);
@@ -4428,13 +4656,25 @@ static gint default_sort_cb(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
 	return 0;
 }
 
+/**
+ * @brief Returns the collate key of the name or path of \a di, creating it on first use
+ */
+static const gchar *dupe_item_sort_key(DupeItem *di, gboolean path)
+{
+	if (path)
+		{
+		if (!di->sort_path_key) di->sort_path_key = g_utf8_collate_key(di->fd->path, -1);
+		return di->sort_path_key;
+		}
+
+	if (!di->sort_name_key) di->sort_name_key = g_utf8_collate_key(di->fd->name, -1);
+	return di->sort_name_key;
+}
+
 static gint column_sort_cb(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, gpointer data)
 {
 	GtkTreeSortable *sortable = data;
 	gint ret = 0;
-	gchar *rank_str_a, *rank_str_b;
-	gint rank_int_a;
-	gint rank_int_b;
 	gint group_a;
 	gint group_b;
 	gint sort_column_id;
@@ -4444,16 +4684,16 @@ static gint column_sort_cb(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
 
 	gtk_tree_sortable_get_sort_column_id(sortable, &sort_column_id, &sort_order);
 
-	gtk_tree_model_get(model, a, DUPE_COLUMN_RANK, &rank_str_a, DUPE_COLUMN_SET, &group_a, DUPE_COLUMN_POINTER, &di_a, -1);
+	gtk_tree_model_get(model, a, DUPE_COLUMN_SET, &group_a, DUPE_COLUMN_POINTER, &di_a, -1);
 
-	gtk_tree_model_get(model, b, DUPE_COLUMN_RANK, &rank_str_b, DUPE_COLUMN_SET, &group_b, DUPE_COLUMN_POINTER, &di_b, -1);
+	gtk_tree_model_get(model, b, DUPE_COLUMN_SET, &group_b, DUPE_COLUMN_POINTER, &di_b, -1);
 
 	if (group_a == group_b)
 		{
 		switch (sort_column_id)
 			{
 			case DUPE_COLUMN_NAME:
-				ret = utf8_compare(di_a->fd->name, di_b->fd->name, TRUE);
+				ret = strcmp(dupe_item_sort_key(di_a, FALSE), dupe_item_sort_key(di_b, FALSE));
 				break;
 			case DUPE_COLUMN_SIZE:
 				if (di_a->fd->size == di_b->fd->size)
@@ -4486,22 +4726,17 @@ static gint column_sort_cb(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b,
 					}
 				break;
 			case DUPE_COLUMN_RANK:
-				rank_int_a = atoi(rank_str_a);
-				rank_int_b = atoi(rank_str_b);
-				if (rank_int_a == 0) rank_int_a = 101;
-				if (rank_int_b == 0) rank_int_b = 101;
-
-				if (rank_int_a == rank_int_b)
+				if (di_a->sort_rank == di_b->sort_rank)
 					{
 					ret = 0;
 					}
 				else
 					{
-					ret = (rank_int_a > rank_int_b) ? 1 : -1;
+					ret = (di_a->sort_rank > di_b->sort_rank) ? 1 : -1;
 					}
 				break;
 			case DUPE_COLUMN_PATH:
-				ret = utf8_compare(di_a->fd->path, di_b->fd->path, TRUE);
+				ret = strcmp(dupe_item_sort_key(di_a, TRUE), dupe_item_sort_key(di_b, TRUE));
 				break;
 			}
 		}
@@ -4540,6 +4775,7 @@ DupeWindow *dupe_window_new()
 	GtkWidget *button;
 	GtkListStore *store;
 	GtkTreeSelection *selection;
+	GtkAdjustment *adj;
 	GdkGeometry geometry;
 	LayoutWindow *lw = NULL;
 
@@ -4646,6 +4882,11 @@ DupeWindow *dupe_window_new()
 	gtk_container_add(GTK_CONTAINER(scrolled), dw->listview);
 	gtk_widget_show(dw->listview);
 
+	/* thumbs are only loaded for visible rows, see dupe_thumb_step() */
+	adj = gtk_tree_view_get_vadjustment(GTK_TREE_VIEW(dw->listview));
+	g_signal_connect(G_OBJECT(adj), "value-changed", G_CALLBACK(dupe_thumb_scroll_cb), dw);
+	g_signal_connect(G_OBJECT(adj), "changed", G_CALLBACK(dupe_thumb_scroll_cb), dw);
+
 	dw->second_vbox = gtk_vbox_new(FALSE, 0);
 	gtk_table_attach_defaults(GTK_TABLE(dw->table), dw->second_vbox, 2, 3, 0, 1);
 	if (dw->second_set)
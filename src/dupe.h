@@ -72,6 +72,11 @@ struct _DupeItem
 
 	GList *group;		/**< List of match data (#DupeMatch) */
 	gdouble group_rank;	/**< (sum of all child ranks) / n */
+	gint group_count;	/**< length of \a group, cached by the rank update for sorting */
+
+	gint sort_rank;		/**< Rank column as an integer, set when the row is added */
+	gchar *sort_name_key;	/**< collate keys for sorting, created on first use */
+	gchar *sort_path_key;
 
 	gint second;
 };
@@ -121,8 +126,20 @@ struct _DupeWindow
 
 	ThumbLoader *thumb_loader;
 	DupeItem *thumb_item;
+	GtkTreeRowReference *thumb_row; /**< row of \a thumb_item in \a listview */
+	guint thumb_scroll_id; /**< event source id, restarts thumbs after the list is scrolled */
+
+	guint populate_id; /**< event source id of the chunked list fill */
+	GList *populate_point; /**< next group of \a dupes to append to \a listview */
+	gint populate_set; /**< set number of the next group */
+	gboolean populate_color;
+	gboolean populate_sorted; /**< the sort column below is restored when the fill completes */
+	gint populate_sort_column;
+	GtkSortType populate_sort_order;
 
 	ImageLoader *img_loader;
+	ImageLoadProbeList *probe_list; /**< header probe of the items in \a probe_items */
+	GList *probe_items; /**< #DupeItem-s being probed, NULL for those removed meanwhile */
 
 	GtkTreeSortable *sortable;
 	gint set_count; /**< Index/counter for number of duplicate sets found */
@@ -660,6 +660,192 @@ static void zd_tz(ZoneDetectResult *results, gchar **timezone, gchar **countryna
 	g_free(timezone_id);
 }
 
+/*
+ *-----------------------------------------------------------------------------
+ * timezone database
+ *-----------------------------------------------------------------------------
+ */
+
+/* lookups are quantised to cells of this size in degrees (about 1 km) */
+#define TZ_CACHE_QUANTUM 0.01
+#define TZ_CACHE_MAX_ENTRIES 4096
+
+typedef struct _TZCacheEntry TZCacheEntry;
+struct _TZCacheEntry
+{
+	gchar *timezone;
+	gchar *countryname;
+	gchar *countryalpha2;
+};
+
+static GMutex tz_lock;
+static ZoneDetect *tz_database = NULL;
+static gboolean tz_database_tried = FALSE;
+static GHashTable *tz_cache = NULL;		/* quantised cells clear of any border */
+static GHashTable *tz_cache_exact = NULL;	/* exact points near a border */
+
+static void tz_cache_entry_free(gpointer data)
+{
+	TZCacheEntry *entry = data;
+
+	g_free(entry->timezone);
+	g_free(entry->countryname);
+	g_free(entry->countryalpha2);
+	g_free(entry);
+}
+
+/* must be called with tz_lock held */
+static ZoneDetect *tz_database_get(void)
+{
+	gchar *path;
+	gchar *basename;
+	gchar *timezone_path;
+
+	if (tz_database || tz_database_tried) return tz_database;
+
+	tz_database_tried = TRUE;
+
+	path = path_from_utf8(TIMEZONE_DATABASE);
+	basename = g_path_get_basename(path);
+	timezone_path = g_build_filename(get_rc_dir(), basename, NULL);
+	if (g_file_test(timezone_path, G_FILE_TEST_EXISTS))
+		{
+		/* ZoneDetect maps the file, so keeping it open costs no heap */
+		tz_database = ZDOpenDatabase(timezone_path);
+		if (!tz_database)
+			{
+			log_printf("Error: Init of timezone database %s failed\n", timezone_path);
+			}
+		}
+	g_free(path);
+	g_free(timezone_path);
+	g_free(basename);
+
+	return tz_database;
+}
+
+/**
+ * @brief Closes the shared timezone database and drops cached lookups
+ *
+ * The database is reopened on the next lookup, so this should be called
+ * whenever the database file has been replaced.
+ */
+void exif_timezone_database_reset(void)
+{
+	g_mutex_lock(&tz_lock);
+	if (tz_database) ZDCloseDatabase(tz_database);
+	tz_database = NULL;
+	tz_database_tried = FALSE;
+	if (tz_cache) g_hash_table_remove_all(tz_cache);
+	if (tz_cache_exact) g_hash_table_remove_all(tz_cache_exact);
+	g_mutex_unlock(&tz_lock);
+}
+
+static gint64 tz_cache_key_cell(gfloat latitude, gfloat longitude)
+{
+	gint64 lat = (gint64)floor((latitude + 90.0) / TZ_CACHE_QUANTUM);
+	gint64 lon = (gint64)floor((longitude + 180.0) / TZ_CACHE_QUANTUM);
+
+	return (lat << 20) | lon;
+}
+
+static gint64 tz_cache_key_exact(gfloat latitude, gfloat longitude)
+{
+	union { gfloat f; guint32 i; } lat, lon;
+
+	lat.f = latitude;
+	lon.f = longitude;
+
+	return (gint64)(((guint64)lat.i << 32) | lon.i);
+}
+
+static void tz_cache_insert(GHashTable *cache, gint64 key, TZCacheEntry *entry)
+{
+	gint64 *k;
+
+	if (g_hash_table_size(cache) >= TZ_CACHE_MAX_ENTRIES)
+		{
+		g_hash_table_remove_all(cache);
+		}
+
+	k = g_new(gint64, 1);
+	*k = key;
+	g_hash_table_insert(cache, k, entry);
+}
+
+/* must be called with tz_lock held */
+static TZCacheEntry *tz_lookup_unlocked(gfloat latitude, gfloat longitude)
+{
+	ZoneDetect *cd;
+	ZoneDetectResult *results;
+	TZCacheEntry *entry;
+	gint64 key_cell;
+	gint64 key_exact;
+	gfloat safezone = 0;
+
+	if (!tz_cache)
+		{
+		tz_cache = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, tz_cache_entry_free);
+		tz_cache_exact = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, tz_cache_entry_free);
+		}
+
+	key_cell = tz_cache_key_cell(latitude, longitude);
+	entry = g_hash_table_lookup(tz_cache, &key_cell);
+	if (entry) return entry;
+
+	key_exact = tz_cache_key_exact(latitude, longitude);
+	entry = g_hash_table_lookup(tz_cache_exact, &key_exact);
+	if (entry) return entry;
+
+	cd = tz_database_get();
+	if (!cd) return NULL;
+
+	results = ZDLookup(cd, latitude, longitude, &safezone);
+	if (!results) return NULL;
+
+	entry = g_new0(TZCacheEntry, 1);
+	zd_tz(results, &entry->timezone, &entry->countryname, &entry->countryalpha2);
+	ZDFreeResults(results);
+
+	/* the whole cell only shares the result when no border crosses it */
+	if (safezone > TZ_CACHE_QUANTUM * G_SQRT2)
+		{
+		tz_cache_insert(tz_cache, key_cell, entry);
+		}
+	else
+		{
+		tz_cache_insert(tz_cache_exact, key_exact, entry);
+		}
+
+	return entry;
+}
+
+/**
+ * @brief Gets timezone data for a location
+ * @param[in] latitude
+ * @param[in] longitude
+ * @param[out] timezone in the form "Europe/London", may be NULL
+ * @param[out] countryname in the form "United Kingdom", may be NULL
+ * @param[out] countryalpha2 in the form "GB", may be NULL
+ * @returns TRUE if the timezone database covers the location
+ */
+gboolean exif_timezone_lookup(gdouble latitude, gdouble longitude, gchar **timezone, gchar **countryname, gchar **countryalpha2)
+{
+	TZCacheEntry *entry;
+
+	g_mutex_lock(&tz_lock);
+	entry = tz_lookup_unlocked(latitude, longitude);
+	if (entry)
+		{
+		if (timezone) *timezone = g_strdup(entry->timezone);
+		if (countryname) *countryname = g_strdup(entry->countryname);
+		if (countryalpha2) *countryalpha2 = g_strdup(entry->countryalpha2);
+		}
+	g_mutex_unlock(&tz_lock);
+
+	return (entry != NULL);
+}
+
 /**
  * @brief Gets timezone data from an exif structure
  * @param[in] exif
@@ -685,12 +871,7 @@ static gboolean exif_build_tz_data(ExifData *exif, gchar **exif_date_time, gchar
 	gchar *lat_min;
 	gchar *lon_deg;
 	gchar *lon_min;
-	gchar *timezone_path;
-	ZoneDetect *cd;
-	ZoneDetectResult *results;
 	gboolean ret = FALSE;
-	gchar *basename;
-	gchar *path;
 
 	text_latitude = exif_get_data_as_text(exif, "Exif.GPSInfo.GPSLatitude");
 	text_longitude = exif_get_data_as_text(exif, "Exif.GPSInfo.GPSLongitude");
@@ -724,30 +905,7 @@ static gboolean exif_build_tz_data(ExifData *exif, gchar **exif_date_time, gchar
 			longitude = -longitude;
 			}
 
-		path = path_from_utf8(TIMEZONE_DATABASE);
-		basename = g_path_get_basename(path);
-		timezone_path = g_build_filename(get_rc_dir(), basename, NULL);
-		if (g_file_test(timezone_path, G_FILE_TEST_EXISTS))
-			{
-			cd = ZDOpenDatabase(timezone_path);
-			if (cd)
-				{
-				results = ZDLookup(cd, latitude, longitude, NULL);
-				if (results)
-					{
-					zd_tz(results, timezone, countryname, countryalpha2);
-					ret = TRUE;
-					}
-				}
-			else
-				{
-				log_printf("Error: Init of timezone database %s failed\n", timezone_path);
-				}
-			ZDCloseDatabase(cd);
-			}
-		g_free(path);
-		g_free(timezone_path);
-		g_free(basename);
+		ret = exif_timezone_lookup(latitude, longitude, timezone, countryname, countryalpha2);
 		}
 
 	if (ret && text_date && text_time)
@@ -1029,20 +1187,11 @@ void exif_init_cache(void)
 	exif_cache = file_cache_new(exif_release_cb, 4);
 }
 
-ExifData *exif_read_fd(FileData *fd)
+gchar *exif_get_sidecar_path_fd(FileData *fd)
 {
-	gchar *sidecar_path;
-
-	if (!exif_cache) exif_init_cache();
-
-	if (!fd) return NULL;
-
-	if (file_cache_get(exif_cache, fd)) return fd->exif;
-	g_assert(fd->exif == NULL);
-
 	/* CACHE_TYPE_XMP_METADATA file should exist only if the metadata are
 	 * not writable directly, thus it should contain the most up-to-date version */
-	sidecar_path = NULL;
+	gchar *sidecar_path = NULL;
 
 #ifdef HAVE_EXIV2
 	/* we are not able to handle XMP sidecars without exiv2 */
@@ -1051,6 +1200,22 @@ ExifData *exif_read_fd(FileData *fd)
 	if (!sidecar_path) sidecar_path = file_data_get_sidecar_path(fd, TRUE);
 #endif
 
+	return sidecar_path;
+}
+
+static ExifData *exif_read_fd_real(FileData *fd)
+{
+	gchar *sidecar_path;
+
+	if (!exif_cache) exif_init_cache();
+
+	if (!fd) return NULL;
+
+	if (file_cache_get(exif_cache, fd)) return fd->exif;
+	g_assert(fd->exif == NULL);
+
+	sidecar_path = exif_get_sidecar_path_fd(fd);
+
 	fd->exif = exif_read(fd->path, sidecar_path, fd->modified_xmp);
 
 	g_free(sidecar_path);
@@ -1058,6 +1223,38 @@ ExifData *exif_read_fd(FileData *fd)
 	return fd->exif;
 }
 
+ExifData *exif_read_fd(FileData *fd)
+{
+	ExifData *exif;
+	TRACE_BEGIN(trace_start);
+
+	exif = exif_read_fd_real(fd);
+
+	TRACE_END(trace_start, "exif_read_fd", fd ? fd->path : NULL);
+	return exif;
+}
+
+
+/**
+ * @brief Stores \a exif, read by exif_read() outside the main thread, as the cached data of \a fd
+ *
+ * \a exif is freed and FALSE returned if \a fd got its data meanwhile, or has
+ * unsaved metadata changes that the plain read does not include.
+ */
+gboolean exif_set_fd(FileData *fd, ExifData *exif)
+{
+	if (!exif_cache) exif_init_cache();
+
+	if (!fd || !exif || fd->exif || fd->modified_xmp)
+		{
+		exif_free(exif);
+		return FALSE;
+		}
+
+	fd->exif = exif;
+	file_cache_put(exif_cache, fd, 1);
+	return TRUE;
+}
 
 void exif_free_fd(FileData *fd, ExifData *exif)
 {
@@ -106,6 +106,8 @@ void exif_init(void);
 ExifData *exif_read(gchar *path, gchar *sidecar_path, GHashTable *modified_xmp);
 
 ExifData *exif_read_fd(FileData *fd);
+gboolean exif_set_fd(FileData *fd, ExifData *exif);
+gchar *exif_get_sidecar_path_fd(FileData *fd);
 void exif_free_fd(FileData *fd, ExifData *exif);
 
 /**
@@ -169,6 +171,9 @@ void exif_set_image_comment(FileData* fd, const gchar* comment);
 guchar *exif_get_preview(ExifData *exif, guint *data_len, gint requested_width, gint requested_height);
 void exif_free_preview(guchar *buf);
 
+gboolean exif_timezone_lookup(gdouble latitude, gdouble longitude, gchar **timezone, gchar **countryname, gchar **countryalpha2);
+void exif_timezone_database_reset(void);
+
 gchar *metadata_file_info(FileData *fd, const gchar *key, MetadataFormat format);
 gchar *metadata_lua_info(FileData *fd, const gchar *key, MetadataFormat format);
 
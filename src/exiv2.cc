@@ -445,11 +445,32 @@ public:
 extern "C" {
 
 
+#if EXIV2_TEST_VERSION(0,21,0) && defined(EXV_HAVE_XMP_TOOLKIT)
+static GMutex exif_xmp_mutex;
+
+static void exif_xmp_lock_cb(void *data, bool lock)
+{
+	if (lock)
+		{
+		g_mutex_lock((GMutex *)data);
+		}
+	else
+		{
+		g_mutex_unlock((GMutex *)data);
+		}
+}
+#endif
+
 void exif_init(void)
 {
 #ifdef EXV_ENABLE_NLS
 	bind_textdomain_codeset (EXV_PACKAGE, "UTF-8");
 #endif
+
+#if EXIV2_TEST_VERSION(0,21,0) && defined(EXV_HAVE_XMP_TOOLKIT)
+	/* exif_read() is also called from worker threads */
+	Exiv2::XmpParser::initialize(exif_xmp_lock_cb, &exif_xmp_mutex);
+#endif
 }
 
 
@@ -29,6 +29,7 @@
 #include "metadata.h"
 #include "trash.h"
 #include "histogram.h"
+#include "page_cache.h"
 #include "secure_save.h"
 
 #include "exif.h"
@@ -646,6 +647,14 @@ FileData *file_data_new_no_grouping(const gchar *path_utf8)
 	return file_data_new(path_utf8, &st, TRUE);
 }
 
+/**
+ * @brief Like file_data_new_dir(), for callers that already have the stat result, e.g. from a worker thread
+ */
+FileData *file_data_new_dir_stat(const gchar *path_utf8, struct stat *st)
+{
+	return file_data_new(path_utf8, st, TRUE);
+}
+
 FileData *file_data_new_dir(const gchar *path_utf8)
 {
 	struct stat st;
@@ -704,6 +713,7 @@ static void file_data_free(FileData *fd)
 #endif
 
 	metadata_cache_free(fd);
+	page_cache_release(fd);
 	g_hash_table_remove(file_data_pool, fd->original_path);
 
 	g_free(fd->path);
@@ -1339,6 +1349,22 @@ static gboolean is_hidden_file(const gchar *name)
 	return TRUE;
 }
 
+/**
+ * @brief Returns TRUE if a subdirectory called \a name is listed by filelist_read()
+ *
+ * Only reads options, can be used from worker threads.
+ */
+gboolean filelist_read_dir_name_allowed(const gchar *name)
+{
+	if (!options->file_filter.show_hidden_files && is_hidden_file(name)) return FALSE;
+
+	/* we ignore the .thumbnails dir for cleanliness */
+	return (!(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) &&
+		strcmp(name, GQ_CACHE_LOCAL_THUMB) != 0 &&
+		strcmp(name, GQ_CACHE_LOCAL_METADATA) != 0 &&
+		strcmp(name, THUMB_FOLDER_LOCAL) != 0);
+}
+
 /*
  *-----------------------------------------------------------------------------
  * the main filelist function
@@ -1392,12 +1418,7 @@ static gboolean filelist_read_real(const gchar *dir_path, GList **files, GList *
 			{
 			if (S_ISDIR(ent_sbuf.st_mode))
 				{
-				/* we ignore the .thumbnails dir for cleanliness */
-				if (dirs &&
-				    !(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) &&
-				    strcmp(name, GQ_CACHE_LOCAL_THUMB) != 0 &&
-				    strcmp(name, GQ_CACHE_LOCAL_METADATA) != 0 &&
-				    strcmp(name, THUMB_FOLDER_LOCAL) != 0)
+				if (dirs && filelist_read_dir_name_allowed(name))
 					{
 					dlist = g_list_prepend(dlist, file_data_new_local(filepath, &ent_sbuf, TRUE));
 					}
@@ -1453,12 +1474,24 @@ static gboolean filelist_read_real(const gchar *dir_path, GList **files, GList *
 
 gboolean filelist_read(FileData *dir_fd, GList **files, GList **dirs)
 {
-	return filelist_read_real(dir_fd->path, files, dirs, TRUE);
+	gboolean ret;
+	TRACE_BEGIN(trace_start);
+
+	ret = filelist_read_real(dir_fd->path, files, dirs, TRUE);
+
+	TRACE_END(trace_start, "filelist_read", dir_fd->path);
+	return ret;
 }
 
 gboolean filelist_read_lstat(FileData *dir_fd, GList **files, GList **dirs)
 {
-	return filelist_read_real(dir_fd->path, files, dirs, FALSE);
+	gboolean ret;
+	TRACE_BEGIN(trace_start);
+
+	ret = filelist_read_real(dir_fd->path, files, dirs, FALSE);
+
+	TRACE_END(trace_start, "filelist_read", dir_fd->path);
+	return ret;
 }
 
 FileData *file_data_new_group(const gchar *path_utf8)
@@ -3135,6 +3168,7 @@ typedef struct _NotifyData NotifyData;
 
 struct _NotifyData {
 	FileDataNotifyFunc func;
+	FileDataNotifyBatchFunc batch_func; /* optional, receives a whole batch at once */
 	gpointer data;
 	NotifyPriority priority;
 };
@@ -3152,6 +3186,18 @@ static gint file_data_notify_sort(gconstpointer a, gconstpointer b)
 }
 
 gboolean file_data_register_notify_func(FileDataNotifyFunc func, gpointer data, NotifyPriority priority)
+{
+	return file_data_register_notify_func_full(func, NULL, data, priority);
+}
+
+/**
+ * @brief Registers a notify function that also handles batches
+ * @param func called for single notifications, and for batched ones if \a batch_func is NULL
+ * @param batch_func called once with the list of #FileDataNotifyChange at the end of a batch
+ *
+ * See file_data_notify_batch_begin()
+ */
+gboolean file_data_register_notify_func_full(FileDataNotifyFunc func, FileDataNotifyBatchFunc batch_func, gpointer data, NotifyPriority priority)
 {
 	NotifyData *nd;
 	GList *work = notify_func_list;
@@ -3170,6 +3216,7 @@ gboolean file_data_register_notify_func(FileDataNotifyFunc func, gpointer data,
 
 	nd = g_new(NotifyData, 1);
 	nd->func = func;
+	nd->batch_func = batch_func;
 	nd->data = data;
 	nd->priority = priority;
 
@@ -3219,10 +3266,202 @@ gboolean file_data_send_notification_idle_cb(gpointer data)
 	return FALSE;
 }
 
+/*
+ * Notification batches
+ *
+ * While a batch is collecting, notifications are added to it instead of
+ * being sent, all notifications for one FileData are merged into a single
+ * #FileDataNotifyChange. At file_data_notify_batch_end() each listener gets
+ * the whole change-set, either at once through its batch function or entry
+ * by entry through its normal notify function.
+ *
+ * A batch only collects between begin or resume and suspend, so an operation
+ * that runs in idle steps defers only what it sends itself; notifications
+ * from the rest of the application go through in between.
+ *
+ * Pixbuf and histmap notifications come from image loading, not from file
+ * operations, and are never deferred.
+ */
+
+struct _FileDataNotifyBatch
+{
+	GList *list; /**< FileDataNotifyChange, newest first */
+	GHashTable *hash; /**< FileData -> FileDataNotifyChange */
+};
+
+static GList *notify_batch_stack = NULL; /* collecting batches, the first one gets the notifications */
+
+static void file_data_notify_batch_add(FileDataNotifyBatch *nb, FileData *fd, NotifyType type)
+{
+	FileDataNotifyChange *nc;
+
+	nc = g_hash_table_lookup(nb->hash, fd);
+	if (!nc)
+		{
+		nc = g_new0(FileDataNotifyChange, 1);
+		nc->fd = file_data_ref(fd);
+		g_hash_table_insert(nb->hash, fd, nc);
+		nb->list = g_list_prepend(nb->list, nc);
+		}
+
+	nc->type |= type;
+
+	/* fd->change is usually freed right after the notification, keep a copy;
+	 * a chain of moves is reported as one move from the first source to the last destination */
+	if ((type & NOTIFY_CHANGE) && fd->change)
+		{
+		if (!nc->change)
+			{
+			nc->change = g_new0(FileDataChangeInfo, 1);
+			nc->change->source = g_strdup(fd->change->source);
+			}
+		nc->change->type = fd->change->type;
+		nc->change->error = fd->change->error;
+		g_free(nc->change->dest);
+		nc->change->dest = g_strdup(fd->change->dest);
+		}
+}
+
+static void file_data_notify_batch_free(GList *changes)
+{
+	GList *work = changes;
+
+	while (work)
+		{
+		FileDataNotifyChange *nc = work->data;
+
+		file_data_change_info_free(nc->change, NULL);
+		file_data_unref(nc->fd);
+		g_free(nc);
+		work = work->next;
+		}
+	g_list_free(changes);
+}
+
+static gboolean file_data_notify_func_registered(NotifyData *nd)
+{
+	GList *work = notify_func_list;
+
+	while (work)
+		{
+		NotifyData *nd_n = work->data;
+
+		if (nd_n->func == nd->func && nd_n->data == nd->data) return TRUE;
+		work = work->next;
+		}
+
+	return FALSE;
+}
+
+static void file_data_notify_batch_send(GList *changes)
+{
+	GList *listeners = NULL;
+	GList *work;
+
+	/* listeners may register or unregister while being called, use a copy */
+	work = notify_func_list;
+	while (work)
+		{
+		listeners = g_list_prepend(listeners, g_memdup(work->data, sizeof(NotifyData)));
+		work = work->next;
+		}
+	listeners = g_list_reverse(listeners);
+
+	work = listeners;
+	while (work)
+		{
+		NotifyData *nd = work->data;
+		work = work->next;
+
+		if (!file_data_notify_func_registered(nd)) continue;
+
+		if (nd->batch_func)
+			{
+			nd->batch_func(changes, nd->data);
+			}
+		else
+			{
+			GList *work_c = changes;
+
+			while (work_c)
+				{
+				FileDataNotifyChange *nc = work_c->data;
+				FileDataChangeInfo *change = nc->fd->change;
+
+				if (nc->change && !change) nc->fd->change = nc->change;
+				nd->func(nc->fd, nc->type, nd->data);
+				if (nc->fd->change == nc->change) nc->fd->change = change;
+
+				work_c = work_c->next;
+				}
+			}
+		}
+
+	g_list_free_full(listeners, g_free);
+}
+
+/**
+ * @brief Starts a batch that collects notifications, see file_data_notify_batch_end()
+ */
+FileDataNotifyBatch *file_data_notify_batch_begin(void)
+{
+	FileDataNotifyBatch *nb = g_new0(FileDataNotifyBatch, 1);
+
+	nb->hash = g_hash_table_new(g_direct_hash, g_direct_equal);
+	file_data_notify_batch_resume(nb);
+
+	return nb;
+}
+
+/**
+ * @brief Stops collecting, e.g. while an operation waits for its next idle call,
+ * collected notifications are kept until the batch ends
+ */
+void file_data_notify_batch_suspend(FileDataNotifyBatch *nb)
+{
+	notify_batch_stack = g_list_remove(notify_batch_stack, nb);
+}
+
+void file_data_notify_batch_resume(FileDataNotifyBatch *nb)
+{
+	if (g_list_find(notify_batch_stack, nb)) return;
+
+	notify_batch_stack = g_list_prepend(notify_batch_stack, nb);
+}
+
+/**
+ * @brief Sends the collected notifications and frees the batch
+ */
+void file_data_notify_batch_end(FileDataNotifyBatch *nb)
+{
+	GList *changes;
+
+	if (!nb) return;
+
+	file_data_notify_batch_suspend(nb);
+
+	changes = g_list_reverse(nb->list);
+	g_hash_table_destroy(nb->hash);
+	g_free(nb);
+
+	if (!changes) return;
+
+	DEBUG_1("Notify batch: %d files", g_list_length(changes));
+
+	file_data_notify_batch_send(changes);
+	file_data_notify_batch_free(changes);
+}
+
 void file_data_send_notification(FileData *fd, NotifyType type)
 {
 	GList *work = notify_func_list;
 
+	if (notify_batch_stack && !(type & (NOTIFY_PIXBUF | NOTIFY_HISTMAP)))
+		{
+		file_data_notify_batch_add(notify_batch_stack->data, fd, type);
+		return;
+		}
+
 	while (work)
 		{
 		NotifyData *nd = (NotifyData *)work->data;
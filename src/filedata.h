@@ -51,6 +51,7 @@ FileData *file_data_new_no_grouping(const gchar *path_utf8);
 FileData *file_data_new_dir(const gchar *path_utf8);
 
 FileData *file_data_new_simple(const gchar *path_utf8);
+FileData *file_data_new_dir_stat(const gchar *path_utf8, struct stat *st);
 
 #ifdef DEBUG_FILEDATA
 FileData *file_data_ref_debug(const gchar *file, gint line, FileData *fd);
@@ -86,6 +87,7 @@ GList *filelist_insert_sort_full(GList *list, gpointer data, SortType method, gb
 
 gboolean filelist_read(FileData *dir_fd, GList **files, GList **dirs);
 gboolean filelist_read_lstat(FileData *dir_fd, GList **files, GList **dirs);
+gboolean filelist_read_dir_name_allowed(const gchar *name);
 void filelist_free(GList *list);
 GList *filelist_copy(GList *list);
 GList *filelist_from_path_list(GList *list);
@@ -168,10 +170,25 @@ void file_data_sc_free_ci_list(GList *fd_list);
 GList *file_data_process_groups_in_selection(GList *list, gboolean ungroup, GList **ungrouped);
 
 
+typedef struct _FileDataNotifyChange FileDataNotifyChange;
+struct _FileDataNotifyChange {
+	FileData *fd;
+	NotifyType type; /**< all notification types sent for \a fd during the batch */
+	FileDataChangeInfo *change; /**< copy of fd->change for NOTIFY_CHANGE, or NULL */
+};
+
+typedef struct _FileDataNotifyBatch FileDataNotifyBatch;
+
 typedef void (*FileDataNotifyFunc)(FileData *fd, NotifyType type, gpointer data);
+typedef void (*FileDataNotifyBatchFunc)(GList *changes, gpointer data);
 gboolean file_data_register_notify_func(FileDataNotifyFunc func, gpointer data, NotifyPriority priority);
+gboolean file_data_register_notify_func_full(FileDataNotifyFunc func, FileDataNotifyBatchFunc batch_func, gpointer data, NotifyPriority priority);
 gboolean file_data_unregister_notify_func(FileDataNotifyFunc func, gpointer data);
 void file_data_send_notification(FileData *fd, NotifyType type);
+FileDataNotifyBatch *file_data_notify_batch_begin(void);
+void file_data_notify_batch_suspend(FileDataNotifyBatch *nb);
+void file_data_notify_batch_resume(FileDataNotifyBatch *nb);
+void file_data_notify_batch_end(FileDataNotifyBatch *nb);
 
 gboolean file_data_register_real_time_monitor(FileData *fd);
 gboolean file_data_unregister_real_time_monitor(FileData *fd);
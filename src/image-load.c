@@ -68,6 +68,10 @@ static void image_loader_class_init_wrapper(void *data, void *user_data);
 static void image_loader_class_init(ImageLoaderClass *class);
 static void image_loader_finalize(GObject *object);
 static void image_loader_stop(ImageLoader *il);
+static void image_loader_client_detach(ImageLoader *il);
+#ifdef HAVE_GTHREAD
+static gboolean image_loader_queue_cancel(ImageLoader *il);
+#endif
 
 GType image_loader_get_type(void)
 {
@@ -205,6 +209,7 @@ static void image_loader_finalize(GObject *object)
 {
 	ImageLoader *il = (ImageLoader *)object;
 
+	image_loader_client_detach(il);
 	image_loader_stop(il);
 
 	if (il->error) DEBUG_1("%s", image_loader_get_error(il));
@@ -257,6 +262,7 @@ static void image_loader_finalize(GObject *object)
 void image_loader_free(ImageLoader *il)
 {
 	if (!il) return;
+	image_loader_client_detach(il);
 	g_object_unref(G_OBJECT(il));
 }
 
@@ -270,6 +276,7 @@ ImageLoader *image_loader_new(FileData *fd)
 	il = (ImageLoader *) g_object_new(TYPE_IMAGE_LOADER, NULL);
 
 	il->fd = file_data_ref(fd);
+	il->page_num = fd->page_num;
 
 	return il;
 }
@@ -309,6 +316,7 @@ static gboolean image_loader_emit_area_ready_cb(gpointer data)
 static gboolean image_loader_emit_done_cb(gpointer data)
 {
 	ImageLoader *il = data;
+	TRACE_END(il->trace_start, "image_loader", il->fd->path);
 	g_signal_emit(il, signals[SIGNAL_DONE], 0);
 	return FALSE;
 }
@@ -316,6 +324,7 @@ static gboolean image_loader_emit_done_cb(gpointer data)
 static gboolean image_loader_emit_error_cb(gpointer data)
 {
 	ImageLoader *il = data;
+	TRACE_END(il->trace_start, "image_loader_error", il->fd->path);
 	g_signal_emit(il, signals[SIGNAL_ERROR], 0);
 	return FALSE;
 }
@@ -543,6 +552,7 @@ static void image_loader_size_cb(gpointer loader,
 	ImageLoader *il = data;
 	gchar **mime_types;
 	gboolean scale = FALSE;
+	gboolean picks_level = FALSE;
 	gint n;
 
 	g_mutex_lock(il->data_mutex);
@@ -565,6 +575,7 @@ static void image_loader_size_cb(gpointer loader,
 	while (mime_types[n] && !scale)
 		{
 		if (strstr(mime_types[n], "jpeg")) scale = TRUE;
+		if (strstr(mime_types[n], "tiff")) scale = picks_level = TRUE;
 		n++;
 		}
 	g_strfreev(mime_types);
@@ -597,148 +608,190 @@ static void image_loader_size_cb(gpointer loader,
 		il->actual_width = nw;
 		il->actual_height = nh;
 		il->backend.set_size(loader, nw, nh);
-		il->shrunk = TRUE;
+		/* tiff may still decode the full image, it calls image_loader_set_reduced() when not */
+		if (!picks_level) il->shrunk = TRUE;
 		}
 
 	g_mutex_unlock(il->data_mutex);
 	image_loader_emit_size(il);
 }
 
+/**
+ * @brief Called by backends that choose a reduced resolution of the file themselves
+ * @param preview TRUE if it is smaller than asked for, e.g. when the full image does not fit into memory
+ */
+void image_loader_set_reduced(ImageLoader *il, gboolean preview)
+{
+	g_mutex_lock(il->data_mutex);
+	if (preview)
+		{
+		il->preview = TRUE;
+		}
+	else
+		{
+		il->shrunk = TRUE;
+		}
+	g_mutex_unlock(il->data_mutex);
+}
+
 static void image_loader_stop_loader(ImageLoader *il)
 {
 	if (!il) return;
 
 	if (il->loader)
 		{
+		gpointer loader;
+
 		/* some loaders do not have a pixbuf till close, order is important here */
 		il->backend.close(il->loader, il->error ? NULL : &il->error); /* we are interested in the first error only */
 		image_loader_sync_pixbuf(il);
-		il->backend.free(il->loader);
+
+		/* image_loader_stop() may abort it from the main thread */
+		g_mutex_lock(il->data_mutex);
+		loader = il->loader;
 		il->loader = NULL;
+		g_mutex_unlock(il->data_mutex);
+		il->backend.free(loader);
 		}
 	g_mutex_lock(il->data_mutex);
 	il->done = TRUE;
 	g_mutex_unlock(il->data_mutex);
 }
 
-static void image_loader_setup_loader(ImageLoader *il)
+/* selects the backend from the first bytes of the file, returns the name of
+ * a custom backend for the log; does not log itself as the dimension probe
+ * calls it from worker threads */
+static const gchar *image_loader_backend_set_by_data(ImageLoaderBackend *backend, FileData *fd, const guchar *data, gsize size)
 {
-#if defined HAVE_TIFF || defined HAVE_PDF || defined HAVE_HEIF || defined HAVE_DJVU
-	gchar *format;
-#endif
+	const gchar *name = NULL;
+
+	memset(backend, 0, sizeof(ImageLoaderBackend));
 
-	g_mutex_lock(il->data_mutex);
 #ifdef HAVE_FFMPEGTHUMBNAILER
-	if (il->fd->format_class == FORMAT_CLASS_VIDEO)
+	if (fd->format_class == FORMAT_CLASS_VIDEO)
 		{
-		DEBUG_1("Using custom ffmpegthumbnailer loader");
-		image_loader_backend_set_ft(&il->backend);
+		name = "custom ffmpegthumbnailer";
+		image_loader_backend_set_ft(backend);
 		}
 	else
 #endif
 #ifdef HAVE_PDF
-	if (il->bytes_total >= 4 &&
-	    (memcmp(il->mapped_file + 0, "%PDF", 4) == 0))
+	if (size >= 4 &&
+	    (memcmp(data + 0, "%PDF", 4) == 0))
 		{
-		DEBUG_1("Using custom pdf loader");
-		image_loader_backend_set_pdf(&il->backend);
+		name = "custom pdf";
+		image_loader_backend_set_pdf(backend);
 		}
 	else
 #endif
 #ifdef HAVE_HEIF
-	if (il->bytes_total >= 12 &&
-		((memcmp(il->mapped_file + 4, "ftypheic", 8) == 0) ||
-		(memcmp(il->mapped_file + 4, "ftypmsf1", 8) == 0) ||
-		(memcmp(il->mapped_file + 4, "ftypmif1", 8) == 0)))
+	if (size >= 12 &&
+		((memcmp(data + 4, "ftypheic", 8) == 0) ||
+		(memcmp(data + 4, "ftypmsf1", 8) == 0) ||
+		(memcmp(data + 4, "ftypmif1", 8) == 0)))
 		{
-		DEBUG_1("Using custom heif loader");
-		image_loader_backend_set_heif(&il->backend);
+		name = "custom heif";
+		image_loader_backend_set_heif(backend);
 		}
 	else
 #endif
 #ifdef HAVE_WEBP
-	if (il->bytes_total >= 12 &&
-		(memcmp(il->mapped_file, "RIFF", 4) == 0) &&
-		(memcmp(il->mapped_file + 8, "WEBP", 4) == 0))
+	if (size >= 12 &&
+		(memcmp(data, "RIFF", 4) == 0) &&
+		(memcmp(data + 8, "WEBP", 4) == 0))
 		{
-		DEBUG_1("Using custom webp loader");
-		image_loader_backend_set_webp(&il->backend);
+		name = "custom webp";
+		image_loader_backend_set_webp(backend);
 		}
 	else
 #endif
 #ifdef HAVE_DJVU
-	if (il->bytes_total >= 16 &&
-		(memcmp(il->mapped_file, "AT&TFORM", 8) == 0) &&
-		(memcmp(il->mapped_file + 12, "DJV", 3) == 0))
+	if (size >= 16 &&
+		(memcmp(data, "AT&TFORM", 8) == 0) &&
+		(memcmp(data + 12, "DJV", 3) == 0))
 		{
-		DEBUG_1("Using custom djvu loader");
-		image_loader_backend_set_djvu(&il->backend);
+		name = "custom djvu";
+		image_loader_backend_set_djvu(backend);
 		}
 	else
 #endif
 #ifdef HAVE_JPEG
-	if (il->bytes_total >= 2 && il->mapped_file[0] == 0xff && il->mapped_file[1] == 0xd8)
+	if (size >= 2 && data[0] == 0xff && data[1] == 0xd8)
 		{
-		DEBUG_1("Using custom jpeg loader");
-		image_loader_backend_set_jpeg(&il->backend);
+		name = "custom jpeg";
+		image_loader_backend_set_jpeg(backend);
 		}
 	else
-	if (il->bytes_total >= 11 &&
-		(memcmp(il->mapped_file + 4, "ftypcrx", 7) == 0) &&
-		(memcmp(il->mapped_file + 64, "CanonCR3", 8) == 0))
+	if (size >= 11 &&
+		(memcmp(data + 4, "ftypcrx", 7) == 0) &&
+		(memcmp(data + 64, "CanonCR3", 8) == 0))
 		{
-		DEBUG_1("Using custom cr3 loader");
-		image_loader_backend_set_cr3(&il->backend);
+		name = "custom cr3";
+		image_loader_backend_set_cr3(backend);
 		}
 	else
 #endif
 #ifdef HAVE_TIFF
-	if (il->bytes_total >= 10 &&
-	    (memcmp(il->mapped_file, "MM\0*", 4) == 0 ||
-	     memcmp(il->mapped_file, "MM\0+\0\x08\0\0", 8) == 0 ||
-	     memcmp(il->mapped_file, "II+\0\x08\0\0\0", 8) == 0 ||
-	     memcmp(il->mapped_file, "II*\0", 4) == 0))
+	if (size >= 10 &&
+	    (memcmp(data, "MM\0*", 4) == 0 ||
+	     memcmp(data, "MM\0+\0\x08\0\0", 8) == 0 ||
+	     memcmp(data, "II+\0\x08\0\0\0", 8) == 0 ||
+	     memcmp(data, "II*\0", 4) == 0))
 	     	{
-		DEBUG_1("Using custom tiff loader");
-		image_loader_backend_set_tiff(&il->backend);
+		name = "custom tiff";
+		image_loader_backend_set_tiff(backend);
 		}
 	else
 #endif
-	if (il->bytes_total >= 3 && il->mapped_file[0] == 0x44 && il->mapped_file[1] == 0x44 && il->mapped_file[2] == 0x53)
+	if (size >= 3 && data[0] == 0x44 && data[1] == 0x44 && data[2] == 0x53)
 		{
-		DEBUG_1("Using dds loader");
-		image_loader_backend_set_dds(&il->backend);
+		name = "dds";
+		image_loader_backend_set_dds(backend);
 		}
 	else
-	if (il->bytes_total >= 6 &&
-		(memcmp(il->mapped_file, "8BPS\0\x01", 6) == 0))
+	if (size >= 6 &&
+		(memcmp(data, "8BPS\0\x01", 6) == 0))
 		{
-		DEBUG_1("Using custom psd loader");
-		image_loader_backend_set_psd(&il->backend);
+		name = "custom psd";
+		image_loader_backend_set_psd(backend);
 		}
 	else
 #ifdef HAVE_J2K
-	if (il->bytes_total >= 12 &&
-		(memcmp(il->mapped_file, "\0\0\0\x0CjP\x20\x20\x0D\x0A\x87\x0A", 12) == 0))
+	if (size >= 12 &&
+		(memcmp(data, "\0\0\0\x0CjP\x20\x20\x0D\x0A\x87\x0A", 12) == 0))
 		{
-		DEBUG_1("Using custom j2k loader");
-		image_loader_backend_set_j2k(&il->backend);
+		name = "custom j2k";
+		image_loader_backend_set_j2k(backend);
 		}
 	else
 #endif
-	if (il->fd->format_class == FORMAT_CLASS_COLLECTION)
+	if (fd->format_class == FORMAT_CLASS_COLLECTION)
 		{
-		DEBUG_1("Using custom collection loader");
-		image_loader_backend_set_collection(&il->backend);
+		name = "custom collection";
+		image_loader_backend_set_collection(backend);
 		}
 	else
-	if (g_strcmp0(strrchr(il->fd->path, '.'), ".svgz") == 0)
+	if (g_strcmp0(strrchr(fd->path, '.'), ".svgz") == 0)
 		{
-		DEBUG_1("Using custom svgz loader");
-		image_loader_backend_set_svgz(&il->backend);
+		name = "custom svgz";
+		image_loader_backend_set_svgz(backend);
 		}
 	else
-		image_loader_backend_set_default(&il->backend);
+		image_loader_backend_set_default(backend);
+
+	return name;
+}
+
+static void image_loader_setup_loader(ImageLoader *il)
+{
+	const gchar *name;
+#if defined HAVE_TIFF || defined HAVE_PDF || defined HAVE_HEIF || defined HAVE_DJVU
+	gchar *format;
+#endif
+
+	g_mutex_lock(il->data_mutex);
+	name = image_loader_backend_set_by_data(&il->backend, il->fd, il->mapped_file, il->bytes_total);
+	if (name) DEBUG_1("Using %s loader", name);
 
 	il->loader = il->backend.loader_new(image_loader_area_updated_cb, image_loader_size_cb, image_loader_area_prepared_cb, il);
 
@@ -746,7 +799,7 @@ static void image_loader_setup_loader(ImageLoader *il)
 	format = il->backend.get_format_name(il->loader);
 	if (g_strcmp0(format, "tiff") == 0)
 		{
-		il->backend.set_page_num(il->loader, il->fd->page_num);
+		il->backend.set_page_num(il->loader, il->page_num);
 		}
 	g_free(format);
 #endif
@@ -755,7 +808,7 @@ static void image_loader_setup_loader(ImageLoader *il)
 	format = il->backend.get_format_name(il->loader);
 	if (g_strcmp0(format, "pdf") == 0)
 		{
-		il->backend.set_page_num(il->loader, il->fd->page_num);
+		il->backend.set_page_num(il->loader, il->page_num);
 		}
 	g_free(format);
 #endif
@@ -764,7 +817,7 @@ static void image_loader_setup_loader(ImageLoader *il)
 	format = il->backend.get_format_name(il->loader);
 	if (g_strcmp0(format, "heif") == 0)
 		{
-		il->backend.set_page_num(il->loader, il->fd->page_num);
+		il->backend.set_page_num(il->loader, il->page_num);
 		}
 	g_free(format);
 #endif
@@ -773,7 +826,7 @@ static void image_loader_setup_loader(ImageLoader *il)
 	format = il->backend.get_format_name(il->loader);
 	if (g_strcmp0(format, "djvu") == 0)
 		{
-		il->backend.set_page_num(il->loader, il->fd->page_num);
+		il->backend.set_page_num(il->loader, il->page_num);
 		}
 	g_free(format);
 #endif
@@ -798,6 +851,30 @@ static void image_loader_error(ImageLoader *il)
 	image_loader_emit_error(il);
 }
 
+/* the load of an async backend ends here instead of in the loader thread */
+void image_loader_backend_finish(ImageLoader *il, gboolean success)
+{
+	g_mutex_lock(il->data_mutex);
+	if (!il->pending || il->stopping)
+		{
+		g_mutex_unlock(il->data_mutex);
+		return;
+		}
+	il->pending = FALSE;
+	g_mutex_unlock(il->data_mutex);
+
+	if (success) image_loader_sync_pixbuf(il);
+
+	if (success && il->pixbuf)
+		{
+		image_loader_done(il);
+		}
+	else
+		{
+		image_loader_error(il);
+		}
+}
+
 static gboolean image_loader_continue(ImageLoader *il)
 {
 	gint b;
@@ -841,6 +918,7 @@ static gboolean image_loader_begin(ImageLoader *il)
 	gchar *format;
 #endif
 	gssize b;
+	gboolean ret;
 
 	if (il->pixbuf) return FALSE;
 
@@ -850,15 +928,37 @@ static gboolean image_loader_begin(ImageLoader *il)
 	image_loader_setup_loader(il);
 
 	g_assert(il->bytes_read == 0);
+
+	if (il->backend.load_async)
+		{
+		/* the backend may finish before load returns */
+		g_mutex_lock(il->data_mutex);
+		il->pending = TRUE;
+		g_mutex_unlock(il->data_mutex);
+
+		il->bytes_read = il->bytes_total;
+		ret = il->backend.load(il->loader, il->mapped_file, il->bytes_total, &il->error);
+		if (ret) return TRUE;
+
+		g_mutex_lock(il->data_mutex);
+		il->pending = FALSE;
+		g_mutex_unlock(il->data_mutex);
+		image_loader_stop_loader(il);
+		return FALSE;
+		}
+
+	TRACE_BEGIN(trace_start);
 	if (il->backend.load) {
 		b = il->bytes_total;
-		if (!il->backend.load(il->loader, il->mapped_file, b, &il->error))
-			{
-			image_loader_stop_loader(il);
-			return FALSE;
-			}
+		ret = il->backend.load(il->loader, il->mapped_file, b, &il->error);
 	}
-	else if (!il->backend.write(il->loader, il->mapped_file, b, &il->error))
+	else
+		{
+		ret = il->backend.write(il->loader, il->mapped_file, b, &il->error);
+		}
+	TRACE_END(trace_start, "backend_load", il->fd->path);
+
+	if (!ret)
 		{
 		image_loader_stop_loader(il);
 		return FALSE;
@@ -1030,9 +1130,20 @@ static void image_loader_stop(ImageLoader *il)
 
 	if (il->thread)
 		{
-		/* stop loader in the other thread */
+#ifdef HAVE_GTHREAD
+		/* a loader still in the queue never gets a thread */
+		if (image_loader_queue_cancel(il))
+			{
+			g_mutex_lock(il->data_mutex);
+			il->can_destroy = TRUE;
+			g_mutex_unlock(il->data_mutex);
+			}
+#endif
+
+		/* stop loader in the other thread, the backends check the abort flag while decoding */
 		g_mutex_lock(il->data_mutex);
 		il->stopping = TRUE;
+		if (il->loader) il->backend.abort(il->loader);
 		while (!il->can_destroy) g_cond_wait(il->can_destroy_cond, il->data_mutex);
 		g_mutex_unlock(il->data_mutex);
 		}
@@ -1108,7 +1219,7 @@ static gboolean image_loader_start_idle(ImageLoader *il)
 
 	ret = image_loader_begin(il);
 
-	if (ret && !il->done) il->idle_id = g_idle_add_full(il->idle_priority, image_loader_idle_cb, il, NULL);
+	if (ret && !il->done && !il->backend.load_async) il->idle_id = g_idle_add_full(il->idle_priority, image_loader_idle_cb, il, NULL);
 	return ret;
 }
 
@@ -1116,98 +1227,143 @@ static gboolean image_loader_start_idle(ImageLoader *il)
 /* execution via thread */
 
 #ifdef HAVE_GTHREAD
+/*
+ * Loaders wait in one queue per priority class and a thread of the bounded
+ * pool always runs the oldest loader of the most urgent class. The pool only
+ * gets a token for each queued loader, the loader itself is picked when a
+ * thread is free, so that it can be moved or taken out of the queue until
+ * then. Background classes leave one thread free for the others.
+ */
 static GThreadPool *image_loader_thread_pool = NULL;
 
-static GCond *image_loader_prio_cond = NULL;
-static GMutex *image_loader_prio_mutex = NULL;
-static gint image_loader_prio_num = 0;
+static GMutex image_loader_queue_mutex;
+static GQueue image_loader_queue[IMAGE_LOADER_PRIORITY_COUNT];
+static guint image_loader_running[IMAGE_LOADER_PRIORITY_COUNT];
+static guint image_loader_finished = 0;
+static guint image_loader_cancelled = 0;
+static guint image_loader_deferred = 0; /**< tokens put back until a background loader ends */
 
-
-static void image_loader_thread_enter_high(void)
+static gint image_loader_thread_max(void)
 {
-	g_mutex_lock(image_loader_prio_mutex);
-	image_loader_prio_num++;
-	g_mutex_unlock(image_loader_prio_mutex);
+	if (options->image.loader_threads > 0) return options->image.loader_threads;
+
+	return MAX(g_get_num_processors(), 1);
 }
 
-static void image_loader_thread_leave_high(void)
+/* this function expects that image_loader_queue_mutex is locked by caller */
+static ImageLoader *image_loader_queue_pop(void)
 {
-	g_mutex_lock(image_loader_prio_mutex);
-	image_loader_prio_num--;
-	if (image_loader_prio_num == 0) g_cond_broadcast(image_loader_prio_cond); /* wake up all low prio threads */
-	g_mutex_unlock(image_loader_prio_mutex);
+	guint background = 0;
+	gint max_background = image_loader_thread_max() - 1;
+	gint i;
+
+	for (i = IMAGE_LOADER_PRIORITY_THUMB_BACKGROUND; i < IMAGE_LOADER_PRIORITY_COUNT; i++)
+		{
+		background += image_loader_running[i];
+		}
+
+	for (i = 0; i < IMAGE_LOADER_PRIORITY_COUNT; i++)
+		{
+		ImageLoader *il;
+
+		if (g_queue_is_empty(&image_loader_queue[i])) continue;
+
+		if (i >= IMAGE_LOADER_PRIORITY_THUMB_BACKGROUND &&
+		    max_background > 0 && background >= (guint)max_background)
+			{
+			image_loader_deferred++;
+			return NULL;
+			}
+
+		il = g_queue_pop_head(&image_loader_queue[i]);
+		il->queued = FALSE;
+		image_loader_running[i]++;
+		return il;
+		}
+
+	return NULL;
 }
 
-static void image_loader_thread_wait_high(void)
+/* a loader stopped before it got a thread is taken out of the queue */
+static gboolean image_loader_queue_cancel(ImageLoader *il)
 {
-	g_mutex_lock(image_loader_prio_mutex);
-	while (image_loader_prio_num)
+	gboolean ret = FALSE;
+
+	g_mutex_lock(&image_loader_queue_mutex);
+	if (il->queued)
 		{
-		g_cond_wait(image_loader_prio_cond, image_loader_prio_mutex);
+		g_queue_remove(&image_loader_queue[il->priority_class], il);
+		il->queued = FALSE;
+		image_loader_cancelled++;
+		ret = TRUE;
 		}
+	g_mutex_unlock(&image_loader_queue_mutex);
 
-	g_mutex_unlock(image_loader_prio_mutex);
+	return ret;
 }
 
-
 static void image_loader_thread_run(gpointer data, gpointer user_data)
 {
-	ImageLoader *il = data;
+	ImageLoader *il;
+	ImageLoaderPriorityClass priority_class = IMAGE_LOADER_PRIORITY_VIEW;
 	gboolean cont;
 	gboolean err;
+	gboolean async;
 
-	if (il->idle_priority > G_PRIORITY_DEFAULT_IDLE)
-		{
-		/* low prio, wait until high prio tasks finishes */
-		image_loader_thread_wait_high();
-		}
-	else
-		{
-		/* high prio */
-		image_loader_thread_enter_high();
-		}
+	g_mutex_lock(&image_loader_queue_mutex);
+	il = image_loader_queue_pop();
+	if (il) priority_class = il->priority_class;
+	g_mutex_unlock(&image_loader_queue_mutex);
 
-	err = !image_loader_begin(il);
+	if (!il) return; /* loader cancelled, or a background slot is not free yet */
 
-	if (err)
+	if (!image_loader_get_stopping(il))
 		{
-		/*
-		loader failed, we have to send signal
-		(idle mode returns the image_loader_begin return value directly)
-		(success is always reported indirectly from image_loader_begin)
-		*/
-		image_loader_emit_error(il);
-		}
+		err = !image_loader_begin(il);
+
+		if (err && !image_loader_get_stopping(il))
+			{
+			/*
+			loader failed, we have to send signal
+			(idle mode returns the image_loader_begin return value directly)
+			(success is always reported indirectly from image_loader_begin)
+			*/
+			image_loader_emit_error(il);
+			}
 
-	cont = !err;
+		/* an async backend goes on without this thread and may already be finished,
+		 * the loader must not be touched here any more */
+		async = !err && il->backend.load_async;
+		cont = !err && !async;
 
-	while (cont && !image_loader_get_is_done(il) && !image_loader_get_stopping(il))
-		{
-		if (il->idle_priority > G_PRIORITY_DEFAULT_IDLE)
+		while (cont && !image_loader_get_is_done(il) && !image_loader_get_stopping(il))
 			{
-			/* low prio, wait until high prio tasks finishes */
-			image_loader_thread_wait_high();
+			cont = image_loader_continue(il);
 			}
-		cont = image_loader_continue(il);
+		if (!async) image_loader_stop_loader(il);
 		}
-	image_loader_stop_loader(il);
 
-	if (il->idle_priority <= G_PRIORITY_DEFAULT_IDLE)
+	g_mutex_lock(&image_loader_queue_mutex);
+	image_loader_running[priority_class]--;
+	image_loader_finished++;
+	while (image_loader_deferred > 0)
 		{
-		/* high prio */
-		image_loader_thread_leave_high();
+		image_loader_deferred--;
+		g_thread_pool_push(image_loader_thread_pool, GINT_TO_POINTER(1), NULL);
 		}
+	g_mutex_unlock(&image_loader_queue_mutex);
 
 	g_mutex_lock(il->data_mutex);
 	il->can_destroy = TRUE;
 	g_cond_signal(il->can_destroy_cond);
 	g_mutex_unlock(il->data_mutex);
-
 }
 
 
 static gboolean image_loader_start_thread(ImageLoader *il)
 {
+	gint max_threads = image_loader_thread_max();
+
 	if (!il) return FALSE;
 
 	if (!il->fd) return FALSE;
@@ -1216,29 +1372,529 @@ static gboolean image_loader_start_thread(ImageLoader *il)
 
 	if (!image_loader_setup_source(il)) return FALSE;
 
-        if (!image_loader_thread_pool)
+	if (!image_loader_thread_pool)
 		{
-		image_loader_thread_pool = g_thread_pool_new(image_loader_thread_run, NULL, -1, FALSE, NULL);
-#if GLIB_CHECK_VERSION(2,32,0)
-		if (!image_loader_prio_cond) image_loader_prio_cond = g_new(GCond, 1);
-		g_cond_init(image_loader_prio_cond);
-		if (!image_loader_prio_mutex) image_loader_prio_mutex = g_new(GMutex, 1);
-		g_mutex_init(image_loader_prio_mutex);
-#else
-		image_loader_prio_cond = g_cond_new();
-		image_loader_prio_mutex = g_mutex_new();
-#endif
+		image_loader_thread_pool = g_thread_pool_new(image_loader_thread_run, NULL, max_threads, FALSE, NULL);
+		}
+	else if (g_thread_pool_get_max_threads(image_loader_thread_pool) != max_threads)
+		{
+		g_thread_pool_set_max_threads(image_loader_thread_pool, max_threads, NULL);
 		}
 
 	il->can_destroy = FALSE; /* ImageLoader can't be freed until image_loader_thread_run finishes */
 
-	g_thread_pool_push(image_loader_thread_pool, il, NULL);
-	DEBUG_1("Thread pool num threads: %d", g_thread_pool_get_num_threads(image_loader_thread_pool));
+	g_mutex_lock(&image_loader_queue_mutex);
+	g_queue_push_tail(&image_loader_queue[il->priority_class], il);
+	il->queued = TRUE;
+	g_mutex_unlock(&image_loader_queue_mutex);
+
+	g_thread_pool_push(image_loader_thread_pool, GINT_TO_POINTER(1), NULL);
+	DEBUG_1("Thread pool num threads: %d, queued: %u", g_thread_pool_get_num_threads(image_loader_thread_pool),
+		g_thread_pool_unprocessed(image_loader_thread_pool));
 
 	return TRUE;
 }
 #endif /* HAVE_GTHREAD */
 
+static void image_loader_queue_set_class(ImageLoader *il, ImageLoaderPriorityClass priority_class)
+{
+#ifdef HAVE_GTHREAD
+	g_mutex_lock(&image_loader_queue_mutex);
+	if (il->queued && il->priority_class != priority_class)
+		{
+		g_queue_remove(&image_loader_queue[il->priority_class], il);
+		g_queue_push_tail(&image_loader_queue[priority_class], il);
+		}
+	il->priority_class = priority_class;
+	g_mutex_unlock(&image_loader_queue_mutex);
+#else
+	il->priority_class = priority_class;
+#endif
+}
+
+
+/**************************************************************************************/
+/* shared decodes */
+
+/*
+ * A loader started with image_loader_start() does not decode by itself: it is
+ * attached as a client to a source loader that decodes the same file and page
+ * at the same size class, and a new source is created only when none is
+ * running. The signals of the source are passed on to all of its clients, so
+ * several windows asking for the same image share one decode. Finished
+ * decodes that are small enough are kept in a cache and served from there.
+ */
+
+#define IMAGE_LOADER_SIZE_CLASS_MIN 64
+#define IMAGE_LOADER_CACHE_MAX (32 * 1024 * 1024)
+
+typedef struct _ImageLoaderCacheEntry ImageLoaderCacheEntry;
+struct _ImageLoaderCacheEntry
+{
+	FileData *fd;
+	gint page_num;
+	time_t date; /**< state of the file the pixbuf was decoded from */
+	gint64 file_size;
+	gint width; /**< size class of the decode, 0 for full size */
+	gint height;
+	gboolean full; /**< the pixbuf is the whole image, not shrunk nor a preview */
+	gint actual_width;
+	gint actual_height;
+	gboolean shrunk;
+	GdkPixbuf *pixbuf;
+	gsize size;
+};
+
+static GList *image_loader_sources = NULL; /**< source loaders still decoding */
+static GList *image_loader_cache = NULL; /**< ImageLoaderCacheEntry, most recently used first */
+static gsize image_loader_cache_size = 0;
+static gboolean image_loader_cache_notify = FALSE;
+
+/* requests are rounded up to a power of two, so that close sizes share a decode */
+static gint image_loader_size_class(gint size)
+{
+	gint size_class = IMAGE_LOADER_SIZE_CLASS_MIN;
+
+	while (size_class < size && size_class < G_MAXINT / 2) size_class *= 2;
+	return size_class;
+}
+
+static void image_loader_cache_remove_link(GList *link)
+{
+	ImageLoaderCacheEntry *ce = link->data;
+
+	image_loader_cache_size -= ce->size;
+	image_loader_cache = g_list_delete_link(image_loader_cache, link);
+
+	file_data_unref(ce->fd);
+	g_object_unref(ce->pixbuf);
+	g_free(ce);
+}
+
+static void image_loader_cache_notify_cb(FileData *fd, NotifyType type, gpointer data)
+{
+	GList *work;
+
+	if (!(type & (NOTIFY_REREAD | NOTIFY_CHANGE))) return;
+
+	work = image_loader_cache;
+	while (work)
+		{
+		ImageLoaderCacheEntry *ce = work->data;
+		GList *next = work->next;
+
+		if (ce->fd == fd)
+			{
+			DEBUG_1("image loader cache: drop %s", fd->path);
+			image_loader_cache_remove_link(work);
+			}
+		work = next;
+		}
+}
+
+static void image_loader_cache_add(ImageLoader *il)
+{
+	ImageLoaderCacheEntry *ce;
+	GdkPixbuf *pixbuf = il->pixbuf;
+	gsize size;
+
+	if (!pixbuf) return;
+
+	size = (gsize)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf);
+	if (size > IMAGE_LOADER_CACHE_MAX / 4) return;
+
+	if (!image_loader_cache_notify)
+		{
+		file_data_register_notify_func(image_loader_cache_notify_cb, NULL, NOTIFY_PRIORITY_HIGH);
+		image_loader_cache_notify = TRUE;
+		}
+
+	ce = g_new0(ImageLoaderCacheEntry, 1);
+	ce->fd = file_data_ref(il->fd);
+	ce->page_num = il->page_num;
+	ce->date = il->fd->date;
+	ce->file_size = il->fd->size;
+	ce->width = il->requested_width;
+	ce->height = il->requested_height;
+	ce->full = !il->shrunk && !il->preview;
+	ce->actual_width = il->actual_width;
+	ce->actual_height = il->actual_height;
+	ce->shrunk = il->shrunk;
+	ce->pixbuf = g_object_ref(pixbuf);
+	ce->size = size;
+
+	image_loader_cache = g_list_prepend(image_loader_cache, ce);
+	image_loader_cache_size += size;
+
+	while (image_loader_cache_size > IMAGE_LOADER_CACHE_MAX)
+		{
+		image_loader_cache_remove_link(g_list_last(image_loader_cache));
+		}
+}
+
+void image_loader_cache_clear(void)
+{
+	while (image_loader_cache) image_loader_cache_remove_link(image_loader_cache);
+}
+
+static ImageLoaderCacheEntry *image_loader_cache_find(FileData *fd, gint page_num, gint width, gint height)
+{
+	GList *work = image_loader_cache;
+
+	while (work)
+		{
+		ImageLoaderCacheEntry *ce = work->data;
+
+		if (ce->fd == fd && ce->page_num == page_num &&
+		    ce->date == fd->date && ce->file_size == fd->size &&
+		    (ce->full || (ce->width == width && ce->height == height)))
+			{
+			if (work != image_loader_cache)
+				{
+				image_loader_cache = g_list_remove_link(image_loader_cache, work);
+				image_loader_cache = g_list_concat(work, image_loader_cache);
+				}
+			return ce;
+			}
+		work = work->next;
+		}
+
+	return NULL;
+}
+
+static ImageLoader *image_loader_source_find(FileData *fd, gint page_num, gint width, gint height)
+{
+	GList *work = image_loader_sources;
+
+	while (work)
+		{
+		ImageLoader *src = work->data;
+
+		if (src->fd == fd && src->page_num == page_num &&
+		    src->requested_width == width && src->requested_height == height)
+			{
+			return src;
+			}
+		work = work->next;
+		}
+
+	return NULL;
+}
+
+static void image_loader_client_set_pixbuf(ImageLoader *il, GdkPixbuf *pixbuf)
+{
+	g_mutex_lock(il->data_mutex);
+	if (pixbuf != il->pixbuf)
+		{
+		if (il->pixbuf) g_object_unref(il->pixbuf);
+		il->pixbuf = pixbuf;
+		if (il->pixbuf) g_object_ref(il->pixbuf);
+		}
+	g_mutex_unlock(il->data_mutex);
+}
+
+static void image_loader_client_area_ready(ImageLoader *il, guint x, guint y, guint w, guint h)
+{
+	g_mutex_lock(il->data_mutex);
+	if (il->delay_area_ready)
+		{
+		image_loader_queue_delayed_area_ready(il, x, y, w, h);
+		g_mutex_unlock(il->data_mutex);
+		return;
+		}
+	g_mutex_unlock(il->data_mutex);
+
+	g_signal_emit(il, signals[SIGNAL_AREA_READY], 0, x, y, w, h);
+}
+
+/* the clients are referenced for the walk, a client released by its owner
+ * meanwhile is detached and gets no more signals */
+static GList *image_loader_source_get_clients(ImageLoader *src)
+{
+	GList *list = g_list_copy(src->clients);
+
+	g_list_foreach(list, (GFunc)g_object_ref, NULL);
+	return list;
+}
+
+static void image_loader_source_area_ready_cb(ImageLoader *src, guint x, guint y, guint w, guint h, gpointer data)
+{
+	GList *list = image_loader_source_get_clients(src);
+	GList *work;
+	GdkPixbuf *pixbuf = image_loader_get_pixbuf(src);
+
+	src->area_sent = TRUE;
+
+	for (work = list; work; work = work->next)
+		{
+		ImageLoader *il = work->data;
+
+		if (il->source != src || il->late_client) continue;
+		image_loader_client_set_pixbuf(il, pixbuf);
+		image_loader_client_area_ready(il, x, y, w, h);
+		}
+
+	g_list_free_full(list, g_object_unref);
+}
+
+static void image_loader_source_size_cb(ImageLoader *src, gint width, gint height, gpointer data)
+{
+	GList *list = image_loader_source_get_clients(src);
+	GList *work;
+	gboolean shrunk = image_loader_get_shrunk(src);
+
+	for (work = list; work; work = work->next)
+		{
+		ImageLoader *il = work->data;
+
+		if (il->source != src) continue;
+		g_mutex_lock(il->data_mutex);
+		il->actual_width = width;
+		il->actual_height = height;
+		il->shrunk = shrunk;
+		g_mutex_unlock(il->data_mutex);
+		g_signal_emit(il, signals[SIGNAL_SIZE], 0, width, height);
+		}
+
+	g_list_free_full(list, g_object_unref);
+}
+
+static void image_loader_source_percent_cb(ImageLoader *src, gdouble percent, gpointer data)
+{
+	GList *list = image_loader_source_get_clients(src);
+	GList *work;
+	gsize bytes_read, bytes_total;
+
+	g_mutex_lock(src->data_mutex);
+	bytes_read = src->bytes_read;
+	bytes_total = src->bytes_total;
+	g_mutex_unlock(src->data_mutex);
+
+	for (work = list; work; work = work->next)
+		{
+		ImageLoader *il = work->data;
+
+		if (il->source != src) continue;
+		g_mutex_lock(il->data_mutex);
+		il->bytes_read = bytes_read;
+		il->bytes_total = bytes_total;
+		g_mutex_unlock(il->data_mutex);
+		g_signal_emit(il, signals[SIGNAL_PERCENT], 0, percent);
+		}
+
+	g_list_free_full(list, g_object_unref);
+}
+
+static gboolean image_loader_source_free_cb(gpointer data)
+{
+	image_loader_free(data);
+	return FALSE;
+}
+
+static void image_loader_source_finish(ImageLoader *src, gboolean success)
+{
+	GdkPixbuf *pixbuf = image_loader_get_pixbuf(src);
+
+	image_loader_sources = g_list_remove(image_loader_sources, src);
+	if (success) image_loader_cache_add(src);
+
+	/* a client is taken from the list before its signal, so clients
+	 * released from any of the handlers simply drop out of the list */
+	while (src->clients)
+		{
+		ImageLoader *il = src->clients->data;
+
+		src->clients = g_list_delete_link(src->clients, src->clients);
+		il->source = NULL;
+
+		image_loader_client_set_pixbuf(il, pixbuf);
+		g_mutex_lock(il->data_mutex);
+		il->actual_width = src->actual_width;
+		il->actual_height = src->actual_height;
+		il->shrunk = src->shrunk;
+		il->preview = src->preview;
+		il->bytes_read = src->bytes_read;
+		il->bytes_total = src->bytes_total;
+		il->done = src->done;
+		if (src->error && !il->error) il->error = g_error_copy(src->error);
+		g_mutex_unlock(il->data_mutex);
+
+		if (!success)
+			{
+			g_signal_emit(il, signals[SIGNAL_ERROR], 0);
+			continue;
+			}
+
+		if (il->late_client && pixbuf)
+			{
+			image_loader_client_area_ready(il, 0, 0, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+			}
+		g_signal_emit(il, signals[SIGNAL_DONE], 0);
+		}
+
+	/* the source is still in its own signal emission */
+	g_idle_add(image_loader_source_free_cb, src);
+}
+
+static void image_loader_source_done_cb(ImageLoader *src, gpointer data)
+{
+	image_loader_source_finish(src, TRUE);
+}
+
+static void image_loader_source_error_cb(ImageLoader *src, gpointer data)
+{
+	image_loader_source_finish(src, FALSE);
+}
+
+/* a source is queued with the most urgent class of its clients */
+static void image_loader_source_update_priority(ImageLoader *src)
+{
+	ImageLoaderPriorityClass priority_class = IMAGE_LOADER_PRIORITY_COUNT;
+	GList *work;
+
+	for (work = src->clients; work; work = work->next)
+		{
+		ImageLoader *il = work->data;
+
+		priority_class = MIN(priority_class, il->priority_class);
+		}
+
+	if (priority_class < IMAGE_LOADER_PRIORITY_COUNT && priority_class != src->priority_class)
+		{
+		image_loader_queue_set_class(src, priority_class);
+		}
+}
+
+static void image_loader_client_attach(ImageLoader *il, ImageLoader *src)
+{
+	GdkPixbuf *pixbuf = image_loader_get_pixbuf(src);
+
+	il->source = src;
+	il->late_client = src->area_sent;
+	src->clients = g_list_append(src->clients, il);
+	image_loader_source_update_priority(src);
+
+	if (pixbuf) image_loader_client_set_pixbuf(il, pixbuf);
+
+	g_mutex_lock(src->data_mutex);
+	il->actual_width = src->actual_width;
+	il->actual_height = src->actual_height;
+	il->shrunk = src->shrunk;
+	g_mutex_unlock(src->data_mutex);
+
+	/* the size was already sent to the other clients */
+	if (il->actual_width > 0) image_loader_emit_size(il);
+}
+
+/* called when the owner releases a client, a source nobody waits for is stopped */
+static void image_loader_client_detach(ImageLoader *il)
+{
+	ImageLoader *src = il->source;
+
+	if (!src) return;
+
+	il->source = NULL;
+	src->clients = g_list_remove(src->clients, il);
+
+	/* a finished source is already out of the list and frees itself */
+	if (src->clients || !g_list_find(image_loader_sources, src)) return;
+
+	DEBUG_1("image loader %p: no clients left, stopping source %p", il, src);
+	image_loader_sources = g_list_remove(image_loader_sources, src);
+	g_signal_handlers_disconnect_matched(src, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, &image_loader_sources);
+	image_loader_free(src);
+}
+
+static gboolean image_loader_cached_cb(gpointer data)
+{
+	ImageLoader *il = data;
+	GdkPixbuf *pixbuf = image_loader_get_pixbuf(il);
+
+	il->idle_done_id = 0;
+
+	g_signal_emit(il, signals[SIGNAL_SIZE], 0, il->actual_width, il->actual_height);
+	image_loader_client_area_ready(il, 0, 0, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+	g_signal_emit(il, signals[SIGNAL_DONE], 0);
+	return FALSE;
+}
+
+static gboolean image_loader_start_cached(ImageLoader *il, ImageLoaderCacheEntry *ce)
+{
+	g_mutex_lock(il->data_mutex);
+	il->pixbuf = g_object_ref(ce->pixbuf);
+	il->actual_width = ce->actual_width;
+	il->actual_height = ce->actual_height;
+	il->shrunk = ce->shrunk;
+	il->preview = !ce->full && !ce->shrunk;
+	il->bytes_read = il->bytes_total = 1;
+	il->done = TRUE;
+	g_mutex_unlock(il->data_mutex);
+
+	il->idle_done_id = g_idle_add_full(il->idle_priority, image_loader_cached_cb, il, NULL);
+	return TRUE;
+}
+
+static gboolean image_loader_start_shared(ImageLoader *il)
+{
+	ImageLoaderCacheEntry *ce;
+	ImageLoader *src;
+	gint page_num = il->fd->page_num;
+	gint width = 0;
+	gint height = 0;
+
+	if (il->source || il->done) return FALSE;
+
+	if (il->requested_width > 0 && il->requested_height > 0)
+		{
+		width = image_loader_size_class(il->requested_width);
+		height = image_loader_size_class(il->requested_height);
+		}
+
+	ce = image_loader_cache_find(il->fd, page_num, width, height);
+	if (ce)
+		{
+		DEBUG_1("image loader %p: cached %s", il, il->fd->path);
+		return image_loader_start_cached(il, ce);
+		}
+
+	src = image_loader_source_find(il->fd, page_num, width, height);
+	if (src)
+		{
+		DEBUG_1("image loader %p: sharing source %p for %s", il, src, il->fd->path);
+		image_loader_client_attach(il, src);
+		return TRUE;
+		}
+
+	src = image_loader_new(il->fd);
+	src->page_num = page_num;
+	src->requested_width = width;
+	src->requested_height = height;
+	src->idle_priority = il->idle_priority;
+	src->priority_class = il->priority_class;
+	src->idle_read_loop_count = il->idle_read_loop_count;
+	src->trace_start = il->trace_start;
+
+	g_signal_connect(G_OBJECT(src), "area_ready", (GCallback)image_loader_source_area_ready_cb, &image_loader_sources);
+	g_signal_connect(G_OBJECT(src), "size_prepared", (GCallback)image_loader_source_size_cb, &image_loader_sources);
+	g_signal_connect(G_OBJECT(src), "percent", (GCallback)image_loader_source_percent_cb, &image_loader_sources);
+	g_signal_connect(G_OBJECT(src), "done", (GCallback)image_loader_source_done_cb, &image_loader_sources);
+	g_signal_connect(G_OBJECT(src), "error", (GCallback)image_loader_source_error_cb, &image_loader_sources);
+
+#ifdef HAVE_GTHREAD
+	if (!image_loader_start_thread(src))
+#else
+	if (!image_loader_start_idle(src))
+#endif
+		{
+		image_loader_free(src);
+		return FALSE;
+		}
+
+	image_loader_sources = g_list_prepend(image_loader_sources, src);
+	image_loader_client_attach(il, src);
+	return TRUE;
+}
+
 
 /**************************************************************************************/
 /* public interface */
@@ -1250,11 +1906,9 @@ gboolean image_loader_start(ImageLoader *il)
 
 	if (!il->fd) return FALSE;
 
-#ifdef HAVE_GTHREAD
-	return image_loader_start_thread(il);
-#else
-	return image_loader_start_idle(il);
-#endif
+	il->trace_start = trace_now();
+
+	return image_loader_start_shared(il);
 }
 
 
@@ -1297,6 +1951,14 @@ void image_loader_set_priority(ImageLoader *il, gint priority)
 	il->idle_priority = priority;
 }
 
+void image_loader_set_priority_class(ImageLoader *il, ImageLoaderPriorityClass priority_class)
+{
+	if (!il) return;
+
+	image_loader_queue_set_class(il, priority_class);
+	if (il->source) image_loader_source_update_priority(il->source);
+}
+
 
 gdouble image_loader_get_percent(ImageLoader *il)
 {
@@ -1361,18 +2023,319 @@ const gchar *image_loader_get_error(ImageLoader *il)
 	return ret;
 }
 
+void image_loader_get_queue_stats(ImageLoaderQueueStats *stats)
+{
+#ifdef HAVE_GTHREAD
+	gint i;
+#endif
+
+	memset(stats, 0, sizeof(ImageLoaderQueueStats));
 
-/* FIXME - this can be rather slow and blocks until the size is known */
+#ifdef HAVE_GTHREAD
+	g_mutex_lock(&image_loader_queue_mutex);
+	stats->threads = image_loader_thread_max();
+	for (i = 0; i < IMAGE_LOADER_PRIORITY_COUNT; i++)
+		{
+		stats->queued[i] = g_queue_get_length(&image_loader_queue[i]);
+		stats->running[i] = image_loader_running[i];
+		}
+	stats->finished = image_loader_finished;
+	stats->cancelled = image_loader_cancelled;
+	g_mutex_unlock(&image_loader_queue_mutex);
+#endif
+}
+
+
+/**************************************************************************************/
+/* dimensions */
+
+/* enough for the headers the backends look at, including most HEIF meta boxes */
+#define IMAGE_LOAD_PROBE_SIZE 65536
+#define IMAGE_LOAD_PROBE_THREADS 4
+
+typedef struct _ImageLoadProbe ImageLoadProbe;
+struct _ImageLoadProbe
+{
+	FileData *fd;
+	gchar *pathl;
+	gint width;
+	gint height;
+	gboolean success;
+	ImageLoadProbeList *pl;
+};
+
+struct _ImageLoadProbeList
+{
+	ImageLoadProbe *probes;
+	guint n;
+	GMutex mutex;
+	gint pending; /**< probes not yet done by the workers, under \a mutex */
+	gboolean done; /**< the done callback has run */
+	gboolean cancelled; /**< freed by the caller before it was done */
+	ImageLoadProbeListDoneFunc func;
+	gpointer data;
+};
+
+#ifdef HAVE_GTHREAD
+static GThreadPool *image_load_probe_pool = NULL;
+#endif
+
+/* files the loader does not read from their own start, or multi-page files
+ * opened at another page, must go through the full loader */
+static gboolean image_load_probe_wanted(FileData *fd)
+{
+	if (fd->page_num > 0) return FALSE;
+
+	switch (fd->format_class)
+		{
+		case FORMAT_CLASS_RAWIMAGE:
+		case FORMAT_CLASS_VIDEO:
+		case FORMAT_CLASS_COLLECTION:
+			return FALSE;
+		default:
+			break;
+		}
+
+	return TRUE;
+}
+
+/* called from worker threads, pathl is in locale encoding */
+static gboolean image_load_probe_path(FileData *fd, const gchar *pathl, gint *width, gint *height)
+{
+	ImageLoaderBackend backend;
+	guchar *buf;
+	gssize count;
+	gint load_fd;
+	gboolean success = FALSE;
+
+	load_fd = open(pathl, O_RDONLY);
+	if (load_fd == -1) return FALSE;
+
+	buf = g_malloc(IMAGE_LOAD_PROBE_SIZE);
+	count = read(load_fd, buf, IMAGE_LOAD_PROBE_SIZE);
+	close(load_fd);
+
+	if (count > 0)
+		{
+		image_loader_backend_set_by_data(&backend, fd, buf, count);
+		if (backend.probe) success = backend.probe(buf, count, width, height);
+		}
+
+	g_free(buf);
+
+	return success;
+}
+
+/**
+ * @brief Reads the size from the file header, without decoding
+ *
+ * Returns FALSE and leaves \a width and \a height alone if the backend has no
+ * header probe or the header does not give the size the loader would report.
+ */
+gboolean image_load_dimensions_probe(FileData *fd, gint *width, gint *height)
+{
+	gchar *pathl;
+	gint w, h;
+	gboolean success;
+
+	if (!fd || !image_load_probe_wanted(fd)) return FALSE;
+
+	pathl = path_from_utf8(fd->path);
+	success = image_load_probe_path(fd, pathl, &w, &h);
+	g_free(pathl);
+
+	if (!success) return FALSE;
+
+	DEBUG_1("dimensions of %s from header: %dx%d", fd->path, w, h);
+	if (width) *width = w;
+	if (height) *height = h;
+
+	return TRUE;
+}
+
+static void image_load_probe_list_release(ImageLoadProbeList *pl)
+{
+	guint i;
+
+	for (i = 0; i < pl->n; i++)
+		{
+		file_data_unref(pl->probes[i].fd);
+		g_free(pl->probes[i].pathl);
+		}
+
+	g_mutex_clear(&pl->mutex);
+	g_free(pl->probes);
+	g_free(pl);
+}
+
+static gboolean image_load_probe_list_done_cb(gpointer data)
+{
+	ImageLoadProbeList *pl = data;
+
+	pl->done = TRUE;
+	DEBUG_1("dimensions from header: %u files probed", pl->n);
+	if (pl->cancelled)
+		{
+		image_load_probe_list_release(pl);
+		}
+	else
+		{
+		pl->func(pl, pl->data);
+		}
+
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief As image_load_dimensions_probe(), for worker threads
+ * @param pathl the path of \a fd in locale encoding
+ *
+ * Does not log and only reads \a fd.
+ */
+gboolean image_load_dimensions_probe_local(FileData *fd, const gchar *pathl, gint *width, gint *height)
+{
+	gint w, h;
+
+	if (!fd || !image_load_probe_wanted(fd)) return FALSE;
+	if (!image_load_probe_path(fd, pathl, &w, &h)) return FALSE;
+
+	if (width) *width = w;
+	if (height) *height = h;
+
+	return TRUE;
+}
+
+#ifdef HAVE_GTHREAD
+static void image_load_probe_thread(gpointer data, gpointer user_data)
+{
+	ImageLoadProbe *probe = data;
+	ImageLoadProbeList *pl = probe->pl;
+	gboolean last;
+
+	probe->success = image_load_probe_path(probe->fd, probe->pathl, &probe->width, &probe->height);
+
+	g_mutex_lock(&pl->mutex);
+	pl->pending--;
+	last = (pl->pending == 0);
+	g_mutex_unlock(&pl->mutex);
+
+	if (last) g_idle_add(image_load_probe_list_done_cb, pl);
+}
+#endif
+
+/**
+ * @brief Header probe of a list of FileData, spread over a few threads
+ * @param list FileData
+ * @param func called from the main loop when all files are probed
+ * @param data passed to \a func
+ * @returns the probe, free with image_load_dimensions_probe_list_free()
+ *
+ * Read the results with image_load_dimensions_probe_list_get(). Files that
+ * could not be probed fall back to image_load_dimensions(). Freeing the
+ * probe before \a func is called cancels the callback.
+ */
+ImageLoadProbeList *image_load_dimensions_probe_list(GList *list, ImageLoadProbeListDoneFunc func, gpointer data)
+{
+	ImageLoadProbeList *pl;
+	GList *work;
+	guint i;
+
+	pl = g_new0(ImageLoadProbeList, 1);
+	pl->n = g_list_length(list);
+	pl->probes = g_new0(ImageLoadProbe, pl->n);
+	pl->func = func;
+	pl->data = data;
+	g_mutex_init(&pl->mutex);
+
+	for (work = list, i = 0; work; work = work->next, i++)
+		{
+		FileData *fd = work->data;
+
+		pl->probes[i].fd = file_data_ref(fd);
+		pl->probes[i].pl = pl;
+		if (image_load_probe_wanted(fd))
+			{
+			/* path_from_utf8() may log, keep it in the main thread */
+			pl->probes[i].pathl = path_from_utf8(fd->path);
+			pl->pending++;
+			}
+		}
+
+	if (pl->pending == 0)
+		{
+		g_idle_add(image_load_probe_list_done_cb, pl);
+		return pl;
+		}
+
+#ifdef HAVE_GTHREAD
+	if (!image_load_probe_pool)
+		{
+		image_load_probe_pool = g_thread_pool_new(image_load_probe_thread, NULL,
+							  IMAGE_LOAD_PROBE_THREADS, FALSE, NULL);
+		}
+
+	/* pending is final before the first worker can count it down */
+	for (i = 0; i < pl->n; i++)
+		{
+		if (pl->probes[i].pathl) g_thread_pool_push(image_load_probe_pool, &pl->probes[i], NULL);
+		}
+#else
+	for (i = 0; i < pl->n; i++)
+		{
+		if (pl->probes[i].pathl)
+			{
+			pl->probes[i].success = image_load_probe_path(pl->probes[i].fd, pl->probes[i].pathl,
+								      &pl->probes[i].width, &pl->probes[i].height);
+			}
+		}
+	g_idle_add(image_load_probe_list_done_cb, pl);
+#endif
+
+	return pl;
+}
+
+/**
+ * @brief Result for item \a n of the list given to image_load_dimensions_probe_list()
+ * @returns FALSE if the size could not be read from the header
+ */
+gboolean image_load_dimensions_probe_list_get(ImageLoadProbeList *pl, guint n, gint *width, gint *height)
+{
+	if (!pl->done || n >= pl->n || !pl->probes[n].success) return FALSE;
+
+	if (width) *width = pl->probes[n].width;
+	if (height) *height = pl->probes[n].height;
+
+	return TRUE;
+}
+
+void image_load_dimensions_probe_list_free(ImageLoadProbeList *pl)
+{
+	if (!pl) return;
+
+	if (!pl->done)
+		{
+		/* the workers still use it, the done callback frees it */
+		pl->cancelled = TRUE;
+		return;
+		}
+
+	image_load_probe_list_release(pl);
+}
+
+/* the header probe first, the full loader blocks until the size is known */
 gboolean image_load_dimensions(FileData *fd, gint *width, gint *height)
 {
 	ImageLoader *il;
 	gboolean success;
 
+	if (image_load_dimensions_probe(fd, width, height)) return TRUE;
+
 	il = image_loader_new(fd);
 
-	success = image_loader_start_idle(il);
+	/* an async backend, e.g. for videos, has no result yet */
+	success = image_loader_start_idle(il) && il->pixbuf;
 
-	if (success && il->pixbuf)
+	if (success)
 		{
 		if (width) *width = gdk_pixbuf_get_width(il->pixbuf);
 		if (height) *height = gdk_pixbuf_get_height(il->pixbuf);;
@@ -40,6 +40,7 @@ typedef gchar* (*ImageLoaderBackendFuncGetFormatName)(gpointer loader);
 typedef gchar** (*ImageLoaderBackendFuncGetFormatMimeTypes)(gpointer loader);
 typedef void (*ImageLoaderBackendFuncSetPageNum)(gpointer loader, gint page_num);
 typedef gint (*ImageLoaderBackendFuncGetPageTotal)(gpointer loader);
+typedef gboolean (*ImageLoaderBackendFuncProbe)(const guchar *buf, gsize count, gint *width, gint *height); /* optional, size from the file header only */
 
 typedef struct _ImageLoaderBackend ImageLoaderBackend;
 struct _ImageLoaderBackend
@@ -56,6 +57,9 @@ struct _ImageLoaderBackend
 	ImageLoaderBackendFuncGetFormatMimeTypes get_format_mime_types;
 	ImageLoaderBackendFuncSetPageNum set_page_num;
 	ImageLoaderBackendFuncGetPageTotal get_page_total;
+	ImageLoaderBackendFuncProbe probe;
+
+	gboolean load_async; /**< load only starts the work, the backend ends it with image_loader_backend_finish() */
 };
 
 
@@ -87,6 +91,8 @@ struct _ImageLoader
 	gboolean done;
 	guint idle_id; /**< event source id */
 	gint idle_priority;
+	ImageLoaderPriorityClass priority_class;
+	gboolean queued; /**< waiting for a loader thread */
 
 	gpointer *loader;
 	GError *error;
@@ -107,6 +113,25 @@ struct _ImageLoader
 	guchar *mapped_file;
 	gsize read_buffer_size;
 	guint idle_read_loop_count;
+
+	gint64 trace_start; /**< start of the load for tracing, 0 if not traced */
+
+	ImageLoader *source; /**< loader doing the decode for this one, see image_loader_start() */
+	GList *clients; /**< loaders fed by this one when it is a source */
+	gint page_num; /**< page to decode, taken from fd when the loader is created */
+	gboolean area_sent; /**< a source has passed area_ready on to its clients */
+	gboolean pending; /**< an async backend is still working, see image_loader_backend_finish() */
+	gboolean late_client; /**< attached after area_ready was passed on, gets the whole area at the end */
+};
+
+typedef struct _ImageLoaderQueueStats ImageLoaderQueueStats;
+struct _ImageLoaderQueueStats
+{
+	gint threads; /**< limit of running loaders */
+	guint queued[IMAGE_LOADER_PRIORITY_COUNT];
+	guint running[IMAGE_LOADER_PRIORITY_COUNT];
+	guint finished; /**< loaders run since the start */
+	guint cancelled; /**< loaders stopped before they got a thread */
 };
 
 struct _ImageLoaderClass {
@@ -148,7 +173,20 @@ void image_loader_set_buffer_size(ImageLoader *il, guint size);
  */
 void image_loader_set_priority(ImageLoader *il, gint priority);
 
+/**
+ * \headerfile image_loader_set_priority_class
+ * position in the loader queue, can be changed until a thread picks the loader,
+ * default is IMAGE_LOADER_PRIORITY_VIEW
+ */
+void image_loader_set_priority_class(ImageLoader *il, ImageLoaderPriorityClass priority_class);
+
+/**
+ * \headerfile image_loader_start
+ * loaders of the same file, page and similar requested size share one decode,
+ * small results are served from a cache
+ */
 gboolean image_loader_start(ImageLoader *il);
+void image_loader_cache_clear(void);
 
 
 GdkPixbuf *image_loader_get_pixbuf(ImageLoader *il);
@@ -158,7 +196,25 @@ FileData *image_loader_get_fd(ImageLoader *il);
 gboolean image_loader_get_shrunk(ImageLoader *il);
 const gchar *image_loader_get_error(ImageLoader *il);
 
+void image_loader_get_queue_stats(ImageLoaderQueueStats *stats);
+
+void image_loader_set_reduced(ImageLoader *il, gboolean preview);
+
+/**
+ * \headerfile image_loader_backend_finish
+ * ends a load of a backend with load_async set, must be called in the main thread
+ */
+void image_loader_backend_finish(ImageLoader *il, gboolean success);
+
 gboolean image_load_dimensions(FileData *fd, gint *width, gint *height);
+gboolean image_load_dimensions_probe(FileData *fd, gint *width, gint *height);
+gboolean image_load_dimensions_probe_local(FileData *fd, const gchar *pathl, gint *width, gint *height);
+
+typedef void (*ImageLoadProbeListDoneFunc)(ImageLoadProbeList *pl, gpointer data);
+
+ImageLoadProbeList *image_load_dimensions_probe_list(GList *list, ImageLoadProbeListDoneFunc func, gpointer data);
+gboolean image_load_dimensions_probe_list_get(ImageLoadProbeList *pl, guint n, gint *width, gint *height);
+void image_load_dimensions_probe_list_free(ImageLoadProbeList *pl);
 
 #endif
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
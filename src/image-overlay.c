@@ -52,6 +52,7 @@ struct _OverlayStateData {
 	OverlayRendererFlags origin;
 
 	gint ovl_info;
+	gchar *info_signature;	/**< text, font and colours of the shown info, NULL if it must be redrawn */
 
 	gint x;
 	gint y;
@@ -228,7 +229,8 @@ void image_osd_toggle(ImageWindow *imd)
 		}
 }
 
-static GdkPixbuf *image_osd_info_render(OverlayStateData *osd)
+/* with unchanged set, returns NULL when the shown info would be drawn the same */
+static GdkPixbuf *image_osd_info_render(OverlayStateData *osd, gboolean *unchanged)
 {
 	GdkPixbuf *pixbuf = NULL;
 	gint width, height;
@@ -240,7 +242,9 @@ static GdkPixbuf *image_osd_info_render(OverlayStateData *osd)
 	ImageWindow *imd = osd->imd;
 	FileData *fd = image_get_fd(imd);
 	PangoFontDescription *font_desc;
+	gchar *signature;
 
+	*unchanged = FALSE;
 	if (!fd) return NULL;
 
 	name = image_get_name(imd);
@@ -401,9 +405,27 @@ static GdkPixbuf *image_osd_info_render(OverlayStateData *osd)
 			}
 	}
 
+	/* the histogram is drawn from the image, only plain text can be reused */
+	signature = g_strdup_printf("%s\n%d %d %d %d %d %d %d %d\n%s", options->image_overlay.font,
+				    options->image_overlay.text_red, options->image_overlay.text_green,
+				    options->image_overlay.text_blue, options->image_overlay.text_alpha,
+				    options->image_overlay.background_red, options->image_overlay.background_green,
+				    options->image_overlay.background_blue, options->image_overlay.background_alpha, text);
+	if (!with_hist && osd->ovl_info && g_strcmp0(signature, osd->info_signature) == 0)
+		{
+		g_free(signature);
+		g_free(text);
+		*unchanged = TRUE;
+		return NULL;
+		}
+	g_free(osd->info_signature);
+	osd->info_signature = with_hist ? NULL : signature;
+	if (with_hist) g_free(signature);
+
 	font_desc = pango_font_description_from_string(options->image_overlay.font);
 	layout = gtk_widget_create_pango_layout(imd->pr, NULL);
 	pango_layout_set_font_description(layout, font_desc);
+	pango_font_description_free(font_desc);
 
 	pango_layout_set_markup(layout, text, -1);
 	g_free(text);
@@ -644,6 +666,9 @@ static void image_osd_info_show(OverlayStateData *osd, GdkPixbuf *pixbuf)
 
 static void image_osd_info_hide(OverlayStateData *osd)
 {
+	g_free(osd->info_signature);
+	osd->info_signature = NULL;
+
 	if (osd->ovl_info == 0) return;
 
 	image_overlay_remove(osd->imd, osd->ovl_info);
@@ -672,6 +697,9 @@ static gboolean image_osd_update_cb(gpointer data)
 				osd->y = ((PixbufRenderer *)imd->pr)->y_offset;
 				osd->origin = OVL_NORMAL;
 
+				g_free(osd->info_signature);
+				osd->info_signature = NULL;
+
 				pixbuf = image_osd_guidelines_render(osd);
 				if (pixbuf)
 					{
@@ -685,13 +713,15 @@ static gboolean image_osd_update_cb(gpointer data)
 				}
 			else
 				{
-				pixbuf = image_osd_info_render(osd);
+				gboolean unchanged;
+
+				pixbuf = image_osd_info_render(osd, &unchanged);
 				if (pixbuf)
 					{
 					image_osd_info_show(osd, pixbuf);
 					g_object_unref(pixbuf);
 					}
-				else
+				else if (!unchanged)
 					{
 					image_osd_info_hide(osd);
 					}
@@ -846,6 +876,7 @@ static void image_osd_free(OverlayStateData *osd)
 
 	if (osd->histogram) histogram_free(osd->histogram);
 
+	g_free(osd->info_signature);
 	g_free(osd);
 }
 
@@ -748,6 +748,7 @@ static void image_read_ahead_start(ImageWindow *imd)
 	DEBUG_1("%s read ahead started for :%s", get_exec_time(), imd->read_ahead_fd->path);
 
 	imd->read_ahead_il = image_loader_new(imd->read_ahead_fd);
+	image_loader_set_priority_class(imd->read_ahead_il, IMAGE_LOADER_PRIORITY_READ_AHEAD);
 
 	image_loader_delay_area_ready(imd->read_ahead_il, TRUE); /* we will need the area_ready signals later */
 
@@ -798,14 +799,32 @@ static void image_cache_set(ImageWindow *imd, FileData *fd)
 {
 	g_assert(fd->pixbuf);
 
-	file_cache_put(image_get_cache(), fd, (gulong)gdk_pixbuf_get_rowstride(fd->pixbuf) * (gulong)gdk_pixbuf_get_height(fd->pixbuf));
+	/* reduced levels are built later but are accounted for here */
+	pixbuf_pyramid_build(fd->pixbuf);
+	file_cache_put(image_get_cache(), fd, (gulong)gdk_pixbuf_get_rowstride(fd->pixbuf) * (gulong)gdk_pixbuf_get_height(fd->pixbuf) + pixbuf_pyramid_size(fd->pixbuf));
 	file_data_send_notification(fd, NOTIFY_PIXBUF); /* to update histogram */
 }
 
+/* pixbufs held for callers that decode ahead, outside of the image cache budget */
+static GHashTable *image_cache_pinned = NULL;
+
 static gint image_cache_get(ImageWindow *imd)
 {
 	gint success;
 
+	if (image_cache_pinned)
+		{
+		GdkPixbuf *pixbuf = g_hash_table_lookup(image_cache_pinned, imd->image_fd);
+
+		if (pixbuf)
+			{
+			/* keep the usual cache behaviour, but show it even if it does not fit */
+			if (!imd->image_fd->pixbuf) image_cache_add(imd->image_fd, pixbuf);
+			image_change_pixbuf(imd, pixbuf, image_zoom_get(imd), FALSE);
+			return TRUE;
+			}
+		}
+
 	success = file_cache_get(image_get_cache(), imd->image_fd);
 	if (success)
 		{
@@ -859,6 +878,9 @@ static void image_load_done_cb(ImageLoader *il, gpointer data)
 		imd->image_fd->pixbuf = g_object_ref(image_loader_get_pixbuf(imd->il));
 		image_cache_set(imd, imd->image_fd);
 		}
+	/* the pixbuf is complete now */
+	pixbuf_pyramid_build(image_loader_get_pixbuf(imd->il));
+
 	/* call the callback triggered by image_state after fd->pixbuf is set */
 	g_object_set(G_OBJECT(imd->pr), "loading", FALSE, NULL);
 	image_state_unset(imd, IMAGE_STATE_LOADING);
@@ -959,6 +981,8 @@ static gboolean image_read_ahead_check(ImageWindow *imd)
 		imd->il = imd->read_ahead_il;
 		imd->read_ahead_il = NULL;
 
+		/* still queued or sharing a decode, move it to the front */
+		image_loader_set_priority_class(imd->il, IMAGE_LOADER_PRIORITY_VIEW);
 		image_load_set_signals(imd, TRUE);
 
 		g_object_set(G_OBJECT(imd->pr), "loading", TRUE, NULL);
@@ -1803,6 +1827,51 @@ void image_prebuffer_set(ImageWindow *imd, FileData *fd)
 		}
 }
 
+/* decoded image cache, shared with users that decode ahead on their own */
+
+gboolean image_cache_contains(FileData *fd)
+{
+	if (!fd) return FALSE;
+
+	if (image_cache_pinned && g_hash_table_lookup(image_cache_pinned, fd)) return TRUE;
+
+	return file_cache_get(image_get_cache(), fd);
+}
+
+void image_cache_pin(FileData *fd, GdkPixbuf *pixbuf)
+{
+	if (!fd || !pixbuf) return;
+
+	if (!image_cache_pinned) image_cache_pinned = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	image_cache_unpin(fd);
+
+	g_hash_table_insert(image_cache_pinned, file_data_ref(fd), g_object_ref(pixbuf));
+}
+
+void image_cache_unpin(FileData *fd)
+{
+	GdkPixbuf *pixbuf;
+
+	if (!fd || !image_cache_pinned) return;
+
+	pixbuf = g_hash_table_lookup(image_cache_pinned, fd);
+	if (!pixbuf) return;
+
+	g_hash_table_remove(image_cache_pinned, fd);
+	g_object_unref(pixbuf);
+	file_data_unref(fd);
+}
+
+void image_cache_add(FileData *fd, GdkPixbuf *pixbuf)
+{
+	if (!fd || !pixbuf || fd->pixbuf) return;
+
+	fd->pixbuf = pixbuf;
+	g_object_ref(fd->pixbuf);
+	image_cache_set(NULL, fd);
+}
+
 static void image_notify_cb(FileData *fd, NotifyType type, gpointer data)
 {
 	ImageWindow *imd = data;
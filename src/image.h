@@ -120,6 +120,32 @@ void image_stereo_pixbuf_set(ImageWindow *imd, StereoPixbufData stereo_mode);
  */
 void image_prebuffer_set(ImageWindow *imd, FileData *fd);
 
+/**
+ * \headerfile image_cache_contains
+ * TRUE if fd is in the decoded image cache, marks it as recently used
+ */
+gboolean image_cache_contains(FileData *fd);
+
+/**
+ * \headerfile image_cache_add
+ * adds a fully decoded pixbuf of fd to the decoded image cache,
+ * a following image_change_fd() will use it without loading
+ */
+void image_cache_add(FileData *fd, GdkPixbuf *pixbuf);
+
+/**
+ * \headerfile image_cache_pin
+ * holds a reference to a decoded pixbuf of fd outside of the image cache budget,
+ * image_change_fd() uses it until image_cache_unpin() is called
+ */
+void image_cache_pin(FileData *fd, GdkPixbuf *pixbuf);
+
+/**
+ * \headerfile image_cache_unpin
+ * releases a pixbuf held by image_cache_pin()
+ */
+void image_cache_unpin(FileData *fd);
+
 /**
  * \headerfile image_auto_refresh_enable
  * auto refresh
@@ -596,6 +596,16 @@ static void image_loader_dds_free(gpointer loader)
 	g_free(ld);
 }
 
+static gboolean image_loader_dds_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	if (count < 128 || memcmp(buf, "DDS ", 4) != 0 || ddsGetType(buf) == 0) return FALSE;
+	if (ddsGetWidth(buf) < 1 || ddsGetHeight(buf) < 1) return FALSE;
+
+	*width = ddsGetWidth(buf);
+	*height = ddsGetHeight(buf);
+	return TRUE;
+}
+
 void image_loader_backend_set_dds(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_dds_new;
@@ -608,6 +618,7 @@ void image_loader_backend_set_dds(ImageLoaderBackend *funcs)
 	funcs->free = image_loader_dds_free;
 	funcs->get_format_name = image_loader_dds_get_format_name;
 	funcs->get_format_mime_types = image_loader_dds_get_format_mime_types;
+	funcs->probe = image_loader_dds_probe;
 }
 
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
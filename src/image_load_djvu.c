@@ -22,6 +22,7 @@
 
 #include "image-load.h"
 #include "image_load_djvu.h"
+#include "page_cache.h"
 
 #ifdef HAVE_DJVU
 
@@ -47,11 +48,25 @@ static void free_buffer(guchar *pixels, gpointer data)
 	g_free (pixels);;
 }
 
-static gboolean image_loader_djvu_load(gpointer loader, const guchar *buf, gsize count, GError **error)
-{
-	ImageLoaderDJVU *ld = (ImageLoaderDJVU *) loader;
+/* the decoded document is kept in the page cache between page flips */
+typedef struct _DJVUDocument DJVUDocument;
+struct _DJVUDocument {
 	ddjvu_context_t *ctx;
 	ddjvu_document_t *doc;
+};
+
+static void image_loader_djvu_document_free(gpointer data)
+{
+	DJVUDocument *djvu = data;
+
+	ddjvu_document_release(djvu->doc);
+	ddjvu_context_release(djvu->ctx);
+	g_free(djvu);
+}
+
+static GdkPixbuf *image_loader_djvu_render(gpointer data, gint page_num)
+{
+	DJVUDocument *djvu = data;
 	ddjvu_page_t *page;
 	ddjvu_rect_t rrect;
 	ddjvu_rect_t prect;
@@ -61,17 +76,10 @@ static gboolean image_loader_djvu_load(gpointer loader, const guchar *buf, gsize
 	gboolean alpha = FALSE;
 	cairo_surface_t *surface;
 	guchar *pixels;
+	GdkPixbuf *pixbuf;
 
-	ctx = ddjvu_context_create(NULL);
-
-	doc = ddjvu_document_create(ctx, NULL, FALSE);
-
-	ddjvu_stream_write(doc, 0, (char *)buf, count );
-	while (!ddjvu_document_decoding_done(doc));
-
-	ld->page_total = ddjvu_document_get_pagenum(doc);
-
-	page = ddjvu_page_create_by_pageno(doc, ld->page_num);
+	page = ddjvu_page_create_by_pageno(djvu->doc, page_num);
+	if (!page) return NULL;
 	while (!ddjvu_page_decoding_done(page));
 
 	fmt = ddjvu_format_create(DDJVU_FORMAT_RGB24, 0, 0);
@@ -99,17 +107,101 @@ static gboolean image_loader_djvu_load(gpointer loader, const guchar *buf, gsize
 	tmp2 = gdk_pixbuf_flip(tmp1, TRUE);
 	g_object_unref(tmp1);
 
-	ld->pixbuf = gdk_pixbuf_rotate_simple(tmp2,GDK_PIXBUF_ROTATE_UPSIDEDOWN);
-
-	ld->area_updated_cb(loader, 0, 0, width, height, ld->data);
-
+	pixbuf = gdk_pixbuf_rotate_simple(tmp2,GDK_PIXBUF_ROTATE_UPSIDEDOWN);
+	g_object_unref(tmp2);
 
 	cairo_surface_destroy(surface);
+	ddjvu_format_release(fmt);
 	ddjvu_page_release(page);
-	ddjvu_document_release(doc);
-	ddjvu_context_release(ctx);
 
-	return TRUE;
+	return pixbuf;
+}
+
+static DJVUDocument *image_loader_djvu_document_new(const guchar *buf, gsize count)
+{
+	DJVUDocument *djvu = g_new0(DJVUDocument, 1);
+
+	djvu->ctx = ddjvu_context_create(NULL);
+	djvu->doc = ddjvu_document_create(djvu->ctx, NULL, FALSE);
+
+	ddjvu_stream_write(djvu->doc, 0, (char *)buf, count );
+	while (!ddjvu_document_decoding_done(djvu->doc));
+
+	return djvu;
+}
+
+/* renders the page from a document that is not kept */
+static GdkPixbuf *image_loader_djvu_render_uncached(ImageLoaderDJVU *ld, const guchar *buf, gsize count)
+{
+	DJVUDocument *djvu;
+	GdkPixbuf *pixbuf = NULL;
+
+	djvu = image_loader_djvu_document_new(buf, count);
+	ld->page_total = ddjvu_document_get_pagenum(djvu->doc);
+	if (!ld->abort) pixbuf = image_loader_djvu_render(djvu, ld->page_num);
+	image_loader_djvu_document_free(djvu);
+
+	return pixbuf;
+}
+
+static gboolean image_loader_djvu_load(gpointer loader, const guchar *buf, gsize count, GError **error)
+{
+	ImageLoaderDJVU *ld = (ImageLoaderDJVU *) loader;
+	ImageLoader *il = ld->data;
+	PageCache *pc;
+	DJVUDocument *djvu;
+
+	if (ld->abort) return FALSE;
+
+	if (il->requested_width > 0 && il->requested_height > 0)
+		{
+		/* thumbnails need one page once, not worth keeping the document */
+		ld->pixbuf = image_loader_djvu_render_uncached(ld, buf, count);
+		}
+	else
+		{
+		pc = page_cache_ref(il->fd);
+		page_cache_lock(pc);
+
+		ld->pixbuf = page_cache_lookup(pc, ld->page_num);
+		if (!ld->pixbuf)
+			{
+			djvu = page_cache_get_document(pc);
+			if (!djvu && !page_cache_get_busy(pc))
+				{
+				/* the decoded document holds about as much as the file */
+				djvu = image_loader_djvu_document_new(buf, count);
+				page_cache_set_document(pc, djvu, count, ddjvu_document_get_pagenum(djvu->doc),
+							image_loader_djvu_render, image_loader_djvu_document_free);
+				djvu = page_cache_get_document(pc);
+				}
+
+			if (djvu && !ld->abort)
+				{
+				ld->pixbuf = image_loader_djvu_render(djvu, ld->page_num);
+				page_cache_insert(pc, ld->page_num, ld->pixbuf);
+				}
+			else if (!djvu && !ld->abort && page_cache_get_busy(pc))
+				{
+				/* a neighbour page is rendered in the background, do not wait for it */
+				ld->pixbuf = image_loader_djvu_render_uncached(ld, buf, count);
+				}
+			}
+
+		if (page_cache_get_page_total(pc) > 0) ld->page_total = page_cache_get_page_total(pc);
+
+		if (ld->pixbuf && !ld->abort) page_cache_prerender(pc, ld->page_num);
+
+		page_cache_unlock(pc);
+		page_cache_unref(pc);
+		}
+
+	if (ld->pixbuf && !ld->abort)
+		{
+		ld->area_updated_cb(loader, 0, 0, gdk_pixbuf_get_width(ld->pixbuf), gdk_pixbuf_get_height(ld->pixbuf), ld->data);
+		}
+
+	return (ld->pixbuf != NULL);
 }
 
 static gpointer image_loader_djvu_new(ImageLoaderBackendCbAreaUpdated area_updated_cb, ImageLoaderBackendCbSize size_cb, ImageLoaderBackendCbAreaPrepared area_prepared_cb, gpointer data)
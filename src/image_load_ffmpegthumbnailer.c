@@ -26,20 +26,21 @@
 #ifdef HAVE_FFMPEGTHUMBNAILER
 #include <libffmpegthumbnailer/videothumbnailerc.h>
 
+typedef struct _ImageLoaderFTJob ImageLoaderFTJob;
+
 typedef struct _ImageLoaderFT ImageLoaderFT;
 struct _ImageLoaderFT {
 	ImageLoaderBackendCbAreaUpdated area_updated_cb;
 	ImageLoaderBackendCbSize size_cb;
 	ImageLoaderBackendCbAreaPrepared area_prepared_cb;
 
-	video_thumbnailer *vt;
-
 	gpointer data;
 
 	GdkPixbuf *pixbuf;
 	guint requested_width;
 	guint requested_height;
 
+	ImageLoaderFTJob *job; /**< running extraction, protected by ft_mutex */
 };
 
 #if HAVE_FFMPEGTHUMBNAILER_RGB
@@ -78,13 +79,6 @@ static gpointer image_loader_ft_new(ImageLoaderBackendCbAreaUpdated area_updated
 	loader->area_prepared_cb = area_prepared_cb;
 	loader->data = data;
 
-	loader->vt = video_thumbnailer_create();
-	loader->vt->overlay_film_strip = 1;
-	loader->vt->maintain_aspect_ratio = 1;
-#if HAVE_FFMPEGTHUMBNAILER_RGB
-	video_thumbnailer_set_log_callback(loader->vt, image_loader_ft_log_cb);
-#endif
-
 	return (gpointer) loader;
 }
 
@@ -96,66 +90,229 @@ static void image_loader_ft_set_size(gpointer loader, int width, int height)
 	DEBUG_1("TG: setting size, w=%d, h=%d", width, height);
 }
 
-// static gboolean image_loader_ft_loadfromdisk(gpointer loader, const gchar *path, GError **error)
-static gboolean image_loader_ft_load (gpointer loader, const guchar *buf, gsize count, GError **error)
+/*
+ *-----------------------------------------------------------------------------
+ * frame extraction workers
+ *-----------------------------------------------------------------------------
+ */
+
+/* Frames are extracted on a separate, small pool. The loader only starts the
+ * job and gives its thread back, the result is handed over in the main thread,
+ * so slow or broken videos can only ever tie up these threads. A job stays
+ * attached to its loader until then, a loader that is stopped or gives up
+ * detaches it; a job that did not get a thread yet is then dropped unstarted.
+ * The timeout counts from the moment a thread picks the job up. */
+
+struct _ImageLoaderFTJob {
+	gchar *path;
+	guint width;
+	guint height;
+	gboolean use_metadata;
+
+	ImageLoaderFT *lft; /**< NULL when detached, protected by ft_mutex */
+	GdkPixbuf *pixbuf;
+	gboolean abandoned; /**< detached before it was started */
+	guint timeout_id; /**< event source id */
+	gint ref; /**< the worker or its done idle, and the timeout */
+};
+
+static GThreadPool *ft_pool = NULL;
+static GMutex ft_mutex;
+
+/* this function expects that ft_mutex is locked by caller */
+static void image_loader_ft_job_unref(ImageLoaderFTJob *job)
 {
-	ImageLoaderFT *lft = (ImageLoaderFT *) loader;
-	ImageLoader *il = lft->data;
+	job->ref--;
+	if (job->ref > 0) return;
+
+	if (job->pixbuf) g_object_unref(job->pixbuf);
+	g_free(job->path);
+	g_free(job);
+}
+
+/* this function expects that ft_mutex is locked by caller */
+static void image_loader_ft_job_detach(ImageLoaderFT *lft)
+{
+	if (!lft->job) return;
+
+	lft->job->lft = NULL;
+	lft->job->abandoned = TRUE;
+	lft->job = NULL;
+}
 
-	image_data *image = video_thumbnailer_create_image_data();
+static GdkPixbuf *image_loader_ft_extract(ImageLoaderFTJob *job)
+{
+	video_thumbnailer *vt;
+	image_data *image;
+	GdkPixbuf *pixbuf;
+
+	vt = video_thumbnailer_create();
+	vt->overlay_film_strip = 1;
+	vt->maintain_aspect_ratio = 1;
+#if HAVE_FFMPEGTHUMBNAILER_RGB
+	video_thumbnailer_set_log_callback(vt, image_loader_ft_log_cb);
+#endif
 
 #ifdef HAVE_FFMPEGTHUMBNAILER_WH
-//	DEBUG_1("TG: FT requested size w=%d:h=%d for %s", lft->requested_width > 0, lft->requested_height, il->fd->path);
-	video_thumbnailer_set_size(lft->vt, lft->requested_width, lft->requested_height);
+	video_thumbnailer_set_size(vt, job->width, job->height);
 #else
-	lft->vt->thumbnail_size = MAX(lft->requested_width,lft->requested_width);
+	vt->thumbnail_size = MAX(job->width, job->height);
 #endif
 
 #ifdef HAVE_FFMPEGTHUMBNAILER_METADATA
-	lft->vt->prefer_embedded_metadata = options->thumbnails.use_ft_metadata ? 1 : 0;
+	vt->prefer_embedded_metadata = job->use_metadata ? 1 : 0;
 #endif
 
 #if HAVE_FFMPEGTHUMBNAILER_RGB
-	lft->vt->thumbnail_image_type = Rgb;
+	vt->thumbnail_image_type = Rgb;
 #else
-	lft->vt->thumbnail_image_type = Png;
+	vt->thumbnail_image_type = Png;
 #endif
 
-	video_thumbnailer_generate_thumbnail_to_buffer (lft->vt, il->fd->path, image);
+	image = video_thumbnailer_create_image_data();
+	video_thumbnailer_generate_thumbnail_to_buffer(vt, job->path, image);
 
 #if HAVE_FFMPEGTHUMBNAILER_RGB
-	lft->pixbuf  = gdk_pixbuf_new_from_data (image->image_data_ptr, GDK_COLORSPACE_RGB, FALSE, 8, image->image_data_width, image->image_data_height,  image->image_data_width*3, image_loader_ft_destroy_image_data, image);
-	lft->size_cb(loader, image->image_data_width, image->image_data_height, lft->data);
-	lft->area_updated_cb(loader, 0, 0, image->image_data_width, image->image_data_height, lft->data);
+	pixbuf = gdk_pixbuf_new_from_data(image->image_data_ptr, GDK_COLORSPACE_RGB, FALSE, 8, image->image_data_width, image->image_data_height, image->image_data_width*3, image_loader_ft_destroy_image_data, image);
 #else
 	GInputStream *image_stream;
-	image_stream = g_memory_input_stream_new_from_data (image->image_data_ptr, image->image_data_size, NULL);
+	image_stream = g_memory_input_stream_new_from_data(image->image_data_ptr, image->image_data_size, NULL);
+
+	pixbuf = image_stream ? gdk_pixbuf_new_from_stream(image_stream, NULL, NULL) : NULL;
+	if (image_stream) g_object_unref(image_stream);
+	video_thumbnailer_destroy_image_data(image);
+#endif
+
+	video_thumbnailer_destroy(vt);
+
+	return pixbuf;
+}
+
+static gboolean image_loader_ft_timeout_cb(gpointer data)
+{
+	ImageLoaderFTJob *job = data;
+	ImageLoaderFT *lft;
+
+	g_mutex_lock(&ft_mutex);
+	job->timeout_id = 0;
+	lft = job->lft;
+	if (lft)
+		{
+		log_printf("FFmpegthumbnailer: no frame from %s after %d seconds, giving up\n", job->path, options->thumbnails.video_timeout);
+		image_loader_ft_job_detach(lft);
+		}
+	image_loader_ft_job_unref(job);
+	g_mutex_unlock(&ft_mutex);
+
+	if (lft) image_loader_backend_finish(lft->data, FALSE);
 
-	if (image_stream == NULL)
-	{
-	video_thumbnailer_destroy_image_data (image);
-	DEBUG_1("FFmpegthumbnailer: cannot open stream for %s", il->fd->path);
 	return FALSE;
-    }
+}
 
-	lft->pixbuf  = gdk_pixbuf_new_from_stream (image_stream, NULL, NULL);
-	lft->size_cb(loader, gdk_pixbuf_get_width(lft->pixbuf), gdk_pixbuf_get_height(lft->pixbuf), lft->data);
-	g_object_unref (image_stream);
-	video_thumbnailer_destroy_image_data (image);
-#endif
+static gboolean image_loader_ft_done_cb(gpointer data)
+{
+	ImageLoaderFTJob *job = data;
+	ImageLoaderFT *lft;
+	GdkPixbuf *pixbuf;
 
-	if (!lft->pixbuf)
+	g_mutex_lock(&ft_mutex);
+	if (job->timeout_id)
+		{
+		g_source_remove(job->timeout_id);
+		job->timeout_id = 0;
+		image_loader_ft_job_unref(job);
+		}
+	lft = job->lft;
+	if (lft) image_loader_ft_job_detach(lft);
+	pixbuf = job->pixbuf;
+	job->pixbuf = NULL;
+	image_loader_ft_job_unref(job);
+	g_mutex_unlock(&ft_mutex);
+
+	if (!lft)
 		{
-		DEBUG_1("FFmpegthumbnailer: no frame generated for %s", il->fd->path);
+		if (pixbuf) g_object_unref(pixbuf);
 		return FALSE;
 		}
 
+	lft->pixbuf = pixbuf;
+	if (pixbuf)
+		{
+		lft->size_cb(lft, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf), lft->data);
+
 /* See comment in image_loader_area_prepared_cb
  * Geeqie uses area_prepared signal to fill pixbuf with background color.
  * We can't do it here as pixbuf already contains the data */
-// 	lft->area_prepared_cb(loader, lft->data);
+//		lft->area_prepared_cb(lft, lft->data);
+
+		lft->area_updated_cb(lft, 0, 0, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf), lft->data);
+		}
+	else
+		{
+		DEBUG_1("FFmpegthumbnailer: no frame generated for %s", ((ImageLoader *)lft->data)->fd->path);
+		}
+
+	image_loader_backend_finish(lft->data, pixbuf != NULL);
+
+	return FALSE;
+}
+
+static void image_loader_ft_worker(gpointer data, gpointer user_data)
+{
+	ImageLoaderFTJob *job = data;
+	GdkPixbuf *pixbuf;
+
+	g_mutex_lock(&ft_mutex);
+	if (job->abandoned)
+		{
+		image_loader_ft_job_unref(job);
+		g_mutex_unlock(&ft_mutex);
+		return;
+		}
+	if (options->thumbnails.video_timeout > 0)
+		{
+		job->ref++;
+		job->timeout_id = g_timeout_add_seconds(options->thumbnails.video_timeout, image_loader_ft_timeout_cb, job);
+		}
+	g_mutex_unlock(&ft_mutex);
 
-	lft->area_updated_cb(loader, 0, 0, gdk_pixbuf_get_width(lft->pixbuf), gdk_pixbuf_get_height(lft->pixbuf), lft->data);
+	pixbuf = image_loader_ft_extract(job);
+
+	g_mutex_lock(&ft_mutex);
+	job->pixbuf = pixbuf;
+	g_mutex_unlock(&ft_mutex);
+
+	g_idle_add(image_loader_ft_done_cb, job);
+}
+
+// static gboolean image_loader_ft_loadfromdisk(gpointer loader, const gchar *path, GError **error)
+static gboolean image_loader_ft_load (gpointer loader, const guchar *buf, gsize count, GError **error)
+{
+	ImageLoaderFT *lft = (ImageLoaderFT *) loader;
+	ImageLoader *il = lft->data;
+	ImageLoaderFTJob *job;
+
+	job = g_new0(ImageLoaderFTJob, 1);
+	job->path = g_strdup(il->fd->path);
+	job->width = lft->requested_width;
+	job->height = lft->requested_height;
+	job->use_metadata = options->thumbnails.use_ft_metadata;
+	job->lft = lft;
+	job->ref = 1;
+
+	/* the job may finish at once, lft must not be used after the push */
+	g_mutex_lock(&ft_mutex);
+	if (!ft_pool)
+		{
+		ft_pool = g_thread_pool_new(image_loader_ft_worker, NULL, options->thumbnails.video_threads, FALSE, NULL);
+		}
+	else
+		{
+		g_thread_pool_set_max_threads(ft_pool, options->thumbnails.video_threads, NULL);
+		}
+	lft->job = job;
+	g_thread_pool_push(ft_pool, job, NULL);
+	g_mutex_unlock(&ft_mutex);
 
 	return TRUE;
 }
@@ -168,6 +325,11 @@ static GdkPixbuf* image_loader_ft_get_pixbuf(gpointer loader)
 
 static void image_loader_ft_abort(gpointer loader)
 {
+	ImageLoaderFT *lft = (ImageLoaderFT *) loader;
+
+	g_mutex_lock(&ft_mutex);
+	image_loader_ft_job_detach(lft);
+	g_mutex_unlock(&ft_mutex);
 }
 
 static gboolean image_loader_ft_close(gpointer loader, GError **error)
@@ -178,8 +340,12 @@ static gboolean image_loader_ft_close(gpointer loader, GError **error)
 static void image_loader_ft_free(gpointer loader)
 {
 	ImageLoaderFT *lft = (ImageLoaderFT *) loader;
+
+	g_mutex_lock(&ft_mutex);
+	image_loader_ft_job_detach(lft);
+	g_mutex_unlock(&ft_mutex);
+
 	if (lft->pixbuf) g_object_unref(lft->pixbuf);
-	video_thumbnailer_destroy (lft->vt);
 
 	g_free(lft);
 }
@@ -197,6 +363,8 @@ void image_loader_backend_set_ft(ImageLoaderBackend *funcs)
 
 	funcs->get_format_name = image_loader_ft_get_format_name;
 	funcs->get_format_mime_types = image_loader_ft_get_format_mime_types;
+
+	funcs->load_async = TRUE;
 }
 
 #endif
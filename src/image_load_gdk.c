@@ -62,6 +62,24 @@ static void image_loader_gdk_free(gpointer loader)
 	g_object_unref(G_OBJECT(loader));
 }
 
+/* only PNG, the other formats of gdk-pixbuf need the full loader */
+static gboolean image_loader_gdk_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	guint32 w, h;
+
+	if (count < 24 ||
+	    memcmp(buf, "\x89PNG\r\n\x1a\n", 8) != 0 ||
+	    memcmp(buf + 12, "IHDR", 4) != 0) return FALSE;
+
+	w = ((guint32)buf[16] << 24) | ((guint32)buf[17] << 16) | ((guint32)buf[18] << 8) | buf[19];
+	h = ((guint32)buf[20] << 24) | ((guint32)buf[21] << 16) | ((guint32)buf[22] << 8) | buf[23];
+	if (w < 1 || h < 1 || w > G_MAXINT || h > G_MAXINT) return FALSE;
+
+	*width = w;
+	*height = h;
+	return TRUE;
+}
+
 void image_loader_backend_set_default(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_gdk_new;
@@ -75,6 +93,7 @@ void image_loader_backend_set_default(ImageLoaderBackend *funcs)
 
 	funcs->get_format_name = image_loader_gdk_get_format_name;
 	funcs->get_format_mime_types = image_loader_gdk_get_format_mime_types;
+	funcs->probe = image_loader_gdk_probe;
 }
 
 
@@ -85,6 +85,13 @@ static gboolean image_loader_heif_load(gpointer loader, const guchar *buf, gsize
 			return FALSE;
 			}
 
+		if (ld->abort)
+			{
+			heif_image_handle_release(handle);
+			heif_context_free(ctx);
+			return FALSE;
+			}
+
 		// decode the image and convert colorspace to RGB, saved as 24bit interleaved
 		error_code = heif_decode_image(handle, &img, heif_colorspace_RGB, heif_chroma_interleaved_24bit, NULL);
 		if (error_code.code)
@@ -177,6 +184,266 @@ static void image_loader_heif_free(gpointer loader)
 	g_free(ld);
 }
 
+/*
+ * Header probe: the ispe property of the primary item, from the meta box.
+ * The loader opens the first top level image, so the probe only answers when
+ * that is the primary item. Cropped (clap) images are left to the full loader.
+ */
+
+#define HEIF_PROBE_16(p) (((guint)(p)[0] << 8) | (p)[1])
+#define HEIF_PROBE_32(p) (((guint32)(p)[0] << 24) | ((guint32)(p)[1] << 16) | ((guint32)(p)[2] << 8) | (p)[3])
+#define HEIF_PROBE_FOURCC(a, b, c, d) (((guint32)(a) << 24) | ((guint32)(b) << 16) | ((guint32)(c) << 8) | (d))
+
+typedef struct _HeifProbeBox HeifProbeBox;
+struct _HeifProbeBox {
+	guint32 type;
+	gsize content;	/**< offset of the box content */
+	gsize end;	/**< offset after the box */
+};
+
+static gboolean heif_probe_box(const guchar *buf, gsize *offset, gsize end, HeifProbeBox *box)
+{
+	guint64 size;
+	gsize header = 8;
+
+	if (*offset + 8 > end) return FALSE;
+
+	size = HEIF_PROBE_32(buf + *offset);
+	box->type = HEIF_PROBE_32(buf + *offset + 4);
+	if (size == 1)
+		{
+		if (*offset + 16 > end) return FALSE;
+		size = ((guint64)HEIF_PROBE_32(buf + *offset + 8) << 32) | HEIF_PROBE_32(buf + *offset + 12);
+		header = 16;
+		}
+	else if (size == 0)
+		{
+		size = end - *offset;
+		}
+	if (size < header || size > end - *offset) return FALSE;
+
+	box->content = *offset + header;
+	box->end = *offset + size;
+	*offset = box->end;
+
+	return TRUE;
+}
+
+static gboolean heif_probe_is_image_type(guint32 type)
+{
+	return (type == HEIF_PROBE_FOURCC('h','v','c','1') ||
+		type == HEIF_PROBE_FOURCC('a','v','0','1') ||
+		type == HEIF_PROBE_FOURCC('g','r','i','d') ||
+		type == HEIF_PROBE_FOURCC('i','d','e','n') ||
+		type == HEIF_PROBE_FOURCC('i','o','v','l') ||
+		type == HEIF_PROBE_FOURCC('j','p','e','g'));
+}
+
+/* thumbnails, auxiliary images and grid tiles are not top level images */
+static gboolean heif_probe_is_referenced(const guchar *buf, const HeifProbeBox *iref, guint32 item_id)
+{
+	gsize offset;
+	gboolean large;
+	HeifProbeBox ref;
+
+	if (!iref || iref->content + 4 > iref->end) return FALSE;
+
+	large = (buf[iref->content] != 0);
+	offset = iref->content + 4;
+	while (heif_probe_box(buf, &offset, iref->end, &ref))
+		{
+		gsize p = ref.content;
+		guint32 from;
+		guint count;
+		guint i;
+
+		if (p + (large ? 6 : 4) > ref.end) return TRUE;
+		from = large ? HEIF_PROBE_32(buf + p) : HEIF_PROBE_16(buf + p);
+		p += large ? 4 : 2;
+		count = HEIF_PROBE_16(buf + p);
+		p += 2;
+
+		if ((ref.type == HEIF_PROBE_FOURCC('t','h','m','b') ||
+		     ref.type == HEIF_PROBE_FOURCC('a','u','x','l')) && from == item_id) return TRUE;
+
+		if (ref.type != HEIF_PROBE_FOURCC('d','i','m','g')) continue;
+
+		for (i = 0; i < count; i++)
+			{
+			guint32 to;
+
+			if (p + (large ? 4 : 2) > ref.end) return TRUE;
+			to = large ? HEIF_PROBE_32(buf + p) : HEIF_PROBE_16(buf + p);
+			p += large ? 4 : 2;
+			if (to == item_id) return TRUE;
+			}
+		}
+
+	return FALSE;
+}
+
+static gboolean image_loader_heif_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	HeifProbeBox box;
+	HeifProbeBox meta = { 0, 0, 0 };
+	HeifProbeBox pitm = { 0, 0, 0 };
+	HeifProbeBox iinf = { 0, 0, 0 };
+	HeifProbeBox iref = { 0, 0, 0 };
+	HeifProbeBox ipco = { 0, 0, 0 };
+	HeifProbeBox ipma = { 0, 0, 0 };
+	gsize offset = 0;
+	guint32 primary;
+	guint32 first = G_MAXUINT32;
+	guint entries;
+	guint i;
+	gint w = 0;
+	gint h = 0;
+	gboolean swap = FALSE;
+
+	while (!meta.end && heif_probe_box(buf, &offset, count, &box))
+		{
+		if (box.type == HEIF_PROBE_FOURCC('m','e','t','a')) meta = box;
+		}
+	if (!meta.end || meta.content + 4 > meta.end) return FALSE;
+
+	offset = meta.content + 4;
+	while (heif_probe_box(buf, &offset, meta.end, &box))
+		{
+		if (box.type == HEIF_PROBE_FOURCC('p','i','t','m')) pitm = box;
+		else if (box.type == HEIF_PROBE_FOURCC('i','i','n','f')) iinf = box;
+		else if (box.type == HEIF_PROBE_FOURCC('i','r','e','f')) iref = box;
+		else if (box.type == HEIF_PROBE_FOURCC('i','p','r','p'))
+			{
+			gsize p = box.content;
+			HeifProbeBox child;
+
+			while (heif_probe_box(buf, &p, box.end, &child))
+				{
+				if (child.type == HEIF_PROBE_FOURCC('i','p','c','o')) ipco = child;
+				else if (child.type == HEIF_PROBE_FOURCC('i','p','m','a')) ipma = child;
+				}
+			}
+		}
+	if (!pitm.end || !iinf.end || !ipco.end || !ipma.end) return FALSE;
+
+	/* primary item */
+	if (pitm.content + 6 > pitm.end || pitm.content + (buf[pitm.content] ? 8 : 6) > pitm.end) return FALSE;
+	primary = buf[pitm.content] ? HEIF_PROBE_32(buf + pitm.content + 4) : HEIF_PROBE_16(buf + pitm.content + 4);
+
+	/* the first top level image, as the loader sees it */
+	if (iinf.content + 6 > iinf.end) return FALSE;
+	offset = iinf.content + (buf[iinf.content] ? 8 : 6);
+	while (heif_probe_box(buf, &offset, iinf.end, &box))
+		{
+		gsize p = box.content;
+		guint32 item_id;
+		guint32 item_type;
+		gboolean hidden;
+
+		if (box.type != HEIF_PROBE_FOURCC('i','n','f','e') || p + 4 > box.end) continue;
+		if (buf[p] < 2) return FALSE;
+
+		hidden = (buf[p + 3] & 1);
+		p += 4;
+		if (buf[box.content] == 2)
+			{
+			if (p + 8 > box.end) return FALSE;
+			item_id = HEIF_PROBE_16(buf + p);
+			p += 2;
+			}
+		else
+			{
+			if (p + 10 > box.end) return FALSE;
+			item_id = HEIF_PROBE_32(buf + p);
+			p += 4;
+			}
+		item_type = HEIF_PROBE_32(buf + p + 2);
+
+		if (!hidden && heif_probe_is_image_type(item_type) &&
+		    !heif_probe_is_referenced(buf, iref.end ? &iref : NULL, item_id))
+			{
+			first = MIN(first, item_id);
+			}
+		}
+	if (first != primary) return FALSE;
+
+	/* properties of the primary item */
+	if (ipma.content + 8 > ipma.end) return FALSE;
+	offset = ipma.content + 8;
+	entries = HEIF_PROBE_32(buf + ipma.content + 4);
+	for (i = 0; i < entries; i++)
+		{
+		gboolean large_id = (buf[ipma.content] >= 1);
+		gboolean large_index = (buf[ipma.content + 3] & 1);
+		guint32 item_id;
+		guint associations;
+		guint j;
+
+		if (offset + (large_id ? 5 : 3) > ipma.end) return FALSE;
+		item_id = large_id ? HEIF_PROBE_32(buf + offset) : HEIF_PROBE_16(buf + offset);
+		offset += large_id ? 4 : 2;
+		associations = buf[offset];
+		offset++;
+
+		if (offset + associations * (large_index ? 2 : 1) > ipma.end) return FALSE;
+		if (item_id != primary)
+			{
+			offset += associations * (large_index ? 2 : 1);
+			continue;
+			}
+
+		for (j = 0; j < associations; j++)
+			{
+			guint index;
+			gsize p = ipco.content;
+			guint n = 0;
+
+			if (large_index)
+				{
+				index = HEIF_PROBE_16(buf + offset) & 0x7fff;
+				offset += 2;
+				}
+			else
+				{
+				index = buf[offset] & 0x7f;
+				offset++;
+				}
+			if (index == 0) continue;
+
+			/* properties are numbered from 1 in the order of ipco */
+			while (heif_probe_box(buf, &p, ipco.end, &box) && ++n < index);
+			if (n != index) return FALSE;
+
+			if (box.type == HEIF_PROBE_FOURCC('i','s','p','e'))
+				{
+				if (box.content + 12 > box.end) return FALSE;
+				w = MIN(HEIF_PROBE_32(buf + box.content + 4), G_MAXINT);
+				h = MIN(HEIF_PROBE_32(buf + box.content + 8), G_MAXINT);
+				}
+			else if (box.type == HEIF_PROBE_FOURCC('i','r','o','t'))
+				{
+				if (box.content + 1 > box.end) return FALSE;
+				swap = (buf[box.content] & 1);
+				}
+			else if (box.type == HEIF_PROBE_FOURCC('c','l','a','p'))
+				{
+				return FALSE;
+				}
+			}
+		break;
+		}
+
+	if (w < 1 || h < 1) return FALSE;
+
+	*width = swap ? h : w;
+	*height = swap ? w : h;
+	return TRUE;
+}
+
+#undef HEIF_PROBE_16
+#undef HEIF_PROBE_32
+#undef HEIF_PROBE_FOURCC
+
 void image_loader_backend_set_heif(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_heif_new;
@@ -191,6 +458,7 @@ void image_loader_backend_set_heif(ImageLoaderBackend *funcs)
 	funcs->get_format_mime_types = image_loader_heif_get_format_mime_types;
 	funcs->set_page_num = image_loader_heif_set_page_num;
 	funcs->get_page_total = image_loader_heif_get_page_total;
+	funcs->probe = image_loader_heif_probe;
 }
 
 #endif
@@ -167,6 +167,18 @@ opj_stream_t* OPJ_CALLCONV opj_stream_create_buffer_stream (opj_buffer_info_t* p
     return ps;
 }
 
+static void image_loader_j2k_release(opj_buffer_info_t *decode_buffer, opj_image_t *image, opj_codec_t *codec, opj_stream_t *stream)
+{
+	if (image)
+		opj_image_destroy (image);
+	if (codec)
+		opj_destroy_codec (codec);
+	if (stream)
+		opj_stream_destroy (stream);
+	g_free(decode_buffer->buf);
+	g_free(decode_buffer);
+}
+
 static gboolean image_loader_j2k_load(gpointer loader, const guchar *buf, gsize count, GError **error)
 {
 	ImageLoaderJ2K *ld = (ImageLoaderJ2K *) loader;
@@ -228,6 +240,12 @@ static gboolean image_loader_j2k_load(gpointer loader, const guchar *buf, gsize
 		return FALSE;
 		}
 
+	if (ld->abort)
+		{
+		image_loader_j2k_release(decode_buffer, image, codec, stream);
+		return FALSE;
+		}
+
 	if (opj_decode(codec, stream, image) != OPJ_TRUE)
 		{
 		log_printf(_("Couldn't decode JP2 image in file"));
@@ -240,6 +258,12 @@ static gboolean image_loader_j2k_load(gpointer loader, const guchar *buf, gsize
 		return FALSE;
 		}
 
+	if (ld->abort)
+		{
+		image_loader_j2k_release(decode_buffer, image, codec, stream);
+		return FALSE;
+		}
+
 	num_components = image->numcomps;
 	if (num_components != 3)
 		{
@@ -253,7 +277,7 @@ static gboolean image_loader_j2k_load(gpointer loader, const guchar *buf, gsize
 	bytes_per_pixel = 3;
 
 	pixels = g_new0(guchar, width * bytes_per_pixel * height);
-	for (i = 0; i < height; i++)
+	for (i = 0; i < height && !ld->abort; i++)
 		{
 		for (j = 0; j < num_components; j++)
 			{
@@ -264,18 +288,18 @@ static gboolean image_loader_j2k_load(gpointer loader, const guchar *buf, gsize
 			}
 		}
 
+	if (ld->abort)
+		{
+		g_free(pixels);
+		image_loader_j2k_release(decode_buffer, image, codec, stream);
+		return FALSE;
+		}
+
 	ld->pixbuf = gdk_pixbuf_new_from_data(pixels, GDK_COLORSPACE_RGB, FALSE , 8, width, height, width * bytes_per_pixel, free_buffer, NULL);
 
 	ld->area_updated_cb(loader, 0, 0, width, height, ld->data);
 
-	g_free(decode_buffer);
-	g_free(buf_copy);
-	if (image)
-		opj_image_destroy (image);
-	if (codec)
-		opj_destroy_codec (codec);
-	if (stream)
-		opj_stream_destroy (stream);
+	image_loader_j2k_release(decode_buffer, image, codec, stream);
 
 	return TRUE;
 }
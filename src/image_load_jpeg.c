@@ -36,6 +36,11 @@
 #include <jpeglib.h>
 #include <jerror.h>
 
+/* output size from which the decode is shown in steps, a quick 1/8 scaled
+ * decode first, or for progressive files a pass after some of the scans */
+#define IMAGE_LOADER_JPEG_FIRST_PAINT_PIXELS (16 * 1024 * 1024)
+#define IMAGE_LOADER_JPEG_FIRST_PAINT_SCALE 8
+
 typedef struct _ImageLoaderJpeg ImageLoaderJpeg;
 struct _ImageLoaderJpeg {
 	ImageLoaderBackendCbAreaUpdated area_updated_cb;
@@ -253,6 +258,145 @@ static void set_mem_src (j_decompress_ptr cinfo, void* buffer, long nbytes)
 }
 
 
+/* spreads the w x h image at the top left of the pixbuf over the whole of it,
+ * backwards so that each pixel is read before it is overwritten */
+static void image_loader_jpeg_scale_up(GdkPixbuf *pixbuf, guint w, guint h)
+{
+	guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
+	gsize rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+	gint n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+	gint width = gdk_pixbuf_get_width(pixbuf);
+	gint height = gdk_pixbuf_get_height(pixbuf);
+	guint last_y = G_MAXUINT;
+	gint x, y, c;
+
+	for (y = height - 1; y >= 0; y--)
+		{
+		guchar *dest = pixels + y * rowstride;
+		guchar *src;
+		guint src_y = (guint64)y * h / height;
+
+		if (src_y == last_y)
+			{
+			memcpy(dest, dest + rowstride, width * n_channels);
+			continue;
+			}
+
+		src = pixels + src_y * rowstride;
+		for (x = width - 1; x >= 0; x--)
+			{
+			guchar *s = src + ((guint64)x * w / width) * n_channels;
+			guchar *d = dest + x * n_channels;
+
+			for (c = 0; c < n_channels; c++) d[c] = s[c];
+			}
+		last_y = src_y;
+		}
+}
+
+/**
+ * @brief Shows a quick DCT scaled decode of \a buf in the loader pixbuf
+ *
+ * Only the DC coefficients are used at 1/8 scale, the result is scaled up
+ * to fill the pixbuf until the full decode replaces it row by row.
+ * Any error just leaves the pixbuf to the full decode.
+ */
+static void image_loader_jpeg_first_paint(ImageLoaderJpeg *lj, const guchar *buf, gsize count)
+{
+	struct jpeg_decompress_struct cinfo;
+	struct error_handler_data jerr;
+	guchar *dptr;
+	guint rowstride;
+
+	cinfo.err = jpeg_std_error(&jerr.pub);
+	jerr.pub.error_exit = fatal_error_handler;
+	jerr.pub.output_message = output_message_handler;
+	jerr.error = NULL;
+
+	if (setjmp(jerr.setjmp_buffer))
+		{
+		jpeg_destroy_decompress(&cinfo);
+		return;
+		}
+
+	jpeg_create_decompress(&cinfo);
+	set_mem_src(&cinfo, (unsigned char *)buf, count);
+	jpeg_read_header(&cinfo, TRUE);
+
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = IMAGE_LOADER_JPEG_FIRST_PAINT_SCALE;
+	cinfo.dct_method = JDCT_IFAST;
+	cinfo.do_fancy_upsampling = FALSE;
+	jpeg_start_decompress(&cinfo);
+
+	if ((cinfo.out_color_components == 4) != gdk_pixbuf_get_has_alpha(lj->pixbuf) ||
+	    cinfo.output_width > gdk_pixbuf_get_width(lj->pixbuf) ||
+	    cinfo.output_height + cinfo.rec_outbuf_height > gdk_pixbuf_get_height(lj->pixbuf))
+		{
+		jpeg_destroy_decompress(&cinfo);
+		return;
+		}
+
+	rowstride = gdk_pixbuf_get_rowstride(lj->pixbuf);
+	dptr = gdk_pixbuf_get_pixels(lj->pixbuf);
+
+	while (cinfo.output_scanline < cinfo.output_height)
+		{
+		if (lj->abort)
+			{
+			jpeg_destroy_decompress(&cinfo);
+			return;
+			}
+		image_loader_jpeg_read_scanline(&cinfo, &dptr, rowstride);
+		}
+
+	image_loader_jpeg_scale_up(lj->pixbuf, cinfo.output_width, cinfo.output_height);
+	DEBUG_1("jpeg first paint from %ux%u", cinfo.output_width, cinfo.output_height);
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+
+	lj->area_updated_cb(lj, 0, 0, gdk_pixbuf_get_width(lj->pixbuf), gdk_pixbuf_get_height(lj->pixbuf), lj->data);
+}
+
+/**
+ * @brief Decodes a progressive file in buffered image mode
+ *
+ * The whole image is shown after the first scan and again each time the
+ * number of scans read doubles, the last pass has all of them. A pass
+ * costs a full inverse DCT, so not every scan gets one.
+ */
+static void image_loader_jpeg_read_scans(ImageLoaderJpeg *lj, struct jpeg_decompress_struct *cinfo)
+{
+	guint rowstride = gdk_pixbuf_get_rowstride(lj->pixbuf);
+	gint scan = 1;
+
+	while (!lj->abort)
+		{
+		guchar *dptr = gdk_pixbuf_get_pixels(lj->pixbuf);
+
+		jpeg_start_output(cinfo, scan);
+		while (cinfo->output_scanline < cinfo->output_height && !lj->abort)
+			{
+			guint scanline = cinfo->output_scanline;
+			image_loader_jpeg_read_scanline(cinfo, &dptr, rowstride);
+			lj->area_updated_cb(lj, 0, scanline, cinfo->output_width, cinfo->rec_outbuf_height, lj->data);
+			}
+		if (lj->abort) break;
+		jpeg_finish_output(cinfo);
+
+		DEBUG_1("jpeg pass with %d scans", cinfo->output_scan_number);
+		if (jpeg_input_complete(cinfo) && cinfo->output_scan_number == cinfo->input_scan_number) break;
+		scan *= 2;
+		}
+}
+
+/**
+ * @brief Decodes the whole file at once
+ *
+ * Large images are shown in steps while they are decoded, see
+ * image_loader_jpeg_first_paint() and image_loader_jpeg_read_scans().
+ */
 static gboolean image_loader_jpeg_load (gpointer loader, const guchar *buf, gsize count, GError **error)
 {
 	ImageLoaderJpeg *lj = (ImageLoaderJpeg *) loader;
@@ -262,6 +406,8 @@ static gboolean image_loader_jpeg_load (gpointer loader, const guchar *buf, gsiz
 	guint rowstride;
 	guchar *stereo_buf2 = NULL;
 	guint stereo_length = 0;
+	gboolean first_paint;
+	gboolean progressive;
 
 	struct error_handler_data jerr;
 
@@ -367,6 +513,10 @@ static gboolean image_loader_jpeg_load (gpointer loader, const guchar *buf, gsiz
 		jpeg_start_decompress(&cinfo2);
 		}
 
+	first_paint = !lj->stereo &&
+		      (guint64)cinfo.output_width * cinfo.output_height >= IMAGE_LOADER_JPEG_FIRST_PAINT_PIXELS;
+	progressive = first_paint && jpeg_has_multiple_scans(&cinfo);
+	if (progressive) cinfo.buffered_image = TRUE;
 
 	jpeg_start_decompress(&cinfo);
 
@@ -402,7 +552,17 @@ static gboolean image_loader_jpeg_load (gpointer loader, const guchar *buf, gsiz
 	dptr2 = gdk_pixbuf_get_pixels(lj->pixbuf) + ((cinfo.out_color_components == 4) ? 4 * cinfo.output_width : 3 * cinfo.output_width);
 
 
-	while (cinfo.output_scanline < cinfo.output_height && !lj->abort)
+	if (progressive)
+		{
+		image_loader_jpeg_read_scans(lj, &cinfo);
+		}
+	else if (first_paint)
+		{
+		/* the scaled decode of a progressive file would read all scans */
+		image_loader_jpeg_first_paint(lj, buf, count);
+		}
+
+	while (!progressive && cinfo.output_scanline < cinfo.output_height && !lj->abort)
 		{
 		guint scanline = cinfo.output_scanline;
 		image_loader_jpeg_read_scanline(&cinfo, &dptr, rowstride);
@@ -468,6 +628,63 @@ static void image_loader_jpeg_free(gpointer loader)
 }
 
 
+/* size from the first SOF marker, MPO files are left to the full loader
+ * because their stereo pixbuf is twice as wide */
+static gboolean image_loader_jpeg_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	guint seg_offset;
+	guint seg_length;
+	gsize offset = 2;
+
+	if (count < 4 || buf[0] != JPEG_MARKER || buf[1] != JPEG_MARKER_SOI) return FALSE;
+
+	if (jpeg_segment_find(buf, count, JPEG_MARKER_APP2, "MPF\x00", 4, &seg_offset, &seg_length)) return FALSE;
+
+	while (offset + 4 <= count)
+		{
+		guchar marker;
+		guint length;
+
+		if (buf[offset] != JPEG_MARKER) return FALSE;
+		marker = buf[offset + 1];
+		if (marker == JPEG_MARKER)
+			{
+			/* fill byte */
+			offset++;
+			continue;
+			}
+		if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7))
+			{
+			offset += 2;
+			continue;
+			}
+		if (marker == JPEG_MARKER_EOI || marker == 0xda) return FALSE;
+
+		length = ((guint)buf[offset + 2] << 8) + buf[offset + 3];
+		if (length < 2) return FALSE;
+
+		/* SOF0 - SOF15, without DHT, JPG and DAC */
+		if (marker >= 0xc0 && marker <= 0xcf &&
+		    marker != 0xc4 && marker != 0xc8 && marker != 0xcc)
+			{
+			gint w, h;
+
+			if (length < 7 || offset + 9 > count) return FALSE;
+			h = ((gint)buf[offset + 5] << 8) + buf[offset + 6];
+			w = ((gint)buf[offset + 7] << 8) + buf[offset + 8];
+			if (w < 1 || h < 1) return FALSE;
+
+			*width = w;
+			*height = h;
+			return TRUE;
+			}
+
+		offset += 2 + length;
+		}
+
+	return FALSE;
+}
+
 void image_loader_backend_set_jpeg(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_jpeg_new;
@@ -481,6 +698,7 @@ void image_loader_backend_set_jpeg(ImageLoaderBackend *funcs)
 
 	funcs->get_format_name = image_loader_jpeg_get_format_name;
 	funcs->get_format_mime_types = image_loader_jpeg_get_format_mime_types;
+	funcs->probe = image_loader_jpeg_probe;
 }
 
 
@@ -22,6 +22,7 @@
 
 #include "image-load.h"
 #include "image_load_pdf.h"
+#include "page_cache.h"
 
 #ifdef HAVE_PDF
 #include <poppler/glib/poppler.h>
@@ -40,56 +41,161 @@ struct _ImageLoaderPDF {
 	gint page_total;
 };
 
-static gboolean image_loader_pdf_load(gpointer loader, const guchar *buf, gsize count, GError **error)
+/* the document is kept open in the page cache between page flips,
+ * poppler does not copy the data so it is kept along with it */
+typedef struct _PDFDocument PDFDocument;
+struct _PDFDocument {
+	PopplerDocument *document;
+	gchar *data;
+};
+
+static void image_loader_pdf_document_free(gpointer data)
 {
-	ImageLoaderPDF *ld = (ImageLoaderPDF *) loader;
-	GError *poppler_error = NULL;
+	PDFDocument *pdf = data;
+
+	g_object_unref(pdf->document);
+	g_free(pdf->data);
+	g_free(pdf);
+}
+
+static GdkPixbuf *image_loader_pdf_render(gpointer data, gint page_num)
+{
+	PDFDocument *pdf = data;
 	PopplerPage *page;
-	PopplerDocument *document;
 	gdouble width, height;
 	cairo_surface_t *surface;
 	cairo_t *cr;
-	gboolean ret = FALSE;
-	gint page_total;
+	GdkPixbuf *pixbuf;
+
+	page = poppler_document_get_page(pdf->document, page_num);
+	if (!page) return NULL;
 
-	document = poppler_document_new_from_data((gchar *)buf, count, NULL, &poppler_error);
+	poppler_page_get_size(page, &width, &height);
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+	cr = cairo_create(surface);
+	poppler_page_render(page, cr);
+
+	cairo_set_operator(cr, CAIRO_OPERATOR_DEST_OVER);
+	cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+	cairo_paint(cr);
+
+	pixbuf = gdk_pixbuf_get_from_surface(surface, 0, 0, width, height);
+
+	cairo_destroy (cr);
+	cairo_surface_destroy(surface);
+	g_object_unref(page);
+
+	return pixbuf;
+}
+
+/* the data is copied when the document is kept, buf only lives as long as the load */
+static PDFDocument *image_loader_pdf_document_new(const guchar *buf, gsize count, gboolean copy)
+{
+	GError *poppler_error = NULL;
+	PopplerDocument *document;
+	PDFDocument *pdf;
+	gchar *data = copy ? g_memdup(buf, count) : NULL;
+
+	document = poppler_document_new_from_data(data ? data : (gchar *)buf, count, NULL, &poppler_error);
 
 	if (poppler_error)
 		{
 		log_printf("warning: pdf reader error: %s\n", poppler_error->message);
 		g_error_free(poppler_error);
+		g_free(data);
+		return NULL;
+		}
+
+	pdf = g_new0(PDFDocument, 1);
+	pdf->document = document;
+	pdf->data = data;
+
+	return pdf;
+}
+
+/* renders the page from a document that is not kept */
+static GdkPixbuf *image_loader_pdf_render_uncached(ImageLoaderPDF *ld, const guchar *buf, gsize count)
+{
+	PDFDocument *pdf;
+	GdkPixbuf *pixbuf = NULL;
+
+	pdf = image_loader_pdf_document_new(buf, count, FALSE);
+	if (pdf)
+		{
+		ld->page_total = poppler_document_get_n_pages(pdf->document);
+		if (!ld->abort) pixbuf = image_loader_pdf_render(pdf, ld->page_num);
+		image_loader_pdf_document_free(pdf);
+		}
+
+	return pixbuf;
+}
+
+static gboolean image_loader_pdf_load(gpointer loader, const guchar *buf, gsize count, GError **error)
+{
+	ImageLoaderPDF *ld = (ImageLoaderPDF *) loader;
+	ImageLoader *il = ld->data;
+	PageCache *pc;
+	PDFDocument *pdf;
+	gint page_total;
+
+	if (ld->abort) return FALSE;
+
+	if (il->requested_width > 0 && il->requested_height > 0)
+		{
+		/* thumbnails need one page once, not worth keeping the document */
+		ld->pixbuf = image_loader_pdf_render_uncached(ld, buf, count);
 		}
 	else
 		{
-		page_total = poppler_document_get_n_pages(document);
+		pc = page_cache_ref(il->fd);
+		page_cache_lock(pc);
+
+		ld->pixbuf = page_cache_lookup(pc, ld->page_num);
+		if (!ld->pixbuf)
+			{
+			pdf = page_cache_get_document(pc);
+			if (!pdf && !page_cache_get_busy(pc))
+				{
+				pdf = image_loader_pdf_document_new(buf, count, TRUE);
+				if (pdf)
+					{
+					page_cache_set_document(pc, pdf, count, poppler_document_get_n_pages(pdf->document),
+								image_loader_pdf_render, image_loader_pdf_document_free);
+					pdf = page_cache_get_document(pc);
+					}
+				}
+
+			if (pdf && !ld->abort)
+				{
+				ld->pixbuf = image_loader_pdf_render(pdf, ld->page_num);
+				page_cache_insert(pc, ld->page_num, ld->pixbuf);
+				}
+			else if (!pdf && !ld->abort && page_cache_get_busy(pc))
+				{
+				/* a neighbour page is rendered in the background, do not wait for it */
+				ld->pixbuf = image_loader_pdf_render_uncached(ld, buf, count);
+				}
+			}
+
+		page_total = page_cache_get_page_total(pc);
 		if (page_total > 0)
 			{
 			ld->page_total = page_total;
 			}
 
-		page = poppler_document_get_page(document, ld->page_num);
-		poppler_page_get_size(page, &width, &height);
-
-		surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
-		cr = cairo_create(surface);
-		poppler_page_render(page, cr);
-
-		cairo_set_operator(cr, CAIRO_OPERATOR_DEST_OVER);
-		cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-		cairo_paint(cr);
+		if (ld->pixbuf && !ld->abort) page_cache_prerender(pc, ld->page_num);
 
-		ld->pixbuf = gdk_pixbuf_get_from_surface(surface, 0, 0, width, height);
-		ld->area_updated_cb(loader, 0, 0, width, height, ld->data);
-
-		cairo_destroy (cr);
-		cairo_surface_destroy(surface);
-		g_object_unref(page);
-		ret = TRUE;
+		page_cache_unlock(pc);
+		page_cache_unref(pc);
 		}
 
-	g_object_unref(document);
+	if (ld->pixbuf && !ld->abort)
+		{
+		ld->area_updated_cb(loader, 0, 0, gdk_pixbuf_get_width(ld->pixbuf), gdk_pixbuf_get_height(ld->pixbuf), ld->data);
+		}
 
-	return ret;
+	return (ld->pixbuf != NULL);
 }
 
 static gpointer image_loader_pdf_new(ImageLoaderBackendCbAreaUpdated area_updated_cb, ImageLoaderBackendCbSize size_cb, ImageLoaderBackendCbAreaPrepared area_prepared_cb, gpointer data)
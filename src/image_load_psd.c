@@ -310,6 +310,13 @@ static gboolean image_loader_psd_load(gpointer loader, const guchar *buf, gsize
 	ctx->finalized = FALSE;
 
 	while (size > 0) {
+		/* channel data is fed one row per pass */
+		if (ld->abort) {
+			if (ctx->pixbuf) g_object_unref(ctx->pixbuf);
+			free_context(ctx);
+			return FALSE;
+		}
+
 		switch (ctx->state) {
 			case PSD_STATE_HEADER:
 				if (feed_buffer(
@@ -583,6 +590,26 @@ static void image_loader_psd_free(gpointer loader)
 	g_free(ld);
 }
 
+/* the same checks as the header state of image_loader_psd_load() */
+static gboolean image_loader_psd_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	PsdHeader hd;
+
+	if (count < PSD_HEADER_SIZE || memcmp(buf, "8BPS", 4) != 0) return FALSE;
+
+	hd = psd_parse_header((guchar *)buf);
+	if (hd.color_mode != PSD_MODE_RGB
+	    && hd.color_mode != PSD_MODE_GRAYSCALE
+	    && hd.color_mode != PSD_MODE_CMYK
+	    && hd.color_mode != PSD_MODE_DUOTONE) return FALSE;
+	if (hd.depth != 8 && hd.depth != 16) return FALSE;
+	if (hd.columns < 1 || hd.rows < 1 || hd.columns > G_MAXINT || hd.rows > G_MAXINT) return FALSE;
+
+	*width = hd.columns;
+	*height = hd.rows;
+	return TRUE;
+}
+
 void image_loader_backend_set_psd(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_psd_new;
@@ -595,5 +622,6 @@ void image_loader_backend_set_psd(ImageLoaderBackend *funcs)
 	funcs->free = image_loader_psd_free;
 	funcs->get_format_name = image_loader_psd_get_format_name;
 	funcs->get_format_mime_types = image_loader_psd_get_format_mime_types;
+	funcs->probe = image_loader_psd_probe;
 }
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
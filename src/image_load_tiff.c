@@ -29,6 +29,7 @@
 
 #include "image-load.h"
 #include "image_load_tiff.h"
+#include "page_cache.h"
 
 #ifdef HAVE_TIFF
 
@@ -137,16 +138,240 @@ tiff_load_unmap_file (thandle_t handle, tdata_t data, toff_t offset)
 {
 }
 
+/*
+ *-------------------------------------------------------------------
+ * directory layout
+ *-------------------------------------------------------------------
+ */
+
+/* The directory layout of a file is read once and kept in the page cache
+ * of the FileData, so paging does not walk the IFD chain on every load.
+ * Reduced-resolution images, either in the main chain or as SubIFDs,
+ * are attached to the page they belong to instead of counting as pages. */
+
+typedef struct _TiffLevel TiffLevel;
+struct _TiffLevel {
+	toff_t offset;
+	gboolean sub_ifd;
+	guint32 width;
+	guint32 height;
+};
+
+typedef struct _TiffLayout TiffLayout;
+struct _TiffLayout {
+	GPtrArray *pages;	/**< GArray of TiffLevel per page, full resolution first */
+};
+
+static void tiff_layout_free(gpointer data)
+{
+	TiffLayout *layout = data;
+
+	g_ptr_array_free(layout->pages, TRUE);
+	g_free(layout);
+}
+
+static void tiff_layout_add_level(GArray *levels, TIFF *tiff, gboolean sub_ifd)
+{
+	TiffLevel level;
+
+	level.offset = TIFFCurrentDirOffset(tiff);
+	level.sub_ifd = sub_ifd;
+	level.width = 0;
+	level.height = 0;
+	TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &level.width);
+	TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &level.height);
+
+	if (level.width > 0 && level.height > 0) g_array_append_val(levels, level);
+}
+
+static TiffLayout *tiff_layout_read(TIFF *tiff)
+{
+	TiffLayout *layout;
+	GArray *levels = NULL;
+
+	layout = g_new0(TiffLayout, 1);
+	layout->pages = g_ptr_array_new_with_free_func((GDestroyNotify)g_array_unref);
+
+	do
+		{
+		toff_t offset = TIFFCurrentDirOffset(tiff);
+		guint32 subfiletype = 0;
+		guint16 sub_count = 0;
+		toff_t *sub_offsets = NULL;
+
+		TIFFGetField(tiff, TIFFTAG_SUBFILETYPE, &subfiletype);
+
+		if (!levels || !(subfiletype & FILETYPE_REDUCEDIMAGE))
+			{
+			levels = g_array_new(FALSE, FALSE, sizeof(TiffLevel));
+			g_ptr_array_add(layout->pages, levels);
+			}
+		tiff_layout_add_level(levels, tiff, FALSE);
+
+		if (TIFFGetField(tiff, TIFFTAG_SUBIFD, &sub_count, &sub_offsets) && sub_count > 0)
+			{
+			toff_t *subs = g_memdup(sub_offsets, sub_count * sizeof(toff_t));
+			gint i;
+
+			for (i = 0; i < sub_count; i++)
+				{
+				if (TIFFSetSubDirectory(tiff, subs[i])) tiff_layout_add_level(levels, tiff, TRUE);
+				}
+			g_free(subs);
+
+			/* continue the main chain */
+			TIFFSetSubDirectory(tiff, offset);
+			}
+		} while (TIFFReadDirectory(tiff));
+
+	return layout;
+}
+
+/* smallest level that still covers the requested size */
+static gint tiff_layout_best_level(GArray *levels, guint width, guint height)
+{
+	gint best = 0;
+	guint i;
+
+	if (width < 1 || height < 1) return 0;
+
+	for (i = 1; i < levels->len; i++)
+		{
+		TiffLevel *level = &g_array_index(levels, TiffLevel, i);
+		TiffLevel *best_level = &g_array_index(levels, TiffLevel, best);
+
+		if (level->width >= width && level->height >= height &&
+		    level->width < best_level->width)
+			{
+			best = i;
+			}
+		}
+
+	return best;
+}
+
+/* next smaller level, when the chosen one does not fit into memory */
+static gint tiff_layout_smaller_level(GArray *levels, gint current)
+{
+	TiffLevel *cur = &g_array_index(levels, TiffLevel, current);
+	gint smaller = -1;
+	guint i;
+
+	for (i = 0; i < levels->len; i++)
+		{
+		TiffLevel *level = &g_array_index(levels, TiffLevel, i);
+
+		if (level->width < cur->width &&
+		    (smaller < 0 || level->width > g_array_index(levels, TiffLevel, smaller).width))
+			{
+			smaller = i;
+			}
+		}
+
+	return smaller;
+}
+
+/*
+ *-------------------------------------------------------------------
+ * decoding
+ *-------------------------------------------------------------------
+ */
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+/* Turns out that the packing used by TIFFRGBAImage depends on
+ * the host byte order...
+ */
+static void tiff_rgba_to_bytes(guchar *ptr, gsize bytes)
+{
+	guchar *end = ptr + bytes;
+
+	while (ptr < end)
+		{
+		uint32 pixel = *(uint32 *)ptr;
+		int r = TIFFGetR(pixel);
+		int g = TIFFGetG(pixel);
+		int b = TIFFGetB(pixel);
+		int a = TIFFGetA(pixel);
+		*ptr++ = r;
+		*ptr++ = g;
+		*ptr++ = b;
+		*ptr++ = a;
+		}
+}
+#endif
+
+/* decode tile by tile straight into the pixbuf, so large tiled files show
+ * progress and can be aborted, returns FALSE if the tiles can not be read
+ * this way at all */
+static gboolean image_loader_tiff_load_tiles(ImageLoaderTiff *lt, TIFF *tiff, guchar *pixels,
+					     gint width, gint height, gint rowstride)
+{
+	uint32 tile_width, tile_height;
+	uint32 *tile;
+	gint row, col;
+	gboolean stop = FALSE;
+
+	if (!TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tile_width) ||
+	    !TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tile_height) ||
+	    tile_width == 0 || tile_height == 0)
+		{
+		return FALSE;
+		}
+
+	tile = g_try_malloc((gsize)tile_width * tile_height * sizeof(uint32));
+	if (!tile) return FALSE;
+
+	for (row = 0; row < height && !stop; row += tile_height)
+		{
+		gint rows = MIN((gint)tile_height, height - row);
+
+		for (col = 0; col < width; col += tile_width)
+			{
+			gint cols = MIN((gint)tile_width, width - col);
+			gint i;
+
+			if (lt->abort || !TIFFReadRGBATile(tiff, col, row, tile))
+				{
+				stop = TRUE;
+				break;
+				}
+
+			/* the tile origin is the lower left corner */
+			for (i = 0; i < rows; i++)
+				{
+				guchar *dest = pixels + (gsize)(row + i) * rowstride + (gsize)col * 4;
+
+				memcpy(dest, tile + (gsize)(tile_height - 1 - i) * tile_width, cols * 4);
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+				tiff_rgba_to_bytes(dest, cols * 4);
+#endif
+				}
+			}
+
+		lt->area_updated_cb(lt, 0, row, width, rows, lt->data);
+		}
+
+	g_free(tile);
+
+	return TRUE;
+}
+
 static gboolean image_loader_tiff_load (gpointer loader, const guchar *buf, gsize count, GError **error)
 {
 	ImageLoaderTiff *lt = (ImageLoaderTiff *) loader;
+	ImageLoader *il = lt->data;
 
 	TIFF *tiff;
 	guchar *pixels = NULL;
 	gint width, height, rowstride;
 	size_t bytes;
 	uint32 rowsperstrip;
-	gint dircount = 0;
+	PageCache *pc;
+	TiffLayout *layout;
+	GArray *levels;
+	TiffLevel *level;
+	gint level_num;
+	gint best_level_num;
 
 	lt->buffer = buf;
 	lt->used = count;
@@ -164,71 +389,91 @@ static gboolean image_loader_tiff_load (gpointer loader, const guchar *buf, gsiz
 		DEBUG_1("Failed to open TIFF image");
 		return FALSE;
 		}
-	else
+
+	pc = page_cache_ref(il->fd);
+	page_cache_lock(pc);
+	layout = page_cache_get_document(pc);
+	if (!layout)
 		{
-		do
-			{
-			dircount++;
-			} while (TIFFReadDirectory(tiff));
-		lt->page_total = dircount;
+		layout = tiff_layout_read(tiff);
+		page_cache_set_document(pc, layout, 0, layout->pages->len, NULL, tiff_layout_free);
+		layout = page_cache_get_document(pc);
 		}
 
-    if (!TIFFSetDirectory(tiff, lt->page_num))
+	if (!layout || lt->page_num < 0 || lt->page_num >= (gint)layout->pages->len)
 		{
 		DEBUG_1("Failed to open TIFF image");
+		page_cache_unlock(pc);
+		page_cache_unref(pc);
 		TIFFClose(tiff);
 		return FALSE;
 		}
 
-	if (!TIFFGetField (tiff, TIFFTAG_IMAGEWIDTH, &width))
-		{
-		DEBUG_1("Could not get image width (bad TIFF file)");
-		TIFFClose(tiff);
-		return FALSE;
-		}
+	lt->page_total = layout->pages->len;
+	levels = g_array_ref(g_ptr_array_index(layout->pages, lt->page_num));
+	page_cache_unlock(pc);
+	page_cache_unref(pc);
 
-	if (!TIFFGetField (tiff, TIFFTAG_IMAGELENGTH, &height))
-		{
-		DEBUG_1("Could not get image height (bad TIFF file)");
-		TIFFClose(tiff);
-		return FALSE;
-		}
+	level = &g_array_index(levels, TiffLevel, 0);
+	width = level->width;
+	height = level->height;
 
-	if (width <= 0 || height <= 0)
+	/* may ask for a smaller size, see image_loader_size_cb */
+	lt->requested_width = width;
+	lt->requested_height = height;
+	lt->size_cb(loader, lt->requested_width, lt->requested_height, lt->data);
+
+	level_num = best_level_num = tiff_layout_best_level(levels, lt->requested_width, lt->requested_height);
+
+	while (level_num >= 0)
 		{
-		DEBUG_1("Width or height of TIFF image is zero");
-		TIFFClose(tiff);
-		return FALSE;
-		}
+		level = &g_array_index(levels, TiffLevel, level_num);
+		width = level->width;
+		height = level->height;
+
+		rowstride = width * 4;
+		if (rowstride / 4 != width)
+			{ /* overflow */
+			DEBUG_1("Dimensions of TIFF image too large: width %d", width);
+			}
+		else
+			{
+			bytes = (size_t) height * rowstride;
+			if (bytes / rowstride != (size_t) height)
+				{ /* overflow */
+				DEBUG_1("Dimensions of TIFF image too large: height %d", height);
+				}
+			else
+				{
+				pixels = g_try_malloc (bytes);
+				if (!pixels) DEBUG_1("Insufficient memory to open TIFF file: need %zu", bytes);
+				}
+			}
 
-	rowstride = width * 4;
-	if (rowstride / 4 != width)
-		{ /* overflow */
-		DEBUG_1("Dimensions of TIFF image too large: width %d", width);
-		TIFFClose(tiff);
-		return FALSE;
+		if (pixels) break;
+		level_num = tiff_layout_smaller_level(levels, level_num);
 		}
 
-	bytes = (size_t) height * rowstride;
-	if (bytes / rowstride != (size_t) height)
-		{ /* overflow */
-		DEBUG_1("Dimensions of TIFF image too large: height %d", height);
+	if (!pixels || !TIFFSetSubDirectory(tiff, level->offset))
+		{
+		DEBUG_1("Failed to open TIFF image");
+		g_free(pixels);
+		g_array_unref(levels);
 		TIFFClose(tiff);
 		return FALSE;
 		}
 
-	lt->requested_width = width;
-	lt->requested_height = height;
-	lt->size_cb(loader, lt->requested_width, lt->requested_height, lt->data);
-
-	pixels = g_try_malloc (bytes);
-
-	if (!pixels)
+	if (level_num != best_level_num)
 		{
-		DEBUG_1("Insufficient memory to open TIFF file: need %zu", bytes);
-		TIFFClose(tiff);
-		return FALSE;
+		log_printf("TIFF: not enough memory for %s, showing a reduced image %dx%d\n", il->fd->path, width, height);
+		image_loader_set_reduced(il, TRUE);
+		}
+	else if (level_num > 0)
+		{
+		DEBUG_1("TIFF: decoding reduced image %dx%d", width, height);
+		image_loader_set_reduced(il, FALSE);
 		}
+	g_array_unref(levels);
 
 	lt->pixbuf = gdk_pixbuf_new_from_data (pixels, GDK_COLORSPACE_RGB, TRUE, 8,
 										   width, height, rowstride,
@@ -243,7 +488,11 @@ static gboolean image_loader_tiff_load (gpointer loader, const guchar *buf, gsiz
 
 	lt->area_prepared_cb(loader, lt->data);
 
-	if (TIFFGetField(tiff, TIFFTAG_ROWSPERSTRIP, &rowsperstrip))
+	if (TIFFIsTiled(tiff) && image_loader_tiff_load_tiles(lt, tiff, pixels, width, height, rowstride))
+		{
+		/* done */
+		}
+	else if (TIFFGetField(tiff, TIFFTAG_ROWSPERSTRIP, &rowsperstrip))
 		{
 		/* read by strip */
 		ptrdiff_t row;
@@ -300,24 +549,7 @@ static gboolean image_loader_tiff_load (gpointer loader, const guchar *buf, gsiz
 			}
 
 #if G_BYTE_ORDER == G_BIG_ENDIAN
-		/* Turns out that the packing used by TIFFRGBAImage depends on
-		 * the host byte order...
-		 */
-		{
-		guchar *ptr = pixels;
-		while (ptr < pixels + bytes)
-			{
-			uint32 pixel = *(uint32 *)ptr;
-			int r = TIFFGetR(pixel);
-			int g = TIFFGetG(pixel);
-			int b = TIFFGetB(pixel);
-			int a = TIFFGetA(pixel);
-			*ptr++ = r;
-			*ptr++ = g;
-			*ptr++ = b;
-			*ptr++ = a;
-			}
-		}
+		tiff_rgba_to_bytes(pixels, bytes);
 #endif
 
 		lt->area_updated_cb(loader, 0, 0, width, height, lt->data);
@@ -395,6 +627,68 @@ static gint image_loader_tiff_get_page_total(gpointer loader)
 	return lt->page_total;
 }
 
+/* size of the first image directory of a classic TIFF, BigTIFF is left to the full loader */
+static gboolean image_loader_tiff_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	gboolean motorola;
+	guint32 offset;
+	guint entries;
+	guint i;
+	gint w = 0;
+	gint h = 0;
+
+	if (count < 8) return FALSE;
+
+	if (memcmp(buf, "MM\0*", 4) == 0)
+		motorola = TRUE;
+	else if (memcmp(buf, "II*\0", 4) == 0)
+		motorola = FALSE;
+	else
+		return FALSE;
+
+#define TIFF_PROBE_16(p) (motorola ? ((guint)(p)[0] << 8) | (p)[1] : ((guint)(p)[1] << 8) | (p)[0])
+#define TIFF_PROBE_32(p) (motorola ? ((guint32)(p)[0] << 24) | ((guint32)(p)[1] << 16) | ((guint32)(p)[2] << 8) | (p)[3] \
+				   : ((guint32)(p)[3] << 24) | ((guint32)(p)[2] << 16) | ((guint32)(p)[1] << 8) | (p)[0])
+
+	offset = TIFF_PROBE_32(buf + 4);
+	if (offset < 8 || (gsize)offset + 2 > count) return FALSE;
+
+	entries = TIFF_PROBE_16(buf + offset);
+	offset += 2;
+	if ((gsize)offset + entries * 12 > count) return FALSE;
+
+	for (i = 0; i < entries; i++)
+		{
+		const guchar *entry = buf + offset + i * 12;
+		guint tag = TIFF_PROBE_16(entry);
+		guint type = TIFF_PROBE_16(entry + 2);
+		gint value;
+
+		if (tag != 256 && tag != 257) continue;
+
+		if (type == 3)		/* SHORT */
+			value = TIFF_PROBE_16(entry + 8);
+		else if (type == 4)	/* LONG */
+			value = MIN(TIFF_PROBE_32(entry + 8), G_MAXINT);
+		else
+			return FALSE;
+
+		if (tag == 256)
+			w = value;
+		else
+			h = value;
+		}
+
+#undef TIFF_PROBE_16
+#undef TIFF_PROBE_32
+
+	if (w < 1 || h < 1) return FALSE;
+
+	*width = w;
+	*height = h;
+	return TRUE;
+}
+
 void image_loader_backend_set_tiff(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_tiff_new;
@@ -411,6 +705,7 @@ void image_loader_backend_set_tiff(ImageLoaderBackend *funcs)
 
 	funcs->set_page_num = image_loader_tiff_set_page_num;
 	funcs->get_page_total = image_loader_tiff_get_page_total;
+	funcs->probe = image_loader_tiff_probe;
 }
 
 
@@ -66,6 +66,8 @@ static gboolean image_loader_webp_load(gpointer loader, const guchar *buf, gsize
 		return FALSE;
 		}
 
+	if (ld->abort) return FALSE;
+
 	if (features.has_alpha)
 		{
 		data = WebPDecodeRGBA(buf, count, &width, &height);
@@ -134,6 +136,19 @@ static void image_loader_webp_free(gpointer loader)
 	g_free(ld);
 }
 
+/* libwebp reads the VP8X, VP8 or VP8L header, it does not need the whole file */
+static gboolean image_loader_webp_probe(const guchar *buf, gsize count, gint *width, gint *height)
+{
+	WebPBitstreamFeatures features;
+
+	if (WebPGetFeatures(buf, count, &features) != VP8_STATUS_OK) return FALSE;
+	if (features.width < 1 || features.height < 1) return FALSE;
+
+	*width = features.width;
+	*height = features.height;
+	return TRUE;
+}
+
 void image_loader_backend_set_webp(ImageLoaderBackend *funcs)
 {
 	funcs->loader_new = image_loader_webp_new;
@@ -146,6 +161,7 @@ void image_loader_backend_set_webp(ImageLoaderBackend *funcs)
 	funcs->free = image_loader_webp_free;
 	funcs->get_format_name = image_loader_webp_get_format_name;
 	funcs->get_format_mime_types = image_loader_webp_get_format_mime_types;
+	funcs->probe = image_loader_webp_probe;
 }
 
 #endif
@@ -278,82 +278,327 @@ static gboolean layout_image_slideshow_continue_check(LayoutWindow *lw)
  *----------------------------------------------------------------------------
  */
 
+#define ANIMATION_RING_SIZE 8
+#define ANIMATION_RETRY_DELAY 5 /* ms to wait for a frame that is not decoded yet */
+
+typedef struct _AnimationFrame AnimationFrame;
+struct _AnimationFrame
+{
+	GdkPixbuf *pixbuf;
+	gint delay;	/* ms, -1 for the last frame of an animation that does not loop */
+};
+
+static AnimationFrame *animation_frame_new(GdkPixbuf *pixbuf, gint delay)
+{
+	AnimationFrame *frame;
+
+	frame = g_new0(AnimationFrame, 1);
+	frame->pixbuf = g_object_ref(pixbuf);
+	frame->delay = delay;
+
+	return frame;
+}
+
+static void animation_frame_free(gpointer data)
+{
+	AnimationFrame *frame = data;
+
+	g_object_unref(frame->pixbuf);
+	g_free(frame);
+}
+
+static gsize animation_frame_size(GdkPixbuf *pixbuf)
+{
+	GdkPixbuf *level;
+	gdouble scale_x = 0.0;
+	gdouble scale_y = 0.0;
+	gsize size;
+
+	size = (gsize)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf);
+	level = pixbuf_pyramid_get_level(pixbuf, &scale_x, &scale_y);
+	if (level != pixbuf) size += (gsize)gdk_pixbuf_get_rowstride(level) * gdk_pixbuf_get_height(level);
+
+	return size;
+}
+
+/* copies the composited frame, with a copy reduced to the display scale
+ * attached so that the renderer does not scale on the main loop */
+static GdkPixbuf *animation_frame_render(GdkPixbuf *src, gdouble scale)
+{
+	GdkPixbuf *pixbuf;
+	GdkPixbuf *level;
+	gint w, h;
+
+	pixbuf = gdk_pixbuf_copy(src);
+	if (!pixbuf || scale >= 1.0 || scale <= 0.0) return pixbuf;
+
+	w = (gint)(gdk_pixbuf_get_width(pixbuf) * scale + 0.999);
+	h = (gint)(gdk_pixbuf_get_height(pixbuf) * scale + 0.999);
+	if (w < 1 || h < 1) return pixbuf;
+
+	level = gdk_pixbuf_scale_simple(pixbuf, w, h, GDK_INTERP_BILINEAR);
+	if (level)
+		{
+		pixbuf_pyramid_attach_level(pixbuf, level, 1.0);
+		g_object_unref(level);
+		}
+
+	return pixbuf;
+}
+
+static gpointer animation_decode_thread(gpointer data)
+{
+	AnimationData *fd = data;
+	GdkPixbufAnimationIter *iter;
+	GPtrArray *loop;		/* frames seen since first, replayed once it comes round again */
+	GdkPixbuf *first = NULL;	/* composited frame the loop started at, held so that its address is not reused */
+	gboolean looped = FALSE;
+	gboolean cacheable = TRUE;
+	gdouble loop_scale = 0.0;
+	gsize loop_bytes = 0;
+	gsize budget;
+	guint loop_pos = 0;
+	GTimeVal t = {0, 0};
+
+	/* the cache budget is shared with the decoded image cache */
+	budget = (gsize)options->image.image_cache_max * 1024 * 1024 / 2;
+
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	iter = gdk_pixbuf_animation_get_iter(fd->gpa, &t);
+	G_GNUC_END_IGNORE_DEPRECATIONS
+	loop = g_ptr_array_new_with_free_func(animation_frame_free);
+
+	while (TRUE)
+		{
+		AnimationFrame *frame;
+		GdkPixbuf *src;
+		GdkPixbuf *pixbuf;
+		gdouble scale;
+		gint delay;
+
+		g_mutex_lock(&fd->lock);
+		while (!fd->stop && g_queue_get_length(fd->frames) >= fd->ring_size)
+			{
+			g_cond_wait(&fd->cond, &fd->lock);
+			}
+		scale = fd->scale;
+		if (fd->stop)
+			{
+			g_mutex_unlock(&fd->lock);
+			break;
+			}
+		g_mutex_unlock(&fd->lock);
+
+		if (looped && scale != loop_scale)
+			{
+			/* the cached frames are reduced for another zoom, decode again */
+			looped = FALSE;
+			g_ptr_array_set_size(loop, 0);
+			loop_bytes = 0;
+			if (first) g_object_unref(first);
+			first = NULL;
+			}
+
+		if (looped)
+			{
+			AnimationFrame *cached = g_ptr_array_index(loop, loop_pos);
+
+			frame = animation_frame_new(cached->pixbuf, cached->delay);
+			loop_pos = (loop_pos + 1) % loop->len;
+			}
+		else
+			{
+			src = gdk_pixbuf_animation_iter_get_pixbuf(iter);
+			delay = gdk_pixbuf_animation_iter_get_delay_time(iter);
+			if (!src) break;
+
+			if (cacheable)
+				{
+				if (!first || scale != loop_scale)
+					{
+					g_ptr_array_set_size(loop, 0);
+					loop_bytes = 0;
+					if (first) g_object_unref(first);
+					first = g_object_ref(src);
+					loop_scale = scale;
+					}
+				else if (src == first && loop->len > 1)
+					{
+					DEBUG_1("animation: replaying %u cached frames", loop->len);
+					looped = TRUE;
+					loop_pos = 0;
+					continue;
+					}
+				else if (src == first)
+					{
+					/* the loader reuses one buffer for all frames */
+					cacheable = FALSE;
+					g_ptr_array_set_size(loop, 0);
+					}
+				}
+
+			pixbuf = animation_frame_render(src, scale);
+			if (!pixbuf) break;
+			frame = animation_frame_new(pixbuf, delay);
+			g_object_unref(pixbuf);
+
+			if (cacheable)
+				{
+				loop_bytes += animation_frame_size(frame->pixbuf);
+				if (loop_bytes > budget)
+					{
+					cacheable = FALSE;
+					g_ptr_array_set_size(loop, 0);
+					}
+				else
+					{
+					g_ptr_array_add(loop, animation_frame_new(frame->pixbuf, frame->delay));
+					}
+				}
+
+			if (delay >= 0)
+				{
+				G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+				g_time_val_add(&t, (glong)delay * 1000);
+				gdk_pixbuf_animation_iter_advance(iter, &t);
+				G_GNUC_END_IGNORE_DEPRECATIONS
+				}
+			}
+
+		g_mutex_lock(&fd->lock);
+		g_queue_push_tail(fd->frames, frame);
+		g_mutex_unlock(&fd->lock);
+
+		if (frame->delay < 0) break;
+		}
+
+	/* nothing more will be queued */
+	g_mutex_lock(&fd->lock);
+	fd->stop = TRUE;
+	g_mutex_unlock(&fd->lock);
+
+	if (first) g_object_unref(first);
+	g_ptr_array_unref(loop);
+	g_object_unref(iter);
+
+	return NULL;
+}
+
 static void image_animation_data_free(AnimationData *fd)
 {
 	if(!fd) return;
-	if(fd->iter) g_object_unref(fd->iter);
+
+	if (fd->timeout_id) g_source_remove(fd->timeout_id);
+
+	if (fd->thread)
+		{
+		g_mutex_lock(&fd->lock);
+		fd->stop = TRUE;
+		g_cond_signal(&fd->cond);
+		g_mutex_unlock(&fd->lock);
+		g_thread_join(fd->thread);
+
+		DEBUG_1("animation: %u frames shown, %u dropped, %u late",
+			fd->frames_shown, fd->frames_dropped, fd->frames_late);
+		}
+
+	if (fd->frames) g_queue_free_full(fd->frames, animation_frame_free);
+	g_mutex_clear(&fd->lock);
+	g_cond_clear(&fd->cond);
 	if(fd->gpa) g_object_unref(fd->gpa);
 	if(fd->cancellable) g_object_unref(fd->cancellable);
 	g_free(fd);
 }
 
-static gboolean animation_should_continue(AnimationData *fd)
-{
-	if (!fd->valid)
-		return FALSE;
-
-	return TRUE;
-}
-
 static gboolean show_next_frame(gpointer data)
 {
 	AnimationData *fd = (AnimationData*)data;
-	int delay;
+	AnimationFrame *frame;
 	PixbufRenderer *pr;
+	gboolean stopped;
+	gint64 now;
+	gint64 start;
+
+	fd->timeout_id = 0;
+	pr = (PixbufRenderer*)fd->iw->pr;
+	now = g_get_monotonic_time();
+
+	g_mutex_lock(&fd->lock);
+	fd->scale = pr->scale;
+	frame = g_queue_pop_head(fd->frames);
 
-	if(animation_should_continue(fd)==FALSE)
+	/* when behind, skip frames whose time has already passed */
+	while (frame && frame->delay >= 0 && !g_queue_is_empty(fd->frames) &&
+	       now >= fd->due + (gint64)frame->delay * 1000)
 		{
-		image_animation_data_free(fd);
-		return FALSE;
+		fd->due += (gint64)frame->delay * 1000;
+		fd->frames_dropped++;
+		animation_frame_free(frame);
+		frame = g_queue_pop_head(fd->frames);
 		}
+	stopped = fd->stop;
+	g_cond_signal(&fd->cond);
+	g_mutex_unlock(&fd->lock);
 
-	pr = (PixbufRenderer*)fd->iw->pr;
+	if (!frame && stopped) return FALSE;
 
-	if (gdk_pixbuf_animation_iter_advance(fd->iter,NULL)==FALSE)
+	if (!frame)
 		{
-		/* This indicates the animation is complete.
-		   Return FALSE here to disable looping. */
+		fd->frames_late++;
+		fd->timeout_id = g_timeout_add(ANIMATION_RETRY_DELAY, show_next_frame, fd);
+		return FALSE;
 		}
 
-	fd->gpb = gdk_pixbuf_animation_iter_get_pixbuf(fd->iter);
-	image_change_pixbuf(fd->iw,fd->gpb,pr->zoom,FALSE);
+	image_change_pixbuf(fd->iw, frame->pixbuf, pr->zoom, FALSE);
 
 	if (fd->iw->func_update)
 		fd->iw->func_update(fd->iw, fd->iw->data_update);
 
-	delay = gdk_pixbuf_animation_iter_get_delay_time(fd->iter);
-	if (delay!=fd->delay)
+	fd->frames_shown++;
+
+	if (frame->delay >= 0)
 		{
-		if (delay>0) /* Current frame not static. */
-			{
-			fd->delay=delay;
-			g_timeout_add(delay,show_next_frame,fd);
-			}
-		else
-			{
-			image_animation_data_free(fd);
-			}
-		return FALSE;
+		/* keep to the frame times unless more than a frame behind */
+		start = (now > fd->due + (gint64)frame->delay * 1000) ? now : fd->due;
+		fd->due = start + (gint64)frame->delay * 1000;
+		fd->timeout_id = g_timeout_add((guint)(MAX(fd->due - now, 0) / 1000), show_next_frame, fd);
+		}
+	else
+		{
+		DEBUG_1("animation: %u frames shown, %u dropped, %u late",
+			fd->frames_shown, fd->frames_dropped, fd->frames_late);
 		}
 
-	return TRUE;
+	animation_frame_free(frame);
+
+	return FALSE;
+}
+
+static void layout_image_animate_stop(LayoutWindow *lw)
+{
+	if (!lw->animation) return;
+
+	if (lw->animation->loading)
+		{
+		/* freed by animation_async_ready_cb */
+		g_cancellable_cancel(lw->animation->cancellable);
+		}
+	else
+		{
+		image_animation_data_free(lw->animation);
+		}
+	lw->animation = NULL;
 }
 
 static gboolean layout_image_animate_check(LayoutWindow *lw)
 {
 	if (!layout_valid(&lw)) return FALSE;
 
-	if(!lw->options.animate || lw->image->image_fd == NULL || lw->image->image_fd->extension == NULL || g_ascii_strcasecmp(lw->image->image_fd->extension,".GIF")!=0)
+	if(!lw->options.animate || lw->image->image_fd == NULL || lw->image->image_fd->extension == NULL ||
+	   (g_ascii_strcasecmp(lw->image->image_fd->extension, ".GIF") != 0 &&
+	    g_ascii_strcasecmp(lw->image->image_fd->extension, ".WEBP") != 0))
 		{
-		if(lw->animation)
-			{
-			lw->animation->valid = FALSE;
-			if (lw->animation->cancellable)
-				{
-				g_cancellable_cancel(lw->animation->cancellable);
-				}
-			lw->animation = NULL;
-			}
+		layout_image_animate_stop(lw);
 		return FALSE;
 		}
 
@@ -378,9 +623,11 @@ static void animation_async_ready_cb(GObject *source_object, GAsyncResult *res,
 {
 	GError *error = NULL;
 	AnimationData *animation = data;
+	gsize frame_bytes;
 
 	if (animation)
 		{
+		animation->loading = FALSE;
 		if (g_cancellable_is_cancelled(animation->cancellable))
 			{
 			gdk_pixbuf_animation_new_from_stream_finish(res, NULL);
@@ -395,22 +642,31 @@ static void animation_async_ready_cb(GObject *source_object, GAsyncResult *res,
 			{
 			if (!gdk_pixbuf_animation_is_static_image(animation->gpa))
 				{
-				animation->iter = gdk_pixbuf_animation_get_iter(animation->gpa, NULL);
-				if (animation->iter)
-					{
-					animation->data_adr = animation->lw->image->image_fd;
-					animation->delay = gdk_pixbuf_animation_iter_get_delay_time(animation->iter);
-					animation->valid = TRUE;
-
-					layout_image_animate_update_image(animation->lw);
-
-					g_timeout_add(animation->delay, show_next_frame, animation);
-					}
+				animation->data_adr = animation->lw->image->image_fd;
+				layout_image_animate_update_image(animation->lw);
+
+				/* a few frames ahead, fewer for huge frames */
+				frame_bytes = (gsize)gdk_pixbuf_animation_get_width(animation->gpa) *
+					      gdk_pixbuf_animation_get_height(animation->gpa) * 4;
+				animation->ring_size = CLAMP((gsize)options->image.image_cache_max * 1024 * 1024 / 4 / MAX(frame_bytes, 1),
+							     2, ANIMATION_RING_SIZE);
+				animation->frames = g_queue_new();
+				animation->scale = ((PixbufRenderer *)animation->iw->pr)->scale;
+				animation->due = g_get_monotonic_time();
+
+				animation->thread = g_thread_new("animation", animation_decode_thread, animation);
+				animation->timeout_id = g_timeout_add(0, show_next_frame, animation);
 				}
 			}
+		else if (g_error_matches(error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_UNKNOWN_TYPE))
+			{
+			/* no animation loader for this format */
+			g_error_free(error);
+			}
 		else
 			{
-			log_printf("Error reading GIF file: %s\n", error->message);
+			log_printf("Error reading animation file: %s\n", error->message);
+			g_error_free(error);
 			}
 
 		g_object_unref(animation->in_file);
@@ -427,17 +683,14 @@ static gboolean layout_image_animate_new_file(LayoutWindow *lw)
 
 	if(!layout_image_animate_check(lw)) return FALSE;
 
-	if(lw->animation) lw->animation->valid = FALSE;
-
-	if (lw->animation)
-		{
-		g_cancellable_cancel(lw->animation->cancellable);
-		}
+	layout_image_animate_stop(lw);
 
 	animation = g_new0(AnimationData, 1);
 	lw->animation = animation;
 	animation->lw = lw;
 	animation->cancellable = g_cancellable_new();
+	g_mutex_init(&animation->lock);
+	g_cond_init(&animation->cond);
 
 	in_file = g_file_new_for_path(lw->image->image_fd->path);
 	animation->in_file = in_file;
@@ -445,11 +698,14 @@ static gboolean layout_image_animate_new_file(LayoutWindow *lw)
 	if (gfstream)
 		{
 		animation->gfstream = gfstream;
+		animation->loading = TRUE;
 		gdk_pixbuf_animation_new_from_stream_async((GInputStream*)gfstream, animation->cancellable, animation_async_ready_cb, animation);
 		}
 	else
 		{
-		log_printf("Error reading GIF file: %s\nError: %s\n", lw->image->image_fd->path, error->message);
+		log_printf("Error reading animation file: %s\nError: %s\n", lw->image->image_fd->path, error->message);
+		g_error_free(error);
+		g_object_unref(in_file);
 		}
 
 	return TRUE;
@@ -32,6 +32,8 @@
 #include <glib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "main.h"
 #include "glua.h"
@@ -41,6 +43,10 @@
 static lua_State *L; /** The LUA object needed for all operations (NOTE: That is
 		       * a upper-case variable to match the documentation!) */
 
+static FileData **lua_image_data;	/**< userdata behind the Image global */
+static gint lua_image_ref;		/**< registry reference of that userdata */
+static gint lua_collection_ref;		/**< registry reference of the Collection table */
+
 /* Taking that definition from lua 5.1 source */
 #if defined(LUA_VERSION_NUM) && LUA_VERSION_NUM >= 502
 int luaL_typerror(lua_State *L, int narg, const char *tname)
@@ -258,67 +264,183 @@ void lua_init(void)
 	lua_settable(L, -3);
 	lua_pop(L, 1);
 	lua_pop(L, 1);
+
+	/* Collection Table (Dummy at the moment) */
+	lua_newtable(L);
+	lua_collection_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	/* The Image global, pointed at the current image for each call */
+	lua_image_data = (FileData **)lua_newuserdata(L, sizeof(FileData *));
+	*lua_image_data = NULL;
+	luaL_getmetatable(L, "Image");
+	lua_setmetatable(L, -2);
+	lua_image_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ * script cache
+ *-----------------------------------------------------------------------------
+ */
+
+#define LUA_SCRIPT_CACHE_MAX 64
+
+typedef struct _LuaScript LuaScript;
+struct _LuaScript
+{
+	gchar *path;	/**< resolved script file, NULL for an inline chunk */
+	time_t mtime;
+	off_t size;
+	gint ref;	/**< compiled chunk in the lua registry */
+};
+
+static GHashTable *lua_scripts = NULL;	/**< script file or inline chunk -> LuaScript */
+
+static void lua_script_free(gpointer data)
+{
+	LuaScript *script = data;
+
+	luaL_unref(L, LUA_REGISTRYINDEX, script->ref);
+	g_free(script->path);
+	g_free(script);
+}
+
+static gchar *lua_script_find(const gchar *file)
+{
+	gchar *path;
+
+	path = g_build_filename(get_rc_dir(), "lua", file, NULL);
+	if (access(path, R_OK) == 0) return path;
+	g_free(path);
+
+	/* FIXME: what is the correct way to find the scripts folder? */
+	path = g_build_filename("/usr/local/lib", GQ_APPNAME_LC, file, NULL);
+	if (access(path, R_OK) == 0) return path;
+	g_free(path);
+
+	return NULL;
 }
 
 /**
- * \brief Call a lua function to get a single value.
+ * \brief Get the compiled chunk for a script file or inline code.
+ *
+ * Script files are compiled once and recompiled when their size or
+ * modification time changes. On success the chunk is pushed on the stack.
+ *
+ * \returns NULL if the script does not exist, otherwise an error message
+ * (pushed nothing) or "" (pushed the chunk). The return must be freed.
  */
-gchar *lua_callvalue(FileData *fd, const gchar *file, const gchar *function)
+static gchar *lua_script_push(const gchar *file, const gchar *function)
 {
+	LuaScript *script;
+	struct stat st;
+	gchar *path = NULL;
+	const gchar *key;
+	gchar *msg;
 	gint result;
-	gchar *data = NULL;
-	gchar *path;
-	FileData **image_data;
-	gchar *tmp;
-	GError *error = NULL;
-	gboolean ok;
 
-	ok = access(g_build_filename(get_rc_dir(), "lua", file, NULL), R_OK);
-	if (ok == 0)
+	if (file[0] == '\0' && !function) return NULL;
+
+	if (!lua_scripts)
 		{
-		path = g_build_filename(get_rc_dir(), "lua", file, NULL);
+		lua_scripts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, lua_script_free);
 		}
-	else
+
+	key = (file[0] == '\0') ? function : file;
+	script = g_hash_table_lookup(lua_scripts, key);
+
+	if (script && script->path)
+		{
+		if (stat(script->path, &st) != 0 || st.st_mtime != script->mtime || st.st_size != script->size)
+			{
+			g_hash_table_remove(lua_scripts, key);
+			script = NULL;
+			}
+		}
+
+	if (!script)
 		{
-		/* FIXME: what is the correct way to find the scripts folder? */
-		ok = access(g_build_filename("/usr/local/lib", GQ_APPNAME_LC, file, NULL), R_OK);
-		if (ok == 0)
+		if (file[0] == '\0')
 			{
-			path = g_build_filename("/usr/local/lib", GQ_APPNAME_LC, file, NULL);
+			result = luaL_loadstring(L, function);
 			}
 		else
 			{
-			return g_strdup("");
+			path = lua_script_find(file);
+			if (!path || stat(path, &st) != 0)
+				{
+				g_free(path);
+				return NULL;
+				}
+			result = luaL_loadfile(L, path);
 			}
+
+		if (result)
+			{
+			msg = g_strdup_printf("Error running lua script: %s", lua_tostring(L, -1));
+			lua_pop(L, 1);
+			g_free(path);
+			return msg;
+			}
+
+		if (g_hash_table_size(lua_scripts) >= LUA_SCRIPT_CACHE_MAX)
+			{
+			g_hash_table_remove_all(lua_scripts);
+			}
+
+		script = g_new0(LuaScript, 1);
+		script->path = path;
+		if (path)
+			{
+			script->mtime = st.st_mtime;
+			script->size = st.st_size;
+			}
+		script->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		g_hash_table_insert(lua_scripts, g_strdup(key), script);
 		}
 
+	lua_rawgeti(L, LUA_REGISTRYINDEX, script->ref);
+	return g_strdup("");
+}
+
+/**
+ * \brief Run the chunk on top of the stack for one image.
+ *
+ * The chunk is left on the stack so that it can be run again.
+ */
+static gchar *lua_script_run(FileData *fd)
+{
+	gint top;
+	gint result;
+	gchar *data;
+	gchar *tmp;
+	GError *error = NULL;
+
+	*lua_image_data = fd;
+
 	/* Collection Table (Dummy at the moment) */
-	lua_newtable(L);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, lua_collection_ref);
 	lua_setglobal(L, "Collection");
 
 	/* Current Image */
-	image_data = (FileData **)lua_newuserdata(L, sizeof(FileData *));
-	luaL_getmetatable(L, "Image");
-	lua_setmetatable(L, -2);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, lua_image_ref);
 	lua_setglobal(L, "Image");
 
-	*image_data = fd;
-	if (file[0] == '\0')
-		{
-		result = luaL_dostring(L, function);
-		}
-	else
-		{
-		result = luaL_dofile(L, path);
-		g_free(path);
-		}
+	top = lua_gettop(L);
+	lua_pushvalue(L, -1);
+	result = lua_pcall(L, 0, LUA_MULTRET, 0);
 
 	if (result)
 		{
 		data = g_strdup_printf("Error running lua script: %s", lua_tostring(L, -1));
+		lua_settop(L, top);
 		return data;
 		}
-	data = g_strdup(lua_tostring(L, -1));
+
+	data = g_strdup(lua_gettop(L) > top ? lua_tostring(L, -1) : NULL);
+	lua_settop(L, top);
+	if (!data) return g_strdup("");
+
 	tmp = g_locale_to_utf8(data, strlen(data), NULL, NULL, &error);
 	if (error)
 		{
@@ -328,10 +450,28 @@ gchar *lua_callvalue(FileData *fd, const gchar *file, const gchar *function)
 	else
 		{
 		g_free(data);
-		data = g_strdup(tmp);
+		data = tmp;
 		} // if (error) { ... } else
 	return data;
 }
 
+/**
+ * \brief Call a lua function to get a single value.
+ */
+gchar *lua_callvalue(FileData *fd, const gchar *file, const gchar *function)
+{
+	gchar *data;
+
+	data = lua_script_push(file, function);
+	if (!data) return g_strdup("");
+	if (data[0] != '\0') return data;
+	g_free(data);
+
+	data = lua_script_run(fd);
+	lua_pop(L, 1);
+
+	return data;
+}
+
 #endif
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
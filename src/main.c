@@ -921,6 +921,12 @@ static void setup_sigbus_handler(void)
 #endif
 }
 
+#ifdef GQ_BENCH
+/* geeqie-bench links all of geeqie and brings its own main() */
+#define main geeqie_main
+gint geeqie_main(gint argc, gchar *argv[]);
+#endif
+
 gint main(gint argc, gchar *argv[])
 {
 	CollectionData *first_collection = NULL;
@@ -122,6 +122,7 @@
 #define GQ_LINK_STR "↗"
 #include "typedefs.h"
 #include "debug.h"
+#include "trace.h"
 #include "options.h"
 
 #define DESKTOP_FILE_TEMPLATE GQ_APP_DIR "/template.desktop"
@@ -1058,6 +1058,7 @@ gboolean meta_data_get_keyword_mark(FileData *fd, gint n, gpointer data)
 			found = TRUE;
 
 		}
+	string_list_free(keywords);
 	return found;
 }
 
@@ -1171,6 +1172,278 @@ gboolean keyword_get_is_keyword(GtkTreeModel *keyword_tree, GtkTreeIter *iter)
 	return is_keyword;
 }
 
+/*
+ * keyword index
+ *
+ * Mirrors keyword_tree for the lookups done per file and per node.
+ * Rows are identified by the iter user_data, which is stable for
+ * GtkTreeStore as long as the row exists. Any change to the rows, names
+ * or the keyword flag drops the index, it is rebuilt on the next query.
+ */
+
+typedef struct _KeywordIndexNode KeywordIndexNode;
+struct _KeywordIndexNode
+{
+	KeywordIndexNode *parent;
+	GtkTreeIter iter;
+	gchar *name;
+	gchar *casefold;
+	gboolean is_keyword;
+	guint id;	/**< position in preorder */
+	guint last;	/**< position of the last descendant in preorder */
+};
+
+typedef struct _KeywordIndex KeywordIndex;
+struct _KeywordIndex
+{
+	gboolean valid;
+	GPtrArray *nodes;		/**< KeywordIndexNode in preorder */
+	GHashTable *by_row;		/**< iter user_data -> KeywordIndexNode */
+	GHashTable *by_name;		/**< name -> GList of KeywordIndexNode, in preorder */
+	GHashTable *by_casefold;	/**< casefold -> GList of KeywordIndexNode, in preorder */
+
+	/* the keyword list of the last query, as one bit per node */
+	GList *set_keywords;
+	gboolean set_case_sensitive;
+	guint8 *set_bits;
+	GPtrArray *set_nodes;		/**< nodes with their bit set */
+};
+
+static KeywordIndex keyword_index;
+
+#define KEYWORD_INDEX_BIT(id) (keyword_index.set_bits[(id) >> 3] & (1 << ((id) & 7)))
+
+static void keyword_index_node_free(gpointer data)
+{
+	KeywordIndexNode *node = data;
+
+	g_free(node->name);
+	g_free(node->casefold);
+	g_free(node);
+}
+
+static void keyword_index_invalidate(void)
+{
+	if (!keyword_index.valid) return;
+
+	g_hash_table_destroy(keyword_index.by_row);
+	g_hash_table_destroy(keyword_index.by_name);
+	g_hash_table_destroy(keyword_index.by_casefold);
+	g_ptr_array_free(keyword_index.set_nodes, TRUE);
+	g_ptr_array_free(keyword_index.nodes, TRUE);
+	string_list_free(keyword_index.set_keywords);
+	g_free(keyword_index.set_bits);
+
+	memset(&keyword_index, 0, sizeof(keyword_index));
+}
+
+static void keyword_index_name_add(GHashTable *table, const gchar *key, KeywordIndexNode *node)
+{
+	GList *list;
+
+	if (!key) return;
+
+	list = g_hash_table_lookup(table, key);
+	if (list)
+		{
+		list = g_list_append(list, node);
+		}
+	else
+		{
+		g_hash_table_insert(table, (gpointer)key, g_list_append(NULL, node));
+		}
+}
+
+static void keyword_index_add_children(GtkTreeModel *keyword_tree, GtkTreeIter *parent_iter, KeywordIndexNode *parent)
+{
+	GtkTreeIter iter;
+
+	if (!gtk_tree_model_iter_children(keyword_tree, &iter, parent_iter)) return;
+
+	do	{
+		KeywordIndexNode *node = g_new0(KeywordIndexNode, 1);
+
+		node->parent = parent;
+		node->iter = iter;
+		gtk_tree_model_get(keyword_tree, &iter, KEYWORD_COLUMN_NAME, &node->name,
+							KEYWORD_COLUMN_CASEFOLD, &node->casefold,
+							KEYWORD_COLUMN_IS_KEYWORD, &node->is_keyword, -1);
+		node->id = keyword_index.nodes->len;
+		g_ptr_array_add(keyword_index.nodes, node);
+
+		g_hash_table_insert(keyword_index.by_row, iter.user_data, node);
+		keyword_index_name_add(keyword_index.by_name, node->name, node);
+		keyword_index_name_add(keyword_index.by_casefold, node->casefold, node);
+
+		keyword_index_add_children(keyword_tree, &iter, node);
+		node->last = keyword_index.nodes->len - 1;
+		} while (gtk_tree_model_iter_next(keyword_tree, &iter));
+}
+
+/**
+ * @brief Returns the index of \a keyword_tree, or NULL if it is not the global keyword tree
+ *
+ * With \a build FALSE the index is only returned when it is current.
+ */
+static KeywordIndex *keyword_index_get(GtkTreeModel *keyword_tree_model, gboolean build)
+{
+	if (!keyword_tree || keyword_tree_model != GTK_TREE_MODEL(keyword_tree)) return NULL;
+	if (keyword_index.valid) return &keyword_index;
+	if (!build) return NULL;
+
+	keyword_index.nodes = g_ptr_array_new_with_free_func(keyword_index_node_free);
+	keyword_index.by_row = g_hash_table_new(g_direct_hash, g_direct_equal);
+	keyword_index.by_name = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_list_free);
+	keyword_index.by_casefold = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_list_free);
+	keyword_index.set_nodes = g_ptr_array_new();
+
+	keyword_index_add_children(keyword_tree_model, NULL, NULL);
+
+	keyword_index.set_bits = g_new0(guint8, keyword_index.nodes->len / 8 + 1);
+	keyword_index.valid = TRUE;
+
+	DEBUG_1("keyword index built, %u nodes", keyword_index.nodes->len);
+	return &keyword_index;
+}
+
+static KeywordIndexNode *keyword_index_lookup(KeywordIndex *index, GtkTreeIter *iter)
+{
+	return g_hash_table_lookup(index->by_row, iter->user_data);
+}
+
+static gboolean keyword_index_list_equal(GList *a, GList *b)
+{
+	while (a && b)
+		{
+		if (strcmp(a->data, b->data) != 0) return FALSE;
+		a = a->next;
+		b = b->next;
+		}
+	return (!a && !b);
+}
+
+static void keyword_index_set_keywords(KeywordIndex *index, GList *kw_list)
+{
+	gboolean case_sensitive = options->metadata.keywords_case_sensitive;
+	GList *work;
+	guint i;
+
+	if (index->set_case_sensitive == case_sensitive &&
+	    keyword_index_list_equal(index->set_keywords, kw_list)) return;
+
+	for (i = 0; i < index->set_nodes->len; i++)
+		{
+		KeywordIndexNode *node = g_ptr_array_index(index->set_nodes, i);
+		index->set_bits[node->id >> 3] &= ~(1 << (node->id & 7));
+		}
+	g_ptr_array_set_size(index->set_nodes, 0);
+
+	string_list_free(index->set_keywords);
+	index->set_keywords = string_list_copy(kw_list);
+	index->set_case_sensitive = case_sensitive;
+
+	for (work = kw_list; work; work = work->next)
+		{
+		GList *nodes;
+
+		if (case_sensitive)
+			{
+			nodes = g_hash_table_lookup(index->by_name, work->data);
+			}
+		else
+			{
+			gchar *casefold = g_utf8_casefold(work->data, -1);
+			nodes = g_hash_table_lookup(index->by_casefold, casefold);
+			g_free(casefold);
+			}
+
+		for (; nodes; nodes = nodes->next)
+			{
+			KeywordIndexNode *node = nodes->data;
+
+			if (!node->is_keyword || KEYWORD_INDEX_BIT(node->id)) continue;
+			index->set_bits[node->id >> 3] |= 1 << (node->id & 7);
+			g_ptr_array_add(index->set_nodes, node);
+			}
+		}
+}
+
+/* a keyword is set if it and all keywords above it are in the list */
+static gboolean keyword_index_keyword_is_set(KeywordIndexNode *node)
+{
+	while (node)
+		{
+		if (node->is_keyword && !KEYWORD_INDEX_BIT(node->id)) return FALSE;
+		node = node->parent;
+		}
+	return TRUE;
+}
+
+static gboolean keyword_index_is_set(KeywordIndex *index, KeywordIndexNode *node, GList *kw_list)
+{
+	guint i;
+
+	if (!kw_list) return FALSE;
+
+	keyword_index_set_keywords(index, kw_list);
+
+	if (node->is_keyword) return keyword_index_keyword_is_set(node);
+
+	/* for the purpose of expanding and hiding, a helper is set if it has any children set,
+	 * a set keyword below it implies all keywords between are set too */
+	for (i = 0; i < index->set_nodes->len; i++)
+		{
+		KeywordIndexNode *set_node = g_ptr_array_index(index->set_nodes, i);
+
+		if (set_node->id > node->id && set_node->id <= node->last &&
+		    keyword_index_keyword_is_set(set_node)) return TRUE;
+		}
+	return FALSE;
+}
+
+static void keyword_index_row_changed_cb(GtkTreeModel *keyword_tree_model, GtkTreePath *tpath, GtkTreeIter *iter, gpointer data)
+{
+	KeywordIndexNode *node;
+	gchar *name;
+	gchar *casefold;
+	gboolean is_keyword;
+	gboolean same;
+
+	if (!keyword_index.valid) return;
+
+	/* changes of the mark or the visibility do not touch the index */
+	node = keyword_index_lookup(&keyword_index, iter);
+	if (node)
+		{
+		gtk_tree_model_get(keyword_tree_model, iter, KEYWORD_COLUMN_NAME, &name,
+							      KEYWORD_COLUMN_CASEFOLD, &casefold,
+							      KEYWORD_COLUMN_IS_KEYWORD, &is_keyword, -1);
+		same = (g_strcmp0(name, node->name) == 0 &&
+			g_strcmp0(casefold, node->casefold) == 0 &&
+			!is_keyword == !node->is_keyword);
+		g_free(name);
+		g_free(casefold);
+		if (same) return;
+		}
+
+	keyword_index_invalidate();
+}
+
+static void keyword_index_row_inserted_cb(GtkTreeModel *keyword_tree_model, GtkTreePath *tpath, GtkTreeIter *iter, gpointer data)
+{
+	keyword_index_invalidate();
+}
+
+static void keyword_index_row_deleted_cb(GtkTreeModel *keyword_tree_model, GtkTreePath *tpath, gpointer data)
+{
+	keyword_index_invalidate();
+}
+
+static void keyword_index_rows_reordered_cb(GtkTreeModel *keyword_tree_model, GtkTreePath *tpath, GtkTreeIter *iter, gpointer new_order, gpointer data)
+{
+	keyword_index_invalidate();
+}
+
 void keyword_set(GtkTreeStore *keyword_tree, GtkTreeIter *iter, const gchar *name, gboolean is_keyword)
 {
 	gchar *casefold = g_utf8_casefold(name, -1);
@@ -1216,6 +1489,52 @@ gboolean keyword_exists(GtkTreeModel *keyword_tree, GtkTreeIter *parent_ptr, Gtk
 	gboolean toplevel = FALSE;
 	gboolean ret;
 	gchar *casefold;
+	KeywordIndex *index;
+
+	/* the index is not rebuilt here, loading the config calls this for every keyword */
+	index = keyword_index_get(keyword_tree, FALSE);
+	if (index &&
+	    (!parent_ptr || keyword_index_lookup(index, parent_ptr)) &&
+	    (!sibling || keyword_index_lookup(index, sibling)))
+		{
+		KeywordIndexNode *parent_node = NULL;
+		KeywordIndexNode *sibling_node = NULL;
+		GList *nodes;
+
+		if (sibling) sibling_node = keyword_index_lookup(index, sibling);
+
+		if (parent_ptr)
+			{
+			parent_node = keyword_index_lookup(index, parent_ptr);
+			}
+		else if (sibling_node)
+			{
+			parent_node = sibling_node->parent;
+			}
+
+		if (options->metadata.keywords_case_sensitive)
+			{
+			nodes = g_hash_table_lookup(index->by_name, name);
+			}
+		else
+			{
+			casefold = g_utf8_casefold(name, -1);
+			nodes = g_hash_table_lookup(index->by_casefold, casefold);
+			g_free(casefold);
+			}
+
+		for (; nodes; nodes = nodes->next)
+			{
+			KeywordIndexNode *node = nodes->data;
+
+			if (node->parent != parent_node) continue;
+			if (exclude_sibling && node == sibling_node) continue;
+
+			if (result) *result = node->iter;
+			return TRUE;
+			}
+		return FALSE;
+		}
 
 	if (parent_ptr)
 		{
@@ -1326,6 +1645,34 @@ GList *keyword_tree_get_path(GtkTreeModel *keyword_tree, GtkTreeIter *iter_ptr)
 gboolean keyword_tree_get_iter(GtkTreeModel *keyword_tree, GtkTreeIter *iter_ptr, GList *path)
 {
 	GtkTreeIter iter;
+	KeywordIndex *index;
+
+	index = keyword_index_get(keyword_tree, TRUE);
+	if (index && path)
+		{
+		GList *last = g_list_last(path);
+		GList *nodes;
+
+		for (nodes = g_hash_table_lookup(index->by_name, last->data); nodes; nodes = nodes->next)
+			{
+			KeywordIndexNode *node = nodes->data;
+			GList *work = last->prev;
+
+			node = node->parent;
+			while (node && work && g_strcmp0(node->name, work->data) == 0)
+				{
+				node = node->parent;
+				work = work->prev;
+				}
+
+			if (!node && !work)
+				{
+				*iter_ptr = ((KeywordIndexNode *)nodes->data)->iter;
+				return TRUE;
+				}
+			}
+		return FALSE;
+		}
 
 	if (!gtk_tree_model_get_iter_first(keyword_tree, &iter)) return FALSE;
 
@@ -1451,6 +1798,12 @@ gboolean keyword_tree_is_set(GtkTreeModel *keyword_tree, GtkTreeIter *iter, GLis
 	gboolean ret;
 	GList *casefold_list = NULL;
 	GList *work;
+	KeywordIndex *index;
+	KeywordIndexNode *node;
+
+	index = keyword_index_get(keyword_tree, TRUE);
+	node = index ? keyword_index_lookup(index, iter) : NULL;
+	if (node) return keyword_index_is_set(index, node, kw_list);
 
 	if (options->metadata.keywords_case_sensitive)
 		{
@@ -1714,6 +2067,15 @@ void keyword_tree_new(void)
 	if (keyword_tree) return;
 
 	keyword_tree = gtk_tree_store_new(KEYWORD_COLUMN_COUNT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_POINTER);
+
+	g_signal_connect(G_OBJECT(keyword_tree), "row-changed",
+			 G_CALLBACK(keyword_index_row_changed_cb), NULL);
+	g_signal_connect(G_OBJECT(keyword_tree), "row-inserted",
+			 G_CALLBACK(keyword_index_row_inserted_cb), NULL);
+	g_signal_connect(G_OBJECT(keyword_tree), "row-deleted",
+			 G_CALLBACK(keyword_index_row_deleted_cb), NULL);
+	g_signal_connect(G_OBJECT(keyword_tree), "rows-reordered",
+			 G_CALLBACK(keyword_index_rows_reordered_cb), NULL);
 }
 
 static GtkTreeIter keyword_tree_default_append(GtkTreeStore *keyword_tree, GtkTreeIter *parent, const gchar *name, gboolean is_keyword)
@@ -408,4 +408,31 @@ void tree_path_free_wrapper(void *data, void *useradata)
 	gtk_tree_path_free(data);
 }
 
+/**
+ * @brief Appends \a text to \a out as a quoted JSON string
+ */
+void json_append_string(GString *out, const gchar *text)
+{
+	const gchar *p;
+
+	g_string_append_c(out, '"');
+	for (p = text; *p; p++)
+		{
+		if (*p == '"' || *p == '\\')
+			{
+			g_string_append_c(out, '\\');
+			g_string_append_c(out, *p);
+			}
+		else if ((guchar)*p < 0x20)
+			{
+			g_string_append_printf(out, "\\u%04x", (guchar)*p);
+			}
+		else
+			{
+			g_string_append_c(out, *p);
+			}
+		}
+	g_string_append_c(out, '"');
+}
+
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -33,5 +33,6 @@ gchar *convert_rating_to_stars(gint rating);
 gchar *get_symbolic_link(const gchar *path_utf8);
 gint get_cpu_cores(void);
 void tree_path_free_wrapper(void *data, void *useradata);
+void json_append_string(GString *out, const gchar *text);
 #endif /* MISC_H */
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -109,6 +109,7 @@ ConfOptions *init_options(ConfOptions *options)
 	options->image.exif_proof_rotate_enable = TRUE;
 	options->image.fit_window_to_image = FALSE;
 	options->image.limit_autofit_size = FALSE;
+	options->image.loader_threads = 0;
 	options->image.limit_window_size = TRUE;
 	options->image.max_autofit_size = 100;
 	options->image.max_enlargement_size = 900;
@@ -171,6 +172,7 @@ ConfOptions *init_options(ConfOptions *options)
 	options->slideshow.delay = 50;
 	options->slideshow.random = FALSE;
 	options->slideshow.repeat = FALSE;
+	options->slideshow.decode_ahead = 2;
 
 	options->thumbnails.cache_into_dirs = FALSE;
 	options->thumbnails.enable_caching = TRUE;
@@ -178,9 +180,12 @@ ConfOptions *init_options(ConfOptions *options)
 	options->thumbnails.max_width = DEFAULT_THUMB_WIDTH;
 	options->thumbnails.quality = GDK_INTERP_TILES;
 	options->thumbnails.spec_standard = TRUE;
+	options->thumbnails.cache_manifest = TRUE;
 	options->thumbnails.use_xvpics = TRUE;
 	options->thumbnails.use_exif = FALSE;
 	options->thumbnails.use_ft_metadata = TRUE;
+	options->thumbnails.video_threads = 2;
+	options->thumbnails.video_timeout = 20;
 // 	options->thumbnails.use_ft_metadata_small = TRUE;
 	options->thumbnails.collection_preview = 20;
 
@@ -139,6 +139,7 @@ struct _ConfOptions
 		gint tile_cache_max;	/**< in megabytes */
 		gint image_cache_max;   /**< in megabytes */
 		gboolean enable_read_ahead;
+		gint loader_threads;	/**< decoding threads, 0 for one per processor */
 
 		ZoomMode zoom_mode;
 		gboolean zoom_2pass;
@@ -162,9 +163,12 @@ struct _ConfOptions
 		gboolean cache_into_dirs;
 		gboolean use_xvpics;
 		gboolean spec_standard;
+		gboolean cache_manifest;	/**< remember validated standard thumbnails between cache cleanups */
 		guint quality;
 		gboolean use_exif;
 		gboolean use_ft_metadata;
+		gint video_threads;	/**< number of videos decoded in parallel for thumbnails */
+		gint video_timeout;	/**< seconds to wait for a frame of one video, 0 for no limit */
 		gint collection_preview;
 // 		gboolean use_ft_metadata_small;
 	} thumbnails;
@@ -206,6 +210,7 @@ struct _ConfOptions
 		gint delay;	/**< in tenths of a second */
 		gboolean random;
 		gboolean repeat;
+		gint decode_ahead;	/**< number of upcoming images decoded in advance */
 	} slideshow;
 
 	/* fullscreen */
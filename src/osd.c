@@ -27,6 +27,7 @@
 
 #include "dnd.h"
 #include "exif.h"
+#include "filedata.h"
 #include "glua.h"
 #include "metadata.h"
 #include "ui_fileops.h"
@@ -241,32 +242,147 @@ static gchar *keywords_to_string(FileData *fd)
 	return ret;
 }
 
-gchar *image_osd_mkinfo(const gchar *str, FileData *fd, GHashTable *vars)
+/*
+ *-----------------------------------------------------------------------------
+ * compiled templates
+ *-----------------------------------------------------------------------------
+ */
+
+typedef enum {
+	OSD_SEGMENT_TEXT,
+	OSD_SEGMENT_KEYWORDS,
+	OSD_SEGMENT_COMMENT,
+	OSD_SEGMENT_IMAGECOMMENT,
+	OSD_SEGMENT_RATING,
+	OSD_SEGMENT_LUA,
+	OSD_SEGMENT_VAR		/* a variable of the caller, or else a metadata key */
+} OsdSegmentType;
+
+typedef struct _OsdSegment OsdSegment;
+struct _OsdSegment
 {
-	gchar delim = '%', imp = '|', sep[] = " - ";
-	gchar *start, *end;
-	guint pos, prev;
-	gboolean want_separator = FALSE;
-	gchar *name, *data;
-	GString *new;
-	gchar *ret;
+	OsdSegmentType type;
+	gchar *text;		/* literal text, or the key name */
+	gchar *lua_file;
+	gchar *lua_function;
+	guint limit;
+	gboolean has_extra;
+	gchar *left;		/* extra string before the data, may be NULL */
+	gchar *right;		/* extra string after the data */
+};
 
-	if (!str || !*str) return g_strdup("");
+typedef struct _OsdTemplate OsdTemplate;
+struct _OsdTemplate
+{
+	gchar *str;
+	GList *segments;
+};
+
+#define OSD_TEMPLATE_CACHE_MAX 8
+#define OSD_VALUE_CACHE_MAX 64
+
+static GList *osd_templates = NULL;	/* OsdTemplate, most recently used first */
+
+static void osd_segment_free(gpointer data)
+{
+	OsdSegment *seg = data;
+
+	g_free(seg->text);
+	g_free(seg->lua_file);
+	g_free(seg->lua_function);
+	g_free(seg->left);
+	g_free(seg->right);
+	g_free(seg);
+}
+
+static void osd_template_free(OsdTemplate *tmpl)
+{
+	g_list_free_full(tmpl->segments, osd_segment_free);
+	g_free(tmpl->str);
+	g_free(tmpl);
+}
 
-	new = g_string_new(str);
+static void osd_template_add_text(OsdTemplate *tmpl, const gchar *text, gsize len)
+{
+	OsdSegment *seg;
+
+	if (len == 0) return;
+
+	seg = g_new0(OsdSegment, 1);
+	seg->type = OSD_SEGMENT_TEXT;
+	seg->text = g_strndup(text, len);
+	tmpl->segments = g_list_prepend(tmpl->segments, seg);
+}
+
+/* Display data between left and right parts of extra string
+ * the data is expressed by a '*' character. A '*' may be escaped
+ * by a \. You should escape all '*' characters, do not rely on the
+ * current implementation which only replaces the first unescaped '*'.
+ * If no "*" is present, the extra string is just appended to data string.
+ * Pango mark up is accepted in left and right parts.
+ * Any \n is replaced by a newline
+ * Examples:
+ * "<i>*</i>\n" -> data is displayed in italics ended with a newline
+ * "\n" 	-> ended with newline
+ * "ISO *"	-> prefix data with "ISO " (ie. "ISO 100")
+ * "\**\*"	-> prefix data with a star, and append a star (ie. "*100*")
+ * "\\*"	-> prefix data with an anti slash (ie "\100")
+ * "Collection <b>*</b>\n" -> display data in bold prefixed by "Collection " and a newline is appended
+ *
+ * FIXME: using background / foreground colors lead to weird results.
+ */
+static void osd_segment_set_extra(OsdSegment *seg, gchar *extra)
+{
+	gchar *left = NULL;
+	gchar *right = extra;
+	gchar *p;
+	guint len = strlen(extra);
+
+	/* Search for left and right parts and unescape characters */
+	for (p = extra; *p; p++, len--)
+		if (p[0] == '\\')
+			{
+			if (p[1] == 'n')
+				{
+				memmove(p+1, p+2, --len);
+				p[0] = '\n';
+				}
+			else if (p[1] != '\0')
+				memmove(p, p+1, len--); // includes \0
+			}
+		else if (p[0] == '*' && !left)
+			{
+			right = p + 1;
+			left = extra;
+			}
+
+	if (left) right[-1] = '\0';
+
+	seg->has_extra = TRUE;
+	seg->left = g_strdup(left);
+	seg->right = g_strdup(right);
+}
+
+static OsdTemplate *osd_template_compile(const gchar *str)
+{
+	gchar delim = '%';
+	OsdTemplate *tmpl;
+	const gchar *start, *end;
+	const gchar *rest;
 
-	prev = -1;
+	tmpl = g_new0(OsdTemplate, 1);
+	tmpl->str = g_strdup(str);
 
+	rest = str;
 	while (TRUE)
 		{
-		guint limit = 0;
-		gchar *trunc = NULL;
-		gchar *limpos = NULL;
-		gchar *extra = NULL;
-		gchar *extrapos = NULL;
-		gchar *p;
-
-		start = strchr(new->str + (prev + 1), delim);
+		OsdSegment *seg;
+		const gchar *trunc = NULL;
+		const gchar *limpos = NULL;
+		const gchar *extrapos = NULL;
+		const gchar *p;
+
+		start = strchr(rest, delim);
 		if (!start)
 			break;
 		end = strchr(start+1, delim);
@@ -294,53 +410,231 @@ gchar *image_osd_mkinfo(const gchar *str, FileData *fd, GHashTable *vars)
 				}
 			}
 
-		if (limpos)
-			limit = (guint) atoi(limpos);
+		seg = g_new0(OsdSegment, 1);
+		seg->text = g_strndup(start+1, (trunc ? trunc : end)-start-1);
+
+		if (strcmp(seg->text, "keywords") == 0)
+			seg->type = OSD_SEGMENT_KEYWORDS;
+		else if (strcmp(seg->text, "comment") == 0)
+			seg->type = OSD_SEGMENT_COMMENT;
+		else if (strcmp(seg->text, "imagecomment") == 0)
+			seg->type = OSD_SEGMENT_IMAGECOMMENT;
+		else if (strcmp(seg->text, "rating") == 0)
+			seg->type = OSD_SEGMENT_RATING;
+#ifdef HAVE_LUA
+		else if (strncmp(seg->text, "lua/", 4) == 0)
+			{
+			gchar *tmp = strchr(seg->text + 4, '/');
 
-		if (extrapos)
-			extra = g_strndup(extrapos, end - extrapos);
+			if (!tmp)
+				{
+				/* the rest of the template is left as it is */
+				osd_segment_free(seg);
+				break;
+				}
+			seg->type = OSD_SEGMENT_LUA;
+			seg->lua_file = g_strndup(seg->text + 4, tmp - seg->text - 4);
+			seg->lua_function = g_strdup(tmp + 1);
+			}
+#endif
+		else
+			seg->type = OSD_SEGMENT_VAR;
 
-		name = g_strndup(start+1, (trunc ? trunc : end)-start-1);
-		pos = start - new->str;
-		data = NULL;
+		if (limpos)
+			seg->limit = (guint) atoi(limpos);
 
-		if (strcmp(name, "keywords") == 0)
-			{
-			data = keywords_to_string(fd);
-			}
-		else if (strcmp(name, "comment") == 0)
-			{
-			data = metadata_read_string(fd, COMMENT_KEY, METADATA_PLAIN);
-			}
-		else if (strcmp(name, "imagecomment") == 0)
+		if (extrapos)
 			{
-			data = exif_get_image_comment(fd);
+			gchar *extra = g_strndup(extrapos, end - extrapos);
+			osd_segment_set_extra(seg, extra);
+			g_free(extra);
 			}
-		else if (strcmp(name, "rating") == 0)
+
+		osd_template_add_text(tmpl, rest, start - rest);
+		tmpl->segments = g_list_prepend(tmpl->segments, seg);
+		rest = end + 1;
+		}
+
+	osd_template_add_text(tmpl, rest, strlen(rest));
+	tmpl->segments = g_list_reverse(tmpl->segments);
+
+	return tmpl;
+}
+
+static OsdTemplate *osd_template_get(const gchar *str)
+{
+	GList *work;
+	OsdTemplate *tmpl;
+
+	for (work = osd_templates; work; work = work->next)
+		{
+		tmpl = work->data;
+		if (strcmp(tmpl->str, str) == 0)
 			{
-			data = metadata_read_string(fd, RATING_KEY, METADATA_PLAIN);
+			osd_templates = g_list_remove_link(osd_templates, work);
+			osd_templates = g_list_concat(work, osd_templates);
+			return tmpl;
 			}
+		}
+
+	tmpl = osd_template_compile(str);
+	osd_templates = g_list_prepend(osd_templates, tmpl);
+
+	if (g_list_length(osd_templates) > OSD_TEMPLATE_CACHE_MAX)
+		{
+		work = g_list_last(osd_templates);
+		osd_template_free(work->data);
+		osd_templates = g_list_delete_link(osd_templates, work);
+		}
+
+	return tmpl;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ * value cache
+ *-----------------------------------------------------------------------------
+ */
+
+/* Values read from the metadata of a file are kept per FileData, valid
+ * while fd->version is unchanged. Metadata changes also drop the entry
+ * from the notify callback, which runs before the overlay's own. */
+
+typedef struct _OsdValues OsdValues;
+struct _OsdValues
+{
+	FileData *fd;
+	gint version;
+	GHashTable *values;	/* key -> value, NULL values are stored too */
+};
+
+static GHashTable *osd_value_cache = NULL;	/* FileData -> OsdValues */
+
+static void osd_values_free(gpointer data)
+{
+	OsdValues *ov = data;
+
+	g_hash_table_destroy(ov->values);
+	file_data_unref(ov->fd);
+	g_free(ov);
+}
+
+static void osd_value_cache_notify_cb(FileData *fd, NotifyType type, gpointer data)
+{
+	if (!(type & (NOTIFY_METADATA | NOTIFY_REREAD | NOTIFY_CHANGE | NOTIFY_GROUPING | NOTIFY_ORIENTATION))) return;
+
+	g_hash_table_remove(osd_value_cache, fd);
+}
+
+static OsdValues *osd_value_cache_get(FileData *fd)
+{
+	OsdValues *ov;
+
+	if (!osd_value_cache)
+		{
+		osd_value_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, osd_values_free);
+		file_data_register_notify_func(osd_value_cache_notify_cb, NULL, NOTIFY_PRIORITY_HIGH);
+		}
+
+	ov = g_hash_table_lookup(osd_value_cache, fd);
+	if (ov && ov->version == fd->version) return ov;
+
+	if (!ov && g_hash_table_size(osd_value_cache) >= OSD_VALUE_CACHE_MAX)
+		{
+		g_hash_table_remove_all(osd_value_cache);
+		}
+
+	ov = g_new0(OsdValues, 1);
+	ov->fd = file_data_ref(fd);
+	ov->version = fd->version;
+	ov->values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	g_hash_table_replace(osd_value_cache, fd, ov);
+
+	return ov;
+}
+
+static gchar *osd_segment_read(OsdSegment *seg, FileData *fd)
+{
+	switch (seg->type)
+		{
+		case OSD_SEGMENT_KEYWORDS:
+			return keywords_to_string(fd);
+		case OSD_SEGMENT_COMMENT:
+			return metadata_read_string(fd, COMMENT_KEY, METADATA_PLAIN);
+		case OSD_SEGMENT_IMAGECOMMENT:
+			return exif_get_image_comment(fd);
+		case OSD_SEGMENT_RATING:
+			return metadata_read_string(fd, RATING_KEY, METADATA_PLAIN);
 #ifdef HAVE_LUA
-		else if (strncmp(name, "lua/", 4) == 0)
-			{
-			gchar *tmp;
-			tmp = strchr(name+4, '/');
-			if (!tmp)
-				break;
-			*tmp = '\0';
-			data = lua_callvalue(fd, name+4, tmp+1);
-			}
+		case OSD_SEGMENT_LUA:
+			return lua_callvalue(fd, seg->lua_file, seg->lua_function);
 #endif
-		else
+		default:
+			return metadata_read_string(fd, seg->text, METADATA_FORMATTED);
+		}
+}
+
+static gchar *osd_segment_value(OsdSegment *seg, FileData *fd, GHashTable *vars)
+{
+	OsdValues *ov;
+	gpointer value;
+	gchar *data;
+
+	if (seg->type == OSD_SEGMENT_VAR)
+		{
+		data = g_strdup(g_hash_table_lookup(vars, seg->text));
+		if (data) return data;
+		}
+
+	/* file.* values come from the file system and are cheap, page_no changes without a new version */
+	if (!fd || strncmp(seg->text, "file.", 5) == 0) return osd_segment_read(seg, fd);
+
+	ov = osd_value_cache_get(fd);
+	if (g_hash_table_lookup_extended(ov->values, seg->text, NULL, &value))
+		{
+		return g_strdup(value);
+		}
+
+	data = osd_segment_read(seg, fd);
+	g_hash_table_insert(ov->values, g_strdup(seg->text), g_strdup(data));
+
+	return data;
+}
+
+gchar *image_osd_mkinfo(const gchar *str, FileData *fd, GHashTable *vars)
+{
+	gchar imp = '|', sep[] = " - ";
+	gchar *start, *end;
+	gboolean want_separator = FALSE;
+	gboolean skip_imp = FALSE;
+	OsdTemplate *tmpl;
+	GList *work;
+	GString *new;
+	gchar *ret;
+
+	if (!str || !*str) return g_strdup("");
+
+	tmpl = osd_template_get(str);
+	new = g_string_sized_new(strlen(str));
+
+	for (work = tmpl->segments; work; work = work->next)
+		{
+		OsdSegment *seg = work->data;
+		OsdSegment *next;
+		gchar *data;
+
+		if (seg->type == OSD_SEGMENT_TEXT)
 			{
-			data = g_strdup(g_hash_table_lookup(vars, name));
-			if (!data)
-				data = metadata_read_string(fd, name, METADATA_FORMATTED);
+			g_string_append(new, seg->text + (skip_imp ? 1 : 0));
+			skip_imp = FALSE;
+			continue;
 			}
 
-		if (data && *data && limit > 0 && strlen(data) > limit + 3)
+		data = osd_segment_value(seg, fd, vars);
+
+		if (data && *data && seg->limit > 0 && strlen(data) > seg->limit + 3)
 			{
-			gchar *new_data = g_strdup_printf("%-*.*s...", limit, limit, data);
+			gchar *new_data = g_strdup_printf("%-*.*s...", seg->limit, seg->limit, data);
 			g_free(data);
 			data = new_data;
 			}
@@ -353,88 +647,44 @@ gchar *image_osd_mkinfo(const gchar *str, FileData *fd, GHashTable *vars)
 			data = escaped;
 			}
 
-		if (extra)
+		if (seg->has_extra && data && *data)
 			{
-			if (data && *data)
-				{
-				/* Display data between left and right parts of extra string
-				 * the data is expressed by a '*' character. A '*' may be escaped
-				 * by a \. You should escape all '*' characters, do not rely on the
-				 * current implementation which only replaces the first unescaped '*'.
-				 * If no "*" is present, the extra string is just appended to data string.
-				 * Pango mark up is accepted in left and right parts.
-				 * Any \n is replaced by a newline
-				 * Examples:
-				 * "<i>*</i>\n" -> data is displayed in italics ended with a newline
-				 * "\n" 	-> ended with newline
-				 * "ISO *"	-> prefix data with "ISO " (ie. "ISO 100")
-				 * "\**\*"	-> prefix data with a star, and append a star (ie. "*100*")
-				 * "\\*"	-> prefix data with an anti slash (ie "\100")
-				 * "Collection <b>*</b>\n" -> display data in bold prefixed by "Collection " and a newline is appended
-				 *
-				 * FIXME: using background / foreground colors lead to weird results.
-				 */
-				gchar *new_data;
-				gchar *left = NULL;
-				gchar *right = extra;
-				gchar *p;
-				guint len = strlen(extra);
-
-				/* Search for left and right parts and unescape characters */
-				for (p = extra; *p; p++, len--)
-					if (p[0] == '\\')
-						{
-						if (p[1] == 'n')
-							{
-							memmove(p+1, p+2, --len);
-							p[0] = '\n';
-							}
-						else if (p[1] != '\0')
-							memmove(p, p+1, len--); // includes \0
-						}
-					else if (p[0] == '*' && !left)
-						{
-						right = p + 1;
-						left = extra;
-						}
-
-				if (left) right[-1] = '\0';
-
-				new_data = g_strdup_printf("%s%s%s", left ? left : "", data, right);
-				g_free(data);
-				data = new_data;
-				}
-			g_free(extra);
+			gchar *new_data = g_strdup_printf("%s%s%s", seg->left ? seg->left : "", data, seg->right);
+			g_free(data);
+			data = new_data;
 			}
 
-		g_string_erase(new, pos, end-start+1);
 		if (data && *data)
 			{
 			if (want_separator)
 				{
 				/* insert separator */
-				g_string_insert(new, pos, sep);
-				pos += strlen(sep);
+				g_string_append(new, sep);
 				want_separator = FALSE;
 				}
 
-			g_string_insert(new, pos, data);
-			pos += strlen(data);
-		}
-
-		if (pos-prev >= 1 && new->str[pos] == imp)
-			{
-			/* pipe character is replaced by a separator, delete it
-			 * and raise a flag if needed */
-			g_string_erase(new, pos--, 1);
-			want_separator |= (data && *data);
+			g_string_append(new, data);
 			}
 
-		if (new->str[pos] == '\n') want_separator = FALSE;
+		next = work->next ? work->next->data : NULL;
+		if (next && next->type == OSD_SEGMENT_TEXT)
+			{
+			if (next->text[0] == imp)
+				{
+				/* pipe character is replaced by a separator, delete it
+				 * and raise a flag if needed */
+				skip_imp = TRUE;
+				want_separator |= (data && *data);
 
-		prev = pos - 1;
+				/* no separator after data that ends the line */
+				if (new->len > 0 && new->str[new->len - 1] == '\n') want_separator = FALSE;
+				}
+			else if (next->text[0] == '\n')
+				{
+				want_separator = FALSE;
+				}
+			}
 
-		g_free(name);
 		g_free(data);
 		}
 
@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Keeps multi-page documents parsed between page flips.
+ *
+ * The document handle and a few rendered pages hang off the FileData, so
+ * stepping through pages only renders the page that is not yet cached, and
+ * the pages next to the current one are rendered in the background.
+ * Loaders run in threads, so all access goes through the cache lock, and
+ * background jobs hold their own reference so the cache may be released
+ * from the FileData at any time. A background render works on the document
+ * without the lock, a loader meanwhile finds the document busy.
+ *
+ * All caches together are kept below PAGE_CACHE_MAX_SIZE, the least
+ * recently used ones are emptied first.
+ */
+
+#include "main.h"
+#include "page_cache.h"
+
+typedef struct _PageCacheEntry PageCacheEntry;
+struct _PageCacheEntry {
+	gint page_num;
+	GdkPixbuf *pixbuf;
+};
+
+struct _PageCache {
+	gint refcount;
+	GMutex lock;	/**< protects everything below */
+	GCond rendered;	/**< signalled when a background render is done */
+
+	gint64 size;	/**< size and date of the file the document was read from */
+	time_t date;
+	gboolean released;
+
+	gpointer document;
+	GDestroyNotify document_free;
+	PageCacheRenderFunc render;
+	gint page_total;
+	gsize document_size;
+
+	gboolean rendering;	/**< the document is used by a background render */
+	gint rendering_page;
+	gpointer stale_document;	/**< dropped while rendering, freed when the render is done */
+	GDestroyNotify stale_document_free;
+
+	GList *pages;	/**< PageCacheEntry, most recently used first */
+
+	gsize bytes;	/**< document and pages, part of page_cache_bytes */
+};
+
+typedef struct _PageCacheJob PageCacheJob;
+struct _PageCacheJob {
+	PageCache *pc;
+	gint page_num;
+};
+
+static GMutex page_cache_fd_lock;	/* protects fd->page_cache */
+static GMutex page_cache_pool_lock;
+static GThreadPool *page_cache_pool = NULL;
+
+static GMutex page_cache_lru_lock;	/* protects the two below and PageCache bytes */
+static GList *page_cache_lru = NULL;	/**< PageCache holding data, most recently used first */
+static gsize page_cache_bytes = 0;
+
+
+static gsize page_cache_entry_size(PageCacheEntry *pe)
+{
+	return (gsize)gdk_pixbuf_get_rowstride(pe->pixbuf) * gdk_pixbuf_get_height(pe->pixbuf);
+}
+
+static void page_cache_entry_free(PageCacheEntry *pe)
+{
+	g_object_unref(pe->pixbuf);
+	g_free(pe);
+}
+
+/* frees the pages and the document, returns the bytes they were counted with,
+ * call with the lock and page_cache_lru_lock held */
+static gsize page_cache_drop_data(PageCache *pc)
+{
+	gsize bytes = pc->bytes;
+
+	g_list_free_full(pc->pages, (GDestroyNotify)page_cache_entry_free);
+	pc->pages = NULL;
+
+	if (pc->document && pc->document_free)
+		{
+		if (pc->rendering)
+			{
+			pc->stale_document = pc->document;
+			pc->stale_document_free = pc->document_free;
+			}
+		else
+			{
+			pc->document_free(pc->document);
+			}
+		}
+	pc->document = NULL;
+	pc->document_free = NULL;
+	pc->render = NULL;
+	pc->page_total = 0;
+	pc->document_size = 0;
+	pc->bytes = 0;
+
+	return bytes;
+}
+
+/* call with the lock held */
+static void page_cache_clear(PageCache *pc)
+{
+	g_mutex_lock(&page_cache_lru_lock);
+	page_cache_bytes -= page_cache_drop_data(pc);
+	page_cache_lru = g_list_remove(page_cache_lru, pc);
+	g_mutex_unlock(&page_cache_lru_lock);
+}
+
+/* adds delta to the size of pc and makes it the most recently used,
+ * call with the lock held */
+static void page_cache_account(PageCache *pc, gssize delta)
+{
+	g_mutex_lock(&page_cache_lru_lock);
+	page_cache_lru = g_list_remove(page_cache_lru, pc);
+	pc->bytes += delta;
+	page_cache_bytes += delta;
+	if (pc->bytes > 0) page_cache_lru = g_list_prepend(page_cache_lru, pc);
+	g_mutex_unlock(&page_cache_lru_lock);
+}
+
+/* Empties the least recently used caches other than pc, then drops the
+ * oldest pages of pc except the current one, until all fit in
+ * PAGE_CACHE_MAX_SIZE. Call with the lock of pc held. */
+static void page_cache_trim(PageCache *pc)
+{
+	GList *work;
+
+	g_mutex_lock(&page_cache_lru_lock);
+
+	work = g_list_last(page_cache_lru);
+	while (work && page_cache_bytes > PAGE_CACHE_MAX_SIZE)
+		{
+		PageCache *old = work->data;
+		GList *prev = work->prev;
+
+		/* waiting for a cache in use could deadlock, it is skipped */
+		if (old != pc && g_mutex_trylock(&old->lock))
+			{
+			DEBUG_1("page cache: over size, dropping a document");
+			page_cache_bytes -= page_cache_drop_data(old);
+			page_cache_lru = g_list_delete_link(page_cache_lru, work);
+			g_mutex_unlock(&old->lock);
+			}
+		work = prev;
+		}
+
+	while (page_cache_bytes > PAGE_CACHE_MAX_SIZE && pc->pages && pc->pages->next)
+		{
+		GList *last = g_list_last(pc->pages);
+		gsize bytes = page_cache_entry_size(last->data);
+
+		page_cache_entry_free(last->data);
+		pc->pages = g_list_delete_link(pc->pages, last);
+		pc->bytes -= bytes;
+		page_cache_bytes -= bytes;
+		}
+
+	g_mutex_unlock(&page_cache_lru_lock);
+}
+
+static PageCache *page_cache_new(FileData *fd)
+{
+	PageCache *pc = g_new0(PageCache, 1);
+
+	pc->refcount = 1;
+	g_mutex_init(&pc->lock);
+	g_cond_init(&pc->rendered);
+	pc->size = fd->size;
+	pc->date = fd->date;
+
+	return pc;
+}
+
+/* detach the cache from fd, call with page_cache_fd_lock held */
+static void page_cache_detach(FileData *fd)
+{
+	PageCache *pc = fd->page_cache;
+
+	if (!pc) return;
+	fd->page_cache = NULL;
+
+	g_mutex_lock(&pc->lock);
+	pc->released = TRUE;
+	page_cache_clear(pc);
+	g_mutex_unlock(&pc->lock);
+
+	page_cache_unref(pc);
+}
+
+/**
+ * @brief Returns the page cache of fd, creating it when needed
+ *
+ * A cache that was built from an older version of the file is dropped.
+ * The result must be released with page_cache_unref().
+ */
+PageCache *page_cache_ref(FileData *fd)
+{
+	PageCache *pc;
+
+	g_mutex_lock(&page_cache_fd_lock);
+
+	if (fd->page_cache && (fd->page_cache->size != fd->size || fd->page_cache->date != fd->date))
+		{
+		DEBUG_1("page cache: %s changed, dropping cached pages", fd->path);
+		page_cache_detach(fd);
+		}
+
+	if (!fd->page_cache) fd->page_cache = page_cache_new(fd);
+
+	pc = fd->page_cache;
+	g_atomic_int_inc(&pc->refcount);
+
+	g_mutex_unlock(&page_cache_fd_lock);
+
+	return pc;
+}
+
+void page_cache_unref(PageCache *pc)
+{
+	if (!pc) return;
+	if (!g_atomic_int_dec_and_test(&pc->refcount)) return;
+
+	g_mutex_lock(&pc->lock);
+	page_cache_clear(pc);
+	g_mutex_unlock(&pc->lock);
+
+	g_cond_clear(&pc->rendered);
+	g_mutex_clear(&pc->lock);
+	g_free(pc);
+}
+
+/* called when fd is freed */
+void page_cache_release(FileData *fd)
+{
+	g_mutex_lock(&page_cache_fd_lock);
+	page_cache_detach(fd);
+	g_mutex_unlock(&page_cache_fd_lock);
+}
+
+void page_cache_lock(PageCache *pc)
+{
+	g_mutex_lock(&pc->lock);
+}
+
+void page_cache_unlock(PageCache *pc)
+{
+	g_mutex_unlock(&pc->lock);
+}
+
+/* The functions below must be called with the lock held */
+
+/**
+ * @brief Returns the cached document, NULL if there is none or a background render uses it
+ */
+gpointer page_cache_get_document(PageCache *pc)
+{
+	if (pc->rendering) return NULL;
+	return pc->document;
+}
+
+/**
+ * @brief TRUE while a background render uses the document
+ *
+ * A loader should then not replace the document, but render the page
+ * from a document of its own.
+ */
+gboolean page_cache_get_busy(PageCache *pc)
+{
+	return pc->rendering;
+}
+
+/**
+ * @brief Hands document to the cache
+ * @param document_size memory held by the document, counted against PAGE_CACHE_MAX_SIZE
+ */
+void page_cache_set_document(PageCache *pc, gpointer document, gsize document_size, gint page_total,
+			     PageCacheRenderFunc render_func, GDestroyNotify free_func)
+{
+	page_cache_clear(pc);
+
+	pc->document = document;
+	pc->document_size = document_size;
+	pc->page_total = page_total;
+	pc->render = render_func;
+	pc->document_free = free_func;
+
+	/* a loader may still hand in a document after the file was released */
+	if (pc->released)
+		{
+		page_cache_clear(pc);
+		return;
+		}
+
+	page_cache_account(pc, document_size);
+	page_cache_trim(pc);
+}
+
+gint page_cache_get_page_total(PageCache *pc)
+{
+	return pc->page_total;
+}
+
+/**
+ * @brief Returns a new reference to the rendered page, or NULL
+ *
+ * If the page is being rendered in the background, waits for it.
+ */
+GdkPixbuf *page_cache_lookup(PageCache *pc, gint page_num)
+{
+	GList *work;
+
+	while (pc->rendering && pc->rendering_page == page_num)
+		{
+		g_cond_wait(&pc->rendered, &pc->lock);
+		}
+
+	work = pc->pages;
+	while (work)
+		{
+		PageCacheEntry *pe = work->data;
+
+		if (pe->page_num == page_num)
+			{
+			pc->pages = g_list_remove_link(pc->pages, work);
+			pc->pages = g_list_concat(work, pc->pages);
+			page_cache_account(pc, 0);
+			return g_object_ref(pe->pixbuf);
+			}
+		work = work->next;
+		}
+
+	return NULL;
+}
+
+void page_cache_insert(PageCache *pc, gint page_num, GdkPixbuf *pixbuf)
+{
+	PageCacheEntry *pe;
+	GList *last;
+	GdkPixbuf *old;
+	gssize delta;
+
+	if (pc->released || !pixbuf) return;
+
+	old = page_cache_lookup(pc, page_num);
+	if (old)
+		{
+		g_object_unref(old);
+		return;
+		}
+
+	pe = g_new0(PageCacheEntry, 1);
+	pe->page_num = page_num;
+	pe->pixbuf = g_object_ref(pixbuf);
+	pc->pages = g_list_prepend(pc->pages, pe);
+	delta = page_cache_entry_size(pe);
+
+	if (g_list_length(pc->pages) > PAGE_CACHE_MAX_PAGES)
+		{
+		last = g_list_last(pc->pages);
+		delta -= page_cache_entry_size(last->data);
+		page_cache_entry_free(last->data);
+		pc->pages = g_list_delete_link(pc->pages, last);
+		}
+
+	page_cache_account(pc, delta);
+	page_cache_trim(pc);
+}
+
+/*
+ *-------------------------------------------------------------------
+ * background rendering
+ *-------------------------------------------------------------------
+ */
+
+static gboolean page_cache_has_page(PageCache *pc, gint page_num)
+{
+	GList *work;
+
+	for (work = pc->pages; work; work = work->next)
+		{
+		PageCacheEntry *pe = work->data;
+		if (pe->page_num == page_num) return TRUE;
+		}
+
+	return FALSE;
+}
+
+static void page_cache_prerender_cb(gpointer data, gpointer user_data)
+{
+	PageCacheJob *job = data;
+	PageCache *pc = job->pc;
+
+	g_mutex_lock(&pc->lock);
+	if (!pc->released && !pc->rendering && pc->document && pc->render &&
+	    job->page_num >= 0 && job->page_num < pc->page_total &&
+	    !page_cache_has_page(pc, job->page_num))
+		{
+		gpointer document = pc->document;
+		PageCacheRenderFunc render = pc->render;
+		GdkPixbuf *pixbuf;
+
+		/* render without the lock, so that loaders of cached pages do not wait */
+		pc->rendering = TRUE;
+		pc->rendering_page = job->page_num;
+		g_mutex_unlock(&pc->lock);
+
+		DEBUG_1("page cache: rendering page %d ahead", job->page_num + 1);
+		pixbuf = render(document, job->page_num);
+
+		g_mutex_lock(&pc->lock);
+		pc->rendering = FALSE;
+		if (pc->stale_document)
+			{
+			/* the cache was emptied meanwhile, the page is not wanted either */
+			pc->stale_document_free(pc->stale_document);
+			pc->stale_document = NULL;
+			pc->stale_document_free = NULL;
+			}
+		else if (pixbuf)
+			{
+			page_cache_insert(pc, job->page_num, pixbuf);
+			}
+		if (pixbuf) g_object_unref(pixbuf);
+		g_cond_broadcast(&pc->rendered);
+		}
+	g_mutex_unlock(&pc->lock);
+
+	page_cache_unref(pc);
+	g_free(job);
+}
+
+static void page_cache_prerender_page(PageCache *pc, gint page_num)
+{
+	PageCacheJob *job;
+
+	if (page_num < 0 || page_num >= pc->page_total) return;
+	if (page_cache_has_page(pc, page_num)) return;
+
+	job = g_new0(PageCacheJob, 1);
+	job->pc = pc;
+	job->page_num = page_num;
+	g_atomic_int_inc(&pc->refcount);
+
+	g_thread_pool_push(page_cache_pool, job, NULL);
+}
+
+/**
+ * @brief Queues rendering of the pages next to page_num
+ *
+ * Must be called with the lock held, the pages are rendered in a
+ * background thread once it is released.
+ */
+void page_cache_prerender(PageCache *pc, gint page_num)
+{
+	if (pc->released || !pc->render) return;
+
+	g_mutex_lock(&page_cache_pool_lock);
+	if (!page_cache_pool)
+		{
+		page_cache_pool = g_thread_pool_new(page_cache_prerender_cb, NULL, 1, FALSE, NULL);
+		}
+	g_mutex_unlock(&page_cache_pool_lock);
+
+	page_cache_prerender_page(pc, page_num + 1);
+	page_cache_prerender_page(pc, page_num - 1);
+}
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+/* number of rendered pages kept per document */
+#define PAGE_CACHE_MAX_PAGES 5
+/* memory of the documents and pages of all caches together */
+#define PAGE_CACHE_MAX_SIZE (128 * 1024 * 1024)
+
+typedef GdkPixbuf *(*PageCacheRenderFunc)(gpointer document, gint page_num);
+
+PageCache *page_cache_ref(FileData *fd);
+void page_cache_unref(PageCache *pc);
+void page_cache_release(FileData *fd);
+
+void page_cache_lock(PageCache *pc);
+void page_cache_unlock(PageCache *pc);
+
+gpointer page_cache_get_document(PageCache *pc);
+gboolean page_cache_get_busy(PageCache *pc);
+void page_cache_set_document(PageCache *pc, gpointer document, gsize document_size, gint page_total,
+			     PageCacheRenderFunc render_func, GDestroyNotify free_func);
+gint page_cache_get_page_total(PageCache *pc);
+
+GdkPixbuf *page_cache_lookup(PageCache *pc, gint page_num);
+void page_cache_insert(PageCache *pc, gint page_num, GdkPixbuf *pixbuf);
+
+void page_cache_prerender(PageCache *pc, gint page_num);
+
+#endif
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
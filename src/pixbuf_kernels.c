@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Pixel loops shared by pixbuf_util.c and renderer-tiles.c.
+ *
+ * Every operation has a plain C version for 3 and 4 bytes per pixel.
+ * On x86 the 4 bytes per pixel case also has an SSE2 version, selected
+ * at run time, that must give the same bytes as the plain one
+ * (geeqie-bench checks this).
+ */
+
+#include "main.h"
+#include "pixbuf_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXBUF_KERNELS_SSE2
+#include <emmintrin.h>
+#define SSE2_FUNC __attribute__((target("sse2")))
+#endif
+
+/* rotation works on square blocks of this many pixels, so that the
+ * rows of both source and destination stay in the cache */
+#define PIXBUF_KERNEL_BLOCK 32
+
+typedef struct _PixbufKernels PixbufKernels;
+struct _PixbufKernels
+{
+	const gchar *name;
+	gboolean (*supported)(void);
+
+	/* 4 bytes per pixel only, 3 bytes per pixel always uses the plain versions */
+	void (*rotate_90)(const guchar *src, gint srs, guchar *dest, gint drs,
+			  gint w, gint h, gboolean counter_clockwise);
+	void (*mirror_row)(const guchar *src, guchar *dest, gint w);
+	void (*desaturate_row)(guchar *p, gint w);
+	void (*highlight_row)(guchar *p, gint w);
+	void (*ignore_alpha_row)(guchar *p, gint w);
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ * plain C
+ *-----------------------------------------------------------------------------
+ */
+
+/* copies the source rows i0..i1 and columns j0..j1 of a w x h rotation */
+static inline void pk_rotate_rect(const guchar *src, gint srs, guchar *dest, gint drs,
+				  gint w, gint h, gint bpp, gboolean counter_clockwise,
+				  gint i0, gint i1, gint j0, gint j1)
+{
+	gint i, j;
+
+	for (i = i0; i < i1; i++)
+		{
+		const guchar *sp = src + i * srs + j0 * bpp;
+		guchar *dp;
+		gint step;
+
+		if (counter_clockwise)
+			{
+			dp = dest + (w - 1 - j0) * drs + i * bpp;
+			step = -drs;
+			}
+		else
+			{
+			dp = dest + j0 * drs + (h - 1 - i) * bpp;
+			step = drs;
+			}
+
+		if (bpp == 4)
+			{
+			for (j = j0; j < j1; j++)
+				{
+				memcpy(dp, sp, 4);
+				sp += 4;
+				dp += step;
+				}
+			}
+		else
+			{
+			for (j = j0; j < j1; j++)
+				{
+				dp[0] = sp[0];
+				dp[1] = sp[1];
+				dp[2] = sp[2];
+				sp += 3;
+				dp += step;
+				}
+			}
+		}
+}
+
+static void pk_rotate_90_generic(const guchar *src, gint srs, guchar *dest, gint drs,
+				 gint w, gint h, gint bpp, gboolean counter_clockwise)
+{
+	gint bi, bj;
+
+	for (bi = 0; bi < h; bi += PIXBUF_KERNEL_BLOCK)
+		{
+		for (bj = 0; bj < w; bj += PIXBUF_KERNEL_BLOCK)
+			{
+			pk_rotate_rect(src, srs, dest, drs, w, h, bpp, counter_clockwise,
+				       bi, MIN(bi + PIXBUF_KERNEL_BLOCK, h),
+				       bj, MIN(bj + PIXBUF_KERNEL_BLOCK, w));
+			}
+		}
+}
+
+static void pk_rotate_90_4_generic(const guchar *src, gint srs, guchar *dest, gint drs,
+				   gint w, gint h, gboolean counter_clockwise)
+{
+	pk_rotate_90_generic(src, srs, dest, drs, w, h, 4, counter_clockwise);
+}
+
+static void pk_mirror_row_generic(const guchar *src, guchar *dest, gint w, gint bpp)
+{
+	guchar *dp = dest + (w - 1) * bpp;
+	gint j;
+
+	for (j = 0; j < w; j++)
+		{
+		dp[0] = src[0];
+		dp[1] = src[1];
+		dp[2] = src[2];
+		if (bpp == 4) dp[3] = src[3];
+		src += bpp;
+		dp -= bpp;
+		}
+}
+
+static void pk_mirror_row_4_generic(const guchar *src, guchar *dest, gint w)
+{
+	pk_mirror_row_generic(src, dest, w, 4);
+}
+
+static void pk_desaturate_row_generic(guchar *p, gint w, gint bpp)
+{
+	gint j;
+
+	for (j = 0; j < w; j++)
+		{
+		guint8 grey = (p[0] + p[1] + p[2]) / 3;
+
+		p[0] = grey;
+		p[1] = grey;
+		p[2] = grey;
+		p += bpp;
+		}
+}
+
+static void pk_desaturate_row_4_generic(guchar *p, gint w)
+{
+	pk_desaturate_row_generic(p, w, 4);
+}
+
+static void pk_highlight_row_generic(guchar *p, gint w, gint bpp)
+{
+	gint j;
+
+	for (j = 0; j < w; j++)
+		{
+		if (p[0] == 255 || p[1] == 255 || p[2] == 255 || p[0] == 0 || p[1] == 0 || p[2] == 0)
+			{
+			p[0] = 255;
+			p[1] = 0;
+			p[2] = 0;
+			}
+		p += bpp;
+		}
+}
+
+static void pk_highlight_row_4_generic(guchar *p, gint w)
+{
+	pk_highlight_row_generic(p, w, 4);
+}
+
+static void pk_ignore_alpha_row_generic(guchar *p, gint w)
+{
+	gint j;
+
+	for (j = 0; j < w; j++)
+		{
+		p[3] = 0xff;
+		p += 4;
+		}
+}
+
+static gboolean pk_generic_supported(void)
+{
+	return TRUE;
+}
+
+static const PixbufKernels pixbuf_kernels_generic = {
+	"generic",
+	pk_generic_supported,
+	pk_rotate_90_4_generic,
+	pk_mirror_row_4_generic,
+	pk_desaturate_row_4_generic,
+	pk_highlight_row_4_generic,
+	pk_ignore_alpha_row_generic
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ * SSE2, 4 bytes per pixel handled as one 32 bit lane each
+ *-----------------------------------------------------------------------------
+ */
+
+#ifdef PIXBUF_KERNELS_SSE2
+
+static SSE2_FUNC void pk_rotate_90_4_sse2(const guchar *src, gint srs, guchar *dest, gint drs,
+					  gint w, gint h, gboolean counter_clockwise)
+{
+	gint bi, bj;
+
+	for (bi = 0; bi < h; bi += PIXBUF_KERNEL_BLOCK)
+		{
+		gint i1 = MIN(bi + PIXBUF_KERNEL_BLOCK, h);
+		gint i4 = bi + ((i1 - bi) & ~3);
+
+		for (bj = 0; bj < w; bj += PIXBUF_KERNEL_BLOCK)
+			{
+			gint j1 = MIN(bj + PIXBUF_KERNEL_BLOCK, w);
+			gint j4 = bj + ((j1 - bj) & ~3);
+			gint i, j;
+
+			for (i = bi; i < i4; i += 4)
+				{
+				const guchar *sp = src + i * srs;
+
+				for (j = bj; j < j4; j += 4)
+					{
+					__m128i r0, r1, r2, r3;
+					__m128i t0, t1, t2, t3;
+
+					/* transpose 4x4 pixels, row n of the result is source column j + n */
+					r0 = _mm_loadu_si128((const __m128i *)(sp + j * 4));
+					r1 = _mm_loadu_si128((const __m128i *)(sp + srs + j * 4));
+					r2 = _mm_loadu_si128((const __m128i *)(sp + 2 * srs + j * 4));
+					r3 = _mm_loadu_si128((const __m128i *)(sp + 3 * srs + j * 4));
+
+					t0 = _mm_unpacklo_epi32(r0, r1);
+					t1 = _mm_unpacklo_epi32(r2, r3);
+					t2 = _mm_unpackhi_epi32(r0, r1);
+					t3 = _mm_unpackhi_epi32(r2, r3);
+
+					r0 = _mm_unpacklo_epi64(t0, t1);
+					r1 = _mm_unpackhi_epi64(t0, t1);
+					r2 = _mm_unpacklo_epi64(t2, t3);
+					r3 = _mm_unpackhi_epi64(t2, t3);
+
+					if (counter_clockwise)
+						{
+						guchar *dp = dest + (w - 1 - j) * drs + i * 4;
+
+						_mm_storeu_si128((__m128i *)dp, r0);
+						_mm_storeu_si128((__m128i *)(dp - drs), r1);
+						_mm_storeu_si128((__m128i *)(dp - 2 * drs), r2);
+						_mm_storeu_si128((__m128i *)(dp - 3 * drs), r3);
+						}
+					else
+						{
+						guchar *dp = dest + j * drs + (h - 4 - i) * 4;
+
+						_mm_storeu_si128((__m128i *)dp, _mm_shuffle_epi32(r0, _MM_SHUFFLE(0, 1, 2, 3)));
+						_mm_storeu_si128((__m128i *)(dp + drs), _mm_shuffle_epi32(r1, _MM_SHUFFLE(0, 1, 2, 3)));
+						_mm_storeu_si128((__m128i *)(dp + 2 * drs), _mm_shuffle_epi32(r2, _MM_SHUFFLE(0, 1, 2, 3)));
+						_mm_storeu_si128((__m128i *)(dp + 3 * drs), _mm_shuffle_epi32(r3, _MM_SHUFFLE(0, 1, 2, 3)));
+						}
+					}
+				}
+
+			/* edges of the block that do not fill 4x4 pixels */
+			pk_rotate_rect(src, srs, dest, drs, w, h, 4, counter_clockwise, bi, i4, j4, j1);
+			pk_rotate_rect(src, srs, dest, drs, w, h, 4, counter_clockwise, i4, i1, bj, j1);
+			}
+		}
+}
+
+static SSE2_FUNC void pk_mirror_row_4_sse2(const guchar *src, guchar *dest, gint w)
+{
+	gint j = 0;
+
+	for (; j + 4 <= w; j += 4)
+		{
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + j * 4));
+
+		_mm_storeu_si128((__m128i *)(dest + (w - 4 - j) * 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+		}
+
+	if (j < w) pk_mirror_row_generic(src + j * 4, dest, w - j, 4);
+}
+
+static SSE2_FUNC void pk_desaturate_row_4_sse2(guchar *p, gint w)
+{
+	const __m128i byte_mask = _mm_set1_epi32(0xff);
+	const __m128i alpha_mask = _mm_set1_epi32((gint)0xff000000);
+	/* (sum * 43691) >> 17 equals sum / 3 for all sums of three bytes */
+	const __m128i third = _mm_set1_epi32(43691);
+	gint j = 0;
+
+	for (; j + 4 <= w; j += 4)
+		{
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + j * 4));
+		__m128i sum;
+		__m128i grey;
+
+		sum = _mm_add_epi32(_mm_and_si128(v, byte_mask),
+				    _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(v, 8), byte_mask),
+						  _mm_and_si128(_mm_srli_epi32(v, 16), byte_mask)));
+		grey = _mm_srli_epi32(_mm_mulhi_epu16(sum, third), 1);
+		grey = _mm_or_si128(grey, _mm_or_si128(_mm_slli_epi32(grey, 8), _mm_slli_epi32(grey, 16)));
+
+		_mm_storeu_si128((__m128i *)(p + j * 4), _mm_or_si128(grey, _mm_and_si128(v, alpha_mask)));
+		}
+
+	if (j < w) pk_desaturate_row_generic(p + j * 4, w - j, 4);
+}
+
+static SSE2_FUNC void pk_highlight_row_4_sse2(guchar *p, gint w)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi8((gchar)0xff);
+	const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+	const __m128i alpha_mask = _mm_set1_epi32((gint)0xff000000);
+	const __m128i red = _mm_set1_epi32(0x000000ff);
+	gint j = 0;
+
+	for (; j + 4 <= w; j += 4)
+		{
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + j * 4));
+		__m128i clipped;
+		__m128i keep;
+
+		clipped = _mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(v, zero), _mm_cmpeq_epi8(v, full)), rgb_mask);
+		keep = _mm_cmpeq_epi32(clipped, zero);
+
+		v = _mm_or_si128(_mm_and_si128(keep, v),
+				 _mm_andnot_si128(keep, _mm_or_si128(red, _mm_and_si128(v, alpha_mask))));
+		_mm_storeu_si128((__m128i *)(p + j * 4), v);
+		}
+
+	if (j < w) pk_highlight_row_generic(p + j * 4, w - j, 4);
+}
+
+static SSE2_FUNC void pk_ignore_alpha_row_sse2(guchar *p, gint w)
+{
+	const __m128i alpha_mask = _mm_set1_epi32((gint)0xff000000);
+	gint j = 0;
+
+	for (; j + 4 <= w; j += 4)
+		{
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + j * 4));
+
+		_mm_storeu_si128((__m128i *)(p + j * 4), _mm_or_si128(v, alpha_mask));
+		}
+
+	if (j < w) pk_ignore_alpha_row_generic(p + j * 4, w - j);
+}
+
+static gboolean pk_sse2_supported(void)
+{
+	return __builtin_cpu_supports("sse2");
+}
+
+static const PixbufKernels pixbuf_kernels_sse2 = {
+	"sse2",
+	pk_sse2_supported,
+	pk_rotate_90_4_sse2,
+	pk_mirror_row_4_sse2,
+	pk_desaturate_row_4_sse2,
+	pk_highlight_row_4_sse2,
+	pk_ignore_alpha_row_sse2
+};
+
+#endif
+
+/*
+ *-----------------------------------------------------------------------------
+ * dispatch
+ *-----------------------------------------------------------------------------
+ */
+
+/* best first */
+static const PixbufKernels *pixbuf_kernels_list[] = {
+#ifdef PIXBUF_KERNELS_SSE2
+	&pixbuf_kernels_sse2,
+#endif
+	&pixbuf_kernels_generic,
+	NULL
+};
+
+static const PixbufKernels *pixbuf_kernels = NULL;
+
+static const PixbufKernels *pixbuf_kernels_get(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized))
+		{
+		gint i;
+
+		for (i = 0; pixbuf_kernels_list[i]; i++)
+			{
+			if (pixbuf_kernels_list[i]->supported()) break;
+			}
+		pixbuf_kernels = pixbuf_kernels_list[i];
+		DEBUG_1("pixbuf kernels: %s", pixbuf_kernels->name);
+
+		g_once_init_leave(&initialized, 1);
+		}
+
+	return pixbuf_kernels;
+}
+
+const gchar *pixbuf_kernels_get_name(void)
+{
+	return pixbuf_kernels_get()->name;
+}
+
+/**
+ * @brief Selects the kernels called \a name, or the best supported ones for NULL
+ *
+ * Meant for comparing the versions, must be called before the kernels are in use
+ * by other threads. Returns FALSE if \a name is unknown or not supported here.
+ */
+gboolean pixbuf_kernels_select(const gchar *name)
+{
+	gint i;
+
+	pixbuf_kernels_get();
+
+	for (i = 0; pixbuf_kernels_list[i]; i++)
+		{
+		const PixbufKernels *pk = pixbuf_kernels_list[i];
+
+		if ((!name || strcmp(pk->name, name) == 0) && pk->supported())
+			{
+			pixbuf_kernels = pk;
+			return TRUE;
+			}
+		}
+
+	return FALSE;
+}
+
+/**
+ * @brief Copies the \a w x \a h pixels at \a src rotated by 90 degrees to \a dest
+ *
+ * \a dest receives \a h x \a w pixels, source and destination must not overlap.
+ */
+void pixbuf_kernel_rotate_90(const guchar *src, gint src_row_stride,
+			     guchar *dest, gint dest_row_stride,
+			     gint w, gint h, gint bytes_per_pixel, gboolean counter_clockwise)
+{
+	if (bytes_per_pixel == 4)
+		{
+		pixbuf_kernels_get()->rotate_90(src, src_row_stride, dest, dest_row_stride, w, h, counter_clockwise);
+		}
+	else
+		{
+		pk_rotate_90_generic(src, src_row_stride, dest, dest_row_stride, w, h, bytes_per_pixel, counter_clockwise);
+		}
+}
+
+/**
+ * @brief Copies \a w pixels from \a src to \a dest in reverse order
+ */
+void pixbuf_kernel_mirror_row(const guchar *src, guchar *dest, gint w, gint bytes_per_pixel)
+{
+	if (bytes_per_pixel == 4)
+		{
+		pixbuf_kernels_get()->mirror_row(src, dest, w);
+		}
+	else
+		{
+		pk_mirror_row_generic(src, dest, w, bytes_per_pixel);
+		}
+}
+
+void pixbuf_kernel_desaturate_row(guchar *p, gint w, gint bytes_per_pixel)
+{
+	if (bytes_per_pixel == 4)
+		{
+		pixbuf_kernels_get()->desaturate_row(p, w);
+		}
+	else
+		{
+		pk_desaturate_row_generic(p, w, bytes_per_pixel);
+		}
+}
+
+/**
+ * @brief Paints pixels with a channel at 0 or 255 red, the alpha channel is kept
+ */
+void pixbuf_kernel_highlight_row(guchar *p, gint w, gint bytes_per_pixel)
+{
+	if (bytes_per_pixel == 4)
+		{
+		pixbuf_kernels_get()->highlight_row(p, w);
+		}
+	else
+		{
+		pk_highlight_row_generic(p, w, bytes_per_pixel);
+		}
+}
+
+/**
+ * @brief Sets the alpha of \a w pixels with 4 bytes each to opaque
+ */
+void pixbuf_kernel_ignore_alpha_row(guchar *p, gint w)
+{
+	pixbuf_kernels_get()->ignore_alpha_row(p, w);
+}
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef PIXBUF_KERNELS_H
+#define PIXBUF_KERNELS_H
+
+void pixbuf_kernel_rotate_90(const guchar *src, gint src_row_stride,
+			     guchar *dest, gint dest_row_stride,
+			     gint w, gint h, gint bytes_per_pixel, gboolean counter_clockwise);
+void pixbuf_kernel_mirror_row(const guchar *src, guchar *dest, gint w, gint bytes_per_pixel);
+void pixbuf_kernel_desaturate_row(guchar *p, gint w, gint bytes_per_pixel);
+void pixbuf_kernel_highlight_row(guchar *p, gint w, gint bytes_per_pixel);
+void pixbuf_kernel_ignore_alpha_row(guchar *p, gint w);
+
+const gchar *pixbuf_kernels_get_name(void);
+gboolean pixbuf_kernels_select(const gchar *name);
+
+#endif
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
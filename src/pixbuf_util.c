@@ -22,6 +22,7 @@
 #include "main.h"
 #include "pixbuf_util.h"
 #include "exif.h"
+#include "pixbuf_kernels.h"
 #include "ui_fileops.h"
 
 #include "icons/icons_inline.h"
@@ -361,54 +362,6 @@ gboolean util_clip_region(gint x, gint y, gint w, gint h,
  *-----------------------------------------------------------------------------
  */
 
-static void pixbuf_copy_block_rotate(guchar *src, gint src_row_stride, gint x, gint y,
-				     guchar *dest, gint dest_row_stride, gint w, gint h,
-				     gint bytes_per_pixel, gboolean counter_clockwise)
-{
-	gint i, j;
-	guchar *sp;
-	guchar *dp;
-
-	for (i = 0; i < h; i++)
-		{
-		sp = src + ((i + y) * src_row_stride) + (x * bytes_per_pixel);
-		for (j = 0; j < w; j++)
-			{
-			if (counter_clockwise)
-				{
-				dp = dest + ((w - j - 1) * dest_row_stride) + (i * bytes_per_pixel);
-				}
-			else
-				{
-				dp = dest + (j * dest_row_stride) + ((h - i - 1) * bytes_per_pixel);
-				}
-			*(dp++) = *(sp++);	/* r */
-			*(dp++) = *(sp++);	/* g */
-			*(dp++) = *(sp++);	/* b */
-			if (bytes_per_pixel == 4) *(dp) = *(sp++);	/* a */
-			}
-		}
-
-}
-
-static void pixbuf_copy_block(guchar *src, gint src_row_stride, gint w, gint h,
-			      guchar *dest, gint dest_row_stride, gint x, gint y, gint bytes_per_pixel)
-{
-	gint i;
-	guchar *sp;
-	guchar *dp;
-
-	for (i = 0; i < h; i++)
-		{
-		sp = src + (i * src_row_stride);
-		dp = dest + ((y + i) * dest_row_stride) + (x * bytes_per_pixel);
-		memcpy(dp, sp, w * bytes_per_pixel);
-		}
-}
-
-#define ROTATE_BUFFER_WIDTH 48
-#define ROTATE_BUFFER_HEIGHT 48
-
 /*
  * Returns a copy of pixbuf src rotated 90 degrees clockwise or 90 counterclockwise
  *
@@ -421,12 +374,7 @@ GdkPixbuf *pixbuf_copy_rotate_90(GdkPixbuf *src, gboolean counter_clockwise)
 	gint dw, dh, drs;
 	guchar *s_pix;
 	guchar *d_pix;
-	gint i, j;
 	gint a;
-	GdkPixbuf *buffer;
-	guchar *b_pix;
-	gint brs;
-	gint w, h;
 
 	if (!src) return NULL;
 
@@ -444,64 +392,8 @@ GdkPixbuf *pixbuf_copy_rotate_90(GdkPixbuf *src, gboolean counter_clockwise)
 
 	a = (has_alpha ? 4 : 3);
 
-	buffer = gdk_pixbuf_new(GDK_COLORSPACE_RGB, has_alpha, 8,
-				ROTATE_BUFFER_WIDTH, ROTATE_BUFFER_HEIGHT);
-	b_pix = gdk_pixbuf_get_pixels(buffer);
-	brs = gdk_pixbuf_get_rowstride(buffer);
-
-	for (i = 0; i < sh; i+= ROTATE_BUFFER_WIDTH)
-		{
-		w = MIN(ROTATE_BUFFER_WIDTH, (sh - i));
-		for (j = 0; j < sw; j += ROTATE_BUFFER_HEIGHT)
-			{
-			gint x, y;
-
-			h = MIN(ROTATE_BUFFER_HEIGHT, (sw - j));
-			pixbuf_copy_block_rotate(s_pix, srs, j, i,
-						 b_pix, brs, h, w,
-						 a, counter_clockwise);
-
-			if (counter_clockwise)
-				{
-				x = i;
-				y = sw - h - j;
-				}
-			else
-				{
-				x = sh - w - i;
-				y = j;
-				}
-			pixbuf_copy_block(b_pix, brs, w, h,
-					  d_pix, drs, x, y, a);
-			}
-		}
-
-	g_object_unref(buffer);
-
-#if 0
-	/* this is the simple version of rotation (roughly 2-4x slower) */
-
-	for (i = 0; i < sh; i++)
-		{
-		sp = s_pix + (i * srs);
-		for (j = 0; j < sw; j++)
-			{
-			if (counter_clockwise)
-				{
-				dp = d_pix + ((dh - j - 1) * drs) + (i * a);
-				}
-			else
-				{
-				dp = d_pix + (j * drs) + ((dw - i - 1) * a);
-				}
-
-			*(dp++) = *(sp++);	/* r */
-			*(dp++) = *(sp++);	/* g */
-			*(dp++) = *(sp++);	/* b */
-			if (has_alpha) *(dp) = *(sp++);	/* a */
-			}
-		}
-#endif
+	/* works in cache sized blocks, see pixbuf_kernels.c */
+	pixbuf_kernel_rotate_90(s_pix, srs, d_pix, drs, sw, sh, a, counter_clockwise);
 
 	return dest;
 }
@@ -521,7 +413,7 @@ GdkPixbuf *pixbuf_copy_mirror(GdkPixbuf *src, gboolean mirror, gboolean flip)
 	guchar *d_pix;
 	guchar *sp;
 	guchar *dp;
-	gint i, j;
+	gint i;
 	gint a;
 
 	if (!src) return NULL;
@@ -551,25 +443,11 @@ GdkPixbuf *pixbuf_copy_mirror(GdkPixbuf *src, gboolean mirror, gboolean flip)
 			}
 		if (mirror)
 			{
-			dp += (w - 1) * a;
-			for (j = 0; j < w; j++)
-				{
-				*(dp++) = *(sp++);	/* r */
-				*(dp++) = *(sp++);	/* g */
-				*(dp++) = *(sp++);	/* b */
-				if (has_alpha) *(dp) = *(sp++);	/* a */
-				dp -= (a + 3);
-				}
+			pixbuf_kernel_mirror_row(sp, dp, w, a);
 			}
 		else
 			{
-			for (j = 0; j < w; j++)
-				{
-				*(dp++) = *(sp++);	/* r */
-				*(dp++) = *(sp++);	/* g */
-				*(dp++) = *(sp++);	/* b */
-				if (has_alpha) *(dp++) = *(sp++);	/* a */
-				}
+			memcpy(dp, sp, w * a);
 			}
 		}
 
@@ -1429,7 +1307,7 @@ void pixbuf_desaturate_rect(GdkPixbuf *pb,
 	gint pw, ph, prs;
 	guchar *p_pix;
 	guchar *pp;
-	gint i, j;
+	gint i;
 
 	if (!pb) return;
 
@@ -1446,19 +1324,7 @@ void pixbuf_desaturate_rect(GdkPixbuf *pb,
 	for (i = 0; i < h; i++)
 		{
 		pp = p_pix + (y + i) * prs + (x * (has_alpha ? 4 : 3));
-		for (j = 0; j < w; j++)
-			{
-			guint8 grey;
-
-			grey = (pp[0] + pp[1] + pp[2]) / 3;
-			*pp = grey;
-			pp++;
-			*pp = grey;
-			pp++;
-			*pp = grey;
-			pp++;
-			if (has_alpha) pp++;
-			}
+		pixbuf_kernel_desaturate_row(pp, w, has_alpha ? 4 : 3);
 		}
 }
 
@@ -1472,7 +1338,7 @@ void pixbuf_highlight_overunderexposed(GdkPixbuf *pb, gint x, gint y, gint w, gi
 	gint pw, ph, prs;
 	guchar *p_pix;
 	guchar *pp;
-	gint i, j;
+	gint i;
 
 	if (!pb) return;
 
@@ -1489,24 +1355,7 @@ void pixbuf_highlight_overunderexposed(GdkPixbuf *pb, gint x, gint y, gint w, gi
 	for (i = 0; i < h; i++)
 		{
 		pp = p_pix + (y + i) * prs + (x * (has_alpha ? 4 : 3));
-		for (j = 0; j < w; j++)
-			{
-			if (pp[0] == 255 || pp[1] == 255 || pp[2] == 255 || pp[0] == 0 || pp[1] == 0 || pp[2] == 0)
-				{
-				*pp = 255;
-				pp++;
-				*pp = 0;
-				pp++;
-				*pp = 0;
-				pp++;
-				if (has_alpha) pp++;
-				}
-			else
-				{
-				pp = pp + 3;
-				if (has_alpha) pp++;
-				}
-			}
+		pixbuf_kernel_highlight_row(pp, w, has_alpha ? 4 : 3);
 		}
 }
 
@@ -1522,7 +1371,7 @@ void pixbuf_ignore_alpha_rect(GdkPixbuf *pb,
    gint pw, ph, prs;
    guchar *p_pix;
    guchar *pp;
-   gint i, j;
+   gint i;
 
    if (!pb) return;
 
@@ -1541,11 +1390,191 @@ void pixbuf_ignore_alpha_rect(GdkPixbuf *pb,
    for (i = 0; i < h; i++)
        {
        pp = p_pix + (y + i) * prs + (x * 4 );
-       for (j = 0; j < w; j++)
-           {
-           pp[3] = 0xff;
-           pp+=4;
-           }
+       pixbuf_kernel_ignore_alpha_row(pp, w);
        }
 }
+
+/*
+ *-----------------------------------------------------------------------------
+ * reduced resolution levels (mipmaps)
+ *-----------------------------------------------------------------------------
+ */
+
+/* Large pixbufs get a chain of half-size copies, built in a background
+ * thread and attached to the pixbuf, so that zoomed out views scale from
+ * a nearby level instead of the full image. The levels are attached from
+ * the main loop only, the renderer reads them without locking. */
+
+#define PIXBUF_PYRAMID_KEY "geeqie-pyramid"
+#define PIXBUF_PYRAMID_PENDING_KEY "geeqie-pyramid-pending"
+#define PIXBUF_PYRAMID_MAX_SCALE_KEY "geeqie-pyramid-max-scale"
+
+/* half-size levels are only used below this scale, where they are not
+ * enlarged again */
+#define PIXBUF_PYRAMID_MAX_SCALE 0.5
+
+typedef struct _PixbufPyramidJob PixbufPyramidJob;
+struct _PixbufPyramidJob {
+	GdkPixbuf *pixbuf;
+	GPtrArray *levels;
+};
+
+static GThreadPool *pixbuf_pyramid_pool = NULL;
+
+static gboolean pixbuf_pyramid_wanted(GdkPixbuf *pixbuf)
+{
+	return (MAX(gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf)) >= PIXBUF_PYRAMID_MIN_SIZE * 4);
+}
+
+static gboolean pixbuf_pyramid_attach_cb(gpointer data)
+{
+	PixbufPyramidJob *job = data;
+
+	g_object_set_data(G_OBJECT(job->pixbuf), PIXBUF_PYRAMID_PENDING_KEY, NULL);
+	if (job->levels->len > 0)
+		{
+		g_object_set_data_full(G_OBJECT(job->pixbuf), PIXBUF_PYRAMID_KEY, job->levels, (GDestroyNotify)g_ptr_array_unref);
+		}
+	else
+		{
+		g_ptr_array_unref(job->levels);
+		}
+
+	g_object_unref(job->pixbuf);
+	g_free(job);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void pixbuf_pyramid_build_cb(gpointer data, gpointer user_data)
+{
+	PixbufPyramidJob *job = data;
+	GdkPixbuf *src = job->pixbuf;
+	gint w = gdk_pixbuf_get_width(src);
+	gint h = gdk_pixbuf_get_height(src);
+
+	while (MAX(w, h) / 2 >= PIXBUF_PYRAMID_MIN_SIZE)
+		{
+		GdkPixbuf *level;
+
+		w = MAX(w / 2, 1);
+		h = MAX(h / 2, 1);
+
+		/* bilinear is a box filter when halving */
+		level = gdk_pixbuf_scale_simple(src, w, h, GDK_INTERP_BILINEAR);
+		if (!level) break;
+
+		g_ptr_array_add(job->levels, level);
+		src = level;
+		}
+
+	DEBUG_1("%s pyramid with %d levels built", get_exec_time(), job->levels->len);
+	g_idle_add(pixbuf_pyramid_attach_cb, job);
+}
+
+/**
+ * @brief Starts building the reduced levels of a large pixbuf
+ *
+ * The pixbuf must not be changed afterwards. Does nothing for small
+ * pixbufs or when the levels exist or are being built.
+ */
+void pixbuf_pyramid_build(GdkPixbuf *pixbuf)
+{
+	PixbufPyramidJob *job;
+
+	if (!pixbuf || !pixbuf_pyramid_wanted(pixbuf)) return;
+	if (g_object_get_data(G_OBJECT(pixbuf), PIXBUF_PYRAMID_KEY) ||
+	    g_object_get_data(G_OBJECT(pixbuf), PIXBUF_PYRAMID_PENDING_KEY)) return;
+
+	if (!pixbuf_pyramid_pool)
+		{
+		pixbuf_pyramid_pool = g_thread_pool_new(pixbuf_pyramid_build_cb, NULL, 1, FALSE, NULL);
+		}
+
+	g_object_set_data(G_OBJECT(pixbuf), PIXBUF_PYRAMID_PENDING_KEY, GINT_TO_POINTER(TRUE));
+
+	job = g_new0(PixbufPyramidJob, 1);
+	job->pixbuf = g_object_ref(pixbuf);
+	job->levels = g_ptr_array_new_with_free_func(g_object_unref);
+
+	g_thread_pool_push(pixbuf_pyramid_pool, job, NULL);
+}
+
+/**
+ * @brief Attaches a single reduced copy, e.g. one scaled to the display size
+ * @param max_scale The level is used for scales below this
+ *
+ * For pixbufs not yet shared with the main loop only, so that it can be
+ * called from a worker thread.
+ */
+void pixbuf_pyramid_attach_level(GdkPixbuf *pixbuf, GdkPixbuf *level, gdouble max_scale)
+{
+	GPtrArray *levels;
+	gdouble *scale;
+
+	levels = g_ptr_array_new_with_free_func(g_object_unref);
+	g_ptr_array_add(levels, g_object_ref(level));
+	g_object_set_data_full(G_OBJECT(pixbuf), PIXBUF_PYRAMID_KEY, levels, (GDestroyNotify)g_ptr_array_unref);
+
+	scale = g_new(gdouble, 1);
+	*scale = max_scale;
+	g_object_set_data_full(G_OBJECT(pixbuf), PIXBUF_PYRAMID_MAX_SCALE_KEY, scale, g_free);
+}
+
+/**
+ * @brief Returns the smallest level that is still at least scale_x, scale_y
+ * times the size of pixbuf, or pixbuf itself
+ *
+ * The scales are updated to apply to the returned pixbuf.
+ */
+GdkPixbuf *pixbuf_pyramid_get_level(GdkPixbuf *pixbuf, gdouble *scale_x, gdouble *scale_y)
+{
+	GPtrArray *levels;
+	GdkPixbuf *best = pixbuf;
+	gdouble *scale;
+	gdouble max_scale = PIXBUF_PYRAMID_MAX_SCALE;
+	gint w, h;
+	guint i;
+
+	if (!pixbuf) return pixbuf;
+
+	levels = g_object_get_data(G_OBJECT(pixbuf), PIXBUF_PYRAMID_KEY);
+	if (!levels) return pixbuf;
+
+	scale = g_object_get_data(G_OBJECT(pixbuf), PIXBUF_PYRAMID_MAX_SCALE_KEY);
+	if (scale) max_scale = *scale;
+	if (*scale_x >= max_scale || *scale_y >= max_scale) return pixbuf;
+
+	w = gdk_pixbuf_get_width(pixbuf);
+	h = gdk_pixbuf_get_height(pixbuf);
+
+	for (i = 0; i < levels->len; i++)
+		{
+		GdkPixbuf *level = g_ptr_array_index(levels, i);
+
+		if (gdk_pixbuf_get_width(level) < w * *scale_x ||
+		    gdk_pixbuf_get_height(level) < h * *scale_y) break;
+
+		best = level;
+		}
+
+	if (best != pixbuf)
+		{
+		*scale_x *= (gdouble)w / gdk_pixbuf_get_width(best);
+		*scale_y *= (gdouble)h / gdk_pixbuf_get_height(best);
+		}
+
+	return best;
+}
+
+/**
+ * @brief Memory that the reduced levels of pixbuf will take
+ */
+gulong pixbuf_pyramid_size(GdkPixbuf *pixbuf)
+{
+	if (!pixbuf || !pixbuf_pyramid_wanted(pixbuf)) return 0;
+
+	/* each level is a quarter of the one above */
+	return (gulong)gdk_pixbuf_get_rowstride(pixbuf) * (gulong)gdk_pixbuf_get_height(pixbuf) / 3;
+}
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
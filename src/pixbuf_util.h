@@ -138,6 +138,15 @@ void pixbuf_highlight_overunderexposed(GdkPixbuf *pb,
 void pixbuf_ignore_alpha_rect(GdkPixbuf *pb,
                  gint x, gint y, gint w, gint h);
 
+/* reduced resolution levels */
+
+#define PIXBUF_PYRAMID_MIN_SIZE 256
+
+void pixbuf_pyramid_build(GdkPixbuf *pixbuf);
+void pixbuf_pyramid_attach_level(GdkPixbuf *pixbuf, GdkPixbuf *level, gdouble max_scale);
+GdkPixbuf *pixbuf_pyramid_get_level(GdkPixbuf *pixbuf, gdouble *scale_x, gdouble *scale_y);
+gulong pixbuf_pyramid_size(GdkPixbuf *pixbuf);
+
 /* clipping utils */
 
 gboolean util_clip_region(gint x, gint y, gint w, gint h,
@@ -300,8 +300,11 @@ static void config_window_apply(void)
 	options->thumbnails.use_exif = c_options->thumbnails.use_exif;
 	options->thumbnails.collection_preview = c_options->thumbnails.collection_preview;
 	options->thumbnails.use_ft_metadata = c_options->thumbnails.use_ft_metadata;
+	options->thumbnails.video_threads = c_options->thumbnails.video_threads;
+	options->thumbnails.video_timeout = c_options->thumbnails.video_timeout;
 // 	options->thumbnails.use_ft_metadata_small = c_options->thumbnails.use_ft_metadata_small;
 	options->thumbnails.spec_standard = c_options->thumbnails.spec_standard;
+	options->thumbnails.cache_manifest = c_options->thumbnails.cache_manifest;
 	options->metadata.enable_metadata_dirs = c_options->metadata.enable_metadata_dirs;
 	options->file_filter.show_hidden_files = c_options->file_filter.show_hidden_files;
 	options->file_filter.show_parent_directory = c_options->file_filter.show_parent_directory;
@@ -318,6 +321,7 @@ static void config_window_apply(void)
 	options->slideshow.random = c_options->slideshow.random;
 	options->slideshow.repeat = c_options->slideshow.repeat;
 	options->slideshow.delay = c_options->slideshow.delay;
+	options->slideshow.decode_ahead = c_options->slideshow.decode_ahead;
 
 	options->mousewheel_scrolls = c_options->mousewheel_scrolls;
 	options->image_lm_click_nav = c_options->image_lm_click_nav;
@@ -334,6 +338,7 @@ static void config_window_apply(void)
 	options->image.zoom_increment = c_options->image.zoom_increment;
 
 	options->image.enable_read_ahead = c_options->image.enable_read_ahead;
+	options->image.loader_threads = c_options->image.loader_threads;
 
 
 	if (options->image.use_custom_border_color != c_options->image.use_custom_border_color
@@ -1950,6 +1955,8 @@ static void config_tab_general(GtkWidget *notebook)
 	pref_radiobutton_new(group_frame, button, get_thumbnails_standard_cache_dir(),
 							options->thumbnails.spec_standard && !options->thumbnails.cache_into_dirs,
 							G_CALLBACK(cache_standard_cb), NULL);
+	pref_checkbox_new_int(group_frame, _("Remember checked thumbnails to speed up cleanup"),
+			      options->thumbnails.cache_manifest, &c_options->thumbnails.cache_manifest);
 
 	pref_checkbox_new_int(group, _("Use EXIF thumbnails when available (EXIF thumbnails may be outdated)"),
 			      options->thumbnails.use_exif, &c_options->thumbnails.use_exif);
@@ -1967,6 +1974,14 @@ static void config_tab_general(GtkWidget *notebook)
 // 			      options->thumbnails.use_ft_metadata_small, &c_options->thumbnails.use_ft_metadata_small);
 #endif
 
+#ifdef HAVE_FFMPEGTHUMBNAILER
+	pref_spin_new_int(group, _("Videos decoded in parallel:"), NULL,
+			  1, 16, 1, options->thumbnails.video_threads, &c_options->thumbnails.video_threads);
+	spin = pref_spin_new_int(group, _("Video frame timeout (seconds):"), NULL,
+				 0, 3600, 1, options->thumbnails.video_timeout, &c_options->thumbnails.video_timeout);
+	gtk_widget_set_tooltip_text(spin, _("Give up on a video if no frame could be extracted in this time, 0 waits forever"));
+#endif
+
 	pref_spacer(group, PREF_PAD_GROUP);
 
 	group = pref_group_new(vbox, FALSE, _("Star Rating"), GTK_ORIENTATION_VERTICAL);
@@ -2069,6 +2084,8 @@ static void config_tab_general(GtkWidget *notebook)
 
 	pref_checkbox_new_int(group, _("Random"), options->slideshow.random, &c_options->slideshow.random);
 	pref_checkbox_new_int(group, _("Repeat"), options->slideshow.repeat, &c_options->slideshow.repeat);
+	pref_spin_new_int(group, _("Images to decode ahead:"), NULL,
+			  0, SLIDESHOW_MAX_DECODE_AHEAD, 1, options->slideshow.decode_ahead, &c_options->slideshow.decode_ahead);
 
 	pref_spacer(group, PREF_PAD_GROUP);
 
@@ -2078,6 +2095,8 @@ static void config_tab_general(GtkWidget *notebook)
 			  0, 99999, 1, options->image.image_cache_max, &c_options->image.image_cache_max);
 	pref_checkbox_new_int(group, _("Preload next image"),
 			      options->image.enable_read_ahead, &c_options->image.enable_read_ahead);
+	pref_spin_new_int(group, _("Decoding threads (0 = one per processor):"), NULL,
+			  0, 64, 1, options->image.loader_threads, &c_options->image.loader_threads);
 
 	pref_checkbox_new_int(group, _("Refresh on file change"),
 			      options->update_on_time_change, &c_options->update_on_time_change);
@@ -3857,6 +3876,7 @@ static void timezone_async_ready_cb(GObject *source_object, GAsyncResult *res, g
 		{
 		tmp_filename = g_file_get_parse_name(tz->tmp_g_file);
 		move_file(tmp_filename, tz->timezone_database_user);
+		exif_timezone_database_reset();
 		g_free(tmp_filename);
 		}
 	else
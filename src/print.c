@@ -38,6 +38,11 @@
 /* method to use when scaling down image data */
 #define PRINT_MAX_INTERP GDK_INTERP_BILINEAR
 
+/* number of pages decoded ahead of the page that is drawn,
+ * bounds the number of pixbufs held by a print job
+ */
+#define PRINT_DECODE_AHEAD 2
+
 /* reverse order is important */
 typedef enum {
 	FOOTER_2,
@@ -52,14 +57,22 @@ struct _PrintWindow
 	GtkWidget *vbox;
 	GList *source_selection;
 
-	gint job_page;
+	gint job_page;		/**< page that is decoded by job_loader */
 	GtkTextBuffer *page_text;
 	gchar *template_string;
 	GtkWidget *parent;
 	ImageLoader	*job_loader;
 
-	GList *print_pixbuf_queue;
-	gboolean job_render_finished;
+	GdkPixbuf **job_pixbufs;	/**< decoded image per page, released when the page is drawn */
+	gboolean *job_decoded;		/**< TRUE when the page has been decoded, even if that failed */
+	gint job_pages;
+	gint job_next_page;		/**< first page that still has to be drawn */
+	gint job_requested_size;	/**< longest side in device pixels at the print resolution */
+
+	GtkPrintOperation *job_operation;
+	GtkPrintContext *job_context;
+	gint job_deferred_page;		/**< page whose drawing waits for its image, -1 for none */
+
 	GSList *image_group;
 	GSList *page_group;
 };
@@ -75,50 +88,119 @@ static gint print_layout_page_count(PrintWindow *pw)
 	return images;
 }
 
-static gboolean print_job_render_image(PrintWindow *pw);
+static void draw_page_real(PrintWindow *pw, GtkPrintContext *context, gint page_nr, GdkPixbuf *pixbuf);
+static void print_job_render_image(PrintWindow *pw);
 
-static void print_job_render_image_loader_done(ImageLoader *il, gpointer data)
+static void print_job_page_release(PrintWindow *pw, gint page)
 {
-	PrintWindow *pw = data;
-	GdkPixbuf *pixbuf;
+	if (pw->job_pixbufs[page]) g_object_unref(pw->job_pixbufs[page]);
+	pw->job_pixbufs[page] = NULL;
+	pw->job_decoded[page] = FALSE;
+}
 
-	pixbuf = image_loader_get_pixbuf(il);
+/* only pages between the one being drawn and the decode ahead limit are kept */
+static void print_job_release_outside(PrintWindow *pw, gint first, gint last)
+{
+	gint i;
 
-	g_object_ref(pixbuf);
-	pw->print_pixbuf_queue = g_list_append(pw->print_pixbuf_queue, pixbuf);
+	for (i = 0; i < pw->job_pages; i++)
+		{
+		if (i < first || i > last) print_job_page_release(pw, i);
+		}
+}
+
+static void print_job_page_decoded(PrintWindow *pw, gint page, GdkPixbuf *pixbuf)
+{
+	pw->job_pixbufs[page] = pixbuf;
+	pw->job_decoded[page] = TRUE;
 
 	image_loader_free(pw->job_loader);
 	pw->job_loader = NULL;
 
-	pw->job_page++;
+	DEBUG_1("%s print job page %d decoded", get_exec_time(), page + 1);
 
-	if (!print_job_render_image(pw))
+	if (pw->job_deferred_page == page)
 		{
-		pw->job_render_finished = TRUE;
+		pw->job_deferred_page = -1;
+		if (pixbuf) draw_page_real(pw, pw->job_context, page, pixbuf);
+		print_job_page_release(pw, page);
+		pw->job_next_page = page + 1;
+		gtk_print_operation_draw_page_finish(pw->job_operation);
 		}
+
+	print_job_render_image(pw);
 }
 
-static gboolean print_job_render_image(PrintWindow *pw)
+static void print_job_render_image_loader_done(ImageLoader *il, gpointer data)
+{
+	PrintWindow *pw = data;
+	GdkPixbuf *pixbuf;
+
+	pixbuf = image_loader_get_pixbuf(il);
+
+	if (pixbuf)
+		{
+		gint w = gdk_pixbuf_get_width(pixbuf);
+		gint h = gdk_pixbuf_get_height(pixbuf);
+
+		/* not all loaders can decode at a reduced size, do not keep more than is printed */
+		if (pw->job_requested_size > 0 && MAX(w, h) > pw->job_requested_size)
+			{
+			gdouble scale = (gdouble)pw->job_requested_size / MAX(w, h);
+
+			pixbuf = gdk_pixbuf_scale_simple(pixbuf, MAX(1, w * scale), MAX(1, h * scale), PRINT_MAX_INTERP);
+			}
+		else
+			{
+			g_object_ref(pixbuf);
+			}
+		}
+
+	print_job_page_decoded(pw, pw->job_page, pixbuf);
+}
+
+static void print_job_render_image_loader_error(ImageLoader *il, gpointer data)
+{
+	PrintWindow *pw = data;
+	FileData *fd = g_list_nth_data(pw->source_selection, pw->job_page);
+
+	log_printf("Error: Print job could not load %s", fd ? fd->path : "");
+
+	/* the page is then printed without the image */
+	print_job_page_decoded(pw, pw->job_page, NULL);
+}
+
+/* starts decoding the next page that is needed, if any */
+static void print_job_render_image(PrintWindow *pw)
 {
 	FileData *fd = NULL;
+	gint page;
 
-	fd = g_list_nth_data(pw->source_selection, pw->job_page);
-	if (!fd) return FALSE;
+	if (pw->job_loader) return;
 
-	image_loader_free(pw->job_loader);
-	pw->job_loader = NULL;
+	page = pw->job_next_page;
+	while (page < pw->job_pages && pw->job_decoded[page]) page++;
+
+	if (page >= pw->job_pages || page > pw->job_next_page + PRINT_DECODE_AHEAD) return;
+
+	fd = g_list_nth_data(pw->source_selection, page);
+	if (!fd) return;
 
+	pw->job_page = page;
 	pw->job_loader = image_loader_new(fd);
+	if (pw->job_requested_size > 0)
+		{
+		image_loader_set_requested_size(pw->job_loader, pw->job_requested_size, pw->job_requested_size);
+		}
 	g_signal_connect(G_OBJECT(pw->job_loader), "done",
 						(GCallback)print_job_render_image_loader_done, pw);
+	g_signal_connect(G_OBJECT(pw->job_loader), "error",
+						(GCallback)print_job_render_image_loader_error, pw);
 
 	if (!image_loader_start(pw->job_loader))
 		{
-		image_loader_free(pw->job_loader);
-		pw->job_loader= NULL;
+		print_job_render_image_loader_error(pw->job_loader, pw);
 		}
-
-	return TRUE;
 }
 
 static void print_set_font_cb(GtkWidget *widget, gpointer data)
@@ -485,16 +567,8 @@ static gboolean paginate_cb(GtkPrintOperation *operation,
 									GtkPrintContext *context,
 									gpointer data)
 {
-	PrintWindow *pw = data;
-
-	if (pw->job_render_finished)
-		{
-		return TRUE;
-		}
-	else
-		{
-		return FALSE;
-		}
+	/* one image per page, images are decoded while the pages are drawn */
+	return TRUE;
 }
 
 gchar *form_image_text(const gchar *template_string, FileData *fd, PrintWindow *pw, gint page_nr, gint total)
@@ -560,17 +634,14 @@ gchar *form_image_text(const gchar *template_string, FileData *fd, PrintWindow *
 	return text;
 }
 
-static void draw_page(GtkPrintOperation *operation, GtkPrintContext *context,
-									gint page_nr, gpointer data)
+static void draw_page_real(PrintWindow *pw, GtkPrintContext *context, gint page_nr, GdkPixbuf *pixbuf)
 {
-	PrintWindow *pw = data;
 	FileData *fd;
 	cairo_t *cr;
 	gdouble context_width, context_height;
 	gdouble pixbuf_image_width, pixbuf_image_height;
 	gdouble width_offset;
 	gdouble height_offset;
-	GdkPixbuf *pixbuf;
 	GdkPixbuf *rotated = NULL;
 	PangoLayout *layout_image = NULL;
 	PangoLayout *layout_page = NULL;
@@ -592,7 +663,6 @@ static void draw_page(GtkPrintOperation *operation, GtkPrintContext *context,
 	fd = g_list_nth_data(pw->source_selection, page_nr);
 	total = g_list_length(pw->source_selection);
 
-	pixbuf = g_list_nth_data(pw->print_pixbuf_queue, page_nr);
 	if (fd->exif_orientation != EXIF_ORIENTATION_TOP_LEFT)
 		{
 		rotated = pixbuf_apply_orientation(pixbuf, fd->exif_orientation);
@@ -774,16 +844,60 @@ static void draw_page(GtkPrintOperation *operation, GtkPrintContext *context,
 	return;
 }
 
+static void draw_page(GtkPrintOperation *operation, GtkPrintContext *context,
+									gint page_nr, gpointer data)
+{
+	PrintWindow *pw = data;
+
+	pw->job_next_page = page_nr;
+	print_job_release_outside(pw, page_nr, page_nr + PRINT_DECODE_AHEAD);
+
+	if (pw->job_decoded[page_nr])
+		{
+		if (pw->job_pixbufs[page_nr]) draw_page_real(pw, context, page_nr, pw->job_pixbufs[page_nr]);
+		print_job_page_release(pw, page_nr);
+		pw->job_next_page = page_nr + 1;
+		print_job_render_image(pw);
+		return;
+		}
+
+	/* the page is finished by print_job_page_decoded() */
+	gtk_print_operation_set_defer_drawing(operation);
+	pw->job_context = context;
+	pw->job_deferred_page = page_nr;
+
+	if (pw->job_loader && pw->job_page != page_nr)
+		{
+		/* pages are not requested in order, e.g. in the preview */
+		image_loader_free(pw->job_loader);
+		pw->job_loader = NULL;
+		}
+
+	print_job_render_image(pw);
+}
+
 static void begin_print(GtkPrintOperation *operation,
 						GtkPrintContext *context,
 						gpointer user_data)
 {
 	PrintWindow *pw = user_data;
 	gint page_count;
+	gdouble dpi;
 
 	page_count = print_layout_page_count(pw);
 	gtk_print_operation_set_n_pages (operation, page_count);
 
+	/* images are decoded only at the size they are printed at, the unit is points */
+	dpi = MAX(gtk_print_context_get_dpi_x(context), gtk_print_context_get_dpi_y(context));
+	pw->job_requested_size = MAX(gtk_print_context_get_width(context), gtk_print_context_get_height(context)) * dpi / 72.0;
+
+	pw->job_operation = operation;
+	pw->job_pages = page_count;
+	pw->job_pixbufs = g_new0(GdkPixbuf *, page_count);
+	pw->job_decoded = g_new0(gboolean, page_count);
+	pw->job_next_page = 0;
+	pw->job_deferred_page = -1;
+
 	print_job_render_image(pw);
 }
 
@@ -811,8 +925,6 @@ static void end_print_cb(GtkPrintOperation *operation,
 								GtkPrintContext *context, gpointer data)
 {
 	PrintWindow *pw = data;
-	GList *work;
-	GdkPixbuf *pixbuf;
 	gchar *path;
 	GtkPrintSettings *print_settings;
 	GtkPageSetup *page_setup;
@@ -846,17 +958,11 @@ static void end_print_cb(GtkPrintOperation *operation,
 
 	print_pref_store(pw);
 
-	work = pw->print_pixbuf_queue;
-	while (work)
-		{
-		pixbuf = work->data;
-		if (pixbuf)
-			{
-			g_object_unref(pixbuf);
-			}
-		work = work->next;
-		}
-	g_list_free(pw->print_pixbuf_queue);
+	image_loader_free(pw->job_loader);
+	print_job_release_outside(pw, 0, -1); /* all pages */
+	g_free(pw->job_pixbufs);
+	g_free(pw->job_decoded);
+
 	g_object_unref(pw->page_text);
 	g_free(pw);
 }
@@ -891,9 +997,8 @@ void print_window_new(FileData *fd, GList *selection, GList *list, GtkWidget *pa
 	print_text_menu(vbox, pw);
 	pw->vbox = vbox;
 
-	pw->print_pixbuf_queue = NULL;
-	pw->job_render_finished = FALSE;
 	pw->job_page = 0;
+	pw->job_deferred_page = -1;
 
 	operation = gtk_print_operation_new();
 	settings = gtk_print_settings_new();
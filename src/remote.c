@@ -22,6 +22,7 @@
 #include "main.h"
 #include "remote.h"
 
+#include "cache.h"
 #include "cache_maint.h"
 #include "collect.h"
 #include "collect-io.h"
@@ -29,10 +30,12 @@
 #include "filedata.h"
 #include "filefilter.h"
 #include "image.h"
+#include "image-load.h"
 #include "img-view.h"
 #include "layout.h"
 #include "layout_image.h"
 #include "layout_util.h"
+#include "metadata.h"
 #include "misc.h"
 #include "pixbuf-renderer.h"
 #include "slideshow.h"
@@ -63,11 +66,14 @@ static void gr_raise(const gchar *text, GIOChannel *channel, gpointer data);
 
 static LayoutWindow *lw_id = NULL; /* points to the window set by the --id option */
 
+typedef struct _RemoteQuery RemoteQuery;
+
 typedef struct _RemoteClient RemoteClient;
 struct _RemoteClient {
 	gint fd;
 	guint channel_id; /* event source id */
 	RemoteConnection *rc;
+	RemoteQuery *query; /* query still answering on this client */
 };
 
 typedef struct _RemoteData RemoteData;
@@ -89,6 +95,14 @@ static gboolean print0 = FALSE;
  */
 static gchar *pwd = NULL;
 
+/* A command that answers after it returns sets this, the end of the command
+ * is then written by the command and not by remote_server_client_cb()
+ */
+static RemoteQuery *remote_query_deferred = NULL;
+
+static void remote_query_client_set(RemoteQuery *query, RemoteClient *client);
+static void remote_query_client_gone(RemoteQuery *query);
+
 /**
  * @brief Ensures file path is absolute.
  * @param[in] filename Filepath, absolute or relative to calling directory
@@ -141,8 +155,16 @@ static gboolean remote_server_client_cb(GIOChannel *source, GIOCondition conditi
 				if (strlen(buffer) > 0)
 					{
 					if (rc->read_func) rc->read_func(rc, buffer, source, rc->read_data);
-					g_io_channel_write_chars(source, "<gq_end_of_command>", -1, NULL, NULL); /* empty line finishes the command */
-					g_io_channel_flush(source, NULL);
+					if (remote_query_deferred)
+						{
+						remote_query_client_set(remote_query_deferred, client);
+						remote_query_deferred = NULL;
+						}
+					else
+						{
+						g_io_channel_write_chars(source, "<gq_end_of_command>", -1, NULL, NULL); /* empty line finishes the command */
+						g_io_channel_flush(source, NULL);
+						}
 					}
 				g_free(buffer);
 
@@ -164,6 +186,7 @@ static gboolean remote_server_client_cb(GIOChannel *source, GIOCondition conditi
 		DEBUG_1("HUP detected, closing client.");
 		DEBUG_1("client count %d", g_list_length(rc->clients));
 
+		if (client->query) remote_query_client_gone(client->query);
 		g_source_remove(client->channel_id);
 		close(client->fd);
 		g_free(client);
@@ -205,6 +228,7 @@ static void remote_server_clients_close(RemoteConnection *rc)
 
 		rc->clients = g_list_remove(rc->clients, client);
 
+		if (client->query) remote_query_client_gone(client->query);
 		g_source_remove(client->channel_id);
 		close(client->fd);
 		g_free(client);
@@ -401,6 +425,8 @@ static gboolean remote_client_send(RemoteConnection *rc, const gchar *text)
 						{
 						printf("%s\n", buffer);
 						}
+					/* streamed replies, e.g. of --query, reach a pipe line by line */
+					fflush(stdout);
 					}
 				g_free(buffer);
 				buffer = NULL;
@@ -1011,6 +1037,609 @@ static void gr_filelist_recurse(const gchar *text, GIOChannel *channel, gpointer
 	get_filelist(text, channel, TRUE);
 }
 
+/*
+ * Batch query: one JSON object per file, written as soon as it is complete.
+ * Files whose data is at hand are answered at once, the others wait for
+ * a worker reading the exif data and the image size off the main thread.
+ */
+
+#define REMOTE_QUERY_THREADS_MAX 8
+
+typedef enum {
+	REMOTE_QUERY_NAME	= 1 << 0,
+	REMOTE_QUERY_CLASS	= 1 << 1,
+	REMOTE_QUERY_SIZE	= 1 << 2,
+	REMOTE_QUERY_DATE	= 1 << 3,
+	REMOTE_QUERY_EXIFDATE	= 1 << 4,
+	REMOTE_QUERY_DIMENSIONS	= 1 << 5,
+	REMOTE_QUERY_RATING	= 1 << 6,
+	REMOTE_QUERY_KEYWORDS	= 1 << 7,
+	REMOTE_QUERY_ALL	= (1 << 8) - 1
+} RemoteQueryField;
+
+/* fields read from the exif data or the sidecar */
+#define REMOTE_QUERY_METADATA (REMOTE_QUERY_EXIFDATE | REMOTE_QUERY_RATING | REMOTE_QUERY_KEYWORDS)
+
+static const struct {
+	const gchar *name;
+	RemoteQueryField field;
+} remote_query_fields[] = {
+	{ "name",	REMOTE_QUERY_NAME },
+	{ "class",	REMOTE_QUERY_CLASS },
+	{ "size",	REMOTE_QUERY_SIZE },
+	{ "date",	REMOTE_QUERY_DATE },
+	{ "exifdate",	REMOTE_QUERY_EXIFDATE },
+	{ "dimensions",	REMOTE_QUERY_DIMENSIONS },
+	{ "rating",	REMOTE_QUERY_RATING },
+	{ "keywords",	REMOTE_QUERY_KEYWORDS },
+	{ NULL, 0 }
+};
+
+/* The query answers from idle callbacks: folders are read one per idle,
+ * the files go to the worker threads and each result is written when its
+ * worker is done. The end of the command follows the last result. */
+struct _RemoteQuery
+{
+	GIOChannel *channel;
+	RemoteClient *client;	/**< set when the command has returned */
+	gboolean connected;	/**< FALSE once the client is gone, nothing is written then */
+
+	RemoteQueryField fields;
+	GList *keys;		/**< metadata keys */
+	gboolean recurse;
+
+	GList *dirs;		/**< FileData of the folders still to be read */
+	guint dirs_id;		/**< event source id of the folder reading */
+	gint pending;		/**< files with a worker or a loader */
+	guint finish_id;	/**< event source id, ends a query without folders to read */
+};
+
+typedef struct _RemoteQueryItem RemoteQueryItem;
+struct _RemoteQueryItem
+{
+	FileData *fd;
+	gchar *path;
+	gchar *pathl;		/**< path in locale encoding */
+	gchar *sidecar_path;
+
+	gboolean read_exif;
+	gboolean read_dimensions;
+	FileFormatClass format_class;
+
+	ExifData *exif;		/**< read by the worker, handed to fd on the main thread */
+	gboolean dimensions;	/**< width and height are valid */
+	gint width;
+	gint height;
+
+	RemoteQuery *query;
+};
+
+static GThreadPool *remote_query_pool = NULL;
+
+/**
+ * @brief Splits the comma separated field list of a query
+ * @param text field names, any other entry is taken as a metadata key
+ * @param keys returns the metadata keys
+ * @returns the requested fields, all of them for an empty list
+ */
+static RemoteQueryField remote_query_parse_fields(const gchar *text, GList **keys)
+{
+	RemoteQueryField fields = 0;
+	gchar **names;
+	gint i;
+
+	names = g_strsplit(text, ",", -1);
+	for (i = 0; names[i]; i++)
+		{
+		gchar *name = g_strstrip(names[i]);
+		gint j;
+
+		if (!name[0]) continue;
+
+		for (j = 0; remote_query_fields[j].name; j++)
+			{
+			if (strcmp(name, remote_query_fields[j].name) == 0) break;
+			}
+
+		if (remote_query_fields[j].name)
+			{
+			fields |= remote_query_fields[j].field;
+			}
+		else
+			{
+			*keys = g_list_append(*keys, g_strdup(name));
+			}
+		}
+	g_strfreev(names);
+
+	if (!fields && !*keys) fields = REMOTE_QUERY_ALL;
+
+	return fields;
+}
+
+static gboolean remote_query_dimensions_cached(const gchar *path, gint *width, gint *height)
+{
+	gchar *cache_path;
+	CacheData *cd;
+	gboolean ret = FALSE;
+
+	cache_path = cache_find_location(CACHE_TYPE_SIM, path);
+	if (!cache_path) return FALSE;
+
+	if (filetime(path) != filetime(cache_path))
+		{
+		g_free(cache_path);
+		return FALSE;
+		}
+
+	cd = cache_sim_data_load(cache_path);
+	g_free(cache_path);
+
+	if (cd)
+		{
+		if (cd->dimensions)
+			{
+			*width = cd->width;
+			*height = cd->height;
+			ret = TRUE;
+			}
+		cache_sim_data_free(cd);
+		}
+
+	return ret;
+}
+
+static gboolean remote_query_item_done_cb(gpointer data);
+
+static void remote_query_thread(gpointer data, gpointer user_data)
+{
+	RemoteQueryItem *item = data;
+
+	if (item->read_dimensions)
+		{
+		item->dimensions = remote_query_dimensions_cached(item->path, &item->width, &item->height) ||
+				   image_load_dimensions_probe_local(item->fd, item->pathl, &item->width, &item->height);
+
+		/* no header probe for this format, gdk-pixbuf reads the size without decoding */
+		if (!item->dimensions && item->format_class == FORMAT_CLASS_IMAGE)
+			{
+			item->dimensions = (gdk_pixbuf_get_file_info(item->pathl, &item->width, &item->height) != NULL &&
+					    item->width > 0 && item->height > 0);
+			}
+		}
+
+	if (item->read_exif)
+		{
+		item->exif = exif_read(item->path, item->sidecar_path, NULL);
+		}
+
+	g_idle_add(remote_query_item_done_cb, item);
+}
+
+static void remote_query_item_free(RemoteQueryItem *item)
+{
+	exif_free(item->exif);
+	file_data_unref(item->fd);
+	g_free(item->path);
+	g_free(item->pathl);
+	g_free(item->sidecar_path);
+	g_free(item);
+}
+
+static void remote_query_write(GIOChannel *channel, RemoteQueryItem *item, RemoteQueryField fields, GList *keys)
+{
+	FileData *fd = item->fd;
+	GString *out;
+	GList *work;
+
+	if (item->exif)
+		{
+		exif_set_fd(fd, item->exif);
+		item->exif = NULL;
+		}
+
+	out = g_string_new("{\"path\":");
+	json_append_string(out, fd->path);
+
+	if (fields & REMOTE_QUERY_NAME)
+		{
+		g_string_append(out, ",\"name\":");
+		json_append_string(out, fd->name);
+		}
+
+	if (fields & REMOTE_QUERY_CLASS)
+		{
+		g_string_append(out, ",\"class\":");
+		json_append_string(out, format_class_list[filter_file_get_class(fd->path)]);
+		}
+
+	if (fields & REMOTE_QUERY_SIZE)
+		{
+		g_string_append_printf(out, ",\"size\":%" G_GINT64_FORMAT, fd->size);
+		}
+
+	if (fields & REMOTE_QUERY_DATE)
+		{
+		g_string_append_printf(out, ",\"date\":%" G_GINT64_FORMAT, (gint64)fd->date);
+		}
+
+	if (fields & REMOTE_QUERY_EXIFDATE)
+		{
+		read_exif_time_data(fd);
+		if (fd->exifdate > 0)
+			{
+			g_string_append_printf(out, ",\"exifdate\":%" G_GINT64_FORMAT, (gint64)fd->exifdate);
+			}
+		else
+			{
+			g_string_append(out, ",\"exifdate\":null");
+			}
+		}
+
+	if (fields & REMOTE_QUERY_DIMENSIONS)
+		{
+		if (item->dimensions)
+			{
+			g_string_append_printf(out, ",\"width\":%d,\"height\":%d", item->width, item->height);
+			}
+		else
+			{
+			g_string_append(out, ",\"width\":null,\"height\":null");
+			}
+		}
+
+	if (fields & REMOTE_QUERY_RATING)
+		{
+		g_string_append_printf(out, ",\"rating\":%d", (gint)metadata_read_int(fd, RATING_KEY, 0));
+		}
+
+	if (fields & REMOTE_QUERY_KEYWORDS)
+		{
+		GList *keywords = metadata_read_list(fd, KEYWORD_KEY, METADATA_PLAIN);
+
+		g_string_append(out, ",\"keywords\":[");
+		for (work = keywords; work; work = work->next)
+			{
+			if (work != keywords) g_string_append_c(out, ',');
+			json_append_string(out, work->data);
+			}
+		g_string_append_c(out, ']');
+		string_list_free(keywords);
+		}
+
+	if (keys)
+		{
+		g_string_append(out, ",\"metadata\":{");
+		for (work = keys; work; work = work->next)
+			{
+			const gchar *key = work->data;
+			gchar *value = metadata_read_string(fd, key, METADATA_FORMATTED);
+
+			if (work != keys) g_string_append_c(out, ',');
+			json_append_string(out, key);
+			g_string_append_c(out, ':');
+			if (value)
+				{
+				json_append_string(out, value);
+				}
+			else
+				{
+				g_string_append(out, "null");
+				}
+			g_free(value);
+			}
+		g_string_append_c(out, '}');
+		}
+
+	g_string_append_c(out, '}');
+
+	g_io_channel_write_chars(channel, out->str, -1, NULL, NULL);
+	g_io_channel_write_chars(channel, "<gq_end_of_command>", -1, NULL, NULL);
+	g_io_channel_flush(channel, NULL);
+
+	g_string_free(out, TRUE);
+}
+
+static void remote_query_free(RemoteQuery *query)
+{
+	g_io_channel_unref(query->channel);
+	string_list_free(query->keys);
+	g_free(query);
+}
+
+/* writes the end of the command when nothing is left to do */
+static void remote_query_check_done(RemoteQuery *query)
+{
+	if (query->pending > 0 || query->dirs_id || query->finish_id) return;
+
+	if (query->connected)
+		{
+		g_io_channel_write_chars(query->channel, "<gq_end_of_command>", -1, NULL, NULL);
+		g_io_channel_flush(query->channel, NULL);
+		}
+	if (query->client) query->client->query = NULL;
+
+	remote_query_free(query);
+}
+
+static void remote_query_item_finish(RemoteQueryItem *item)
+{
+	RemoteQuery *query = item->query;
+
+	if (query->connected) remote_query_write(query->channel, item, query->fields, query->keys);
+	remote_query_item_free(item);
+
+	query->pending--;
+	remote_query_check_done(query);
+}
+
+static void remote_query_loader_done_cb(ImageLoader *il, gpointer data)
+{
+	RemoteQueryItem *item = data;
+	GdkPixbuf *pixbuf;
+
+	pixbuf = image_loader_get_pixbuf(il);
+	if (pixbuf)
+		{
+		item->width = gdk_pixbuf_get_width(pixbuf);
+		item->height = gdk_pixbuf_get_height(pixbuf);
+		item->dimensions = (item->width > 0 && item->height > 0);
+		}
+
+	image_loader_free(il);
+	remote_query_item_finish(item);
+}
+
+static gboolean remote_query_item_done_cb(gpointer data)
+{
+	RemoteQueryItem *item = data;
+
+	if (item->read_dimensions && !item->dimensions && item->query->connected &&
+	    (item->format_class == FORMAT_CLASS_IMAGE || item->format_class == FORMAT_CLASS_RAWIMAGE))
+		{
+		ImageLoader *il;
+
+		/* the loader has to tell, it decodes in its own threads */
+		il = image_loader_new(item->fd);
+		image_loader_set_priority_class(il, IMAGE_LOADER_PRIORITY_BATCH);
+		g_signal_connect(G_OBJECT(il), "error", (GCallback)remote_query_loader_done_cb, item);
+		g_signal_connect(G_OBJECT(il), "done", (GCallback)remote_query_loader_done_cb, item);
+		if (image_loader_start(il)) return G_SOURCE_REMOVE;
+
+		image_loader_free(il);
+		}
+
+	remote_query_item_finish(item);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* takes the reference to fd */
+static void remote_query_add_file(RemoteQuery *query, FileData *fd)
+{
+	RemoteQueryItem *item = g_new0(RemoteQueryItem, 1);
+
+	item->fd = fd;
+	item->query = query;
+	item->read_dimensions = !!(query->fields & REMOTE_QUERY_DIMENSIONS);
+	/* loaded exif data is used as it is, unsaved changes need the main thread */
+	item->read_exif = ((query->fields & REMOTE_QUERY_METADATA) || query->keys) && !fd->exif && !fd->modified_xmp;
+
+	if (!item->read_exif && !item->read_dimensions)
+		{
+		remote_query_write(query->channel, item, query->fields, query->keys);
+		remote_query_item_free(item);
+		return;
+		}
+
+	item->path = g_strdup(fd->path);
+	item->pathl = path_from_utf8(fd->path);
+	item->format_class = filter_file_get_class(fd->path);
+	if (item->read_exif) item->sidecar_path = exif_get_sidecar_path_fd(fd);
+
+	if (!remote_query_pool)
+		{
+		remote_query_pool = g_thread_pool_new(remote_query_thread, NULL,
+						      CLAMP(g_get_num_processors(), 1, REMOTE_QUERY_THREADS_MAX), FALSE, NULL);
+		}
+
+	query->pending++;
+	g_thread_pool_push(remote_query_pool, item, NULL);
+}
+
+/* reads one folder per call, so that large trees do not block the main loop */
+static gboolean remote_query_dirs_cb(gpointer data)
+{
+	RemoteQuery *query = data;
+	FileData *dir_fd;
+	GList *files = NULL;
+	GList *dirs = NULL;
+	GList *work;
+
+	dir_fd = query->dirs->data;
+	query->dirs = g_list_delete_link(query->dirs, query->dirs);
+
+	if (filelist_read(dir_fd, &files, query->recurse ? &dirs : NULL) && query->recurse)
+		{
+		/* same files and order as filelist_recursive() */
+		files = filelist_filter(files, FALSE);
+		files = filelist_sort_path(files);
+
+		dirs = filelist_filter(dirs, TRUE);
+		dirs = filelist_sort_path(dirs);
+		query->dirs = g_list_concat(dirs, query->dirs);
+		}
+	file_data_unref(dir_fd);
+
+	for (work = files; work; work = work->next)
+		{
+		remote_query_add_file(query, work->data);
+		}
+	g_list_free(files);
+
+	if (query->dirs) return G_SOURCE_CONTINUE;
+
+	query->dirs_id = 0;
+	remote_query_check_done(query);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean remote_query_finish_cb(gpointer data)
+{
+	RemoteQuery *query = data;
+
+	query->finish_id = 0;
+	remote_query_check_done(query);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void remote_query_client_set(RemoteQuery *query, RemoteClient *client)
+{
+	query->client = client;
+	client->query = query;
+}
+
+/* the client closed the connection, the results still on their way are dropped */
+static void remote_query_client_gone(RemoteQuery *query)
+{
+	query->client->query = NULL;
+	query->client = NULL;
+	query->connected = FALSE;
+
+	if (query->dirs_id)
+		{
+		g_source_remove(query->dirs_id);
+		query->dirs_id = 0;
+		}
+	filelist_free(query->dirs);
+	query->dirs = NULL;
+
+	if (query->finish_id)
+		{
+		g_source_remove(query->finish_id);
+		query->finish_id = 0;
+		}
+
+	remote_query_check_done(query);
+}
+
+/**
+ * @brief Adds a file or the files of a folder of a query parameter
+ * @returns FALSE if \a text is neither a file nor a folder
+ */
+static gboolean remote_query_add_path(RemoteQuery *query, const gchar *text)
+{
+	gchar *tilde_filename;
+	gchar *filename;
+	gboolean ret = TRUE;
+
+	tilde_filename = expand_tilde(text);
+	filename = set_pwd(tilde_filename);
+
+	if (isdir(filename))
+		{
+		query->dirs = g_list_append(query->dirs, file_data_new_dir(filename));
+		}
+	else if (isfile(filename))
+		{
+		remote_query_add_file(query, file_data_new_group(filename));
+		}
+	else
+		{
+		ret = FALSE;
+		}
+
+	g_free(filename);
+	g_free(tilde_filename);
+	return ret;
+}
+
+/**
+ * @brief Answers a batch query
+ * @param text "FIELDS:PATH" with newline separated files or folders as PATH
+ * @param recurse expand folders recursively
+ *
+ * Each file gets one line with a JSON object, in the order the results
+ * become available. The command returns at once, the results and the end
+ * of the command are written from the main loop.
+ */
+static void get_query(const gchar *text, GIOChannel *channel, gboolean recurse)
+{
+	RemoteQuery *query;
+	gchar **paths = NULL;
+	gchar *field_text;
+	const gchar *path_text;
+	gint i;
+
+	path_text = strchr(text, ':');
+	if (path_text)
+		{
+		field_text = g_strndup(text, path_text - text);
+		path_text++;
+		}
+	else
+		{
+		field_text = g_strdup(text);
+		path_text = "";
+		}
+
+	query = g_new0(RemoteQuery, 1);
+	query->channel = g_io_channel_ref(channel);
+	query->connected = TRUE;
+	query->recurse = recurse;
+	query->fields = remote_query_parse_fields(field_text, &query->keys);
+	g_free(field_text);
+
+	if (path_text[0])
+		{
+		paths = g_strsplit(path_text, "\n", -1);
+		for (i = 0; paths[i]; i++)
+			{
+			if (!paths[i][0]) continue;
+
+			if (!remote_query_add_path(query, paths[i]))
+				{
+				GString *out = g_string_new("{\"path\":");
+
+				json_append_string(out, paths[i]);
+				g_string_append(out, ",\"error\":\"not found\"}");
+				g_io_channel_write_chars(channel, out->str, -1, NULL, NULL);
+				g_io_channel_write_chars(channel, "<gq_end_of_command>", -1, NULL, NULL);
+				g_string_free(out, TRUE);
+				}
+			}
+		g_strfreev(paths);
+		}
+	else if (layout_valid(&lw_id))
+		{
+		remote_query_add_path(query, lw_id->dir_fd->path);
+		}
+
+	if (query->dirs)
+		{
+		query->dirs_id = g_idle_add(remote_query_dirs_cb, query);
+		}
+	else
+		{
+		/* the end of the command must follow the return of this command */
+		query->finish_id = g_idle_add(remote_query_finish_cb, query);
+		}
+
+	remote_query_deferred = query;
+}
+
+static void gr_query(const gchar *text, GIOChannel *channel, gpointer data)
+{
+	get_query(text, channel, FALSE);
+}
+
+static void gr_query_recurse(const gchar *text, GIOChannel *channel, gpointer data)
+{
+	get_query(text, channel, TRUE);
+}
+
 static void gr_file_tell(const gchar *text, GIOChannel *channel, gpointer data)
 {
 	gchar *out_string;
@@ -1332,6 +1961,29 @@ static void gr_pwd(const gchar *text, GIOChannel *channel, gpointer data)
 	lw_id = lw;
 }
 
+static void gr_trace_start(const gchar *text, GIOChannel *channel, gpointer data)
+{
+	trace_clear();
+	trace_set_enabled(TRUE);
+}
+
+static void gr_trace_stop(const gchar *text, GIOChannel *channel, gpointer data)
+{
+	trace_set_enabled(FALSE);
+}
+
+static void gr_trace_save(const gchar *text, GIOChannel *channel, gpointer data)
+{
+	gchar *filename;
+	gchar *tilde_filename = expand_tilde(text);
+
+	filename = set_pwd(tilde_filename);
+
+	trace_save(filename);
+	g_free(filename);
+	g_free(tilde_filename);
+}
+
 static void gr_print0(const gchar *text, GIOChannel *channel, gpointer data)
 {
 	g_io_channel_write_chars(channel, "print0", -1, NULL, NULL);
@@ -1412,6 +2064,8 @@ static RemoteCommandEntry remote_commands[] = {
 	{ NULL, "--get-render-intent",  gr_render_intent,       FALSE, FALSE, NULL, N_("get render intent") },
 	{ NULL, "--get-filelist:",      gr_filelist,            TRUE,  FALSE, N_("[<FOLDER>]"), N_("get list of files and class") },
 	{ NULL, "--get-filelist-recurse:", gr_filelist_recurse, TRUE,  FALSE, N_("[<FOLDER>]"), N_("get list of files and class recursive") },
+	{ NULL, "--query:",             gr_query,               TRUE,  FALSE, N_("[<FIELDS>][:<FILE|FOLDER>...]"), N_("print one JSON line per file with the comma separated FIELDS") },
+	{ NULL, "--query-recurse:",     gr_query_recurse,       TRUE,  FALSE, N_("[<FIELDS>][:<FOLDER>...]"), N_("as --query, folders recursive") },
 	{ NULL, "--get-collection:",    gr_collection,          TRUE,  FALSE, N_("<COLLECTION>"), N_("get collection content") },
 	{ NULL, "--get-collection-list", gr_collection_list,    FALSE, FALSE, NULL, N_("get collection list") },
 	{ NULL, "--get-file-info",      gr_file_info,           FALSE, FALSE, NULL, N_("get file info") },
@@ -1435,6 +2089,9 @@ static RemoteCommandEntry remote_commands[] = {
 #ifdef HAVE_LUA
 	{ NULL, "--lua:",               gr_lua,                 TRUE, FALSE, N_("<FILE>,<lua script>"), N_("run lua script on FILE") },
 #endif
+	{ NULL, "--trace-start",        gr_trace_start,         FALSE, FALSE, NULL, N_("start recording timing spans") },
+	{ NULL, "--trace-stop",         gr_trace_stop,          FALSE, FALSE, NULL, N_("stop recording timing spans") },
+	{ NULL, "--trace-save:",        gr_trace_save,          TRUE, FALSE, N_("<FILE>"), N_("save recorded timing spans to FILE as Chrome trace JSON") },
 	{ NULL, "--PWD:",               gr_pwd,                 TRUE, FALSE, N_("<PWD>"), N_("use PWD as working directory for following commands") },
 	{ NULL, "--print0",             gr_print0,              TRUE, FALSE, NULL, N_("terminate returned data with null character instead of newline") },
 	{ NULL, NULL, NULL, FALSE, FALSE, NULL, NULL }
@@ -43,6 +43,7 @@
 #ifdef GQ_BUILD
 #include "main.h"
 #include "pixbuf_util.h"
+#include "pixbuf_kernels.h"
 #include "exif.h"
 #else
 typedef enum {
@@ -948,31 +949,19 @@ static void rt_tile_rotate_90_clockwise(RendererTiles *rt, GdkPixbuf **tile, gin
 	GdkPixbuf *dest;
 	gint srs, drs;
 	guchar *s_pix, *d_pix;
-	guchar *sp, *dp;
-	guchar *ip, *spi, *dpi;
-	gint i, j;
 	gint tw = rt->tile_width * rt->hidpi_scale;
 
 	srs = gdk_pixbuf_get_rowstride(src);
 	s_pix = gdk_pixbuf_get_pixels(src);
-	spi = s_pix + (x * COLOR_BYTES);
 
 	dest = rt_get_spare_tile(rt);
 	drs = gdk_pixbuf_get_rowstride(dest);
 	d_pix = gdk_pixbuf_get_pixels(dest);
-	dpi = d_pix + (tw - 1) * COLOR_BYTES;
 
-	for (i = y; i < y + h; i++)
-		{
-		sp = spi + (i * srs);
-		ip = dpi - (i * COLOR_BYTES);
-		for (j = x; j < x + w; j++)
-			{
-			dp = ip + (j * drs);
-			memcpy(dp, sp, COLOR_BYTES);
-			sp += COLOR_BYTES;
-			}
-		}
+	/* source rows y..y+h end up in the columns tw-y-h..tw-y of dest rows x..x+w */
+	pixbuf_kernel_rotate_90(s_pix + (y * srs) + (x * COLOR_BYTES), srs,
+				d_pix + (x * drs) + ((tw - y - h) * COLOR_BYTES), drs,
+				w, h, COLOR_BYTES, FALSE);
 
 	rt->spare_tile = src;
 	*tile = dest;
@@ -984,31 +973,19 @@ static void rt_tile_rotate_90_counter_clockwise(RendererTiles *rt, GdkPixbuf **t
 	GdkPixbuf *dest;
 	gint srs, drs;
 	guchar *s_pix, *d_pix;
-	guchar *sp, *dp;
-	guchar *ip, *spi, *dpi;
-	gint i, j;
 	gint th = rt->tile_height * rt->hidpi_scale;
 
 	srs = gdk_pixbuf_get_rowstride(src);
 	s_pix = gdk_pixbuf_get_pixels(src);
-	spi = s_pix + (x * COLOR_BYTES);
 
 	dest = rt_get_spare_tile(rt);
 	drs = gdk_pixbuf_get_rowstride(dest);
 	d_pix = gdk_pixbuf_get_pixels(dest);
-	dpi = d_pix + (th - 1) * drs;
 
-	for (i = y; i < y + h; i++)
-		{
-		sp = spi + (i * srs);
-		ip = dpi + (i * COLOR_BYTES);
-		for (j = x; j < x + w; j++)
-			{
-			dp = ip - (j * drs);
-			memcpy(dp, sp, COLOR_BYTES);
-			sp += COLOR_BYTES;
-			}
-		}
+	/* source columns x..x+w end up in the dest rows th-x-w..th-x, columns y..y+h */
+	pixbuf_kernel_rotate_90(s_pix + (y * srs) + (x * COLOR_BYTES), srs,
+				d_pix + ((th - x - w) * drs) + (y * COLOR_BYTES), drs,
+				w, h, COLOR_BYTES, TRUE);
 
 	rt->spare_tile = src;
 	*tile = dest;
@@ -1021,30 +998,22 @@ static void rt_tile_mirror_only(RendererTiles *rt, GdkPixbuf **tile, gint x, gin
 	gint srs, drs;
 	guchar *s_pix, *d_pix;
 	guchar *sp, *dp;
-	guchar *spi, *dpi;
-	gint i, j;
+	gint i;
 
 	gint tw = rt->tile_width * rt->hidpi_scale;
 
 	srs = gdk_pixbuf_get_rowstride(src);
 	s_pix = gdk_pixbuf_get_pixels(src);
-	spi = s_pix + (x * COLOR_BYTES);
 
 	dest = rt_get_spare_tile(rt);
 	drs = gdk_pixbuf_get_rowstride(dest);
 	d_pix = gdk_pixbuf_get_pixels(dest);
-	dpi =  d_pix + (tw - x - 1) * COLOR_BYTES;
 
 	for (i = y; i < y + h; i++)
 		{
-		sp = spi + (i * srs);
-		dp = dpi + (i * drs);
-		for (j = 0; j < w; j++)
-			{
-			memcpy(dp, sp, COLOR_BYTES);
-			sp += COLOR_BYTES;
-			dp -= COLOR_BYTES;
-			}
+		sp = s_pix + (i * srs) + (x * COLOR_BYTES);
+		dp = d_pix + (i * drs) + ((tw - x - w) * COLOR_BYTES);
+		pixbuf_kernel_mirror_row(sp, dp, w, COLOR_BYTES);
 		}
 
 	rt->spare_tile = src;
@@ -1058,8 +1027,7 @@ static void rt_tile_mirror_and_flip(RendererTiles *rt, GdkPixbuf **tile, gint x,
 	gint srs, drs;
 	guchar *s_pix, *d_pix;
 	guchar *sp, *dp;
-	guchar *dpi;
-	gint i, j;
+	gint i;
 	gint tw = rt->tile_width * rt->hidpi_scale;
 	gint th = rt->tile_height * rt->hidpi_scale;
 
@@ -1069,18 +1037,12 @@ static void rt_tile_mirror_and_flip(RendererTiles *rt, GdkPixbuf **tile, gint x,
 	dest = rt_get_spare_tile(rt);
 	drs = gdk_pixbuf_get_rowstride(dest);
 	d_pix = gdk_pixbuf_get_pixels(dest);
-	dpi = d_pix + (th - 1) * drs + (tw - 1) * COLOR_BYTES;
 
 	for (i = y; i < y + h; i++)
 		{
 		sp = s_pix + (i * srs) + (x * COLOR_BYTES);
-		dp = dpi - (i * drs) - (x * COLOR_BYTES);
-		for (j = 0; j < w; j++)
-			{
-			memcpy(dp, sp, COLOR_BYTES);
-			sp += COLOR_BYTES;
-			dp -= COLOR_BYTES;
-			}
+		dp = d_pix + ((th - 1 - i) * drs) + ((tw - x - w) * COLOR_BYTES);
+		pixbuf_kernel_mirror_row(sp, dp, w, COLOR_BYTES);
 		}
 
 	rt->spare_tile = src;
@@ -1457,6 +1419,8 @@ static void rt_tile_render(RendererTiles *rt, ImageTile *it,
 
 	if (new_data) it->blank = FALSE;
 
+	TRACE_BEGIN(trace_start);
+
 	rt_tile_prepare(rt, it);
 	has_alpha = (pr->pixbuf && gdk_pixbuf_get_has_alpha(pr->pixbuf));
 
@@ -1484,6 +1448,8 @@ static void rt_tile_render(RendererTiles *rt, ImageTile *it,
 		gdouble src_x, src_y;
 		gint pb_x, pb_y;
 		gint pb_w, pb_h;
+		gdouble level_scale_x, level_scale_y;
+		GdkPixbuf *src;
 
 		if (pr->image_width == 0 || pr->image_height == 0) return;
 
@@ -1527,13 +1493,19 @@ static void rt_tile_render(RendererTiles *rt, ImageTile *it,
 		 * small sizes for anything but GDK_INTERP_NEAREST
 		 */
 		if (pr->width < PR_MIN_SCALE_SIZE || pr->height < PR_MIN_SCALE_SIZE) fast = TRUE;
-		if (pr->image_width > 32767) wide_image = TRUE;
+
+		/* when zoomed out, scale from the nearest reduced level */
+		level_scale_x = scale_x;
+		level_scale_y = scale_y;
+		src = pixbuf_pyramid_get_level(pr->pixbuf, &level_scale_x, &level_scale_y);
+
+		if ((src == pr->pixbuf ? pr->image_width : gdk_pixbuf_get_width(src)) > 32767) wide_image = TRUE;
 
 		rt_tile_get_region(has_alpha, pr->ignore_alpha,
-				   pr->pixbuf, it->pixbuf, pb_x, pb_y, pb_w, pb_h,
+				   src, it->pixbuf, pb_x, pb_y, pb_w, pb_h,
 				   (gdouble) 0.0 - src_x - GET_RIGHT_PIXBUF_OFFSET(rt) * scale_x,
 				   (gdouble) 0.0 - src_y,
-				   scale_x, scale_y,
+				   level_scale_x, level_scale_y,
 				   (fast) ? GDK_INTERP_NEAREST : pr->zoom_quality,
 				   it->x + pb_x, it->y + pb_y, wide_image);
 		if (rt->stereo_mode & PR_STEREO_ANAGLYPH &&
@@ -1541,10 +1513,10 @@ static void rt_tile_render(RendererTiles *rt, ImageTile *it,
 			{
 			GdkPixbuf *right_pb = rt_get_spare_tile(rt);
 			rt_tile_get_region(has_alpha, pr->ignore_alpha,
-					   pr->pixbuf, right_pb, pb_x, pb_y, pb_w, pb_h,
+					   src, right_pb, pb_x, pb_y, pb_w, pb_h,
 					   (gdouble) 0.0 - src_x - GET_LEFT_PIXBUF_OFFSET(rt) * scale_x,
 					   (gdouble) 0.0 - src_y,
-					   scale_x, scale_y,
+					   level_scale_x, level_scale_y,
 					   (fast) ? GDK_INTERP_NEAREST : pr->zoom_quality,
 					   it->x + pb_x, it->y + pb_y, wide_image);
 			pr_create_anaglyph(rt->stereo_mode, it->pixbuf, right_pb, pb_x, pb_y, pb_w, pb_h);
@@ -1566,6 +1538,8 @@ static void rt_tile_render(RendererTiles *rt, ImageTile *it,
 		rt_hidpi_aware_draw(rt, cr, it->pixbuf, 0, 0);
 		cairo_destroy (cr);
 		}
+
+	TRACE_END(trace_start, "rt_tile_render", NULL);
 }
 
 
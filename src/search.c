@@ -1734,6 +1734,26 @@ static void search_stop(SearchData *sd)
 	search_status_update(sd);
 }
 
+static void search_file_cache_save(CacheData *cd, FileData *fd)
+{
+	gchar *base;
+	mode_t mode = 0755;
+
+	if (!options->thumbnails.enable_caching || !fd) return;
+
+	base = cache_get_location(CACHE_TYPE_SIM, fd->path, FALSE, &mode);
+	if (recursive_mkdir_if_not_exists(base, mode))
+		{
+		g_free(cd->path);
+		cd->path = cache_get_location(CACHE_TYPE_SIM, fd->path, TRUE, NULL);
+		if (cache_sim_data_save(cd))
+			{
+			filetime_set(cd->path, filetime(fd->path));
+			}
+		}
+	g_free(base);
+}
+
 static void search_file_load_process(SearchData *sd, CacheData *cd)
 {
 	GdkPixbuf *pixbuf;
@@ -1766,26 +1786,7 @@ static void search_file_load_process(SearchData *sd, CacheData *cd)
 			image_sim_free(sim);
 			}
 
-		if (options->thumbnails.enable_caching &&
-		    sd->img_loader && image_loader_get_fd(sd->img_loader))
-			{
-			gchar *base;
-			const gchar *path;
-			mode_t mode = 0755;
-
-			path = image_loader_get_fd(sd->img_loader)->path;
-			base = cache_get_location(CACHE_TYPE_SIM, path, FALSE, &mode);
-			if (recursive_mkdir_if_not_exists(base, mode))
-				{
-				g_free(cd->path);
-				cd->path = cache_get_location(CACHE_TYPE_SIM, path, TRUE, NULL);
-				if (cache_sim_data_save(cd))
-					{
-					filetime_set(cd->path, filetime(image_loader_get_fd(sd->img_loader)->path));
-					}
-				}
-			g_free(base);
-			}
+		if (sd->img_loader) search_file_cache_save(cd, image_loader_get_fd(sd->img_loader));
 		}
 
 	image_loader_free(sd->img_loader);
@@ -1826,11 +1827,25 @@ static gboolean search_file_do_extra(SearchData *sd, FileData *fd, gint *match,
 		sd->img_cd = cache_sim_data_new();
 		}
 
+	if (new_data && sd->match_dimensions_enable && !sd->img_cd->dimensions &&
+	    !(sd->match_similarity_enable && !sd->img_cd->similarity) && !sd->match_broken_enable)
+		{
+		gint w, h;
+
+		/* only the size is needed, the file header may be enough */
+		if (image_load_dimensions_probe(fd, &w, &h))
+			{
+			cache_sim_data_set_dimensions(sd->img_cd, w, h);
+			search_file_cache_save(sd->img_cd, fd);
+			}
+		}
+
 	if (new_data)
 		{
 		if ((sd->match_dimensions_enable && !sd->img_cd->dimensions) || (sd->match_similarity_enable && !sd->img_cd->similarity) || sd->match_broken_enable)
 			{
 			sd->img_loader = image_loader_new(fd);
+			image_loader_set_priority_class(sd->img_loader, IMAGE_LOADER_PRIORITY_BATCH);
 			g_signal_connect(G_OBJECT(sd->img_loader), "error", (GCallback)search_file_load_done_cb, sd);
 			g_signal_connect(G_OBJECT(sd->img_loader), "done", (GCallback)search_file_load_done_cb, sd);
 			if (image_loader_start(sd->img_loader))
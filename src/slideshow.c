@@ -22,6 +22,7 @@
 #include "main.h"
 #include "collect.h"
 #include "image.h"
+#include "image-load.h"
 #include "slideshow.h"
 #include "filedata.h"
 
@@ -31,6 +32,7 @@
 
 
 static void slideshow_timer_stop(SlideShowData *ss);
+static void slideshow_decode_cancel_all(SlideShowData *ss);
 
 
 void slideshow_free(SlideShowData *ss)
@@ -38,6 +40,12 @@ void slideshow_free(SlideShowData *ss)
 	if (!ss) return;
 
 	slideshow_timer_stop(ss);
+	slideshow_decode_cancel_all(ss);
+
+	if (options->slideshow.decode_ahead > 0 && ss->slides_shown > 1)
+		{
+		log_printf("slideshow: %u slides shown, %u not decoded ahead in time\n", ss->slides_shown, ss->deadline_misses);
+		}
 
 	if (ss->stop_func) ss->stop_func(ss, ss->stop_data);
 
@@ -160,6 +168,187 @@ static void slideshow_list_init(SlideShowData *ss, gint start_index)
 		}
 }
 
+static FileData *slideshow_get_fd(SlideShowData *ss, gint row)
+{
+	if (ss->filelist)
+		{
+		return g_list_nth_data(ss->filelist, row);
+		}
+	else if (ss->cd)
+		{
+		CollectInfo *info;
+
+		info = g_list_nth_data(ss->cd->list, row);
+		return info ? info->fd : NULL;
+		}
+
+	return layout_list_get_fd(ss->lw, row);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ * decode ahead
+ *
+ * The next images of the slideshow sequence (ss->list, which is already
+ * shuffled in random mode) are decoded by the loader threads and pinned
+ * in the decoded image cache until they are shown, so that large images
+ * are not pushed out by each other under the image cache size limit.
+ *-----------------------------------------------------------------------------
+ */
+
+typedef struct _SlideShowDecode SlideShowDecode;
+struct _SlideShowDecode
+{
+	SlideShowData *ss;
+	FileData *fd;
+	ImageLoader *il;
+	gboolean done;	/**< the pixbuf is pinned in the image cache */
+};
+
+static void slideshow_decode_free(SlideShowDecode *sd)
+{
+	sd->ss->decode_list = g_list_remove(sd->ss->decode_list, sd);
+
+	if (sd->done) image_cache_unpin(sd->fd);
+	image_loader_free(sd->il);
+	file_data_unref(sd->fd);
+	g_free(sd);
+}
+
+static void slideshow_decode_done_cb(ImageLoader *il, gpointer data)
+{
+	SlideShowDecode *sd = data;
+	GdkPixbuf *pixbuf;
+
+	DEBUG_1("%s slideshow decode ahead done: %s", get_exec_time(), sd->fd->path);
+
+	pixbuf = image_loader_get_pixbuf(il);
+	if (!pixbuf)
+		{
+		slideshow_decode_free(sd);
+		return;
+		}
+
+	/* kept until the slide is shown or no longer upcoming */
+	image_cache_pin(sd->fd, pixbuf);
+	sd->done = TRUE;
+
+	image_loader_free(sd->il);
+	sd->il = NULL;
+}
+
+static void slideshow_decode_error_cb(ImageLoader *il, gpointer data)
+{
+	SlideShowDecode *sd = data;
+
+	DEBUG_1("slideshow decode ahead failed: %s", sd->fd->path);
+
+	slideshow_decode_free(sd);
+}
+
+static void slideshow_decode_cancel_all(SlideShowData *ss)
+{
+	while (ss->decode_list)
+		{
+		slideshow_decode_free(ss->decode_list->data);
+		}
+}
+
+static SlideShowDecode *slideshow_decode_find(SlideShowData *ss, FileData *fd)
+{
+	GList *work;
+
+	for (work = ss->decode_list; work; work = work->next)
+		{
+		SlideShowDecode *sd = work->data;
+
+		if (sd->fd == fd) return sd;
+		}
+
+	return NULL;
+}
+
+static gboolean slideshow_decode_ready(SlideShowData *ss, FileData *fd)
+{
+	SlideShowDecode *sd = slideshow_decode_find(ss, fd);
+
+	return (sd && sd->done);
+}
+
+static void slideshow_decode_start(SlideShowData *ss, FileData *fd)
+{
+	SlideShowDecode *sd;
+
+	sd = g_new0(SlideShowDecode, 1);
+	sd->ss = ss;
+	sd->fd = file_data_ref(fd);
+
+	if (image_cache_contains(fd) && fd->pixbuf)
+		{
+		/* already decoded, only make sure it stays until it is shown */
+		image_cache_pin(fd, fd->pixbuf);
+		sd->done = TRUE;
+		ss->decode_list = g_list_append(ss->decode_list, sd);
+		return;
+		}
+
+	sd->il = image_loader_new(fd);
+
+	/* the image on screen is loaded with higher priority */
+	image_loader_set_priority(sd->il, G_PRIORITY_LOW);
+	image_loader_set_priority_class(sd->il, IMAGE_LOADER_PRIORITY_READ_AHEAD);
+
+	g_signal_connect(G_OBJECT(sd->il), "error", (GCallback)slideshow_decode_error_cb, sd);
+	g_signal_connect(G_OBJECT(sd->il), "done", (GCallback)slideshow_decode_done_cb, sd);
+
+	ss->decode_list = g_list_append(ss->decode_list, sd);
+
+	DEBUG_1("%s slideshow decode ahead started: %s", get_exec_time(), fd->path);
+
+	if (!image_loader_start(sd->il))
+		{
+		slideshow_decode_free(sd);
+		}
+}
+
+static void slideshow_decode_update(SlideShowData *ss)
+{
+	GList *wanted = NULL;
+	GList *work;
+	gint n;
+
+	/* the upcoming sequence, in the order it will be shown */
+	n = 0;
+	for (work = ss->list; work && n < options->slideshow.decode_ahead; work = work->next)
+		{
+		FileData *fd = slideshow_get_fd(ss, GPOINTER_TO_INT(work->data));
+
+		if (!fd || g_list_find(wanted, fd)) continue;
+		wanted = g_list_append(wanted, fd);
+		n++;
+		}
+
+	/* drop decodes that are no longer needed, e.g. after going backwards */
+	work = ss->decode_list;
+	while (work)
+		{
+		SlideShowDecode *sd = work->data;
+		work = work->next;
+
+		if (!g_list_find(wanted, sd->fd)) slideshow_decode_free(sd);
+		}
+
+	for (work = wanted; work; work = work->next)
+		{
+		FileData *fd = work->data;
+
+		if (slideshow_decode_find(ss, fd)) continue;
+		slideshow_decode_start(ss, fd);
+		}
+
+	g_list_free(wanted);
+}
+
 gboolean slideshow_should_continue(SlideShowData *ss)
 {
 	FileData *imd_fd;
@@ -222,6 +411,8 @@ static gboolean slideshow_step(SlideShowData *ss, gboolean forward)
 		row = GPOINTER_TO_INT(ss->list_done->data);
 		}
 
+	ss->slides_shown++;
+
 	file_data_unref(ss->slide_fd);
 	ss->slide_fd = NULL;
 
@@ -270,6 +461,12 @@ static gboolean slideshow_step(SlideShowData *ss, gboolean forward)
 		return FALSE;
 		}
 
+	if (options->slideshow.decode_ahead > 0)
+		{
+		slideshow_decode_update(ss);
+		return TRUE;
+		}
+
 	/* read ahead */
 	if (options->image.enable_read_ahead && (!ss->lw || ss->from_selection))
 		{
@@ -312,6 +509,18 @@ static gboolean slideshow_loop_cb(gpointer data)
 
 	if (ss->paused) return TRUE;
 
+	/* only timed forward steps have a deadline, manual steps may go anywhere */
+	if (options->slideshow.decode_ahead > 0 && ss->list)
+		{
+		FileData *fd = slideshow_get_fd(ss, GPOINTER_TO_INT(ss->list->data));
+
+		if (fd && !slideshow_decode_ready(ss, fd))
+			{
+			ss->deadline_misses++;
+			DEBUG_1("%s slideshow deadline missed, not decoded yet: %s", get_exec_time(), fd->path);
+			}
+		}
+
 	if (!slideshow_step(ss, TRUE))
 		{
 		ss->timeout_id = 0;
@@ -134,6 +134,7 @@ static void thumb_loader_done_cb(ImageLoader *il, gpointer data)
 	gint pw, ph;
 	gint save;
 	GdkPixbuf *rotated = NULL;
+	TRACE_BEGIN(trace_start);
 
 	DEBUG_1("thumb done: %s", tl->fd->path);
 
@@ -230,6 +231,8 @@ static void thumb_loader_done_cb(ImageLoader *il, gpointer data)
 		thumb_loader_save_thumbnail(tl, FALSE);
 		}
 
+	TRACE_END(trace_start, "thumb_loader_done", tl->fd->path);
+
 	if (tl->func_done) tl->func_done(tl, tl->data);
 }
 
@@ -275,6 +278,7 @@ static void thumb_loader_setup(ThumbLoader *tl, FileData *fd)
 	image_loader_free(tl->il);
 	tl->il = image_loader_new(fd);
 	image_loader_set_priority(tl->il, G_PRIORITY_LOW);
+	image_loader_set_priority_class(tl->il, tl->priority_class);
 
 	/* this will speed up jpegs by up to 3x in some cases */
 	image_loader_set_requested_size(tl->il, tl->max_w, tl->max_h);
@@ -321,6 +325,20 @@ void thumb_loader_set_cache(ThumbLoader *tl, gboolean enable_cache, gboolean loc
 	tl->cache_enable = enable_cache;
 }
 
+void thumb_loader_set_priority_class(ThumbLoader *tl, ImageLoaderPriorityClass priority_class)
+{
+	if (!tl) return;
+
+	if (tl->standard_loader)
+		{
+		thumb_loader_std_set_priority_class((ThumbLoaderStd *)tl, priority_class);
+		return;
+		}
+
+	tl->priority_class = priority_class;
+	if (tl->il) image_loader_set_priority_class(tl->il, priority_class);
+}
+
 
 gboolean thumb_loader_start(ThumbLoader *tl, FileData *fd)
 {
@@ -464,6 +482,7 @@ ThumbLoader *thumb_loader_new(gint width, gint height)
 	tl->percent_done = 0.0;
 	tl->max_w = width;
 	tl->max_h = height;
+	tl->priority_class = IMAGE_LOADER_PRIORITY_THUMB_VISIBLE;
 
 	return tl;
 }
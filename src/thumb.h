@@ -30,6 +30,7 @@ void thumb_loader_set_callbacks(ThumbLoader *tl,
 				ThumbLoaderFunc func_progress,
 				gpointer data);
 void thumb_loader_set_cache(ThumbLoader *tl, gboolean enable_cache, gboolean local, gboolean retry_failed);
+void thumb_loader_set_priority_class(ThumbLoader *tl, ImageLoaderPriorityClass priority_class);
 
 gboolean thumb_loader_start(ThumbLoader *tl, FileData *fd);
 void thumb_loader_free(ThumbLoader *tl);
@@ -89,6 +89,7 @@ ThumbLoaderStd *thumb_loader_std_new(gint width, gint height)
 	tl->requested_width = width;
 	tl->requested_height = height;
 	tl->cache_enable = options->thumbnails.enable_caching;
+	tl->priority_class = IMAGE_LOADER_PRIORITY_THUMB_VISIBLE;
 
 	return tl;
 }
@@ -575,8 +576,12 @@ static void thumb_loader_std_done_cb(ImageLoader *il, gpointer data)
 
 	if (tl->fd)
 		{
+		TRACE_BEGIN(trace_start);
+
 		if (tl->fd->thumb_pixbuf) g_object_unref(tl->fd->thumb_pixbuf);
 		tl->fd->thumb_pixbuf = thumb_loader_std_finish(tl, pixbuf, image_loader_get_shrunk(il));
+
+		TRACE_END(trace_start, "thumb_loader_std_finish", tl->fd->path);
 		}
 
 	if (tl->func_done) tl->func_done(tl, tl->data);
@@ -616,6 +621,7 @@ static gboolean thumb_loader_std_setup(ThumbLoaderStd *tl, FileData *fd)
 {
 	tl->il = image_loader_new(fd);
 	image_loader_set_priority(tl->il, G_PRIORITY_LOW);
+	image_loader_set_priority_class(tl->il, tl->priority_class);
 
 	/* this will speed up jpegs by up to 3x in some cases */
 	if (tl->requested_width <= THUMB_SIZE_NORMAL &&
@@ -658,6 +664,14 @@ void thumb_loader_std_set_cache(ThumbLoaderStd *tl, gboolean enable_cache, gbool
 	tl->cache_retry = retry_failed;
 }
 
+void thumb_loader_std_set_priority_class(ThumbLoaderStd *tl, ImageLoaderPriorityClass priority_class)
+{
+	if (!tl) return;
+
+	tl->priority_class = priority_class;
+	if (tl->il) image_loader_set_priority_class(tl->il, priority_class);
+}
+
 gboolean thumb_loader_std_start(ThumbLoaderStd *tl, FileData *fd)
 {
 	static gchar *thumb_cache = NULL;
@@ -927,6 +941,104 @@ static void thumb_std_maint_remove_one(const gchar *source, const gchar *uri, gb
 	g_free(thumb_path);
 }
 
+/*
+ * Reads the URI and MTime markers of a thumbnail by walking the png chunks,
+ * without decoding the image. The markers are written before the image data,
+ * so only the first few hundred bytes of the file are read.
+ */
+gboolean thumb_std_read_markers(const gchar *path, gchar **uri, gchar **mtime_str)
+{
+	static const guchar png_signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+	guchar head[8];
+	guint32 length;
+	gboolean ret = FALSE;
+	FILE *f;
+
+	*uri = NULL;
+	*mtime_str = NULL;
+
+	f = fopen(path, "rb");
+	if (!f) return FALSE;
+
+	if (fread(head, 1, 8, f) != 8 || memcmp(head, png_signature, 8) != 0)
+		{
+		fclose(f);
+		return FALSE;
+		}
+
+	while (fread(head, 1, 8, f) == 8)
+		{
+		memcpy(&length, head, 4);
+		length = GUINT32_FROM_BE(length);
+
+		if (memcmp(head + 4, "IDAT", 4) == 0 || memcmp(head + 4, "IEND", 4) == 0)
+			{
+			ret = TRUE;
+			break;
+			}
+
+		if ((memcmp(head + 4, "tEXt", 4) == 0 || memcmp(head + 4, "iTXt", 4) == 0) && length < 65536)
+			{
+			gchar *data;
+			gchar *value;
+			gchar *end;
+
+			data = g_malloc(length + 1);
+			if (fread(data, 1, length, f) != length)
+				{
+				g_free(data);
+				break;
+				}
+			data[length] = '\0';
+			end = data + length;
+
+			value = data + strlen(data) + 1;
+			if (head[4] == 'i' && value + 2 <= end && value[0] == 0)
+				{
+				/* uncompressed international text: skip language and translated keyword */
+				value += 2;
+				if (value < end) value += strlen(value) + 1;
+				if (value < end) value += strlen(value) + 1;
+				}
+			else if (head[4] == 'i')
+				{
+				value = end;
+				}
+
+			if (value < end)
+				{
+				if (!*uri && strcmp(data, THUMB_MARKER_URI + strlen("tEXt::")) == 0)
+					{
+					*uri = g_strdup(value);
+					}
+				else if (!*mtime_str && strcmp(data, THUMB_MARKER_MTIME + strlen("tEXt::")) == 0)
+					{
+					*mtime_str = g_strdup(value);
+					}
+				}
+			g_free(data);
+
+			if (fseek(f, 4, SEEK_CUR) != 0) break;
+			}
+		else if (fseek(f, (long)length + 4, SEEK_CUR) != 0)
+			{
+			break;
+			}
+		}
+
+	fclose(f);
+
+	if (!ret)
+		{
+		g_free(*uri);
+		g_free(*mtime_str);
+		*uri = NULL;
+		*mtime_str = NULL;
+		}
+
+	return ret;
+}
+
 /* this also removes local thumbnails (the source is gone so it makes sense) */
 void thumb_std_maint_removed(const gchar *source)
 {
@@ -65,6 +65,8 @@ struct _ThumbLoaderStd
 
 	gdouble progress;
 
+	ImageLoaderPriorityClass priority_class;
+
 	ThumbLoaderStdFunc func_done;
 	ThumbLoaderStdFunc func_error;
 	ThumbLoaderStdFunc func_progress;
@@ -80,6 +82,7 @@ void thumb_loader_std_set_callbacks(ThumbLoaderStd *tl,
 				    ThumbLoaderStdFunc func_progress,
 				    gpointer data);
 void thumb_loader_std_set_cache(ThumbLoaderStd *tl, gboolean enable_cache, gboolean local, gboolean retry_failed);
+void thumb_loader_std_set_priority_class(ThumbLoaderStd *tl, ImageLoaderPriorityClass priority_class);
 gboolean thumb_loader_std_start(ThumbLoaderStd *tl, FileData *fd);
 void thumb_loader_std_free(ThumbLoaderStd *tl);
 
@@ -98,6 +101,14 @@ ThumbLoaderStd *thumb_loader_std_thumb_file_validate(const gchar *thumb_path, gi
 void thumb_loader_std_thumb_file_validate_cancel(ThumbLoaderStd *tl);
 
 
+/**
+ * \headerfile thumb_std_read_markers
+ * reads the source uri and mtime stored in a thumbnail file (locale encoded path)
+ * without decoding it, safe to call from any thread.
+ * returns FALSE if the file is not a complete png, markers not present are NULL
+ */
+gboolean thumb_std_read_markers(const gchar *path, gchar **uri, gchar **mtime_str);
+
 void thumb_std_maint_removed(const gchar *source);
 void thumb_std_maint_moved(const gchar *source, const gchar *dest);
 
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Timing spans for the load, decode, render and thumbnail stages.
+ *
+ * Each thread records into its own ring buffer, the buffers are only
+ * walked when the trace is saved in the Chrome trace event format
+ * (chrome://tracing, Perfetto). While tracing is off a span costs one
+ * integer test.
+ */
+
+#include "main.h"
+#include "trace.h"
+
+#include "misc.h"
+#include "secure_save.h"
+
+#define TRACE_DETAIL_SIZE 64
+
+typedef struct _TraceEvent TraceEvent;
+struct _TraceEvent {
+	const gchar *name;
+	gint64 start;
+	gint64 duration;
+	gchar detail[TRACE_DETAIL_SIZE];
+};
+
+typedef struct _TraceBuffer TraceBuffer;
+struct _TraceBuffer {
+	GMutex lock;	/**< only contended while saving */
+	gint tid;
+	guint next;	/**< slot to write next */
+	guint count;
+	gboolean unused;	/**< its thread exited, the next new thread takes it over */
+	TraceEvent events[TRACE_BUFFER_SIZE];
+};
+
+gint trace_enabled = FALSE;
+
+static GMutex trace_buffers_lock;
+static GList *trace_buffers = NULL;	/**< TraceBuffer, never freed */
+
+static void trace_buffer_release(gpointer data);
+static GPrivate trace_buffer_key = G_PRIVATE_INIT(trace_buffer_release);
+
+
+/* buffers stay valid after their thread exits, so that the spans of
+ * finished pool threads can still be saved, and are reused by new threads
+ * so that their number stays at the most threads running at once */
+static void trace_buffer_release(gpointer data)
+{
+	TraceBuffer *tb = data;
+
+	g_mutex_lock(&trace_buffers_lock);
+	tb->unused = TRUE;
+	g_mutex_unlock(&trace_buffers_lock);
+}
+
+static TraceBuffer *trace_buffer_get(void)
+{
+	TraceBuffer *tb = g_private_get(&trace_buffer_key);
+	GList *work;
+
+	if (!tb)
+		{
+		g_mutex_lock(&trace_buffers_lock);
+		for (work = trace_buffers; work; work = work->next)
+			{
+			TraceBuffer *old = work->data;
+
+			if (old->unused)
+				{
+				old->unused = FALSE;
+				tb = old;
+				break;
+				}
+			}
+
+		if (!tb)
+			{
+			tb = g_new0(TraceBuffer, 1);
+			g_mutex_init(&tb->lock);
+			tb->tid = g_list_length(trace_buffers) + 1;
+			trace_buffers = g_list_append(trace_buffers, tb);
+			}
+		g_mutex_unlock(&trace_buffers_lock);
+
+		g_private_set(&trace_buffer_key, tb);
+		}
+
+	return tb;
+}
+
+/**
+ * @brief Records a span from start until now
+ */
+void trace_span(const gchar *name, const gchar *detail, gint64 start)
+{
+	TraceBuffer *tb;
+	TraceEvent *ev;
+	gint64 end = g_get_monotonic_time();
+
+	if (!g_atomic_int_get(&trace_enabled) || !start) return;
+
+	tb = trace_buffer_get();
+
+	g_mutex_lock(&tb->lock);
+	ev = &tb->events[tb->next];
+	ev->name = name;
+	ev->start = start;
+	ev->duration = end - start;
+	if (detail)
+		{
+		gsize len = strlen(detail);
+
+		/* the end of a path is the interesting part */
+		if (len >= TRACE_DETAIL_SIZE)
+			{
+			detail += len - (TRACE_DETAIL_SIZE - 1);
+			/* do not start within a UTF-8 sequence */
+			if ((*detail & 0xc0) == 0x80) detail = g_utf8_find_next_char(detail, NULL);
+			}
+		g_strlcpy(ev->detail, detail, TRACE_DETAIL_SIZE);
+		}
+	else
+		{
+		ev->detail[0] = '\0';
+		}
+
+	tb->next = (tb->next + 1) % TRACE_BUFFER_SIZE;
+	if (tb->count < TRACE_BUFFER_SIZE) tb->count++;
+	g_mutex_unlock(&tb->lock);
+}
+
+void trace_set_enabled(gboolean enabled)
+{
+	DEBUG_1("tracing %s", enabled ? "enabled" : "disabled");
+	g_atomic_int_set(&trace_enabled, enabled ? TRUE : FALSE);
+}
+
+void trace_clear(void)
+{
+	GList *work;
+
+	g_mutex_lock(&trace_buffers_lock);
+	for (work = trace_buffers; work; work = work->next)
+		{
+		TraceBuffer *tb = work->data;
+
+		g_mutex_lock(&tb->lock);
+		tb->next = 0;
+		tb->count = 0;
+		g_mutex_unlock(&tb->lock);
+		}
+	g_mutex_unlock(&trace_buffers_lock);
+}
+
+/**
+ * @brief Writes the recorded spans as Chrome trace JSON
+ */
+gboolean trace_save(const gchar *path)
+{
+	SecureSaveInfo *ssi;
+	GString *out;
+	GList *work;
+	gboolean first = TRUE;
+	gchar *pathl;
+	gint count = 0;
+
+	out = g_string_new("{\"traceEvents\":[\n");
+
+	g_mutex_lock(&trace_buffers_lock);
+	for (work = trace_buffers; work; work = work->next)
+		{
+		TraceBuffer *tb = work->data;
+		guint i;
+
+		g_mutex_lock(&tb->lock);
+		for (i = 0; i < tb->count; i++)
+			{
+			TraceEvent *ev = &tb->events[(tb->next + TRACE_BUFFER_SIZE - tb->count + i) % TRACE_BUFFER_SIZE];
+
+			if (!first) g_string_append(out, ",\n");
+			first = FALSE;
+
+			g_string_append(out, "{\"name\":");
+			json_append_string(out, ev->name);
+			g_string_append_printf(out, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+					       tb->tid, ev->start, ev->duration);
+			if (ev->detail[0])
+				{
+				g_string_append(out, ",\"args\":{\"detail\":");
+				json_append_string(out, ev->detail);
+				g_string_append_c(out, '}');
+				}
+			g_string_append_c(out, '}');
+			count++;
+			}
+		g_mutex_unlock(&tb->lock);
+		}
+	g_mutex_unlock(&trace_buffers_lock);
+
+	g_string_append(out, "\n]}\n");
+
+	pathl = path_from_utf8(path);
+	ssi = secure_open(pathl);
+	g_free(pathl);
+	if (!ssi)
+		{
+		log_printf(_("error saving trace file: %s\n"), path);
+		g_string_free(out, TRUE);
+		return FALSE;
+		}
+
+	secure_fputs(ssi, out->str);
+	g_string_free(out, TRUE);
+
+	if (secure_close(ssi))
+		{
+		log_printf(_("error saving trace file: %s\nerror: %s\n"), path, secsave_strerror(secsave_errno));
+		return FALSE;
+		}
+
+	DEBUG_1("%d trace spans saved to %s", count, path);
+	return TRUE;
+}
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2008 - 2016 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <glib.h>
+
+/* spans kept per thread, older ones are overwritten */
+#define TRACE_BUFFER_SIZE 8192
+
+extern gint trace_enabled;
+
+void trace_set_enabled(gboolean enabled);
+void trace_clear(void);
+gboolean trace_save(const gchar *path);
+
+void trace_span(const gchar *name, const gchar *detail, gint64 start);
+
+/**
+ * @brief Start time of a span, 0 when tracing is off
+ */
+#define trace_now() (g_atomic_int_get(&trace_enabled) ? g_get_monotonic_time() : 0)
+
+/**
+ * @brief Scoped spans
+ *
+ * TRACE_BEGIN(t);
+ * ...
+ * TRACE_END(t, "stage", fd->path);
+ *
+ * name must be a static string, detail is copied and may be NULL.
+ */
+#define TRACE_BEGIN(var) gint64 var = trace_now()
+#define TRACE_END(var, name, detail) do { if (var) trace_span((name), (detail), (var)); } while (0)
+
+#endif
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -276,6 +276,16 @@ typedef enum {
 	STEREO_PIXBUF_NONE     = 3
 } StereoPixbufData;
 
+/* order of the image loader queue, most urgent first */
+typedef enum {
+	IMAGE_LOADER_PRIORITY_VIEW = 0,		/**< the image shown in a window */
+	IMAGE_LOADER_PRIORITY_READ_AHEAD,	/**< next image of a view or slideshow */
+	IMAGE_LOADER_PRIORITY_THUMB_VISIBLE,	/**< thumbnail on screen */
+	IMAGE_LOADER_PRIORITY_THUMB_BACKGROUND,	/**< thumbnail scrolled out of view */
+	IMAGE_LOADER_PRIORITY_BATCH,		/**< duplicate search, find, cache maintenance */
+	IMAGE_LOADER_PRIORITY_COUNT
+} ImageLoaderPriorityClass;
+
 typedef enum {
 	BAR_SORT_MODE_FOLDER = 0,
 	BAR_SORT_MODE_COLLECTION,
@@ -305,6 +315,7 @@ typedef enum {
 } SelectionType;
 
 typedef struct _ImageLoader ImageLoader;
+typedef struct _ImageLoadProbeList ImageLoadProbeList;
 typedef struct _ThumbLoader ThumbLoader;
 
 typedef struct _AnimationData AnimationData;
@@ -336,6 +347,7 @@ typedef struct _FullScreenData FullScreenData;
 typedef struct _PixmapFolders PixmapFolders;
 typedef struct _Histogram Histogram;
 typedef struct _HistMap HistMap;
+typedef struct _PageCache PageCache;
 
 typedef struct _SecureSaveInfo SecureSaveInfo;
 
@@ -381,6 +393,8 @@ struct _ThumbLoader
 	gint max_w;
 	gint max_h;
 
+	ImageLoaderPriorityClass priority_class;
+
 	ThumbLoaderFunc func_done;
 	ThumbLoaderFunc func_error;
 	ThumbLoaderFunc func_progress;
@@ -395,14 +409,25 @@ struct _AnimationData
 	ImageWindow *iw;
 	LayoutWindow *lw;
 	GdkPixbufAnimation *gpa;
-	GdkPixbufAnimationIter *iter;
-	GdkPixbuf *gpb;
 	FileData *data_adr;
-	guint delay;
-	gboolean valid;
+	gboolean loading;	/**< gpa is being read, the read callback frees the data when cancelled */
 	GCancellable *cancellable;
 	GFile *in_file;
 	GFileInputStream *gfstream;
+
+	GThread *thread;	/**< decodes and scales frames ahead of display */
+	GMutex lock;		/**< protects frames, scale and stop */
+	GCond cond;
+	GQueue *frames;		/**< frames waiting to be shown, at most ring_size */
+	guint ring_size;
+	gdouble scale;		/**< display scale, frames carry a copy reduced to it */
+	gboolean stop;		/**< set to end the decoder, and by the decoder when it is done */
+
+	guint timeout_id;	/**< event source id */
+	gint64 due;		/**< monotonic time at which the shown frame ends */
+	guint frames_shown;
+	guint frames_dropped;	/**< skipped to keep up with the frame times */
+	guint frames_late;	/**< not decoded in time */
 };
 
 struct _CollectInfo
@@ -448,6 +473,9 @@ struct _CollectTable
 
 	CollectionData *cd;
 
+	GPtrArray *index;	/**< cd->list by position, cells are resolved as index[row * columns + column] */
+	GHashTable *positions;	/**< CollectInfo -> position in index + 1 */
+
 	GList *selection;
 	CollectInfo *prev_selection;
 
@@ -645,6 +673,7 @@ struct _FileData {
 
 	gint page_num;
 	gint page_total;
+	PageCache *page_cache; /**< open document and rendered pages of multi-page files */
 };
 
 struct _LayoutOptions
@@ -991,6 +1020,9 @@ struct _ViewFileInfoIcon
 	gint columns;
 	gint rows;
 
+	GPtrArray *index;	/**< vf->list by position, cells are resolved as index[row * columns + column] */
+	GHashTable *positions;	/**< FileData -> position in index + 1 */
+
 	GList *selection;
 	FileData *prev_selection;
 
@@ -1031,6 +1063,10 @@ struct _SlideShowData
 	gpointer stop_data;
 
 	gboolean paused;
+
+	GList *decode_list;      /**< upcoming images being decoded ahead, SlideShowDecode */
+	guint slides_shown;
+	guint deadline_misses;   /**< timed advances to a slide that was not decoded yet */
 };
 
 struct _FullScreenData
@@ -302,6 +302,7 @@ struct _UtilityData {
 
 	guint update_idle_id; /* event source id */
 	guint perform_idle_id; /* event source id */
+	FileDataNotifyBatch *notify_batch; /* notifications sent by the operation itself are collected until it ends, see file_data_notify_batch_begin */
 
 	gboolean with_sidecars; /* operate on grouped or single files; TRUE = use file_data_sc_, FALSE = use file_data_ functions */
 
@@ -423,12 +424,35 @@ static UtilityData *file_util_data_new(UtilityType type)
 	return ud;
 }
 
+static void file_util_notify_batch_begin(UtilityData *ud)
+{
+	if (ud->notify_batch)
+		file_data_notify_batch_resume(ud->notify_batch);
+	else
+		ud->notify_batch = file_data_notify_batch_begin();
+}
+
+/* other code may run until the next step, its notifications are not held back */
+static void file_util_notify_batch_suspend(UtilityData *ud)
+{
+	if (ud->notify_batch) file_data_notify_batch_suspend(ud->notify_batch);
+}
+
+static void file_util_notify_batch_end(UtilityData *ud)
+{
+	if (!ud->notify_batch) return;
+
+	file_data_notify_batch_end(ud->notify_batch);
+	ud->notify_batch = NULL;
+}
+
 static void file_util_data_free(UtilityData *ud)
 {
 	if (!ud) return;
 
 	if (ud->update_idle_id) g_source_remove(ud->update_idle_id);
 	if (ud->perform_idle_id) g_source_remove(ud->perform_idle_id);
+	file_util_notify_batch_end(ud);
 
 	file_data_unref(ud->dir_fd);
 	filelist_free(ud->content_list);
@@ -580,6 +604,9 @@ static gint file_util_perform_ci_cb(gpointer resume_data, EditorFlags flags, GLi
 
 	ud->resume_data = resume_data;
 
+	/* the files are processed one at a time, listeners get all changes at the end */
+	file_util_notify_batch_begin(ud);
+
 	if (EDITOR_ERRORS_BUT_SKIPPED(flags))
 		{
 		GString *msg = g_string_new(editor_get_error_str(flags));
@@ -644,6 +671,12 @@ static gint file_util_perform_ci_cb(gpointer resume_data, EditorFlags flags, GLi
 		file_data_unref(fd);
 		}
 
+	/* let the views catch up while a dialog waits for the user */
+	if (!resume_data || ret == EDITOR_CB_SUSPEND)
+		file_util_notify_batch_end(ud);
+	else
+		file_util_notify_batch_suspend(ud);
+
 	if (!resume_data) /* end of the list */
 		{
 		ud->phase = UTILITY_PHASE_DONE;
@@ -707,6 +740,8 @@ static gboolean file_util_perform_ci_internal(gpointer data)
 
 static void file_util_perform_ci_dir(UtilityData *ud, gboolean internal, gboolean ext_result)
 {
+	file_util_notify_batch_begin(ud);
+
 	switch (ud->type)
 		{
 		case UTILITY_TYPE_DELETE_LINK:
@@ -856,6 +891,9 @@ static void file_util_perform_ci_dir(UtilityData *ud, gboolean internal, gboolea
 		default:
 			g_warning("unhandled operation");
 		}
+
+	file_util_notify_batch_end(ud);
+
 	ud->phase = UTILITY_PHASE_DONE;
 	file_util_dialog_run(ud);
 }
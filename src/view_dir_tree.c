@@ -48,8 +48,51 @@ struct _PathData
 	FileData *node;
 };
 
+#define VDTREE_SCAN_THREADS 2
+#define VDTREE_SCAN_BATCH 256
+
+/* The worker only touches refcount, cancelled and path,
+ * everything else belongs to the main thread */
+struct _VdtreeScan
+{
+	gint refcount;
+	gint cancelled;
+
+	gchar *path;		/**< folder to read, in locale encoding */
+
+	ViewDir *vd;
+	NodeData *nd;
+	GtkTreeRowReference *row;
+	GHashTable *old;	/**< FileData -> GtkTreeRowReference of the rows present before the read, NULL key for the "empty" node */
+	time_t start_time;
+};
+
+typedef struct _VdtreeScanEntry VdtreeScanEntry;
+struct _VdtreeScanEntry
+{
+	gchar *path;		/**< locale encoding */
+	struct stat st;
+	gboolean accessible;	/**< the folder can be entered */
+	gboolean has_children;	/**< FALSE if the folder is known to have no subfolders */
+	gboolean is_link;
+	gchar *link;
+};
+
+typedef struct _VdtreeScanBatch VdtreeScanBatch;
+struct _VdtreeScanBatch
+{
+	VdtreeScan *scan;
+	GList *entries;
+	gboolean last;
+};
+
+static GThreadPool *vdtree_scan_pool = NULL;
+
 
 static void vdtree_row_expanded(GtkTreeView *treeview, GtkTreeIter *iter, GtkTreePath *tpath, gpointer data);
+static void vdtree_add_by_data_full(ViewDir *vd, FileData *fd, GtkTreeIter *parent, VdtreeScanEntry *entry);
+static void vdtree_populate_path_by_iter_async(ViewDir *vd, GtkTreeIter *iter);
+static void vdtree_scan_cancel(NodeData *nd);
 
 
 /*
@@ -181,6 +224,7 @@ static void vdtree_node_free(NodeData *nd)
 {
 	if (!nd) return;
 
+	vdtree_scan_cancel(nd);
 	if (nd->fd) file_data_unref(nd->fd);
 	g_free(nd);
 }
@@ -384,21 +428,57 @@ static NodeData *vdtree_find_iter_by_fd(ViewDir *vd, GtkTreeIter *parent, FileDa
 	return NULL;
 }
 
-static void vdtree_add_by_data(ViewDir *vd, FileData *fd, GtkTreeIter *parent)
+/* the "empty" node shows the expander of a row that is not populated yet */
+static void vdtree_add_empty_node(GtkTreeStore *store, GtkTreeIter *parent)
+{
+	NodeData *end;
+	GtkTreeIter empty;
+
+	end = g_new0(NodeData, 1);
+	end->fd = NULL;
+	end->expanded = TRUE;
+
+	gtk_tree_store_append(store, &empty, parent);
+	gtk_tree_store_set(store, &empty, DIR_COLUMN_POINTER, end,
+					  DIR_COLUMN_NAME, "empty", -1);
+}
+
+/**
+ * @brief Adds a row for \a fd below \a parent
+ *
+ * \a entry carries what the background read already found out about the folder,
+ * if it is NULL the file system is queried here.
+ */
+static void vdtree_add_by_data_full(ViewDir *vd, FileData *fd, GtkTreeIter *parent, VdtreeScanEntry *entry)
 {
 	GtkTreeStore *store;
 	GtkTreeIter child;
 	NodeData *nd;
 	GdkPixbuf *pixbuf;
-	NodeData *end;
-	GtkTreeIter empty;
 	gchar *link = NULL;
+	gboolean accessible;
+	gboolean is_link;
+	gboolean has_children = TRUE;
 
 	if (!fd) return;
 
-	if (access_file(fd->path, R_OK | X_OK))
+	if (entry)
 		{
-		if (islink(fd->path))
+		accessible = entry->accessible;
+		is_link = entry->is_link;
+		has_children = entry->has_children;
+		link = g_strdup(entry->link);
+		}
+	else
+		{
+		accessible = access_file(fd->path, R_OK | X_OK);
+		is_link = islink(fd->path);
+		link = is_link ? realpath(fd->path, NULL) : NULL;
+		}
+
+	if (accessible)
+		{
+		if (is_link)
 			{
 			pixbuf = vd->pf->link;
 			}
@@ -418,15 +498,6 @@ static void vdtree_add_by_data(ViewDir *vd, FileData *fd, GtkTreeIter *parent)
 	nd->expanded = FALSE;
 	nd->last_update = time(NULL);
 
-	if (islink(fd->path))
-		{
-		link = realpath(fd->path, NULL);
-		}
-	else
-		{
-		link = NULL;
-		}
-
 	store = GTK_TREE_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view)));
 	gtk_tree_store_append(store, &child, parent);
 	gtk_tree_store_set(store, &child, DIR_COLUMN_POINTER, nd,
@@ -437,13 +508,7 @@ static void vdtree_add_by_data(ViewDir *vd, FileData *fd, GtkTreeIter *parent)
 
 	/* all nodes are created with an "empty" node, so that the expander is shown
 	 * this is removed when the child is populated */
-	end = g_new0(NodeData, 1);
-	end->fd = NULL;
-	end->expanded = TRUE;
-
-	gtk_tree_store_append(store, &empty, &child);
-	gtk_tree_store_set(store, &empty, DIR_COLUMN_POINTER, end,
-					  DIR_COLUMN_NAME, "empty", -1);
+	vdtree_add_empty_node(store, &child);
 
 	if (parent)
 		{
@@ -456,7 +521,14 @@ static void vdtree_add_by_data(ViewDir *vd, FileData *fd, GtkTreeIter *parent)
 		    gtk_tree_view_row_expanded(GTK_TREE_VIEW(vd->view), tpath) &&
 		    !nd->expanded)
 			{
-			vdtree_populate_path_by_iter(vd, &child, FALSE, vd->dir_fd);
+			if (!entry)
+				{
+				vdtree_populate_path_by_iter(vd, &child, FALSE, vd->dir_fd);
+				}
+			else if (has_children)
+				{
+				vdtree_populate_path_by_iter_async(vd, &child);
+				}
 			}
 		gtk_tree_path_free(tpath);
 		}
@@ -464,24 +536,22 @@ static void vdtree_add_by_data(ViewDir *vd, FileData *fd, GtkTreeIter *parent)
 	g_free(link);
 }
 
-gboolean vdtree_populate_path_by_iter(ViewDir *vd, GtkTreeIter *iter, gboolean force, FileData *target_fd)
+static void vdtree_add_by_data(ViewDir *vd, FileData *fd, GtkTreeIter *parent)
 {
-	GtkTreeModel *store;
-	GList *list;
-	GList *work;
-	GList *old;
-	time_t current_time;
-	GtkTreeIter child;
-	NodeData *nd;
-	gboolean add_hidden = FALSE;
-	gchar *link = NULL;
+	vdtree_add_by_data_full(vd, fd, parent, NULL);
+}
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
-	gtk_tree_model_get(store, iter, DIR_COLUMN_POINTER, &nd, -1);
+typedef enum {
+	VDTREE_POPULATE_REMOVED,	/**< the folder is gone, its row was removed */
+	VDTREE_POPULATE_CURRENT,	/**< the children are up to date */
+	VDTREE_POPULATE_READ		/**< the folder has to be read */
+} VdtreePopulateState;
 
-	if (!nd) return FALSE;
+static VdtreePopulateState vdtree_populate_check(ViewDir *vd, GtkTreeIter *iter, NodeData *nd, gboolean force, gboolean add_hidden)
+{
+	GtkTreeModel *store;
 
-	current_time = time(NULL);
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
 
 	if (nd->expanded)
 		{
@@ -491,21 +561,46 @@ gboolean vdtree_populate_path_by_iter(ViewDir *vd, GtkTreeIter *iter, gboolean f
 			if (vd->drop_fd == nd->fd) vd->drop_fd = NULL;
 			gtk_tree_store_remove(GTK_TREE_STORE(store), iter);
 			vdtree_node_free(nd);
-			return FALSE;
+			return VDTREE_POPULATE_REMOVED;
 			}
-		if (!force && current_time - nd->last_update < 2)
+		if (!force && time(NULL) - nd->last_update < 2)
 			{
 			DEBUG_1("Too frequent update of %s", nd->fd->path);
-			return TRUE;
+			return VDTREE_POPULATE_CURRENT;
 			}
 		file_data_check_changed_files(nd->fd); /* make sure we have recent info */
 		}
 
+	if (nd->expanded && (!force && !add_hidden) && nd->fd->version == nd->version)
+		return VDTREE_POPULATE_CURRENT;
+
+	return VDTREE_POPULATE_READ;
+}
+
+gboolean vdtree_populate_path_by_iter(ViewDir *vd, GtkTreeIter *iter, gboolean force, FileData *target_fd)
+{
+	GtkTreeModel *store;
+	GList *list;
+	GList *work;
+	GList *old;
+	time_t current_time;
+	GtkTreeIter child;
+	NodeData *nd;
+	gboolean add_hidden = FALSE;
+	gchar *link = NULL;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
+	gtk_tree_model_get(store, iter, DIR_COLUMN_POINTER, &nd, -1);
+
+	if (!nd) return FALSE;
+
+	current_time = time(NULL);
+
 	/* when hidden files are not enabled, and the user enters a hidden path,
 	 * allow the tree to display that path by specifically inserting the hidden entries
 	 */
 	if (!options->file_filter.show_hidden_files &&
-	    target_fd &&
+	    target_fd && nd->fd &&
 	    strncmp(nd->fd->path, target_fd->path, strlen(nd->fd->path)) == 0)
 		{
 		gint n;
@@ -515,8 +610,18 @@ gboolean vdtree_populate_path_by_iter(ViewDir *vd, GtkTreeIter *iter, gboolean f
 			add_hidden = TRUE;
 		}
 
-	if (nd->expanded && (!force && !add_hidden) && nd->fd->version == nd->version)
-		return TRUE;
+	switch (vdtree_populate_check(vd, iter, nd, force, add_hidden))
+		{
+		case VDTREE_POPULATE_REMOVED:
+			return FALSE;
+		case VDTREE_POPULATE_CURRENT:
+			return TRUE;
+		case VDTREE_POPULATE_READ:
+			break;
+		}
+
+	/* the synchronous read supersedes a pending background one */
+	vdtree_scan_cancel(nd);
 
 	vdtree_busy_push(vd);
 
@@ -628,6 +733,371 @@ gboolean vdtree_populate_path_by_iter(ViewDir *vd, GtkTreeIter *iter, gboolean f
 	return TRUE;
 }
 
+/*
+ *----------------------------------------------------------------------------
+ * background read
+ *----------------------------------------------------------------------------
+ */
+
+static void vdtree_scan_unref(VdtreeScan *scan)
+{
+	if (!g_atomic_int_dec_and_test(&scan->refcount)) return;
+
+	g_free(scan->path);
+	g_free(scan);
+}
+
+static void vdtree_scan_entry_free(gpointer data)
+{
+	VdtreeScanEntry *entry = data;
+
+	g_free(entry->path);
+	free(entry->link);
+	g_free(entry);
+}
+
+static void vdtree_scan_batch_free(VdtreeScanBatch *batch)
+{
+	g_list_free_full(batch->entries, vdtree_scan_entry_free);
+	vdtree_scan_unref(batch->scan);
+	g_free(batch);
+}
+
+/* main thread, releases everything the worker must not see */
+static void vdtree_scan_finish(VdtreeScan *scan)
+{
+	g_atomic_int_set(&scan->cancelled, TRUE);
+
+	if (scan->nd->scan == scan) scan->nd->scan = NULL;
+	gtk_tree_row_reference_free(scan->row);
+	scan->row = NULL;
+	g_hash_table_destroy(scan->old);
+	scan->old = NULL;
+
+	vdtree_scan_unref(scan);
+}
+
+static void vdtree_scan_cancel(NodeData *nd)
+{
+	if (!nd->scan) return;
+
+	DEBUG_1("vdtree cancelled background read of %s", nd->scan->path);
+	vdtree_scan_finish(nd->scan);
+}
+
+/* the row present before the read for key, FALSE if there is none */
+static gboolean vdtree_scan_old_iter(VdtreeScan *scan, GtkTreeModel *store, gconstpointer key, GtkTreeIter *iter)
+{
+	GtkTreeRowReference *row;
+	GtkTreePath *tpath;
+	gboolean valid;
+
+	row = g_hash_table_lookup(scan->old, key);
+	if (!row) return FALSE;
+
+	tpath = gtk_tree_row_reference_get_path(row);
+	valid = (tpath && gtk_tree_model_get_iter(store, iter, tpath));
+	gtk_tree_path_free(tpath);
+
+	return valid;
+}
+
+static void vdtree_scan_remove_old(ViewDir *vd, VdtreeScan *scan, gconstpointer key)
+{
+	GtkTreeModel *store;
+	GtkTreeIter child;
+	NodeData *cnd;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
+	if (!vdtree_scan_old_iter(scan, store, key, &child))
+		{
+		g_hash_table_remove(scan->old, key);
+		return;
+		}
+
+	gtk_tree_model_get(store, &child, DIR_COLUMN_POINTER, &cnd, -1);
+
+	if (cnd->fd)
+		{
+		if (vd->click_fd == cnd->fd) vd->click_fd = NULL;
+		if (vd->drop_fd == cnd->fd) vd->drop_fd = NULL;
+		}
+
+	g_hash_table_remove(scan->old, key);
+	gtk_tree_store_remove(GTK_TREE_STORE(store), &child);
+	vdtree_node_free(cnd);
+}
+
+static void vdtree_scan_apply(VdtreeScanBatch *batch)
+{
+	VdtreeScan *scan = batch->scan;
+	ViewDir *vd = scan->vd;
+	NodeData *nd = scan->nd;
+	GtkTreeModel *store;
+	GtkTreePath *tpath;
+	GtkTreeIter iter;
+	GList *work;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
+	tpath = gtk_tree_row_reference_get_path(scan->row);
+	if (!tpath || !gtk_tree_model_get_iter(store, &iter, tpath))
+		{
+		gtk_tree_path_free(tpath);
+		vdtree_scan_finish(scan);
+		return;
+		}
+	gtk_tree_path_free(tpath);
+
+	/* the "empty" node only kept the expander visible while reading */
+	if (batch->entries) vdtree_scan_remove_old(vd, scan, NULL);
+
+	work = batch->entries;
+	while (work)
+		{
+		VdtreeScanEntry *entry = work->data;
+		FileData *fd;
+		GtkTreeIter child;
+		gchar *path_utf8;
+
+		work = work->next;
+
+		path_utf8 = path_to_utf8(entry->path);
+		fd = file_data_new_dir_stat(path_utf8, &entry->st);
+		g_free(path_utf8);
+
+		if (vdtree_scan_old_iter(scan, store, fd, &child))
+			{
+			NodeData *cnd;
+
+			gtk_tree_model_get(store, &child, DIR_COLUMN_POINTER, &cnd, -1);
+			gtk_tree_store_set(GTK_TREE_STORE(store), &child, DIR_COLUMN_NAME, fd->name,
+									 DIR_COLUMN_LINK, entry->link, -1);
+			g_hash_table_remove(scan->old, fd);
+
+			/* a row emptied by an earlier read gets its expander back */
+			if (!cnd->expanded && !gtk_tree_model_iter_has_child(store, &child))
+				{
+				vdtree_add_empty_node(GTK_TREE_STORE(store), &child);
+				}
+
+			if (cnd->expanded && cnd->version != fd->version)
+				{
+				vdtree_populate_path_by_iter_async(vd, &child);
+				}
+
+			cnd->version = fd->version;
+			file_data_unref(fd);
+			}
+		else
+			{
+			vdtree_add_by_data_full(vd, fd, &iter, entry);
+			}
+		}
+
+	if (!batch->last) return;
+
+	while (g_hash_table_size(scan->old) > 0)
+		{
+		GHashTableIter hash_iter;
+		gpointer key;
+
+		g_hash_table_iter_init(&hash_iter, scan->old);
+		g_hash_table_iter_next(&hash_iter, &key, NULL);
+		vdtree_scan_remove_old(vd, scan, key);
+		}
+
+	nd->expanded = TRUE;
+	nd->last_update = scan->start_time;
+
+	DEBUG_1("%s vdtree background read done: %s", get_exec_time(), scan->path);
+	vdtree_scan_finish(scan);
+}
+
+static gboolean vdtree_scan_batch_cb(gpointer data)
+{
+	VdtreeScanBatch *batch = data;
+
+	if (!g_atomic_int_get(&batch->scan->cancelled)) vdtree_scan_apply(batch);
+	vdtree_scan_batch_free(batch);
+
+	return FALSE;
+}
+
+static void vdtree_scan_push(VdtreeScan *scan, GList *entries, gboolean last)
+{
+	VdtreeScanBatch *batch;
+
+	batch = g_new0(VdtreeScanBatch, 1);
+	batch->scan = scan;
+	batch->entries = g_list_reverse(entries);
+	batch->last = last;
+	g_atomic_int_inc(&scan->refcount);
+
+	g_idle_add(vdtree_scan_batch_cb, batch);
+}
+
+/*
+ * Runs in a worker thread.
+ * A link count of 2 (just "." and the entry in the parent) leaves out
+ * symlinked subfolders, and some file systems do not count subfolders at
+ * all, so it is only a hint to look at the entries of the folder.
+ */
+static gboolean vdtree_scan_has_subdirs(const gchar *path, const struct stat *st)
+{
+#ifdef _DIRENT_HAVE_D_TYPE
+	DIR *dp;
+	struct dirent *dir;
+	gboolean found = FALSE;
+
+	if (st->st_nlink != 2) return TRUE;
+
+	dp = opendir(path);
+	if (!dp) return TRUE;
+
+	while (!found && (dir = readdir(dp)) != NULL)
+		{
+		if (dir->d_type != DT_DIR && dir->d_type != DT_LNK && dir->d_type != DT_UNKNOWN) continue;
+		found = filelist_read_dir_name_allowed(dir->d_name);
+		}
+	closedir(dp);
+
+	return found;
+#else
+	return TRUE;
+#endif
+}
+
+/*
+ * Runs in a worker thread.
+ * The dirent type skips the stat of plain files.
+ */
+static void vdtree_scan_thread(gpointer data, gpointer user_data)
+{
+	VdtreeScan *scan = data;
+	DIR *dp;
+	struct dirent *dir;
+	GList *entries = NULL;
+	gint count = 0;
+
+	dp = g_atomic_int_get(&scan->cancelled) ? NULL : opendir(scan->path);
+	if (dp)
+		{
+		while ((dir = readdir(dp)) != NULL && !g_atomic_int_get(&scan->cancelled))
+			{
+			VdtreeScanEntry *entry;
+			gchar *filepath;
+			gboolean is_link = FALSE;
+			gboolean check_link = TRUE;
+			struct stat st;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+			if (dir->d_type != DT_DIR && dir->d_type != DT_LNK && dir->d_type != DT_UNKNOWN) continue;
+			is_link = (dir->d_type == DT_LNK);
+			check_link = (dir->d_type == DT_UNKNOWN);
+#endif
+			if (!filelist_read_dir_name_allowed(dir->d_name)) continue;
+
+			filepath = g_build_filename(scan->path, dir->d_name, NULL);
+			if (stat(filepath, &st) < 0 || !S_ISDIR(st.st_mode))
+				{
+				g_free(filepath);
+				continue;
+				}
+
+			if (check_link)
+				{
+				struct stat lst;
+
+				is_link = (lstat(filepath, &lst) == 0 && S_ISLNK(lst.st_mode));
+				}
+
+			entry = g_new0(VdtreeScanEntry, 1);
+			entry->path = filepath;
+			entry->st = st;
+			entry->accessible = (access(filepath, R_OK | X_OK) == 0);
+			entry->has_children = (!options->tree_descend_subdirs || vdtree_scan_has_subdirs(filepath, &st));
+			entry->is_link = is_link;
+			entry->link = is_link ? realpath(filepath, NULL) : NULL;
+
+			entries = g_list_prepend(entries, entry);
+			count++;
+
+			if (count >= VDTREE_SCAN_BATCH)
+				{
+				vdtree_scan_push(scan, entries, FALSE);
+				entries = NULL;
+				count = 0;
+				}
+			}
+		closedir(dp);
+		}
+
+	vdtree_scan_push(scan, entries, TRUE);
+	vdtree_scan_unref(scan);
+}
+
+static void vdtree_scan_start(ViewDir *vd, GtkTreeIter *iter, NodeData *nd)
+{
+	GtkTreeModel *store;
+	GtkTreePath *tpath;
+	GtkTreeIter child;
+	VdtreeScan *scan;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
+
+	scan = g_new0(VdtreeScan, 1);
+	scan->refcount = 2; /* the worker and the main thread */
+	scan->path = path_from_utf8(nd->fd->path);
+	scan->vd = vd;
+	scan->nd = nd;
+	scan->start_time = time(NULL);
+
+	tpath = gtk_tree_model_get_path(store, iter);
+	scan->row = gtk_tree_row_reference_new(store, tpath);
+	gtk_tree_path_free(tpath);
+
+	scan->old = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)gtk_tree_row_reference_free);
+	if (gtk_tree_model_iter_children(store, &child, iter))
+		{
+		do	{
+			NodeData *cnd;
+
+			gtk_tree_model_get(store, &child, DIR_COLUMN_POINTER, &cnd, -1);
+			tpath = gtk_tree_model_get_path(store, &child);
+			g_hash_table_insert(scan->old, cnd->fd, gtk_tree_row_reference_new(store, tpath));
+			gtk_tree_path_free(tpath);
+			} while (gtk_tree_model_iter_next(store, &child));
+		}
+
+	nd->scan = scan;
+
+	if (!vdtree_scan_pool)
+		{
+		vdtree_scan_pool = g_thread_pool_new(vdtree_scan_thread, NULL, VDTREE_SCAN_THREADS, FALSE, NULL);
+		}
+	g_thread_pool_push(vdtree_scan_pool, scan, NULL);
+}
+
+/**
+ * @brief Like vdtree_populate_path_by_iter(), but reads the folder in a worker thread
+ *
+ * The rows are added in batches as the read progresses, the "empty" node keeps
+ * the expander until the first batch arrives.
+ */
+static void vdtree_populate_path_by_iter_async(ViewDir *vd, GtkTreeIter *iter)
+{
+	GtkTreeModel *store;
+	NodeData *nd;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vd->view));
+	gtk_tree_model_get(store, iter, DIR_COLUMN_POINTER, &nd, -1);
+
+	if (!nd || nd->scan) return;
+	if (vdtree_populate_check(vd, iter, nd, FALSE, FALSE) != VDTREE_POPULATE_READ) return;
+
+	vdtree_scan_start(vd, iter, nd);
+}
+
 FileData *vdtree_populate_path(ViewDir *vd, FileData *target_fd, gboolean expand, gboolean force)
 {
 	GList *list;
@@ -830,7 +1300,7 @@ gboolean vdtree_press_key_cb(GtkWidget *widget, GdkEventKey *event, gpointer dat
 		case GDK_KEY_KP_Add:
 			if (fd)
 				{
-				vdtree_populate_path_by_iter(vd, &iter, FALSE, vd->dir_fd);
+				vdtree_populate_path_by_iter_async(vd, &iter);
 
 				if (islink(fd->path))
 					{
@@ -902,7 +1372,7 @@ gboolean vdtree_press_cb(GtkWidget *widget, GdkEventButton *bevent, gpointer dat
 			    !left_of_expander &&
 			    !gtk_tree_view_row_expanded(GTK_TREE_VIEW(vd->view), tpath))
 				{
-				vdtree_populate_path_by_iter(vd, &iter, FALSE, vd->dir_fd);
+				vdtree_populate_path_by_iter_async(vd, &iter);
 
 				fd = (nd) ? nd->fd : NULL;
 				if (fd && islink(fd->path))
@@ -944,7 +1414,7 @@ static void vdtree_row_expanded(GtkTreeView *treeview, GtkTreeIter *iter, GtkTre
 
 	gtk_tree_view_set_tooltip_column(treeview, DIR_COLUMN_LINK);
 
-	vdtree_populate_path_by_iter(vd, iter, FALSE, NULL);
+	vdtree_populate_path_by_iter_async(vd, iter);
 	store = gtk_tree_view_get_model(GTK_TREE_VIEW(treeview));
 
 	gtk_tree_model_get_iter(store, iter, tpath);
@@ -968,7 +1438,7 @@ static void vdtree_row_collapsed(GtkTreeView *treeview, GtkTreeIter *iter, GtkTr
 	NodeData *nd = NULL;
 	FileData *fd;
 
-	vdtree_populate_path_by_iter(vd, iter, FALSE, NULL);
+	vdtree_populate_path_by_iter_async(vd, iter);
 	store = gtk_tree_view_get_model(GTK_TREE_VIEW(treeview));
 
 	gtk_tree_model_get_iter(store, iter, tpath);
@@ -22,6 +22,8 @@
 #ifndef VIEW_DIR_TREE_H
 #define VIEW_DIR_TREE_H
 
+typedef struct _VdtreeScan VdtreeScan;
+
 typedef struct _NodeData NodeData;
 struct _NodeData
 {
@@ -29,6 +31,7 @@ struct _NodeData
 	gboolean expanded;
 	time_t last_update;
 	gint version;
+	VdtreeScan *scan; /**< background read of the children in progress, or NULL */
 };
 
 ViewDir *vdtree_new(ViewDir *vd, FileData *dir_fd);
@@ -25,6 +25,7 @@
 #include "collect.h"
 #include "collect-table.h"
 #include "editors.h"
+#include "filefilter.h"
 #include "history_list.h"
 #include "layout.h"
 #include "menu.h"
@@ -1300,6 +1301,7 @@ static void vf_thumb_done_cb(ThumbLoader *tl, gpointer data)
 static gboolean vf_thumb_next(ViewFile *vf)
 {
 	FileData *fd = NULL;
+	gboolean visible = FALSE;
 
 	if (!gtk_widget_get_realized(vf->listview))
 		{
@@ -1309,8 +1311,8 @@ static gboolean vf_thumb_next(ViewFile *vf)
 
 	switch (vf->type)
 	{
-	case FILEVIEW_LIST: fd = vflist_thumb_next_fd(vf); break;
-	case FILEVIEW_ICON: fd = vficon_thumb_next_fd(vf); break;
+	case FILEVIEW_LIST: fd = vflist_thumb_next_fd(vf, &visible); break;
+	case FILEVIEW_ICON: fd = vficon_thumb_next_fd(vf, &visible); break;
 	}
 
 	if (!fd)
@@ -1330,6 +1332,7 @@ static gboolean vf_thumb_next(ViewFile *vf)
 				   vf_thumb_error_cb,
 				   NULL,
 				   vf);
+	if (!visible) thumb_loader_set_priority_class(vf->thumbs_loader, IMAGE_LOADER_PRIORITY_THUMB_BACKGROUND);
 
 	if (!thumb_loader_start(vf->thumbs_loader, fd))
 		{
@@ -1618,48 +1621,297 @@ void vf_refresh_idle(ViewFile *vf)
 		}
 }
 
-void vf_notify_cb(FileData *fd, NotifyType type, gpointer data)
+/**
+ * @brief Checks that \a path is directly inside the folder shown by \a vf, without allocating
+ */
+static gboolean vf_notify_path_in_dir(ViewFile *vf, const gchar *path)
 {
-	ViewFile *vf = data;
-	gboolean refresh;
+	const gchar *dir = vf->dir_fd->path;
+	const gchar *name;
+	gsize len = strlen(dir);
+
+	if (!path || strncmp(path, dir, len) != 0) return FALSE;
 
+	name = path + len;
+	if (len == 0 || dir[len - 1] != G_DIR_SEPARATOR)
+		{
+		if (name[0] != G_DIR_SEPARATOR) return FALSE;
+		name++;
+		}
+
+	return (name[0] != '\0' && !strchr(name, G_DIR_SEPARATOR));
+}
+
+static NotifyType vf_notify_interested(ViewFile *vf)
+{
 	NotifyType interested = NOTIFY_CHANGE | NOTIFY_REREAD | NOTIFY_GROUPING;
 	if (vf->marks_enabled) interested |= NOTIFY_MARKS | NOTIFY_METADATA;
 	/* FIXME: NOTIFY_METADATA should be checked by the keyword-to-mark functions and converted to NOTIFY_MARKS only if there was a change */
 
-	if (!(type & interested) || vf->refresh_idle_id || !vf->dir_fd) return;
+	return interested;
+}
+
+void vf_notify_cb(FileData *fd, NotifyType type, gpointer data)
+{
+	ViewFile *vf = data;
+	gboolean refresh;
+
+	if (!(type & vf_notify_interested(vf)) || vf->refresh_idle_id || !vf->dir_fd) return;
 
-	refresh = (fd == vf->dir_fd);
+	refresh = (fd == vf->dir_fd) || vf_notify_path_in_dir(vf, fd->path);
 
-	if (!refresh)
+	if (!refresh && (type & NOTIFY_CHANGE) && fd->change)
 		{
-		gchar *base = remove_level_from_path(fd->path);
-		refresh = (g_strcmp0(base, vf->dir_fd->path) == 0);
-		g_free(base);
+		refresh = vf_notify_path_in_dir(vf, fd->change->dest) ||
+			  vf_notify_path_in_dir(vf, fd->change->source);
 		}
 
-	if ((type & NOTIFY_CHANGE) && fd->change)
+	if (refresh)
+		{
+		DEBUG_1("Notify vf: %s %04x", fd->path, type);
+		vf_refresh_idle(vf);
+		}
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ * batched notifications
+ *
+ * Changes collected during a file operation are applied to vf->list directly
+ * where that gives the same result as reading the folder again: files that
+ * were deleted or moved away are removed, files renamed within the folder
+ * are re-sorted, files moved in are filtered and inserted. Anything that may
+ * change sidecar grouping falls back to a full refresh.
+ *-----------------------------------------------------------------------------
+ */
+
+typedef enum {
+	VF_NOTIFY_NONE = 0,	/**< the list is not affected */
+	VF_NOTIFY_UPDATE,	/**< the file stays in the list, its position or display may change */
+	VF_NOTIFY_INSERT,	/**< the file was moved into the folder */
+	VF_NOTIFY_REMOVE,	/**< the file left the folder */
+	VF_NOTIFY_REFRESH	/**< the folder must be read again */
+} ViewFileNotifyAction;
+
+static gboolean vf_notify_name_visible(FileData *fd)
+{
+	if (!options->file_filter.show_hidden_files && fd->name[0] == '.') return FALSE;
+
+	return filter_name_exists(fd->name);
+}
+
+static ViewFileNotifyAction vf_notify_action(ViewFile *vf, FileDataNotifyChange *nc, GHashTable *listed)
+{
+	FileData *fd = nc->fd;
+	gboolean in_list = (g_hash_table_lookup(listed, fd) != NULL);
+	gboolean source_in_dir;
+	gboolean dest_in_dir;
+
+	if (fd == vf->dir_fd) return VF_NOTIFY_REFRESH;
+
+	if (!nc->change)
 		{
-		if (!refresh && fd->change->dest)
+		if (!in_list)
 			{
-			gchar *dest_base = remove_level_from_path(fd->change->dest);
-			refresh = (g_strcmp0(dest_base, vf->dir_fd->path) == 0);
-			g_free(dest_base);
+			return (vf_notify_path_in_dir(vf, fd->path) && (nc->type & NOTIFY_GROUPING)) ? VF_NOTIFY_REFRESH : VF_NOTIFY_NONE;
 			}
+		if (nc->type & NOTIFY_GROUPING) return VF_NOTIFY_REFRESH;
+		if ((nc->type & (NOTIFY_MARKS | NOTIFY_METADATA)) && vf_marks_get_filter(vf)) return VF_NOTIFY_REFRESH;
+		return VF_NOTIFY_UPDATE;
+		}
+
+	source_in_dir = vf_notify_path_in_dir(vf, nc->change->source);
+	dest_in_dir = vf_notify_path_in_dir(vf, nc->change->dest);
+
+	if (!source_in_dir && !dest_in_dir && !vf_notify_path_in_dir(vf, fd->path)) return VF_NOTIFY_NONE;
+
+	/* sidecars are shown as part of their group */
+	if (fd->parent || (nc->type & NOTIFY_GROUPING)) return VF_NOTIFY_REFRESH;
+
+	switch (nc->change->type)
+		{
+		case FILEDATA_CHANGE_DELETE:
+			return (in_list) ? VF_NOTIFY_REMOVE : VF_NOTIFY_NONE;
+		case FILEDATA_CHANGE_MOVE:
+		case FILEDATA_CHANGE_RENAME:
+			if (source_in_dir && dest_in_dir)
+				{
+				if (!in_list) return VF_NOTIFY_REFRESH;
+				return (vf_notify_name_visible(fd)) ? VF_NOTIFY_UPDATE : VF_NOTIFY_REMOVE;
+				}
+			if (source_in_dir) return (in_list) ? VF_NOTIFY_REMOVE : VF_NOTIFY_NONE;
+			if (!vf_notify_path_in_dir(vf, fd->path)) return VF_NOTIFY_REFRESH;
+			return (vf_notify_name_visible(fd)) ? VF_NOTIFY_INSERT : VF_NOTIFY_NONE;
+		case FILEDATA_CHANGE_COPY:
+			return (dest_in_dir) ? VF_NOTIFY_REFRESH : VF_NOTIFY_NONE;
+		case FILEDATA_CHANGE_UNSPECIFIED:
+		case FILEDATA_CHANGE_WRITE_METADATA:
+			break;
+		}
+
+	return VF_NOTIFY_REFRESH;
+}
+
+static void vf_notify_basename_add(GHashTable *basenames, FileData *fd, FileData *parent)
+{
+	gchar *basename = g_strndup(fd->path, fd->extension - fd->path);
+	FileData *other = g_hash_table_lookup(basenames, basename);
+
+	/* two groups with the same base name would be merged by a folder read, mark it with NULL */
+	g_hash_table_insert(basenames, basename, (other && other != parent) ? NULL : parent);
+}
+
+/**
+ * @brief Checks that no file in \a list shares a base name with a file of another group
+ */
+static gboolean vf_notify_grouping_unchanged(GList *list)
+{
+	GHashTable *basenames;
+	GList *work;
+	gboolean ret = TRUE;
 
-		if (!refresh && fd->change->source)
+	basenames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	for (work = list; work; work = work->next)
+		{
+		FileData *fd = work->data;
+		GList *work_s;
+
+		vf_notify_basename_add(basenames, fd, fd);
+		for (work_s = fd->sidecar_files; work_s; work_s = work_s->next)
 			{
-			gchar *source_base = remove_level_from_path(fd->change->source);
-			refresh = (g_strcmp0(source_base, vf->dir_fd->path) == 0);
-			g_free(source_base);
+			vf_notify_basename_add(basenames, work_s->data, fd);
 			}
 		}
 
+	for (work = list; work && ret; work = work->next)
+		{
+		FileData *fd = work->data;
+		gchar *basename;
+
+		if (!fd->sidecar_priority || fd->disable_grouping) continue;
+
+		basename = g_strndup(fd->path, fd->extension - fd->path);
+		ret = (g_hash_table_lookup(basenames, basename) == fd);
+		g_free(basename);
+		}
+
+	g_hash_table_destroy(basenames);
+
+	return ret;
+}
+
+/**
+ * @brief Filters files moved into the folder the same way as a folder read does
+ */
+static GList *vf_notify_filter_list(ViewFile *vf, GList *list)
+{
+	GRegex *file_filter;
+
+	file_filter = vf_file_filter_get_filter(vf);
+
+	list = file_data_filter_marks_list(list, vf_marks_get_filter(vf));
+	list = g_list_first(list);
+	list = file_data_filter_file_filter_list(list, file_filter);
+	list = g_list_first(list);
+	list = file_data_filter_class_list(list, vf_class_get_filter(vf));
+
+	if (file_filter) g_regex_unref(file_filter);
+
+	return list;
+}
+
+static void vf_refresh_list(ViewFile *vf, GList *list)
+{
+	switch (vf->type)
+	{
+	case FILEVIEW_LIST: vflist_refresh_list(vf, list); break;
+	case FILEVIEW_ICON: vficon_refresh_list(vf, list); break;
+	}
+}
+
+void vf_notify_batch_cb(GList *changes, gpointer data)
+{
+	ViewFile *vf = data;
+	NotifyType interested;
+	GHashTable *listed;
+	GHashTable *removed;
+	GList *inserted = NULL;
+	GList *new_list = NULL;
+	GList *work;
+	gboolean changed = FALSE;
+	gboolean refresh = FALSE;
+
+	if (vf->refresh_idle_id || !vf->dir_fd) return;
+
+	interested = vf_notify_interested(vf);
+
+	listed = g_hash_table_new(g_direct_hash, g_direct_equal);
+	for (work = vf->list; work; work = work->next)
+		{
+		g_hash_table_insert(listed, work->data, work->data);
+		}
+	removed = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	for (work = changes; work && !refresh; work = work->next)
+		{
+		FileDataNotifyChange *nc = work->data;
+
+		if (!(nc->type & interested)) continue;
+
+		switch (vf_notify_action(vf, nc, listed))
+			{
+			case VF_NOTIFY_NONE:
+				break;
+			case VF_NOTIFY_UPDATE:
+				changed = TRUE;
+				break;
+			case VF_NOTIFY_INSERT:
+				inserted = g_list_prepend(inserted, file_data_ref(nc->fd));
+				changed = TRUE;
+				break;
+			case VF_NOTIFY_REMOVE:
+				g_hash_table_insert(removed, nc->fd, nc->fd);
+				changed = TRUE;
+				break;
+			case VF_NOTIFY_REFRESH:
+				refresh = TRUE;
+				break;
+			}
+		}
+
+	if (!refresh && changed)
+		{
+		inserted = vf_notify_filter_list(vf, inserted);
+
+		for (work = vf->list; work; work = work->next)
+			{
+			FileData *fd = work->data;
+
+			if (!g_hash_table_lookup(removed, fd)) new_list = g_list_prepend(new_list, file_data_ref(fd));
+			}
+		new_list = g_list_concat(inserted, new_list);
+		inserted = NULL;
+
+		if (!vf_notify_grouping_unchanged(new_list)) refresh = TRUE;
+		}
+
 	if (refresh)
 		{
-		DEBUG_1("Notify vf: %s %04x", fd->path, type);
+		DEBUG_1("Notify vf batch: %d files, refresh", g_list_length(changes));
+		filelist_free(new_list);
 		vf_refresh_idle(vf);
 		}
+	else if (changed)
+		{
+		DEBUG_1("Notify vf batch: %d files, %d removed, list of %d", g_list_length(changes),
+			g_hash_table_size(removed), g_list_length(new_list));
+		vf_refresh_list(vf, new_list);
+		}
+
+	filelist_free(inserted);
+	g_hash_table_destroy(removed);
+	g_hash_table_destroy(listed);
 }
 
 static gboolean vf_read_metadata_in_idle_cb(gpointer data)
@@ -58,8 +58,11 @@
 
 #define VFICON_TIP_DELAY 500
 
+/* the store only holds the row number, the FileData of each cell is
+ * resolved arithmetically from VFICON(vf)->index when it is drawn
+ */
 enum {
-	FILE_COLUMN_POINTER = 0,
+	FILE_COLUMN_ROW = 0,
 	FILE_COLUMN_COUNT
 };
 
@@ -182,7 +185,7 @@ static void vficon_send_layout_select(ViewFile *vf, FileData *fd)
 		{
 		gint row;
 
-		row = g_list_index(vf->list, fd);
+		row = vficon_index_by_fd(vf, fd);
 		if (row > vficon_index_by_fd(vf, cur_fd) &&
 		    (guint) (row + 1) < vf_count(vf, NULL))
 			{
@@ -227,11 +230,59 @@ static gint vficon_get_icon_width(ViewFile *vf)
  *-------------------------------------------------------------------
  */
 
+static void vficon_index_rebuild(ViewFile *vf)
+{
+	GList *work;
+	gint n = 0;
+
+	if (!VFICON(vf)->index)
+		{
+		VFICON(vf)->index = g_ptr_array_new();
+		VFICON(vf)->positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+		}
+
+	g_ptr_array_set_size(VFICON(vf)->index, 0);
+	g_hash_table_remove_all(VFICON(vf)->positions);
+
+	for (work = vf->list; work; work = work->next)
+		{
+		g_ptr_array_add(VFICON(vf)->index, work->data);
+		g_hash_table_insert(VFICON(vf)->positions, work->data, GINT_TO_POINTER(++n));
+		}
+}
+
+static FileData *vficon_index_nth(ViewFile *vf, gint n)
+{
+	if (!VFICON(vf)->index || n < 0 || (guint)n >= VFICON(vf)->index->len) return NULL;
+
+	return g_ptr_array_index(VFICON(vf)->index, n);
+}
+
+static gint vficon_row_from_iter(ViewFile *vf, GtkTreeModel *store, GtkTreeIter *iter)
+{
+	gint row;
+
+	gtk_tree_model_get(store, iter, FILE_COLUMN_ROW, &row, -1);
+
+	return row;
+}
+
+static void vficon_row_changed(ViewFile *vf, GtkTreeIter *iter)
+{
+	GtkTreeModel *store;
+	GtkTreePath *tpath;
+
+	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
+	tpath = gtk_tree_model_get_path(store, iter);
+	gtk_tree_model_row_changed(store, tpath, iter);
+	gtk_tree_path_free(tpath);
+}
+
 static gboolean vficon_find_position(ViewFile *vf, FileData *fd, gint *row, gint *col)
 {
 	gint n;
 
-	n = g_list_index(vf->list, fd);
+	n = vficon_index_by_fd(vf, fd);
 
 	if (n < 0) return FALSE;
 
@@ -259,22 +310,16 @@ static FileData *vficon_find_data(ViewFile *vf, gint row, gint col, GtkTreeIter
 	GtkTreeModel *store;
 	GtkTreeIter p;
 
-	if (row < 0 || col < 0) return NULL;
+	if (row < 0 || col < 0 || col >= VFICON(vf)->columns) return NULL;
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
-	if (gtk_tree_model_iter_nth_child(store, &p, NULL, row))
+	if (iter)
 		{
-		GList *list;
-
-		gtk_tree_model_get(store, &p, FILE_COLUMN_POINTER, &list, -1);
-		if (!list) return NULL;
-
-		if (iter) *iter = p;
-
-		return g_list_nth_data(list, col);
+		store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
+		if (!gtk_tree_model_iter_nth_child(store, &p, NULL, row)) return NULL;
+		*iter = p;
 		}
 
-	return NULL;
+	return vficon_index_nth(vf, row * VFICON(vf)->columns + col);
 }
 
 static FileData *vficon_find_data_by_coord(ViewFile *vf, gint x, gint y, GtkTreeIter *iter)
@@ -287,21 +332,17 @@ static FileData *vficon_find_data_by_coord(ViewFile *vf, gint x, gint y, GtkTree
 		{
 		GtkTreeModel *store;
 		GtkTreeIter row;
-		GList *list;
 		gint n;
 
 		store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
 		gtk_tree_model_get_iter(store, &row, tpath);
 		gtk_tree_path_free(tpath);
 
-		gtk_tree_model_get(store, &row, FILE_COLUMN_POINTER, &list, -1);
-
 		n = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(column), "column_number"));
-		if (list)
-			{
-			if (iter) *iter = row;
-			return g_list_nth_data(list, n);
-			}
+		if (n >= VFICON(vf)->columns) return NULL;
+
+		if (iter) *iter = row;
+		return vficon_index_nth(vf, vficon_row_from_iter(vf, store, &row) * VFICON(vf)->columns + n);
 		}
 
 	return NULL;
@@ -314,19 +355,17 @@ static void vficon_mark_toggled_cb(GtkCellRendererToggle *cell, gchar *path_str,
 	GtkTreePath *path = gtk_tree_path_new_from_string(path_str);
 	GtkTreeIter row;
 	gint column;
-	GList *list;
 	guint toggled_mark;
 	FileData *fd;
 
 	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
 	if (!path || !gtk_tree_model_get_iter(store, &row, path)) return;
-
-	gtk_tree_model_get(store, &row, FILE_COLUMN_POINTER, &list, -1);
+	gtk_tree_path_free(path);
 
 	column = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(cell), "column_number"));
 	g_object_get(G_OBJECT(cell), "toggled_mark", &toggled_mark, NULL);
 
-	fd = g_list_nth_data(list, column);
+	fd = vficon_find_data(vf, vficon_row_from_iter(vf, store, &row), column, NULL);
 	if (fd)
 		{
 		file_data_set_mark(fd, toggled_mark, !file_data_get_mark(fd, toggled_mark));
@@ -593,29 +632,20 @@ void vficon_dnd_init(ViewFile *vf)
 
 static void vficon_selection_set(ViewFile *vf, FileData *fd, SelectionType value, GtkTreeIter *iter)
 {
-	GtkTreeModel *store;
-	GList *list;
-
 	if (!fd) return;
 
 	if (fd->selected == value) return;
 	fd->selected = value;
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
 	if (iter)
 		{
-		gtk_tree_model_get(store, iter, FILE_COLUMN_POINTER, &list, -1);
-		if (list) gtk_list_store_set(GTK_LIST_STORE(store), iter, FILE_COLUMN_POINTER, list, -1);
+		vficon_row_changed(vf, iter);
 		}
 	else
 		{
 		GtkTreeIter row;
 
-		if (vficon_find_iter(vf, fd, &row, NULL))
-			{
-			gtk_tree_model_get(store, &row, FILE_COLUMN_POINTER, &list, -1);
-			if (list) gtk_list_store_set(GTK_LIST_STORE(store), &row, FILE_COLUMN_POINTER, list, -1);
-			}
+		if (vficon_find_iter(vf, fd, &row, NULL)) vficon_row_changed(vf, &row);
 		}
 }
 
@@ -682,9 +712,10 @@ void vficon_select_all(ViewFile *vf)
 		FileData *fd = work->data;
 		work = work->next;
 
-		VFICON(vf)->selection = g_list_append(VFICON(vf)->selection, fd);
+		VFICON(vf)->selection = g_list_prepend(VFICON(vf)->selection, fd);
 		vficon_selection_add(vf, fd, SELECTION_SELECTED, NULL);
 		}
+	VFICON(vf)->selection = g_list_reverse(VFICON(vf)->selection);
 
 	vf_send_update(vf);
 }
@@ -785,7 +816,7 @@ static void vficon_select_region_util(ViewFile *vf, FileData *start, FileData *e
 		{
 		GList *work;
 
-		if (g_list_index(vf->list, start) > g_list_index(vf->list, end))
+		if (vficon_index_by_fd(vf, start) > vficon_index_by_fd(vf, end))
 			{
 			FileData *tmp = start;
 			start = end;
@@ -834,7 +865,7 @@ static void vficon_select_region_util(ViewFile *vf, FileData *start, FileData *e
 
 gboolean vficon_index_is_selected(ViewFile *vf, gint row)
 {
-	FileData *fd = g_list_nth_data(vf->list, row);
+	FileData *fd = vficon_index_nth(vf, row);
 
 	if (!fd) return FALSE;
 
@@ -901,7 +932,7 @@ GList *vficon_selection_get_list_by_index(ViewFile *vf)
 	work = VFICON(vf)->selection;
 	while (work)
 		{
-		list = g_list_prepend(list, GINT_TO_POINTER(g_list_index(vf->list, work->data)));
+		list = g_list_prepend(list, GINT_TO_POINTER(vficon_index_by_fd(vf, work->data)));
 		work = work->next;
 		}
 
@@ -911,7 +942,7 @@ GList *vficon_selection_get_list_by_index(ViewFile *vf)
 void vficon_select_by_fd(ViewFile *vf, FileData *fd)
 {
 	if (!fd) return;
-	if (!g_list_find(vf->list, fd)) return;
+	if (vficon_index_by_fd(vf, fd) < 0) return;
 
 	if (!(fd->selected & SELECTION_SELECTED))
 		{
@@ -933,7 +964,7 @@ void vficon_select_list(ViewFile *vf, GList *list)
 	while (work)
 		{
 		fd = work->data;
-		if (g_list_find(vf->list, fd))
+		if (vficon_index_by_fd(vf, fd) >= 0)
 			{
 			VFICON(vf)->selection = g_list_append(VFICON(vf)->selection, fd);
 			vficon_selection_add(vf, fd, SELECTION_SELECTED, NULL);
@@ -1115,7 +1146,7 @@ static void vficon_move_focus(ViewFile *vf, gint row, gint col, gboolean relativ
 
 		/* if we moved beyond the last image, go to the last image */
 
-		l = g_list_length(vf->list);
+		l = VFICON(vf)->index ? VFICON(vf)->index->len : 0;
 		if (VFICON(vf)->rows > 1) l -= (VFICON(vf)->rows - 1) * VFICON(vf)->columns;
 		if (new_col >= l) new_col = l - 1;
 		}
@@ -1128,7 +1159,7 @@ static void vficon_set_focus(ViewFile *vf, FileData *fd)
 	GtkTreeIter iter;
 	gint row, col;
 
-	if (g_list_find(vf->list, VFICON(vf)->focus_fd))
+	if (vficon_index_by_fd(vf, VFICON(vf)->focus_fd) >= 0)
 		{
 		if (fd == VFICON(vf)->focus_fd)
 			{
@@ -1506,80 +1537,39 @@ static gboolean vficon_leave_cb(GtkWidget *widget, GdkEventCrossing *event, gpoi
  *-------------------------------------------------------------------
  */
 
-static gboolean vficon_destroy_node_cb(GtkTreeModel *store, GtkTreePath *tpath, GtkTreeIter *iter, gpointer data)
-{
-	GList *list;
-
-	gtk_tree_model_get(store, iter, FILE_COLUMN_POINTER, &list, -1);
-
-	/* it seems that gtk_list_store_clear may call some callbacks
-	   that use the column. Set the pointer to NULL to be safe. */
-	gtk_list_store_set(GTK_LIST_STORE(store), iter, FILE_COLUMN_POINTER, NULL, -1);
-	g_list_free(list);
-
-	return FALSE;
-}
-
-static void vficon_clear_store(ViewFile *vf)
+/* must be called before the list or the column count is changed */
+static FileData *vficon_first_visible_fd(ViewFile *vf)
 {
-	GtkTreeModel *store;
-
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
-	gtk_tree_model_foreach(store, vficon_destroy_node_cb, NULL);
-
-	gtk_list_store_clear(GTK_LIST_STORE(store));
-}
-
-static GList *vficon_add_row(ViewFile *vf, GtkTreeIter *iter)
-{
-	GtkListStore *store;
-	GList *list = NULL;
-	gint i;
+	GtkTreePath *tpath;
+	FileData *fd;
 
-	for (i = 0; i < VFICON(vf)->columns; i++) list = g_list_prepend(list, NULL);
+	if (!gtk_widget_get_realized(vf->listview) ||
+	    !gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, NULL, NULL, NULL)) return NULL;
 
-	store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview)));
-	gtk_list_store_append(store, iter);
-	gtk_list_store_set(store, iter, FILE_COLUMN_POINTER, list, -1);
+	fd = vficon_index_nth(vf, gtk_tree_path_get_indices(tpath)[0] * VFICON(vf)->columns);
+	gtk_tree_path_free(tpath);
 
-	return list;
+	return fd;
 }
 
-static void vficon_populate(ViewFile *vf, gboolean resize, gboolean keep_position)
+static void vficon_populate(ViewFile *vf, gboolean resize, FileData *visible_fd)
 {
 	GtkTreeModel *store;
 	GtkTreePath *tpath;
-	GList *work;
-	FileData *visible_fd = NULL;
-	gint r, c;
-	gboolean valid;
+	gint rows;
+	gint r;
 	GtkTreeIter iter;
 
+	vficon_index_rebuild(vf);
 	vficon_verify_selections(vf);
 
 	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
 
-	if (keep_position && gtk_widget_get_realized(vf->listview) &&
-	    gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, NULL, NULL, NULL))
-		{
-		GtkTreeIter iter;
-		GList *list;
-
-		gtk_tree_model_get_iter(store, &iter, tpath);
-		gtk_tree_path_free(tpath);
-
-		gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
-		if (list) visible_fd = list->data;
-		}
-
-
 	if (resize)
 		{
 		gint i;
 		gint thumb_width;
 
-		vficon_clear_store(vf);
-
 		thumb_width = vficon_get_icon_width(vf);
 
 		for (i = 0; i < VFICON_MAX_COLUMNS; i++)
@@ -1606,74 +1596,44 @@ static void vficon_populate(ViewFile *vf, gboolean resize, gboolean keep_positio
 							     NULL);
 				}
 			}
-		if (gtk_widget_get_realized(vf->listview)) gtk_tree_view_columns_autosize(GTK_TREE_VIEW(vf->listview));
 		}
 
-	r = -1;
-	c = 0;
-
-	valid = gtk_tree_model_iter_children(store, &iter, NULL);
+	/* the layout is arithmetic, only the number of rows has to match */
+	rows = (VFICON(vf)->columns > 0) ? (VFICON(vf)->index->len + VFICON(vf)->columns - 1) / VFICON(vf)->columns : 0;
+	r = gtk_tree_model_iter_n_children(store, NULL);
 
-	work = vf->list;
-	while (work)
+	while (r > rows)
 		{
-		GList *list;
-		r++;
-		c = 0;
-		if (valid)
-			{
-			gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
-			gtk_list_store_set(GTK_LIST_STORE(store), &iter, FILE_COLUMN_POINTER, list, -1);
-			}
-		else
+		r--;
+		if (gtk_tree_model_iter_nth_child(store, &iter, NULL, r))
 			{
-			list = vficon_add_row(vf, &iter);
-			}
-
-		while (list)
-			{
-			FileData *fd;
-
-			if (work)
-				{
-				fd = work->data;
-				work = work->next;
-				c++;
-				}
-			else
-				{
-				fd = NULL;
-				}
-
-			list->data = fd;
-			list = list->next;
+			gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
 			}
-		if (valid) valid = gtk_tree_model_iter_next(store, &iter);
 		}
-
-	r++;
-	while (valid)
+	while (r < rows)
 		{
-		GList *list;
-
-		gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
-		valid = gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
-		g_list_free(list);
+		gtk_list_store_insert_with_values(GTK_LIST_STORE(store), &iter, r, FILE_COLUMN_ROW, r, -1);
+		r++;
 		}
 
-	VFICON(vf)->rows = r;
+	VFICON(vf)->rows = rows;
+
+	/* existing rows are not touched, so their heights have to be invalidated,
+	 * the tree view then measures the visible rows first and the rest when idle
+	 */
+	if (gtk_widget_get_realized(vf->listview)) gtk_tree_view_columns_autosize(GTK_TREE_VIEW(vf->listview));
+	gtk_widget_queue_draw(vf->listview);
 
 	if (visible_fd &&
 	    gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, NULL, NULL, NULL))
 		{
-		GtkTreeIter iter;
-		GList *list;
+		gint row;
+		gint col;
 
-		gtk_tree_model_get_iter(store, &iter, tpath);
+		r = gtk_tree_path_get_indices(tpath)[0];
 		gtk_tree_path_free(tpath);
 
-		gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
-		if (g_list_find(list, visible_fd) == NULL &&
+		if (vficon_find_position(vf, visible_fd, &row, &col) && row != r &&
 		    vficon_find_iter(vf, visible_fd, &iter, NULL))
 			{
 			tree_view_row_make_visible(GTK_TREE_VIEW(vf->listview), &iter, FALSE);
@@ -1690,6 +1650,7 @@ static void vficon_populate_at_new_size(ViewFile *vf, gint w, gint h, gboolean f
 {
 	gint new_cols;
 	gint thumb_width;
+	FileData *visible_fd;
 
 	thumb_width = vficon_get_icon_width(vf);
 
@@ -1698,9 +1659,10 @@ static void vficon_populate_at_new_size(ViewFile *vf, gint w, gint h, gboolean f
 
 	if (!force && new_cols == VFICON(vf)->columns) return;
 
+	visible_fd = (VFICON(vf)->columns > 0) ? vficon_first_visible_fd(vf) : NULL;
 	VFICON(vf)->columns = new_cols;
 
-	vficon_populate(vf, TRUE, TRUE);
+	vficon_populate(vf, TRUE, visible_fd);
 
 	DEBUG_1("col tab pop cols=%d rows=%d", VFICON(vf)->columns, VFICON(vf)->rows);
 }
@@ -1764,24 +1726,20 @@ void vficon_read_metadata_progress_count(GList *list, gint *count, gint *done)
 
 void vficon_set_thumb_fd(ViewFile *vf, FileData *fd)
 {
-	GtkTreeModel *store;
 	GtkTreeIter iter;
-	GList *list;
 
-	if (!g_list_find(vf->list, fd)) return;
 	if (!vficon_find_iter(vf, fd, &iter, NULL)) return;
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
-
-	gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
-	gtk_list_store_set(GTK_LIST_STORE(store), &iter, FILE_COLUMN_POINTER, list, -1);
+	vficon_row_changed(vf, &iter);
 }
 
 /* Returns the next fd without a loaded pixbuf, so the thumb-loader can load the pixbuf for it. */
-FileData *vficon_thumb_next_fd(ViewFile *vf)
+FileData *vficon_thumb_next_fd(ViewFile *vf, gboolean *visible)
 {
 	GtkTreePath *tpath;
 
+	*visible = TRUE;
+
 	/* First see if there are visible files that don't have a loaded thumb... */
 	if (gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, NULL, NULL, NULL))
 		{
@@ -1796,13 +1754,12 @@ FileData *vficon_thumb_next_fd(ViewFile *vf)
 
 		while (valid && tree_view_row_get_visibility(GTK_TREE_VIEW(vf->listview), &iter, FALSE) == 0)
 			{
-			GList *list;
-			gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
+			gint row = vficon_row_from_iter(vf, store, &iter);
+			gint col;
 
-			// TODO(xsdg): for loop here.
-			for (; list; list = list->next)
+			for (col = 0; col < VFICON(vf)->columns; col++)
 				{
-				FileData *fd = list->data;
+				FileData *fd = vficon_find_data(vf, row, col, NULL);
 				if (fd && !fd->thumb_pixbuf) return fd;
 				}
 
@@ -1812,6 +1769,7 @@ FileData *vficon_thumb_next_fd(ViewFile *vf)
 
 	/* Then iterate through the entire list to load all of them. */
 	GList *work;
+	*visible = FALSE;
 	for (work = vf->list; work; work = work->next)
 		{
 		FileData *fd = work->data;
@@ -1826,17 +1784,11 @@ FileData *vficon_thumb_next_fd(ViewFile *vf)
 
 void vficon_set_star_fd(ViewFile *vf, FileData *fd)
 {
-	GtkTreeModel *store;
 	GtkTreeIter iter;
-	GList *list;
 
-	if (!g_list_find(vf->list, fd)) return;
 	if (!vficon_find_iter(vf, fd, &iter, NULL)) return;
 
-	store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
-
-	gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
-	gtk_list_store_set(GTK_LIST_STORE(store), &iter, FILE_COLUMN_POINTER, list, -1);
+	vficon_row_changed(vf, &iter);
 }
 
 FileData *vficon_star_next_fd(ViewFile *vf)
@@ -1858,12 +1810,12 @@ FileData *vficon_star_next_fd(ViewFile *vf)
 
 		while (valid && tree_view_row_get_visibility(GTK_TREE_VIEW(vf->listview), &iter, FALSE) == 0)
 			{
-			GList *list;
-			gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
+			gint row = vficon_row_from_iter(vf, store, &iter);
+			gint col;
 
-			for (; list; list = list->next)
+			for (col = 0; col < VFICON(vf)->columns; col++)
 				{
-				FileData *fd = list->data;
+				FileData *fd = vficon_find_data(vf, row, col, NULL);
 				if (fd && fd->rating == STAR_RATING_NOT_READ)
 					{
 					vf->stars_filedata = fd;
@@ -1912,21 +1864,9 @@ FileData *vficon_star_next_fd(ViewFile *vf)
 
 gint vficon_index_by_fd(ViewFile *vf, FileData *in_fd)
 {
-	gint p = 0;
-	GList *work;
-
-	if (!in_fd) return -1;
-
-	work = vf->list;
-	while (work)
-		{
-		FileData *fd = work->data;
-		if (fd == in_fd) return p;
-		work = work->next;
-		p++;
-		}
+	if (!in_fd || !VFICON(vf)->positions) return -1;
 
-	return -1;
+	return GPOINTER_TO_INT(g_hash_table_lookup(VFICON(vf)->positions, in_fd)) - 1;
 }
 
 /*
@@ -1935,28 +1875,19 @@ gint vficon_index_by_fd(ViewFile *vf, FileData *in_fd)
  *-----------------------------------------------------------------------------
  */
 
-static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
+/**
+ * @brief Merges \a new_filelist into vf->list and updates the view, takes ownership of \a new_filelist
+ */
+static void vficon_refresh_list_real(ViewFile *vf, GList *new_filelist, gboolean keep_position)
 {
-	gboolean ret = TRUE;
 	GList *work, *new_work;
 	FileData *focus_fd;
 	FileData *first_selected = NULL;
-	GList *new_filelist = NULL;
 	GList *new_fd_list = NULL;
+	FileData *visible_fd = NULL;
 
 	focus_fd = VFICON(vf)->focus_fd;
-
-	if (vf->dir_fd)
-		{
-		ret = filelist_read(vf->dir_fd, &new_filelist, NULL);
-		new_filelist = file_data_filter_marks_list(new_filelist, vf_marks_get_filter(vf));
-		new_filelist = g_list_first(new_filelist);
-		new_filelist = file_data_filter_file_filter_list(new_filelist, vf_file_filter_get_filter(vf));
-
-		new_filelist = g_list_first(new_filelist);
-		new_filelist = file_data_filter_class_list(new_filelist, vf_class_get_filter(vf));
-
-		}
+	if (keep_position) visible_fd = vficon_first_visible_fd(vf);
 
 	vf->list = filelist_sort(vf->list, vf->sort_method, vf->sort_ascend); /* the list might not be sorted if there were renames */
 	new_filelist = filelist_sort(new_filelist, vf->sort_method, vf->sort_ascend);
@@ -2049,7 +1980,7 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 
 	filelist_free(new_filelist);
 
-	vficon_populate(vf, TRUE, keep_position);
+	vficon_populate(vf, TRUE, visible_fd);
 
 	if (first_selected && !VFICON(vf)->selection)
 		{
@@ -2059,10 +1990,30 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 	file_data_unref(first_selected);
 
 	/* attempt to keep focus on same icon when refreshing */
-	if (focus_fd && g_list_find(vf->list, focus_fd))
+	if (focus_fd && vficon_index_by_fd(vf, focus_fd) >= 0)
 		{
 		vficon_set_focus(vf, focus_fd);
 		}
+}
+
+static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
+{
+	gboolean ret = TRUE;
+	GList *new_filelist = NULL;
+
+	if (vf->dir_fd)
+		{
+		ret = filelist_read(vf->dir_fd, &new_filelist, NULL);
+		new_filelist = file_data_filter_marks_list(new_filelist, vf_marks_get_filter(vf));
+		new_filelist = g_list_first(new_filelist);
+		new_filelist = file_data_filter_file_filter_list(new_filelist, vf_file_filter_get_filter(vf));
+
+		new_filelist = g_list_first(new_filelist);
+		new_filelist = file_data_filter_class_list(new_filelist, vf_class_get_filter(vf));
+
+		}
+
+	vficon_refresh_list_real(vf, new_filelist, keep_position);
 
 	return ret;
 }
@@ -2072,6 +2023,16 @@ gboolean vficon_refresh(ViewFile *vf)
 	return vficon_refresh_real(vf, TRUE);
 }
 
+/**
+ * @brief Shows \a list instead of reading the folder, takes ownership of \a list
+ *
+ * Used to apply batched file changes, see vf_notify_batch_cb().
+ */
+void vficon_refresh_list(ViewFile *vf, GList *list)
+{
+	vficon_refresh_list_real(vf, list, TRUE);
+}
+
 /*
  *-----------------------------------------------------------------------------
  * draw, etc.
@@ -2088,7 +2049,6 @@ struct _ColumnData
 static void vficon_cell_data_cb(GtkTreeViewColumn *tree_column, GtkCellRenderer *cell,
 				GtkTreeModel *tree_model, GtkTreeIter *iter, gpointer data)
 {
-	GList *list;
 	FileData *fd;
 	ColumnData *cd = data;
 	ViewFile *vf = cd->vf;
@@ -2096,9 +2056,7 @@ static void vficon_cell_data_cb(GtkTreeViewColumn *tree_column, GtkCellRenderer
 
 	if (!GQV_IS_CELL_RENDERER_ICON(cell)) return;
 
-	gtk_tree_model_get(tree_model, iter, FILE_COLUMN_POINTER, &list, -1);
-
-	fd = g_list_nth_data(list, cd->number);
+	fd = vficon_find_data(vf, vficon_row_from_iter(vf, tree_model, iter), cd->number, NULL);
 
 	if (fd)
 		{
@@ -2245,7 +2203,7 @@ gboolean vficon_set_fd(ViewFile *vf, FileData *dir_fd)
 	g_list_free(vf->list);
 	vf->list = NULL;
 
-	/* NOTE: populate will clear the store for us */
+	/* NOTE: populate will resize the store for us */
 	ret = vficon_refresh_real(vf, FALSE);
 
 	VFICON(vf)->focus_fd = NULL;
@@ -2269,6 +2227,9 @@ void vficon_destroy_cb(GtkWidget *widget, gpointer data)
 
 	g_list_free(vf->list);
 	g_list_free(VFICON(vf)->selection);
+
+	if (VFICON(vf)->index) g_ptr_array_free(VFICON(vf)->index, TRUE);
+	if (VFICON(vf)->positions) g_hash_table_destroy(VFICON(vf)->positions);
 }
 
 ViewFile *vficon_new(ViewFile *vf, FileData *dir_fd)
@@ -2281,7 +2242,7 @@ ViewFile *vficon_new(ViewFile *vf, FileData *dir_fd)
 
 	VFICON(vf)->show_text = options->show_icon_names;
 
-	store = gtk_list_store_new(1, G_TYPE_POINTER);
+	store = gtk_list_store_new(FILE_COLUMN_COUNT, G_TYPE_INT);
 	vf->listview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
 	g_object_unref(store);
 
@@ -2315,7 +2276,7 @@ ViewFile *vficon_new(ViewFile *vf, FileData *dir_fd)
 	/* force VFICON(vf)->columns to be at least 1 (sane) - this will be corrected in the size_cb */
 	vficon_populate_at_new_size(vf, 1, 1, FALSE);
 
-	file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+	file_data_register_notify_func_full(vf_notify_cb, vf_notify_batch_cb, vf, NOTIFY_PRIORITY_MEDIUM);
 
 	return vf;
 }
@@ -35,6 +35,7 @@ ViewFile *vficon_new(ViewFile *vf, FileData *dir_fd);
 
 gboolean vficon_set_fd(ViewFile *vf, FileData *dir_fd);
 gboolean vficon_refresh(ViewFile *vf);
+void vficon_refresh_list(ViewFile *vf, GList *list);
 
 void vficon_sort_set(ViewFile *vf, SortType type, gboolean ascend);
 
@@ -73,7 +74,7 @@ void vficon_selection_to_mark(ViewFile *vf, gint mark, SelectionToMarkMode mode)
 void vficon_thumb_progress_count(GList *list, gint *count, gint *done);
 void vficon_read_metadata_progress_count(GList *list, gint *count, gint *done);
 void vficon_set_thumb_fd(ViewFile *vf, FileData *fd);
-FileData *vficon_thumb_next_fd(ViewFile *vf);
+FileData *vficon_thumb_next_fd(ViewFile *vf, gboolean *visible);
 void vficon_thumb_reset_all(ViewFile *vf);
 
 FileData *vficon_star_next_fd(ViewFile *vf);
@@ -1207,11 +1207,13 @@ void vflist_set_thumb_fd(ViewFile *vf, FileData *fd)
 	gtk_tree_store_set(store, &iter, FILE_COLUMN_THUMB, fd->thumb_pixbuf, -1);
 }
 
-FileData *vflist_thumb_next_fd(ViewFile *vf)
+FileData *vflist_thumb_next_fd(ViewFile *vf, gboolean *visible)
 {
 	GtkTreePath *tpath;
 	FileData *fd = NULL;
 
+	*visible = TRUE;
+
 	/* first check the visible files */
 
 	if (gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, NULL, NULL, NULL))
@@ -1242,6 +1244,8 @@ FileData *vflist_thumb_next_fd(ViewFile *vf)
 	if (!fd)
 		{
 		GList *work = vf->list;
+
+		*visible = FALSE;
 		while (work && !fd)
 			{
 			FileData *fd_p = work->data;
@@ -1814,7 +1818,7 @@ void vflist_selection_to_mark(ViewFile *vf, gint mark, SelectionToMarkMode mode)
 			}
 
 
-		file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+		file_data_register_notify_func_full(vf_notify_cb, vf_notify_batch_cb, vf, NOTIFY_PRIORITY_MEDIUM);
 
 		work = work->next;
 		}
@@ -1960,7 +1964,7 @@ gboolean vflist_refresh(ViewFile *vf)
 		vf->list = g_list_first(vf->list);
 		vf->list = file_data_filter_class_list(vf->list, vf_class_get_filter(vf));
 
-		file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+		file_data_register_notify_func_full(vf_notify_cb, vf_notify_batch_cb, vf, NOTIFY_PRIORITY_MEDIUM);
 
 		DEBUG_1("%s vflist_refresh: sort", get_exec_time());
 		vf->list = filelist_sort(vf->list, vf->sort_method, vf->sort_ascend);
@@ -1978,6 +1982,26 @@ gboolean vflist_refresh(ViewFile *vf)
 	return ret;
 }
 
+/**
+ * @brief Shows \a list instead of reading the folder, takes ownership of \a list
+ *
+ * Used to apply batched file changes, see vf_notify_batch_cb().
+ */
+void vflist_refresh_list(ViewFile *vf, GList *list)
+{
+	GList *old_list;
+
+	old_list = vf->list;
+
+	if (vf->marks_enabled) file_data_lock_list(list);
+
+	vf->list = filelist_sort(list, vf->sort_method, vf->sort_ascend);
+
+	vflist_populate_view(vf, FALSE);
+
+	filelist_free(old_list);
+}
+
 
 
 /* this overrides the low default of a GtkCellRenderer from 100 to CELL_HEIGHT_OVERRIDE, something sane for our purposes */
@@ -2102,7 +2126,7 @@ static void vflist_listview_mark_toggled_cb(GtkCellRendererToggle *cell, gchar *
 		/* mark functions can change sidecars too */
 		vflist_setup_iter_recursive(vf, GTK_TREE_STORE(store), &iter, fd->sidecar_files, NULL, FALSE);
 		}
-	file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+	file_data_register_notify_func_full(vf_notify_cb, vf_notify_batch_cb, vf, NOTIFY_PRIORITY_MEDIUM);
 
 	gtk_tree_path_free(path);
 }
@@ -2245,7 +2269,7 @@ ViewFile *vflist_new(ViewFile *vf, FileData *dir_fd)
 	g_assert(column == FILE_VIEW_COLUMN_DATE);
 	column++;
 
-	file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+	file_data_register_notify_func_full(vf_notify_cb, vf_notify_batch_cb, vf, NOTIFY_PRIORITY_MEDIUM);
 	return vf;
 }
 
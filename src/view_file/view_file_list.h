@@ -35,6 +35,7 @@ ViewFile *vflist_new(ViewFile *vf, FileData *dir_fd);
 
 gboolean vflist_set_fd(ViewFile *vf, FileData *dir_fd);
 gboolean vflist_refresh(ViewFile *vf);
+void vflist_refresh_list(ViewFile *vf, GList *list);
 
 void vflist_thumb_set(ViewFile *vf, gboolean enable);
 void vflist_marks_set(ViewFile *vf, gboolean enable);
@@ -73,7 +74,7 @@ void vflist_color_set(ViewFile *vf, FileData *fd, gboolean color_set);
 void vflist_thumb_progress_count(GList *list, gint *count, gint *done);
 void vflist_read_metadata_progress_count(GList *list, gint *count, gint *done);
 void vflist_set_thumb_fd(ViewFile *vf, FileData *fd);
-FileData *vflist_thumb_next_fd(ViewFile *vf);
+FileData *vflist_thumb_next_fd(ViewFile *vf, gboolean *visible);
 void vflist_thumb_reset_all(ViewFile *vf);
 void vflist_pop_menu_show_star_rating_cb(GtkWidget *widget, gpointer data);
 